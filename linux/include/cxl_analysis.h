@@ -2,6 +2,45 @@
 #define CXL_ANALYSIS_H
 
 #include "cxl_common.h"
+#include "cxl_histogram.h"
+#include "cxl_stats.h"
+
+/* ====== 分位数引擎配置 ====== */
+#define CXL_ANALYSIS_MAX_QUANTILES  64    /* 单次调用最多请求的分位数个数 */
+
+/* ====== 显著性检验配置 ====== */
+#define CXL_ANALYSIS_DEFAULT_ALPHA  0.01  /* 判定延迟偏移的默认显著性水平 */
+#define CXL_ANALYSIS_NORMAL_DF      1e5   /* 自由度不小于此值时 t 分布按正态计算 */
+#define CXL_ANALYSIS_BETA_MAX_ITER  1000  /* 不完全 Beta 连分式的最大迭代次数 */
+
+/* ====== 双峰阈值拟合配置 ====== */
+#define CXL_GMM_MAX_ITER            200   /* EM 最大迭代次数 */
+#define CXL_GMM_TOLERANCE           1e-9  /* 对数似然的相对收敛阈值 */
+#define CXL_GMM_MIN_VARIANCE        1e-4  /* ln 域方差下限（约 1% 相对标准差），防止单桶模式塌缩 */
+
+/* ====== 双分量高斯混合模型（ln 周期域，分量 0 为低延迟模式） ====== */
+typedef struct {
+    double weight[2];
+    double mean[2];
+    double variance[2];
+    double log_likelihood;
+    int iterations;
+    int converged;
+} cxl_gmm2_t;
+
+/* ====== 检验结果 ====== */
+typedef struct {
+    double statistic;           /* Welch t、KS D 或 Mann-Whitney U */
+    double p_value;             /* 双侧 p 值 */
+    double df;                  /* Welch 自由度（其他检验为 0） */
+    double effect;              /* 效应量：均值差（A - B）、D 或 P(A > B) */
+} cxl_test_result_t;
+
+typedef struct {
+    cxl_test_result_t welch;
+    cxl_test_result_t ks;
+    cxl_test_result_t mann_whitney;
+} cxl_compare_result_t;
 
 /* ====== 数据分析与可视化接口 ====== */
 
@@ -27,6 +66,21 @@ int cxl_analysis_compute_statistics(const uint64_t *timings, int num_samples,
                                     uint64_t *min, uint64_t *max, 
                                     double *mean, double *median, double *stddev);
 
+/**
+ * @brief 一次计算多个精确分位数（introselect，无逐次排序）
+ * @param timings 时间数据数组
+ * @param num_samples 样本数量
+ * @param quantiles 分位数数组（0-1 范围，如 0.5/0.9/0.99/0.999/0.9999）
+ * @param num_quantiles 分位数数量（不超过 CXL_ANALYSIS_MAX_QUANTILES）
+ * @param values 返回的分位数值（相邻次序统计量之间线性插值）
+ * @return 0 成功，-1 失败
+ * @note 数据只复制一次到模块内部复用的暂存区，稳态下不做逐次 malloc；
+ *       暂存区由 cxl_analysis_cleanup 释放，本函数非线程安全
+ */
+int cxl_analysis_quantiles(const uint64_t *timings, int num_samples,
+                           const double *quantiles, int num_quantiles,
+                           double *values);
+
 /**
  * @brief 计算两组时间序列的对比
  * @param timings_a 第一组时间数据
@@ -34,13 +88,86 @@ int cxl_analysis_compute_statistics(const uint64_t *timings, int num_samples,
  * @param timings_b 第二组时间数据
  * @param num_b 第二组样本数
  * @param difference 返回平均差异
- * @param p_value 返回统计 p 值（用于判断差异显著性）
+ * @param p_value 返回 Welch t 检验的双侧 p 值（用于判断差异显著性）
  * @return 0 成功，-1 失败
  */
 int cxl_analysis_compare_distributions(const uint64_t *timings_a, int num_a,
                                        const uint64_t *timings_b, int num_b,
                                        double *difference, double *p_value);
 
+/*
+ * 显著性检验可用于 10^8 量级的样本：Welch t 检验只需要单遍统计（cxl_stats_t），
+ * KS 与 Mann-Whitney U 检验在对数-线性直方图上逐桶进行，代价与样本数无关。
+ * 直方图检验把同一桶内的样本视为并列，值域分辨率为 2 / CXL_HIST_SUB_BUCKET_COUNT（小于
+ * CXL_HIST_SUB_BUCKET_COUNT 的值精确）；对延迟偏移检测而言这一分辨率远小于关心的效应量。
+ */
+
+/**
+ * @brief Welch t 检验（不假设方差相等）
+ * @param a 第一组统计（至少 2 个样本）
+ * @param b 第二组统计（至少 2 个样本）
+ * @param result 返回 t、Welch-Satterthwaite 自由度、双侧 p 值和均值差
+ * @return 0 成功，-1 失败
+ */
+int cxl_analysis_welch_test(const cxl_stats_t *a, const cxl_stats_t *b, cxl_test_result_t *result);
+
+/**
+ * @brief 两样本 Kolmogorov-Smirnov 检验
+ * @param a 第一组直方图
+ * @param b 第二组直方图
+ * @param result 返回 D 统计量与渐近 p 值（Stephens 修正）
+ * @return 0 成功，-1 失败
+ */
+int cxl_analysis_ks_test(const cxl_histogram_t *a, const cxl_histogram_t *b, cxl_test_result_t *result);
+
+/**
+ * @brief Mann-Whitney U 检验（正态近似，含并列修正）
+ * @param a 第一组直方图
+ * @param b 第二组直方图
+ * @param result 返回第一组的 U、双侧 p 值和 P(A > B)（并列计一半）
+ * @return 0 成功，-1 失败
+ */
+int cxl_analysis_mann_whitney(const cxl_histogram_t *a, const cxl_histogram_t *b, cxl_test_result_t *result);
+
+/**
+ * @brief 对两个直方图执行全部三种检验（Welch 的方差按桶中点估计）
+ * @param a 第一组直方图
+ * @param b 第二组直方图
+ * @param result 返回三种检验结果
+ * @return 0 成功，-1 失败
+ */
+int cxl_analysis_compare_histograms(const cxl_histogram_t *a, const cxl_histogram_t *b,
+                                    cxl_compare_result_t *result);
+
+/**
+ * @brief 对两组原始样本执行全部三种检验（Welch 使用精确方差）
+ * @param timings_a 第一组样本
+ * @param num_a 第一组样本数（至少 2）
+ * @param timings_b 第二组样本
+ * @param num_b 第二组样本数（至少 2）
+ * @param result 返回三种检验结果
+ * @return 0 成功，-1 失败
+ */
+int cxl_analysis_compare_samples(const uint64_t *timings_a, size_t num_a,
+                                 const uint64_t *timings_b, size_t num_b,
+                                 cxl_compare_result_t *result);
+
+/**
+ * @brief 判定两组分布是否发生显著偏移（三个检验按 Bonferroni 校正，任一拒绝即为偏移）
+ * @param result 检验结果
+ * @param alpha 显著性水平（如 CXL_ANALYSIS_DEFAULT_ALPHA）
+ * @return 1 显著偏移，0 无显著偏移
+ */
+int cxl_analysis_shift_detected(const cxl_compare_result_t *result, double alpha);
+
+/**
+ * @brief 打印检验结果与判定
+ * @param result 检验结果
+ * @param label 标题
+ * @param alpha 显著性水平
+ */
+void cxl_analysis_print_comparison(const cxl_compare_result_t *result, const char *label, double alpha);
+
 /**
  * @brief 将时间分布数据导出为 CSV 格式
  * @param timings 时间数据数组
@@ -52,6 +179,45 @@ int cxl_analysis_compare_distributions(const uint64_t *timings_a, int num_a,
 int cxl_analysis_export_csv(const uint64_t *timings, int num_samples,
                             const char *label, const char *output_file);
 
+/**
+ * @brief 将时间分布数据导出为二进制样本文件（.cxltrace，见 cxl_trace.h）
+ * @param timings 时间数据数组
+ * @param num_samples 样本数量
+ * @param label 数据标签
+ * @param output_file 输出文件路径
+ * @return 0 成功，-1 失败
+ * @note 差值变长编码，典型延迟数据每个样本 1-2 字节，约为 CSV 的 1/5 到 1/10
+ */
+int cxl_analysis_export_binary(const uint64_t *timings, int num_samples,
+                               const char *label, const char *output_file);
+
+/**
+ * @brief 直接从二进制样本文件计算基本统计（逐块解码，不整体载入内存）
+ * @param trace_file 样本文件路径
+ * @param min 返回最小值
+ * @param max 返回最大值
+ * @param mean 返回平均值
+ * @param median 返回中位数
+ * @param stddev 返回标准差
+ * @return 0 成功，-1 失败
+ * @note min/max/mean/stddev 精确；median 来自直方图，
+ *       相对误差不超过 2 / CXL_HIST_SUB_BUCKET_COUNT
+ */
+int cxl_analysis_compute_statistics_trace(const char *trace_file,
+                                          uint64_t *min, uint64_t *max,
+                                          double *mean, double *median, double *stddev);
+
+/**
+ * @brief 直接从二进制样本文件计算多个分位数
+ * @param trace_file 样本文件路径
+ * @param quantiles 分位数数组（0-1 范围）
+ * @param num_quantiles 分位数数量
+ * @param values 返回的分位数值（精度同直方图）
+ * @return 0 成功，-1 失败
+ */
+int cxl_analysis_quantiles_trace(const char *trace_file, const double *quantiles,
+                                 int num_quantiles, uint64_t *values);
+
 /**
  * @brief 生成时间分布直方图
  * @param timings 时间数据数组
@@ -128,6 +294,49 @@ int cxl_analysis_hit_miss_separation(const uint64_t *hit_timings, int num_hits,
 uint64_t cxl_analysis_recommend_threshold(const uint64_t *hit_timings, int num_hits,
                                           const uint64_t *miss_timings, int num_misses);
 
+/*
+ * 双峰拟合在对数-线性直方图的非空桶上进行，取 ln(周期) 为横轴：延迟的离散程度大致与其大小成正比，
+ * 对数域下命中与未命中两个模式的宽度相近，CXL 的未命中模式离得再远也不会把阈值拉偏。
+ * 返回的阈值都是直方图桶的下界，访问时间小于阈值判为命中。
+ */
+
+/**
+ * @brief Otsu 阈值（最大化两类的类间方差）
+ * @param hist 命中与未命中样本的合并直方图
+ * @return 阈值（周期），只有一个非空桶时返回 0
+ */
+uint64_t cxl_analysis_otsu_threshold(const cxl_histogram_t *hist);
+
+/**
+ * @brief 用 EM 拟合双分量高斯混合（以 Otsu 分割初始化）
+ * @param hist 合并直方图
+ * @param model 返回的模型
+ * @return 0 成功，-1 失败（单峰或分量塌缩）
+ */
+int cxl_analysis_gmm2_fit(const cxl_histogram_t *hist, cxl_gmm2_t *model);
+
+/**
+ * @brief 计算 GMM 的判决阈值（两个加权分量密度相等处）
+ * @param model 拟合好的模型
+ * @return 阈值（周期），模型无效时返回 0
+ */
+uint64_t cxl_analysis_gmm2_threshold(const cxl_gmm2_t *model);
+
+/**
+ * @brief 按指定方法从直方图拟合阈值（GMM 失败时退回 Otsu）
+ * @param hist 合并直方图
+ * @param method 拟合方法
+ * @return 阈值（周期），失败返回 0
+ */
+uint64_t cxl_analysis_fit_threshold(const cxl_histogram_t *hist, cxl_threshold_method_t method);
+
+/**
+ * @brief 获取拟合方法名称
+ * @param method 拟合方法
+ * @return "otsu" 或 "gmm"
+ */
+const char *cxl_analysis_threshold_method_name(cxl_threshold_method_t method);
+
 /**
  * @brief 从噪声中恢复信号（去噪分析）
  * @param raw_samples 原始样本数组
@@ -3,6 +3,51 @@
 
 #include "cxl_common.h"
 
+/* ====== 探测引擎配置 ====== */
+#define CXL_PROBE_CALIBRATION_SAMPLES   10000   /* 每核计时开销校准采样数 */
+
+/* ====== 阈值表 ====== */
+/*
+ * 阈值按 [NUMA 节点][缓存级] 存放。L 级阈值区分"由 L 级或更近的缓存提供"与"更远"，
+ * Flush+Reload 等判断"是否在缓存中"的分类器使用 CXL_CACHE_LEVEL_LLC（缓存与该节点内存之间）。
+ * 分类器按目标地址所在节点（cxl_addr_to_node，按页缓存）查表，未设置的项回退到全局阈值。
+ * 缓存级常量 CXL_MAX_CACHE_LEVELS / CXL_CACHE_LEVEL_LLC 在 cxl_common.h 中定义。
+ */
+
+/* ====== 命中/未命中阈值校准配置 ====== */
+#define CXL_THRESHOLD_CALIBRATION_SAMPLES   20000               /* 每节点命中与未命中各采样数 */
+#define CXL_THRESHOLD_CALIBRATION_BUFFER    (8UL * 1024 * 1024) /* 校准缓冲区，缓存行数须为 2 的幂 */
+#define CXL_THRESHOLD_CALIBRATION_STRIDE    4099                /* 遍历步长（缓存行，奇数且跨页） */
+#define CXL_THRESHOLD_CALIBRATION_BATCH     32                  /* 每次驱逐后计时的缓存行数 */
+
+/* ====== 批量清除配置 ====== */
+/*
+ * 清除指令在首次使用时按 CPUID.(EAX=7):EBX 选择：clflushopt 之间互不排序，可以流水发出，
+ * 整段范围只在末尾加一次 sfence；clflush 每条都与其他 clflush 及写操作排序，只作退回路径。
+ * clwb 写回脏行但允许保留在缓存中，只在需要持久化而不需要冷缓存时使用。
+ */
+#define CXL_FLUSH_THREAD_CHUNK      (256UL * 1024 * 1024)   /* 自动线程数：每个线程至少清除的字节数 */
+#define CXL_FLUSH_MAX_THREADS       16
+
+typedef enum {
+    FLUSH_INSN_AUTO,            /* 支持的最快失效指令（clflushopt，否则 clflush） */
+    FLUSH_INSN_CLFLUSH,
+    FLUSH_INSN_CLFLUSHOPT,
+    FLUSH_INSN_CLWB
+} flush_insn_t;
+
+/* ====== 阈值校准结果 ====== */
+typedef struct {
+    int node;                       /* NUMA 节点 */
+    int level;                      /* 缓存级（1 ~ CXL_MAX_CACHE_LEVELS） */
+    cxl_threshold_method_t method;  /* 拟合方法 */
+    uint64_t threshold;             /* 安装的阈值（周期） */
+    uint64_t hit_median;            /* 已知命中样本中位数（周期） */
+    uint64_t miss_median;           /* 已知未命中样本中位数（周期） */
+    double hit_error;               /* 命中样本被判为未命中的比例 */
+    double miss_error;              /* 未命中样本被判为命中的比例 */
+} cxl_threshold_calibration_t;
+
 /* ====== 侧信道攻击原语基础操作 ====== */
 
 /**
@@ -12,18 +57,48 @@
 void cxl_flush_clflush(void *addr);
 
 /**
- * @brief Clflushopt 优化缓存清除原语
+ * @brief Clflushopt 优化缓存清除原语（运行时检测，不支持时使用 clflush；不带屏障）
  * @param addr 要清除的内存地址
  */
 void cxl_flush_clflushopt(void *addr);
 
 /**
- * @brief 批量 Clflush 操作
+ * @brief 批量清除操作（单线程，使用 FLUSH_INSN_AUTO，末尾一次 sfence）
  * @param start_addr 起始地址
  * @param end_addr 结束地址
  */
 void cxl_flush_range(void *start_addr, void *end_addr);
 
+/**
+ * @brief 批量清除一段内存的缓存行，返回时所有清除均已完成
+ * @param addr 起始地址
+ * @param size 字节数
+ * @param insn 清除指令，不支持时依次退回 clflushopt、clflush
+ * @param num_threads 线程数（调用线程计入其中），0 表示按 CXL_FLUSH_THREAD_CHUNK 自动选择
+ * @return 0 成功，-1 参数错误
+ */
+int cxl_flush_bulk(void *addr, size_t size, flush_insn_t insn, int num_threads);
+
+/**
+ * @brief 获取 FLUSH_INSN_AUTO 实际使用的清除指令
+ * @return FLUSH_INSN_CLFLUSHOPT 或 FLUSH_INSN_CLFLUSH
+ */
+flush_insn_t cxl_flush_insn(void);
+
+/**
+ * @brief 检查 CPU 是否支持指定清除指令
+ * @param insn 清除指令
+ * @return 1 支持，0 不支持
+ */
+int cxl_flush_supports(flush_insn_t insn);
+
+/**
+ * @brief 获取清除指令名称
+ * @param insn 清除指令
+ * @return 名称字符串
+ */
+const char *cxl_flush_insn_name(flush_insn_t insn);
+
 /**
  * @brief Probe 操作：通过访问时间测量缓存命中/缺失
  * @param addr 要 probe 的内存地址
@@ -33,13 +108,49 @@ void cxl_flush_range(void *start_addr, void *end_addr);
 uint64_t cxl_probe_access_time(void *addr, uint64_t *out_time);
 
 /**
- * @brief 批量 Probe 操作
+ * @brief 批量 Probe 操作（基于 cxl_probe_batch，已扣除计时开销）
  * @param addrs 地址数组
  * @param num_addrs 地址数量
  * @param timings 返回的时间数组
  */
 void cxl_probe_multiple(void **addrs, int num_addrs, uint64_t *timings);
 
+/**
+ * @brief 校准当前核心上空 rdtscp 计时对的开销
+ * @param num_samples 校准采样次数
+ * @return 当前核心的计时开销中位数（cycles）
+ */
+uint64_t cxl_probe_calibrate(int num_samples);
+
+/**
+ * @brief 依次在调用线程允许的每个 CPU 上校准计时开销，结束后恢复原亲和性
+ * @param num_samples 每核校准采样次数
+ * @return 成功校准的 CPU 数，失败返回 -1
+ */
+int cxl_probe_calibrate_all(int num_samples);
+
+/**
+ * @brief 获取指定 CPU 的计时开销
+ * @param cpu_id CPU 编号
+ * @return 计时开销（cycles），未校准返回 0
+ */
+uint64_t cxl_probe_get_overhead(int cpu_id);
+
+/**
+ * @brief 扣除计时开销后的单次访问时间
+ * @param addr 要 probe 的内存地址
+ * @return 修正后的访问时间（cycles），当前核未校准时先自动校准
+ */
+uint64_t cxl_probe_access_time_corrected(void *addr);
+
+/**
+ * @brief 批量 Probe 引擎：展开的内联计时循环，输出扣除计时开销的访问时间
+ * @param addrs 地址数组
+ * @param num_addrs 地址数量
+ * @param timings 返回的修正后时间数组
+ */
+void cxl_probe_batch(void **addrs, int num_addrs, uint64_t *timings);
+
 /**
  * @brief Reload 操作：将数据重新加载到缓存
  * @param addr 要 reload 的地址
@@ -93,12 +204,22 @@ uint64_t cxl_victim_memory_access(void *addr, int is_write);
 void cxl_random_memory_access(void *start_addr, size_t size, int num_accesses);
 
 /**
- * @brief 驱逐级别特定的缓存
- * @param level 缓存级别（1 L1, 2 L2, 3 L3）
- * @param evict_addr 用于驱逐的地址
+ * @brief 驱逐级别特定的缓存（驱逐量按 cxl_cache_get() 探测到的该级容量计算）
+ * @param level 缓存级别（1 L1, 2 L2, CXL_CACHE_LEVEL_LLC），超过最高级时按 LLC 处理
+ * @param evict_addr 用于驱逐的缓冲区，NULL 时使用本节点的驱逐缓冲区；
+ *                   非 NULL 时至少需要 L1/L2/LLC 各 64/256/4096 行，最多读取这么多
  */
 void cxl_evict_cache_level(int level, void *evict_addr);
 
+/**
+ * @brief 同 cxl_evict_cache_level，但调用者给出缓冲区大小
+ * @param level 缓存级别（同 cxl_evict_cache_level）
+ * @param evict_addr 用于驱逐的缓冲区，NULL 时使用本节点的驱逐缓冲区
+ * @param evict_size 缓冲区大小（字节），只读取 min(evict_size, cxl_evict_buffer_size(level))；
+ *                   小于 cxl_evict_buffer_size(level) 时驱逐不完全。evict_addr 为 NULL 时忽略
+ */
+void cxl_evict_cache_level_sized(int level, void *evict_addr, size_t evict_size);
+
 /**
  * @brief 执行 Flush + Reload 组合
  * @param addr 目标地址
@@ -114,7 +235,7 @@ void cxl_flush_double(void *addr);
 
 /**
  * @brief 执行 Evict + Time 组合
- * @param evict_addr 驱逐地址
+ * @param evict_addr 驱逐缓冲区，NULL 使用本节点的驱逐缓冲区（大小要求见 cxl_evict_cache_level）
  * @param probe_addr Probe 地址
  * @return Probe 访问时间
  */
@@ -141,6 +262,60 @@ void cxl_set_timing_threshold(uint64_t threshold);
  */
 uint64_t cxl_get_timing_threshold(void);
 
+/**
+ * @brief 设置阈值表中的一项
+ * @param node NUMA 节点
+ * @param level 缓存级（1 ~ CXL_MAX_CACHE_LEVELS）
+ * @param threshold 以周期为单位的阈值，0 表示清除（回退到全局阈值）
+ */
+void cxl_set_node_threshold(int node, int level, uint64_t threshold);
+
+/**
+ * @brief 查询阈值表
+ * @param node NUMA 节点，-1 表示未知
+ * @param level 缓存级（1 ~ CXL_MAX_CACHE_LEVELS）
+ * @return 该项的阈值；未设置或节点未知时返回全局阈值
+ */
+uint64_t cxl_get_node_threshold(int node, int level);
+
+/**
+ * @brief 按地址所在节点查询阈值（节点查询按页缓存，命中时不进入内核）
+ * @param addr 目标地址
+ * @param level 缓存级
+ * @return 阈值（周期）
+ */
+uint64_t cxl_get_addr_threshold(const void *addr, int level);
+
+/**
+ * @brief 打印阈值表（只列出有设置项的节点）
+ */
+void cxl_print_thresholds(void);
+
+/**
+ * @brief 校准单个节点某一缓存级的命中/未命中阈值并安装到阈值表
+ *
+ * 在该节点上分配缓冲区，分别采集已知命中（刚加载）和已知未命中的访问时间，
+ * 合并为双峰直方图后用 Otsu 或双分量 GMM 拟合分割点。LLC 级的未命中样本在 clflush 后采集
+ * （来自该节点内存），L1/L2 的未命中样本在 cxl_evict_level(level) 后采集（来自更远一级缓存）。
+ *
+ * @param node NUMA 节点
+ * @param level 缓存级（1 ~ CXL_MAX_CACHE_LEVELS）
+ * @param num_samples 命中与未命中各采样数，<= 0 时使用默认值
+ * @param method 拟合方法
+ * @param result 返回的校准结果（可为 NULL）
+ * @return 0 成功，-1 失败
+ */
+int cxl_calibrate_node_threshold(int node, int level, int num_samples, cxl_threshold_method_t method,
+                                 cxl_threshold_calibration_t *result);
+
+/**
+ * @brief 校准所有带内存的 NUMA 节点的各级阈值
+ * @param num_samples 每节点每级采样数，<= 0 时使用默认值
+ * @param method 拟合方法
+ * @return LLC 级校准成功的节点数
+ */
+int cxl_calibrate_thresholds(int num_samples, cxl_threshold_method_t method);
+
 /**
  * @brief 执行原子操作（用于同步）
  * @param addr 目标地址
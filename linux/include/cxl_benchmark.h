@@ -0,0 +1,262 @@
+#ifndef CXL_BENCHMARK_H
+#define CXL_BENCHMARK_H
+
+#include "cxl_common.h"
+#include "cxl_perf.h"
+
+/* ====== 内存性能基准测试接口 ====== */
+
+/* ====== 基准测试默认参数 ====== */
+#define CXL_BENCH_MIN_WORKING_SET   (4UL * 1024)                 /* 4 KiB */
+#define CXL_BENCH_MAX_WORKING_SET   (4UL * 1024 * 1024 * 1024)   /* 4 GiB */
+#define CXL_BENCH_MAX_POINTS        64
+#define CXL_BENCH_BW_ARRAY_SIZE     (64UL * 1024 * 1024)         /* 每线程每个数组 64 MiB */
+#define CXL_BENCH_BW_REPEATS        5
+#define CXL_BENCH_LOADED_WORKING_SET (256UL * 1024 * 1024)       /* 负载延迟追逐线程工作集 */
+#define CXL_BENCH_MAX_DELAYS        32
+#define CXL_BENCH_MIGRATE_REGION    (64UL * 1024 * 1024)         /* 迁移测试区域 64 MiB */
+#define CXL_BENCH_MIGRATE_PASSES    4                            /* 迁移后测量的追逐遍数 */
+
+/* ====== 指针追逐结果 ====== */
+typedef struct {
+    int node;                   /* NUMA 节点 */
+    size_t working_set;         /* 工作集大小（字节） */
+    size_t stride;              /* 链表节点间距（字节） */
+    uint64_t num_loads;         /* 计时的依赖加载次数 */
+    double ns_per_load;         /* 每次加载的纳秒数 */
+    double cycles_per_load;     /* 每次加载的 TSC 周期数 */
+    size_t page_size;           /* 工作集实际使用的页大小 */
+    cxl_perf_counts_t perf;     /* 计时追逐期间测量线程的硬件计数 */
+} chase_result_t;
+
+/* ====== 带宽测试内核（STREAM 风格） ====== */
+typedef enum {
+    BW_KERNEL_READ,     /* sum += a[i] */
+    BW_KERNEL_WRITE,    /* a[i] = s */
+    BW_KERNEL_COPY,     /* a[i] = b[i] */
+    BW_KERNEL_TRIAD,    /* a[i] = b[i] + s * c[i] */
+    BW_KERNEL_COUNT
+} bw_kernel_t;
+
+/* ====== 带宽测试结果 ====== */
+typedef struct {
+    int node;                   /* 数据所在 NUMA 节点 */
+    int num_threads;            /* 线程数 */
+    bw_kernel_t kernel;         /* 测试内核 */
+    size_t bytes_per_thread;    /* 每线程每个数组的字节数 */
+    uint64_t bytes_moved;       /* 单次重复搬运的总字节数 */
+    double seconds;             /* 最佳一次重复的耗时 */
+    double gbps;                /* 带宽（GB/s，10^9 字节） */
+    size_t page_size;           /* 数组实际使用的页大小 */
+    cxl_perf_counts_t perf;     /* 最佳一次重复中所有线程的硬件计数之和 */
+} bandwidth_result_t;
+
+/* ====== 负载延迟：注入线程的流量类型 ====== */
+typedef enum {
+    INJECT_READ,        /* 每个缓存行一次加载 */
+    INJECT_WRITE,       /* 非临时存储写满缓存行，不产生 RFO */
+    INJECT_READ_WRITE,  /* 读-改-写，每行一读一写回 */
+    INJECT_COUNT
+} inject_traffic_t;
+
+/* ====== 负载延迟测试参数 ====== */
+typedef struct {
+    int node;                   /* 被测 NUMA 节点（追逐与注入缓冲区都在此节点） */
+    int chase_cpu;              /* 追逐线程绑定的 CPU */
+    const int *injector_cpus;   /* 注入线程绑定的 CPU 列表 */
+    int num_injectors;          /* 注入线程数（不超过 CXL_MAX_THREADS - 1） */
+    inject_traffic_t traffic;   /* 注入流量类型 */
+    size_t chase_working_set;   /* 追逐线程工作集（字节） */
+    size_t inject_bytes;        /* 每个注入线程的缓冲区大小（字节） */
+    uint64_t num_loads;         /* 每个测量点计时的依赖加载次数 */
+} loaded_latency_params_t;
+
+/* ====== 负载延迟测试结果（延迟-带宽曲线上的一个点） ====== */
+typedef struct {
+    int node;                   /* 被测 NUMA 节点 */
+    int num_injectors;          /* 实际运行的注入线程数（0 表示空载） */
+    inject_traffic_t traffic;   /* 注入流量类型 */
+    uint32_t delay;             /* 注入线程每个缓存行之后的 pause 次数 */
+    double injected_gbps;       /* 追逐计时窗口内注入线程的聚合带宽（GB/s） */
+    double ns_per_load;         /* 追逐线程每次加载的纳秒数 */
+    double cycles_per_load;     /* 追逐线程每次加载的 TSC 周期数 */
+    uint64_t num_loads;         /* 计时的依赖加载次数 */
+    size_t page_size;           /* 追逐缓冲区实际使用的页大小 */
+    cxl_perf_counts_t perf;     /* 计时窗口内追逐线程的硬件计数（不含注入线程） */
+} loaded_latency_result_t;
+
+/* ====== 页迁移方式 ====== */
+typedef enum {
+    MIGRATE_MOVE_PAGES,     /* move_pages(2)：逐页指定目标节点，按批提交 */
+    MIGRATE_MIGRATE_PAGES,  /* migrate_pages(2)：子进程在源节点上的页一次迁走 */
+    MIGRATE_METHOD_COUNT
+} migrate_method_t;
+
+/* ====== 页迁移测试参数 ====== */
+typedef struct {
+    int src_node;               /* 区域初始所在节点 */
+    int dst_node;               /* 迁移目标节点 */
+    migrate_method_t method;    /* 迁移方式 */
+    size_t region_size;         /* 区域大小（字节） */
+    page_mode_t page_mode;      /* 区域的页大小模式 */
+    size_t batch_pages;         /* move_pages 每次调用的页数（0 表示整个区域一次） */
+} migration_params_t;
+
+/* ====== 页迁移测试结果 ====== */
+typedef struct {
+    int src_node;               /* 源节点 */
+    int dst_node;               /* 目标节点 */
+    migrate_method_t method;    /* 迁移方式 */
+    size_t region_size;         /* 区域大小（字节） */
+    size_t page_size;           /* 区域实际使用的页大小 */
+    uint64_t num_pages;         /* 区域页数 */
+    size_t batch_pages;         /* 实际批大小（migrate_pages 为整个区域） */
+    uint64_t pages_moved;       /* 迁移后位于目标节点的页数 */
+    uint64_t pages_failed;      /* 未能迁移的页数 */
+    double seconds;             /* 迁移系统调用耗时（秒） */
+    double pages_per_sec;       /* 迁移吞吐（页/秒） */
+    double gbps;                /* 迁移吞吐（GB/s） */
+    double ns_before;           /* 迁移前稳态每页访问延迟（ns） */
+    double ns_after[CXL_BENCH_MIGRATE_PASSES]; /* 迁移后逐遍的每页访问延迟（ns），第一遍为瞬态 */
+    cxl_perf_counts_t perf_before; /* 迁移前稳态一遍的硬件计数 */
+    cxl_perf_counts_t perf_after;  /* 迁移后第一遍（瞬态）的硬件计数 */
+} migration_result_t;
+
+/**
+ * @brief 在缓冲区上构造随机单环链表（Sattolo 算法，原地完成，无额外内存）
+ * @param buffer 缓冲区起始地址
+ * @param size 缓冲区大小（字节）
+ * @param stride 节点间距（字节，至少 8 且为 8 的倍数）
+ * @param seed 随机种子
+ * @return 链表头指针，失败返回 NULL
+ */
+void *cxl_chase_build(void *buffer, size_t size, size_t stride, uint64_t seed);
+
+/**
+ * @brief 沿链表执行依赖加载并计时
+ * @param head 链表头
+ * @param num_loads 加载次数
+ * @param result 返回 ns_per_load / cycles_per_load / num_loads
+ * @return 0 成功，-1 失败
+ */
+int cxl_chase_run(void *head, uint64_t num_loads, chase_result_t *result);
+
+/**
+ * @brief 在指定节点上分配工作集并测量空载指针追逐延迟
+ * @param node NUMA 节点 ID
+ * @param working_set 工作集大小（字节）
+ * @param num_loads 计时的加载次数
+ * @param result 返回结果
+ * @return 0 成功，-1 失败
+ */
+int cxl_bench_pointer_chase(int node, size_t working_set, uint64_t num_loads,
+                            chase_result_t *result);
+
+/**
+ * @brief 以 2 倍步进扫描工作集，得到节点的空载延迟曲线（L1 到内存）
+ * @param node NUMA 节点 ID
+ * @param min_working_set 最小工作集（字节）
+ * @param max_working_set 最大工作集（字节，超过节点空闲内存一半时自动截断）
+ * @param num_loads 每个点计时的加载次数
+ * @param results 返回的结果数组
+ * @param max_results 结果数组容量
+ * @return 实际测量的点数，失败返回 -1
+ */
+int cxl_bench_latency_sweep(int node, size_t min_working_set, size_t max_working_set,
+                            uint64_t num_loads, chase_result_t *results, int max_results);
+
+/**
+ * @brief 获取带宽内核名称
+ * @param kernel 内核类型
+ * @return 名称字符串
+ */
+const char *cxl_bench_kernel_name(bw_kernel_t kernel);
+
+/**
+ * @brief 获取运行时选择的 SIMD 实现（avx512/avx2/scalar）
+ * @return 名称字符串
+ */
+const char *cxl_bench_simd_level(void);
+
+/**
+ * @brief 设置所有基准测试缓冲区的页大小模式（默认 PAGE_MODE_4K）
+ * @param mode 页大小模式；大页不足时自动回退，实际页大小记录在结果中
+ */
+void cxl_bench_set_page_mode(page_mode_t mode);
+
+/**
+ * @brief 获取当前页大小模式
+ * @return 页大小模式
+ */
+page_mode_t cxl_bench_get_page_mode(void);
+
+/**
+ * @brief 选择运行基准测试线程的 CPU（调用线程允许的、属于指定节点的 CPU）
+ * @param node 发起访问的 NUMA 节点（CPU 所在节点，-1 表示不限）
+ * @param cpus 返回的 CPU 列表
+ * @param max_cpus 列表容量
+ * @return CPU 数量；节点上没有可用 CPU 时退回到所有允许的 CPU
+ */
+int cxl_bench_select_cpus(int node, int *cpus, int max_cpus);
+
+/**
+ * @brief 多线程带宽测试：每个线程绑定到一个 CPU，在目标节点上分配自己的数组
+ * @param node 数据所在 NUMA 节点
+ * @param cpus 线程绑定的 CPU 列表
+ * @param num_threads 线程数（不超过 CXL_MAX_THREADS）
+ * @param kernel 测试内核
+ * @param bytes_per_thread 每线程每个数组的字节数
+ * @param repeats 重复次数（取最快一次）
+ * @param result 返回结果
+ * @return 0 成功，-1 失败
+ */
+int cxl_bench_bandwidth(int node, const int *cpus, int num_threads, bw_kernel_t kernel,
+                        size_t bytes_per_thread, int repeats, bandwidth_result_t *result);
+
+/**
+ * @brief 获取注入流量类型名称
+ * @param traffic 流量类型
+ * @return 名称字符串（read/write/rw）
+ */
+const char *cxl_bench_traffic_name(inject_traffic_t traffic);
+
+/**
+ * @brief 负载延迟单点测量：注入线程以给定节流强度产生流量，同时追逐线程测量延迟
+ * @param params 测试参数
+ * @param delay 注入线程每个缓存行之后的 pause 次数（0 为不节流）
+ * @param result 返回结果
+ * @return 0 成功，-1 失败
+ */
+int cxl_bench_loaded_latency(const loaded_latency_params_t *params, uint32_t delay,
+                             loaded_latency_result_t *result);
+
+/**
+ * @brief 负载延迟扫描：先测空载点，再按给定节流强度依次测量，得到延迟-带宽曲线
+ * @param params 测试参数（缓冲区只分配、构造一次，所有测量点复用）
+ * @param delays 节流强度数组（建议从大到小，即负载从轻到重）
+ * @param num_delays 节流强度数量（不超过 CXL_BENCH_MAX_DELAYS）
+ * @param results 返回的结果数组（容量至少 num_delays + 1）
+ * @return 实际测量的点数，失败返回 -1
+ */
+int cxl_bench_loaded_latency_sweep(const loaded_latency_params_t *params, const uint32_t *delays,
+                                   int num_delays, loaded_latency_result_t *results);
+
+/**
+ * @brief 获取页迁移方式名称
+ * @param method 迁移方式
+ * @return 名称字符串（move_pages/migrate_pages）
+ */
+const char *cxl_bench_migrate_method_name(migrate_method_t method);
+
+/**
+ * @brief 页迁移测试：在源节点上分配区域，迁移到目标节点，测量迁移吞吐与迁移后的访问延迟瞬态
+ *
+ * 区域内每页放一个追逐节点，迁移前后各走一遍链表；MIGRATE_MIGRATE_PAGES 在 fork 出的子进程中
+ * 分配区域并迁移（子进程去掉 CAP_SYS_NICE，只迁移其独占的页），调用进程的内存不受影响。
+ * @param params 测试参数
+ * @param result 返回结果
+ * @return 0 成功，-1 失败
+ */
+int cxl_bench_migration(const migration_params_t *params, migration_result_t *result);
+
+#endif /* CXL_BENCHMARK_H */
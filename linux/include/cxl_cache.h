@@ -0,0 +1,95 @@
+#ifndef CXL_CACHE_H
+#define CXL_CACHE_H
+
+#include "cxl_common.h"
+
+/* ====== 缓存几何 ====== */
+
+/*
+ * 缓存大小、相联度与行大小优先从 sysfs（devices/system/cpu/cpuN/cache/indexM/）读取，
+ * 不可读时退回 CPUID 叶 4（AMD 为 0x8000001D）。只记录数据缓存与统一缓存；
+ * 缓存级按 cxl_common.h 的 CXL_MAX_CACHE_LEVELS 存放，更深的缓存级并入 LLC 一项（取较大者）。
+ */
+
+/* ====== 驱逐缓冲区 ====== */
+
+/*
+ * 每个（NUMA 节点，缓存级）一个驱逐缓冲区，大小为该级容量的 CXL_EVICT_SIZE_FACTOR 倍，
+ * 首次使用时在调用线程所在节点上分配（透明大页，减少遍历时的 TLB 未命中）。
+ * 缓冲区的缓存行串成一个随机置换环，遍历时 CXL_EVICT_CHAINS 条依赖加载链并行推进：
+ * 依赖加载使硬件预取器无法预测下一行，多条链保持足够的内存级并行度。
+ */
+#define CXL_EVICT_SIZE_FACTOR       2
+#define CXL_EVICT_CHAINS            8
+
+typedef enum {
+    CACHE_SOURCE_NONE,          /* 未探测到，使用默认值 */
+    CACHE_SOURCE_SYSFS,
+    CACHE_SOURCE_CPUID
+} cache_source_t;
+
+/* ====== 单级缓存 ====== */
+typedef struct {
+    size_t size;                /* 容量（字节），0 表示该级不存在 */
+    int ways;                   /* 相联度 */
+    int sets;                   /* 组数 */
+    int line_size;              /* 行大小（字节） */
+    int shared_cpus;            /* 共享该缓存的逻辑 CPU 数，未知为 0 */
+} cxl_cache_level_t;
+
+/* ====== 缓存几何 ====== */
+typedef struct {
+    int cpu;                    /* 探测所用的 CPU */
+    cache_source_t source;      /* 数据来源 */
+    int num_levels;             /* 最高缓存级（LLC 级） */
+    cxl_cache_level_t levels[CXL_MAX_CACHE_LEVELS];    /* levels[L - 1] 为 L 级 */
+} cxl_cache_geometry_t;
+
+/**
+ * @brief 探测指定 CPU 的缓存几何
+ * @param cpu CPU 编号（CPUID 退回路径使用调用线程当前所在的 CPU）
+ * @param sysfs_root sysfs 根目录，NULL 时依次使用 CXL_SYSFS_ROOT 环境变量和 /sys
+ * @param geo 返回的缓存几何
+ * @return 0 成功，-1 两种来源都不可用（geo 填入默认值）
+ */
+int cxl_cache_discover(int cpu, const char *sysfs_root, cxl_cache_geometry_t *geo);
+
+/**
+ * @brief 获取本机缓存几何（首次调用时在当前 CPU 上探测并缓存）
+ * @return 缓存几何指针，不会返回 NULL
+ */
+const cxl_cache_geometry_t *cxl_cache_get(void);
+
+/**
+ * @brief 获取某一级缓存的容量
+ * @param level 缓存级（1 起），超过最高级时按 LLC 处理
+ * @return 容量（字节）
+ */
+size_t cxl_cache_level_size(int level);
+
+/**
+ * @brief 打印缓存几何
+ * @param geo 缓存几何
+ */
+void cxl_cache_print(const cxl_cache_geometry_t *geo);
+
+/**
+ * @brief 驱逐指定级缓存所需的缓冲区大小
+ * @param level 缓存级（1 起），超过最高级时按 LLC 处理
+ * @return 字节数（该级容量的 CXL_EVICT_SIZE_FACTOR 倍）
+ */
+size_t cxl_evict_buffer_size(int level);
+
+/**
+ * @brief 用本节点的驱逐缓冲区驱逐指定级缓存（首次调用时分配并构造置换环）
+ * @param level 缓存级（1 起），超过最高级时按 LLC 处理
+ * @return 0 成功，-1 缓冲区分配失败
+ */
+int cxl_evict_level(int level);
+
+/**
+ * @brief 释放所有驱逐缓冲区
+ */
+void cxl_evict_cleanup(void);
+
+#endif /* CXL_CACHE_H */
@@ -16,11 +16,27 @@
 #define CXL_PAGE_SIZE           4096
 #define CXL_MAX_THREADS         64
 #define CXL_RESULT_BUFFER_SIZE  1000000
+#define CXL_ADDR_NODE_CACHE_ENTRIES 512  /* 每线程页 -> 节点缓存条目数（2 的幂） */
 
-/* ====== NUMA 节点配置 ====== */
+/* ====== 缓存级（L1、L2、LLC；更深的缓存级如 L4 eDRAM 并入 LLC） ====== */
+#define CXL_MAX_CACHE_LEVELS    3
+#define CXL_CACHE_LEVEL_LLC     3
+
+/* ====== NUMA 节点配置（仅为默认值，实际节点由 cxl_topology 探测） ====== */
 #define NUMA_NODE_NORMAL        0
 #define NUMA_NODE_CXL_MEMORY    1
 
+/* ====== 页大小配置 ====== */
+#define CXL_HUGE_PAGE_SIZE_2M   (2UL * 1024 * 1024)
+#define CXL_HUGE_PAGE_SIZE_1G   (1024UL * 1024 * 1024)
+
+typedef enum {
+    PAGE_MODE_4K,           /* 4 KiB 普通页（显式关闭 THP） */
+    PAGE_MODE_THP,          /* madvise(MADV_HUGEPAGE) 透明大页 */
+    PAGE_MODE_HUGETLB_2M,   /* MAP_HUGETLB 2 MiB 大页，不足时回退到 THP */
+    PAGE_MODE_HUGETLB_1G    /* MAP_HUGETLB 1 GiB 大页，不足时回退到 2 MiB */
+} page_mode_t;
+
 /* ====== 攻击者/受害者位置配置 ====== */
 typedef enum {
     CROSS_CORE,          /* 不同核心 */
@@ -42,6 +58,12 @@ typedef enum {
     OBSERVE_TRACE       /* 访问痕迹观测 */
 } observation_type_t;
 
+/* ====== 命中/未命中阈值拟合方法（cxl_analysis 实现，阈值校准使用） ====== */
+typedef enum {
+    CXL_THRESHOLD_OTSU,         /* 最大类间方差 */
+    CXL_THRESHOLD_GMM           /* 双分量高斯混合（失败时退回 Otsu） */
+} cxl_threshold_method_t;
+
 /* ====== 时间戳结构 ====== */
 typedef struct {
     uint64_t tsc;           /* TSC 值 */
@@ -97,6 +119,8 @@ typedef struct {
     int victim_cpu;
     int probe_cpu;
     int monitor_cpu;
+    int worker_cpus[CXL_MAX_THREADS];   /* 并行运行器与基准测试线程的 CPU，为空时自动选择 */
+    int num_worker_cpus;
     
     /* 系统配置 */
     int prefetcher_enabled;
@@ -106,6 +130,10 @@ typedef struct {
     uint64_t iterations;
     uint64_t warmup_iterations;
     uint32_t sample_size;
+    
+    /* 缓冲区配置 */
+    size_t test_buffer_size;    /* Flush+Reload 与延迟测试的目标缓冲区 */
+    page_mode_t page_mode;      /* 基准测试缓冲区的页大小 */
 } cxl_config_t;
 
 /* ====== 内联函数：快速获取 RDTSCP 时间戳 ====== */
@@ -145,12 +173,30 @@ static inline uint64_t cxl_access_time(uint64_t start, uint64_t end) {
     return (end > start) ? (end - start) : 0;
 }
 
+/* ====== 内联函数：CPUID ====== */
+static inline void cxl_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax, uint32_t *ebx,
+                             uint32_t *ecx, uint32_t *edx) {
+    asm volatile(
+        "cpuid"
+        : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+        : "a" (leaf), "c" (subleaf)
+    );
+}
+
 /* ====== CXL 内存地址辅助函数 ====== */
 void *cxl_malloc_on_node(size_t size, int node);
 void cxl_free(void *ptr, size_t size);
+void *cxl_malloc_on_node_pages(size_t size, int node, page_mode_t mode, size_t *actual_page_size);
+void cxl_free_pages(void *ptr, size_t size, page_mode_t mode);
+const char *cxl_page_mode_name(page_mode_t mode);
+int cxl_addr_to_node(const void *addr);     /* 地址所在节点（按页缓存），未知返回 -1 */
+void cxl_addr_node_invalidate(void);        /* 页迁移后使所有线程的页 -> 节点缓存失效 */
 int cxl_bind_to_cpu(int cpu_id);
 int cxl_bind_to_node(int node_id);
 
+/* ====== sysfs 辅助函数 ====== */
+int cxl_read_sysfs_line(const char *path, char *buf, size_t size);    /* 读取首行并去掉换行，文件不存在返回 -1 */
+
 /* ====== 日志函数 ====== */
 void cxl_log_info(const char *format, ...);
 void cxl_log_error(const char *format, ...);
@@ -0,0 +1,157 @@
+#ifndef CXL_HISTOGRAM_H
+#define CXL_HISTOGRAM_H
+
+#include "cxl_common.h"
+
+/* ====== 对数-线性（HdrHistogram 风格）延迟直方图 ====== */
+
+/*
+ * 每个 2 的幂区间再细分为 CXL_HIST_SUB_BUCKET_COUNT / 2 个线性子桶，
+ * 相对误差上限为 2 / CXL_HIST_SUB_BUCKET_COUNT（7 位时约 1.6%），
+ * 小于 CXL_HIST_SUB_BUCKET_COUNT 的值精确记录。
+ * 覆盖整个 uint64_t 范围，内存占用固定（约 30 KB），记录为 O(1)。
+ */
+#define CXL_HIST_SUB_BUCKET_BITS    7
+#define CXL_HIST_SUB_BUCKET_COUNT   (1 << CXL_HIST_SUB_BUCKET_BITS)
+#define CXL_HIST_SUB_BUCKET_HALF    (CXL_HIST_SUB_BUCKET_COUNT / 2)
+#define CXL_HIST_NUM_BUCKETS        ((64 - CXL_HIST_SUB_BUCKET_BITS) * CXL_HIST_SUB_BUCKET_HALF + \
+                                     CXL_HIST_SUB_BUCKET_COUNT)
+
+/* ====== 直方图结构 ====== */
+typedef struct {
+    uint64_t total_count;       /* 样本总数 */
+    uint64_t min_value;         /* 精确最小值 */
+    uint64_t max_value;         /* 精确最大值 */
+    uint64_t sum;               /* 精确累加和（用于均值） */
+    uint64_t counts[CXL_HIST_NUM_BUCKETS];
+} cxl_histogram_t;
+
+/* ====== 内联函数：值到桶索引的映射 ====== */
+static inline int cxl_histogram_bucket_index(uint64_t value) {
+    if (value < CXL_HIST_SUB_BUCKET_COUNT) {
+        return (int)value;
+    }
+    
+    int msb = 63 - __builtin_clzll(value);
+    int exponent = msb - CXL_HIST_SUB_BUCKET_BITS + 1;
+    
+    return exponent * CXL_HIST_SUB_BUCKET_HALF + (int)(value >> exponent);
+}
+
+/* ====== 内联函数：O(1) 记录单个样本 ====== */
+static inline void cxl_histogram_record(cxl_histogram_t *hist, uint64_t value) {
+    hist->counts[cxl_histogram_bucket_index(value)]++;
+    hist->total_count++;
+    hist->sum += value;
+    if (value < hist->min_value) hist->min_value = value;
+    if (value > hist->max_value) hist->max_value = value;
+}
+
+/**
+ * @brief 初始化（清空）直方图
+ * @param hist 直方图指针
+ */
+void cxl_histogram_init(cxl_histogram_t *hist);
+
+/**
+ * @brief 在堆上创建并初始化直方图
+ * @return 直方图指针，失败返回 NULL
+ */
+cxl_histogram_t *cxl_histogram_create(void);
+
+/**
+ * @brief 释放由 cxl_histogram_create 创建的直方图
+ * @param hist 直方图指针
+ */
+void cxl_histogram_destroy(cxl_histogram_t *hist);
+
+/**
+ * @brief 记录同一个值 count 次
+ * @param hist 直方图指针
+ * @param value 样本值（cycles）
+ * @param count 重复次数
+ */
+void cxl_histogram_record_n(cxl_histogram_t *hist, uint64_t value, uint64_t count);
+
+/**
+ * @brief 批量记录样本数组
+ * @param hist 直方图指针
+ * @param samples 样本数组
+ * @param num_samples 样本数量
+ * @return 0 成功，-1 失败
+ */
+int cxl_histogram_record_array(cxl_histogram_t *hist, const uint64_t *samples, size_t num_samples);
+
+/**
+ * @brief 合并直方图（用于汇总各线程的结果）
+ * @param dst 目标直方图
+ * @param src 源直方图
+ * @return 0 成功，-1 失败
+ */
+int cxl_histogram_merge(cxl_histogram_t *dst, const cxl_histogram_t *src);
+
+/**
+ * @brief 桶所代表的最小值
+ * @param index 桶索引
+ * @return 桶内最小等价值
+ */
+uint64_t cxl_histogram_bucket_lowest(int index);
+
+/**
+ * @brief 桶所代表的最大值
+ * @param index 桶索引
+ * @return 桶内最大等价值
+ */
+uint64_t cxl_histogram_bucket_highest(int index);
+
+/**
+ * @brief 查询单个分位数
+ * @param hist 直方图指针
+ * @param quantile 分位数（0-1 范围）
+ * @return 分位数对应的值（桶内最大等价值，限制在 [min, max] 内），空直方图返回 0
+ */
+uint64_t cxl_histogram_quantile(const cxl_histogram_t *hist, double quantile);
+
+/**
+ * @brief 一次遍历查询多个分位数
+ * @param hist 直方图指针
+ * @param quantiles 分位数数组（0-1 范围，任意顺序）
+ * @param num_quantiles 分位数数量
+ * @param values 返回的分位数值
+ * @return 0 成功，-1 失败
+ */
+int cxl_histogram_quantiles(const cxl_histogram_t *hist, const double *quantiles,
+                            int num_quantiles, uint64_t *values);
+
+/**
+ * @brief 计算平均值（精确）
+ * @param hist 直方图指针
+ * @return 平均值，空直方图返回 0
+ */
+double cxl_histogram_mean(const cxl_histogram_t *hist);
+
+/**
+ * @brief 计算标准差（按桶中点近似）
+ * @param hist 直方图指针
+ * @return 标准差，空直方图返回 0
+ */
+double cxl_histogram_stddev(const cxl_histogram_t *hist);
+
+/**
+ * @brief 打印直方图摘要（min/max/mean/p50/p90/p99/p99.9/p99.99）
+ * @param hist 直方图指针
+ * @param label 数据标签
+ */
+void cxl_histogram_print_summary(const cxl_histogram_t *hist, const char *label);
+
+/**
+ * @brief 将非空桶导出为 CSV（bucket_low,bucket_high,count）
+ * @param hist 直方图指针
+ * @param label 数据标签
+ * @param output_file 输出文件路径
+ * @return 0 成功，-1 失败
+ */
+int cxl_histogram_export_csv(const cxl_histogram_t *hist, const char *label,
+                             const char *output_file);
+
+#endif /* CXL_HISTOGRAM_H */
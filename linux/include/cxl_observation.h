@@ -2,13 +2,117 @@
 #define CXL_OBSERVATION_H
 
 #include "cxl_common.h"
+#include "cxl_histogram.h"
+#include "cxl_perf.h"
+
+/* ====== 每线程样本环形缓冲区 ====== */
+
+/*
+ * 每个生产者线程拥有一个单生产者/单消费者环形缓冲区（首次记录时在该线程所在的
+ * NUMA 节点上分配），写入只有一次 release store，不加锁、不调用回调、不做 I/O。
+ * 线程退出时缓冲区退役，其中的样本排空后由下一个新线程复用（优先复用同一节点上的缓冲区），
+ * CXL_OBS_MAX_RINGS 限制的是同时存在的生产者线程数。
+ * 后台排空线程批量把样本交给输出端（文件、直方图或批量回调）；
+ * 未启动排空线程时，可以用 peek/release 零拷贝地直接读取环形缓冲区。
+ */
+#define CXL_OBS_MAX_RINGS           64      /* 同时存在的生产者线程数上限 */
+#define CXL_OBS_RING_MIN_SLOTS      4096
+#define CXL_OBS_DRAIN_INTERVAL_US   1000    /* 所有缓冲区都为空时排空线程的休眠间隔 */
+
+typedef struct {
+    /* 生产者独占 */
+    uint64_t head __attribute__((aligned(CXL_CACHE_LINE_SIZE)));  /* 下一个写入位置 */
+    uint64_t cached_tail;                           /* 生产者看到的 tail 副本 */
+    uint64_t dropped;                               /* 缓冲区满而丢弃的样本数 */
+    
+    /* 消费者独占 */
+    uint64_t tail __attribute__((aligned(CXL_CACHE_LINE_SIZE)));  /* 下一个读取位置 */
+    
+    /* 只读 */
+    observation_data_t *slots __attribute__((aligned(CXL_CACHE_LINE_SIZE)));
+    uint64_t mask;                                  /* 槽位数 - 1（槽位数为 2 的幂） */
+    size_t alloc_size;
+    int node;                                       /* 缓冲区所在 NUMA 节点 */
+    int cpu;                                        /* 注册时生产者所在 CPU */
+    int retired;                                    /* 生产者线程已退出，排空后可被新线程复用 */
+} cxl_obs_ring_t;
+
+/* ====== 内联函数：写入一个样本（仅限拥有该缓冲区的线程） ====== */
+static inline int cxl_obs_ring_push(cxl_obs_ring_t *ring, const observation_data_t *data) {
+    uint64_t head = ring->head;
+    
+    if (head - ring->cached_tail > ring->mask) {
+        ring->cached_tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        if (head - ring->cached_tail > ring->mask) {
+            __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+            return -1;
+        }
+    }
+    
+    ring->slots[head & ring->mask] = *data;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    
+    return 0;
+}
+
+/* ====== 排空输出端 ====== */
+typedef enum {
+    OBS_SINK_FILE,              /* 将 access_time 写入二进制样本文件（cxl_trace） */
+    OBS_SINK_HISTOGRAM,         /* 将 access_time 记录到直方图 */
+    OBS_SINK_CALLBACK           /* 批量回调 */
+} obs_sink_type_t;
+
+typedef void (*observation_batch_callback_t)(const observation_data_t *data, size_t count, void *ctx);
+
+typedef struct {
+    obs_sink_type_t type;
+    const char *path;                       /* OBS_SINK_FILE */
+    cxl_histogram_t *hist;                  /* OBS_SINK_HISTOGRAM，排空线程停止前不要读取 */
+    observation_batch_callback_t callback;  /* OBS_SINK_CALLBACK，在排空线程中调用 */
+    void *ctx;
+} obs_sink_t;
+
+/* ====== 缓冲区统计 ====== */
+typedef struct {
+    int num_rings;
+    uint64_t produced;          /* 写入缓冲区的样本数 */
+    uint64_t consumed;          /* 已被排空线程或读取接口取走的样本数 */
+    uint64_t dropped;           /* 缓冲区满而丢弃的样本数 */
+} obs_buffer_stats_t;
+
+/* ====== 实时监测（绑核忙轮询，TSC 截止时间节拍） ====== */
+#define CXL_OBS_REALTIME_DEFAULT_RATE   1000        /* Hz，cxl_observe_realtime_start 使用 */
+#define CXL_OBS_REALTIME_MAX_RATE       10000000    /* Hz */
+#define CXL_OBS_REALTIME_MAX_TARGETS    256
+
+/* ====== 访问痕迹（perf mem 采样） ====== */
+#define CXL_OBS_TRACE_WINDOW_US         100000      /* 默认采样窗口 */
+#define CXL_OBS_TRACE_DRAIN_US          10000       /* 窗口内排空环形缓冲区的间隔 */
+
+typedef struct {
+    void **targets;             /* 目标地址数组，每个节拍按轮转顺序探测一个 */
+    int num_targets;
+    uint64_t rate_hz;           /* 总采样率（每秒探测次数），每个目标为 rate_hz / num_targets */
+    int cpu;                    /* 采样线程绑定的 CPU，-1 表示不绑定 */
+    int flush_after_probe;      /* 探测后 clflush 目标（Flush+Reload：命中即表示其他核访问过） */
+} realtime_params_t;
+
+typedef struct {
+    uint64_t samples;           /* 已采集的样本数 */
+    uint64_t dropped;           /* 环形缓冲区满而丢弃的样本数 */
+    uint64_t missed_deadlines;  /* 因落后超过一个周期而跳过的节拍数 */
+    uint64_t max_lateness;      /* 节拍实际开始时间相对截止时间的最大延后（cycles） */
+    uint64_t period_cycles;     /* 节拍周期（cycles） */
+    double achieved_rate_hz;    /* 实际采样率 */
+} realtime_stats_t;
 
 /* ====== 侧信道观测接口 ====== */
 
 /**
  * @brief 初始化观测模块
  * @param observation_type 观测类型（时间/模式/痕迹）
- * @param buffer_size 缓冲区大小
+ * @param buffer_size 每个线程环形缓冲区的字节数（按 2 的幂个样本向下取整，
+ *                    不少于 CXL_OBS_RING_MIN_SLOTS 个样本）
  * @return 0 成功，-1 失败
  */
 int cxl_observation_init(observation_type_t observation_type, size_t buffer_size);
@@ -22,6 +126,15 @@ int cxl_observation_init(observation_type_t observation_type, size_t buffer_size
  */
 int cxl_observe_access_timing(void *addr, int num_samples, uint64_t *samples);
 
+/**
+ * @brief 流式观测内存访问时间（直接写入直方图，内存占用恒定）
+ * @param addr 要观测的内存地址
+ * @param num_samples 样本数量（可远超内存可容纳的样本数组）
+ * @param hist 累加样本的直方图（不会被清空，可跨多次调用/线程合并）
+ * @return 0 成功，-1 失败
+ */
+int cxl_observe_access_timing_hist(void *addr, uint64_t num_samples, cxl_histogram_t *hist);
+
 /**
  * @brief 观测缓存命中/未命中模式
  * @param addrs 观测地址数组
@@ -35,15 +148,32 @@ int cxl_observe_cache_pattern(void **addrs, int num_addrs, int num_probes,
 
 /**
  * @brief 观测内存访问痕迹（哪些地址被访问）
- * @param addr_range_start 观测范围起始地址
- * @param addr_range_size 范围大小
- * @param num_traces 返回的访问痕迹数据
- * @param traces 访问痕迹数据（相对偏移量）
- * @return 实际捕获的访问痕迹数
+ *
+ * 在 CXL_OBS_TRACE_WINDOW_US 窗口内对调用进程的所有线程做 perf mem 加载采样，返回落在范围内
+ * 的样本地址；不支持 perf mem 采样时退回一个空闲页跟踪间隔（见 cxl_profiler.h），按页返回。
+ * @param addr_range_start 观测范围起始地址（调用进程内）
+ * @param addr_range_size 范围大小（不超过 4 GiB）
+ * @param num_traces 输入为 traces 的容量，返回实际捕获的痕迹数
+ * @param traces 访问痕迹数据（相对范围起始地址的字节偏移量）
+ * @return 实际捕获的访问痕迹数，两种痕迹来源都不可用时返回 -1
  */
 int cxl_observe_access_trace(void *addr_range_start, size_t addr_range_size,
                              int *num_traces, uint32_t *traces);
 
+/**
+ * @brief 采样范围内的内存加载，样本带地址、加载延迟与数据来源
+ *
+ * PMU 报告为本地/远端内存、而地址所在节点为 CXL（或无 CPU）节点的样本，来源改记为 CXL_MEM_SRC_CXL。
+ * @param addr_range_start 观测范围起始地址（调用进程内）
+ * @param addr_range_size 范围大小
+ * @param window_us 采样窗口（微秒），0 使用 CXL_OBS_TRACE_WINDOW_US
+ * @param samples 返回的样本数组
+ * @param max_samples 数组容量（装满后提前结束）
+ * @return 样本数，不支持 perf mem 采样时返回 -1
+ */
+int cxl_observe_access_samples(void *addr_range_start, size_t addr_range_size, uint32_t window_us,
+                               cxl_mem_sample_t *samples, int max_samples);
+
 /**
  * @brief 高精度时间戳采集
  * @param samples 返回的采样数组
@@ -131,14 +261,34 @@ int cxl_observe_detect_anomalies(const uint64_t *samples, int num_samples,
  * @brief 启动实时观测（后台线程）
  * @param target_addr 观测目标地址
  * @param observation_type 观测类型
- * @param callback 观测数据回调函数
+ * @param callback 观测数据回调函数（在排空线程中逐个样本调用，不占用采样线程）
  * @return 0 成功，-1 失败
+ * @note 单目标、CXL_OBS_REALTIME_DEFAULT_RATE、不绑核的 cxl_observe_realtime_start_ex；
+ *       未启动排空线程时自动以回调输出端启动，停止观测时一并停止
  */
 typedef void (*observation_callback_t)(const observation_data_t *data, void *ctx);
 
 int cxl_observe_realtime_start(void *target_addr, observation_type_t observation_type,
                                observation_callback_t callback, void *ctx);
 
+/**
+ * @brief 启动实时观测（绑核忙轮询，多目标，可配置采样率）
+ * @param params 监测参数
+ * @param callback 观测数据回调函数（在排空线程中调用），可为 NULL（样本留在环形缓冲区中，
+ *                 由已运行的排空线程或 peek/get_data 读取）
+ * @param ctx 回调上下文
+ * @return 0 成功，-1 失败
+ */
+int cxl_observe_realtime_start_ex(const realtime_params_t *params,
+                                  observation_callback_t callback, void *ctx);
+
+/**
+ * @brief 获取实时观测统计（运行中或停止后均可调用）
+ * @param stats 返回的统计
+ * @return 0 成功，-1 失败
+ */
+int cxl_observe_realtime_get_stats(realtime_stats_t *stats);
+
 /**
  * @brief 停止实时观测
  * @return 0 成功，-1 失败
@@ -146,16 +296,73 @@ int cxl_observe_realtime_start(void *target_addr, observation_type_t observation
 int cxl_observe_realtime_stop(void);
 
 /**
- * @brief 清空观测缓冲区
+ * @brief 获取当前线程的环形缓冲区（首次调用时在本地 NUMA 节点上分配并注册）
+ * @return 缓冲区指针，失败返回 NULL
+ */
+cxl_obs_ring_t *cxl_observation_thread_ring(void);
+
+/**
+ * @brief 将一个样本写入当前线程的环形缓冲区
+ * @param data 样本
+ * @return 0 成功，-1 缓冲区已满（计入 dropped）或未初始化
+ */
+int cxl_observation_record(const observation_data_t *data);
+
+/**
+ * @brief 启动后台排空线程
+ * @param sink 输出端
+ * @param cpu 排空线程绑定的 CPU，-1 表示不绑定
+ * @return 0 成功，-1 失败
+ */
+int cxl_observation_drain_start(const obs_sink_t *sink, int cpu);
+
+/**
+ * @brief 停止排空线程（先排空所有缓冲区中剩余的样本）
+ * @return 0 成功，-1 失败
+ */
+int cxl_observation_drain_stop(void);
+
+/**
+ * @brief 获取已注册的环形缓冲区数量
+ * @return 缓冲区数量
+ */
+int cxl_observation_num_rings(void);
+
+/**
+ * @brief 零拷贝读取：返回缓冲区中最早的一段连续样本（不移动读取位置）
+ * @param ring_id 缓冲区编号（0 到 cxl_observation_num_rings() - 1）
+ * @param data 返回指向缓冲区内部的样本指针
+ * @param count 返回连续样本数（到缓冲区末尾回绕处为止）
+ * @return 0 成功，-1 失败（排空线程运行时不可用）
+ */
+int cxl_observation_peek(int ring_id, const observation_data_t **data, size_t *count);
+
+/**
+ * @brief 零拷贝读取：归还已处理的样本
+ * @param ring_id 缓冲区编号
+ * @param count 归还的样本数（不超过 peek 返回的数量）
+ * @return 0 成功，-1 失败（排空线程运行时不可用）
+ */
+int cxl_observation_release(int ring_id, size_t count);
+
+/**
+ * @brief 获取缓冲区统计
+ * @param stats 返回的统计
+ * @return 0 成功，-1 失败
+ */
+int cxl_observation_get_stats(obs_buffer_stats_t *stats);
+
+/**
+ * @brief 清空观测缓冲区（丢弃所有未读取的样本）
  * @return 0 成功，-1 失败
  */
 int cxl_observation_clear_buffer(void);
 
 /**
- * @brief 获取观测缓冲区中的数据
- * @param buffer 返回的数据缓冲
- * @param buffer_size 缓冲大小
- * @return 返回的数据大小
+ * @brief 取出观测缓冲区中的数据（依次读取各线程缓冲区，已取出的样本被消费）
+ * @param buffer 返回的 observation_data_t 数组
+ * @param buffer_size 缓冲大小（字节）
+ * @return 返回的数据大小（字节，整数个样本），-1 失败
  */
 int cxl_observation_get_data(void *buffer, size_t buffer_size);
 
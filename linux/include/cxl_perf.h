@@ -0,0 +1,204 @@
+#ifndef CXL_PERF_H
+#define CXL_PERF_H
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "cxl_common.h"
+
+/* ====== 硬件计数器 ====== */
+
+/*
+ * 每个绑核线程用 perf_event_open 打开一个计数器组（以 cycles 为组长，只计用户态），
+ * 组内事件同时调度，读数可以相互比较。计数器页 mmap 到用户态后用 rdpmc 直接读取，
+ * 包围一个实验阶段只需两次读取而不进入内核；计数器暂时未调度时退回 read()。
+ *
+ * PMU 不可用（虚拟机未透传、perf_event_paranoid 过高、事件不存在）时不报错：
+ * 组长打不开则整组为空，单个成员打不开则只缺该事件，计数结果用 valid 位标记。
+ */
+
+typedef enum {
+    CXL_PERF_CYCLES,            /* 核心周期 */
+    CXL_PERF_INSTRUCTIONS,      /* 退休指令数 */
+    CXL_PERF_LLC_MISSES,        /* LLC 读未命中 */
+    CXL_PERF_DTLB_MISSES,       /* dTLB 读未命中 */
+    CXL_PERF_REMOTE_LOADS,      /* 由远端节点内存提供的退休加载（仅 Intel） */
+    CXL_PERF_NUM_EVENTS
+} cxl_perf_event_t;
+
+/* ====== 计数器组（每线程一个，只能在打开它的线程上读取） ====== */
+typedef struct {
+    int fds[CXL_PERF_NUM_EVENTS];           /* -1 表示未打开 */
+    void *pages[CXL_PERF_NUM_EVENTS];       /* 计数器页，rdpmc 读取用 */
+    uint32_t valid;                         /* 已打开事件的位掩码 */
+} cxl_perf_t;
+
+/* ====== 计数值 ====== */
+typedef struct {
+    uint64_t value[CXL_PERF_NUM_EVENTS];
+    uint32_t valid;                         /* 有效事件的位掩码，0 表示 PMU 不可用 */
+} cxl_perf_counts_t;
+
+/**
+ * @brief 为调用线程打开计数器组（应在绑核之后调用）
+ * @param perf 计数器组
+ * @return 打开的事件数，PMU 不可用时返回 0（首次失败时打印一次原因）
+ */
+int cxl_perf_open(cxl_perf_t *perf);
+
+/**
+ * @brief 关闭计数器组（全零初始化、从未打开的结构也可以关闭）
+ * @param perf 计数器组
+ */
+void cxl_perf_close(cxl_perf_t *perf);
+
+/**
+ * @brief 读取当前计数（rdpmc，不进入内核）
+ * @param perf 计数器组
+ * @param counts 返回的计数
+ */
+void cxl_perf_read(const cxl_perf_t *perf, cxl_perf_counts_t *counts);
+
+/**
+ * @brief 计算两次读取之间的增量
+ * @param end 阶段结束时的读数
+ * @param start 阶段开始时的读数
+ * @param delta 返回的增量（valid 取两者交集）
+ */
+void cxl_perf_diff(const cxl_perf_counts_t *end, const cxl_perf_counts_t *start,
+                   cxl_perf_counts_t *delta);
+
+/**
+ * @brief 累加增量（用于合并多个轮次或线程）
+ * @param total 累加结果，valid 为 0 时采用 delta 的 valid，否则取交集
+ * @param delta 增量
+ */
+void cxl_perf_accumulate(cxl_perf_counts_t *total, const cxl_perf_counts_t *delta);
+
+/**
+ * @brief 打印计数与派生指标（IPC、每次操作的未命中数）
+ * @param counts 计数
+ * @param label 标签
+ * @param num_ops 阶段内的操作数（用于归一化），0 表示不归一化
+ */
+void cxl_perf_print(const cxl_perf_counts_t *counts, const char *label, uint64_t num_ops);
+
+/**
+ * @brief 获取事件名称
+ * @param event 事件
+ * @return 名称字符串
+ */
+const char *cxl_perf_event_name(cxl_perf_event_t event);
+
+/**
+ * @brief 写出计数器的 CSV 列名（每个事件一列，每列前带逗号，接在已有列之后）
+ * @param file 输出文件
+ * @param prefix 列名前缀（如 "before_"），NULL 表示无前缀
+ */
+void cxl_perf_csv_header(FILE *file, const char *prefix);
+
+/**
+ * @brief 写出与 cxl_perf_csv_header 对应的计数值（无效事件留空）
+ * @param file 输出文件
+ * @param counts 计数
+ */
+void cxl_perf_csv_row(FILE *file, const cxl_perf_counts_t *counts);
+
+/* ====== 内存加载采样（perf mem） ====== */
+
+/*
+ * 精确采样退休的加载指令（Intel PEBS 加载延迟事件 mem-loads，AMD 为 IBS op），每个样本带
+ * 数据地址、加载延迟（weight）与数据来源（perf_mem_data_src）。样本经 mmap 环形缓冲区读取，不经过 read()。
+ *
+ * mem-loads 对目标进程的每个现有线程打开一个事件（inherit，之后创建的线程写入父事件的缓冲区）；
+ * PMU 提供 mem-loads-aux 时（Sapphire Rapids 起、混合架构的 cpu_core）以它为组长。
+ * IBS 不接受按任务的事件，也不接受任何 exclude_* 位，因此在目标进程任一线程允许运行的每个 CPU 上
+ * 打开系统范围事件，读取时按进程号过滤并只保留加载；需要 perf_event_paranoid <= 0 或 CAP_PERFMON。
+ */
+#define CXL_MEM_SAMPLER_MAX_EVENTS      256         /* 线程数（mem-loads）或 CPU 数（IBS）上限 */
+#define CXL_MEM_SAMPLER_RING_PAGES      64          /* 每个事件的数据页数（2 的幂） */
+#define CXL_MEM_SAMPLER_DEFAULT_PERIOD  1000        /* 每 N 个符合条件的加载采一个样本 */
+#define CXL_MEM_SAMPLER_DEFAULT_LDLAT   30          /* Intel：只采延迟不低于该值（cycles）的加载 */
+
+/* ====== 数据来源 ====== */
+typedef enum {
+    CXL_MEM_SRC_UNKNOWN,        /* PMU 未给出来源 */
+    CXL_MEM_SRC_L1,             /* L1 或行填充缓冲区 */
+    CXL_MEM_SRC_L2,
+    CXL_MEM_SRC_LLC,            /* 本地 L3/L4 */
+    CXL_MEM_SRC_LOCAL_DRAM,
+    CXL_MEM_SRC_REMOTE,         /* 远端节点的缓存或内存 */
+    CXL_MEM_SRC_CXL,            /* CXL 内存（PMU 直接报告，或由地址所在节点判定） */
+    CXL_MEM_SRC_COUNT
+} cxl_mem_source_t;
+
+/* ====== 解码后的样本 ====== */
+typedef struct {
+    uint64_t addr;              /* 数据虚拟地址 */
+    uint64_t weight;            /* 加载延迟（cycles，由 PMU 报告） */
+    uint64_t data_src;          /* 原始 perf_mem_data_src */
+    uint32_t tid;               /* 执行加载的线程 */
+    cxl_mem_source_t source;    /* 解码后的数据来源 */
+} cxl_mem_sample_t;
+
+/* ====== 采样器 ====== */
+typedef struct {
+    int num_events;
+    int fds[CXL_MEM_SAMPLER_MAX_EVENTS];
+    int leader_fds[CXL_MEM_SAMPLER_MAX_EVENTS]; /* mem-loads-aux 组长，-1 表示没有 */
+    void *rings[CXL_MEM_SAMPLER_MAX_EVENTS];    /* 元数据页 + 数据页 */
+    pid_t filter_pid;           /* 系统范围事件（IBS）只保留该进程的样本，0 表示不过滤 */
+    int loads_only;             /* 只保留 data_src 中 mem_op 为加载的样本（IBS 标记任意 op） */
+    size_t ring_size;
+    uint64_t lost;              /* 内核因缓冲区满丢弃的样本数 */
+    uint64_t filtered;          /* 不在请求地址范围内（或不属于目标进程、不是加载）而丢弃的样本数 */
+} cxl_mem_sampler_t;
+
+/**
+ * @brief 检查本机是否支持内存加载采样（存在 mem-loads 事件或 IBS op PMU）
+ * @return 1 支持，0 不支持
+ */
+int cxl_mem_sampler_available(void);
+
+/**
+ * @brief 对目标进程打开内存加载采样（mem-loads 每线程一个事件，IBS 每 CPU 一个事件）
+ * @param sampler 采样器
+ * @param pid 目标进程，0 表示调用进程
+ * @param period 采样周期（0 使用 CXL_MEM_SAMPLER_DEFAULT_PERIOD）
+ * @param ldlat 加载延迟阈值（cycles，0 使用 CXL_MEM_SAMPLER_DEFAULT_LDLAT；AMD 忽略）
+ * @return 打开的事件数，不可用时返回 -1（打印一次原因）
+ */
+int cxl_mem_sampler_open(cxl_mem_sampler_t *sampler, pid_t pid, uint64_t period, uint32_t ldlat);
+
+/**
+ * @brief 取出环形缓冲区中的样本，只保留地址在 [lo, hi) 内的样本
+ * @param sampler 采样器
+ * @param lo 地址下界
+ * @param hi 地址上界（不含）
+ * @param samples 返回的样本数组
+ * @param max_samples 数组容量（装满后剩余样本留在缓冲区中）
+ * @return 返回的样本数
+ */
+int cxl_mem_sampler_read(cxl_mem_sampler_t *sampler, uint64_t lo, uint64_t hi,
+                         cxl_mem_sample_t *samples, int max_samples);
+
+/**
+ * @brief 关闭采样器
+ * @param sampler 采样器
+ */
+void cxl_mem_sampler_close(cxl_mem_sampler_t *sampler);
+
+/**
+ * @brief 把 perf_mem_data_src 解码为数据来源（优先使用 mem_lvl_num，旧内核退回 mem_lvl 位）
+ * @param data_src 原始数据来源
+ * @return 数据来源
+ */
+cxl_mem_source_t cxl_mem_decode_source(uint64_t data_src);
+
+/**
+ * @brief 获取数据来源名称
+ * @param source 数据来源
+ * @return 名称字符串
+ */
+const char *cxl_mem_source_name(cxl_mem_source_t source);
+
+#endif /* CXL_PERF_H */
@@ -12,6 +12,65 @@
  */
 int cxl_config_init(cxl_config_t *config);
 
+/* ====== 配置文件 ====== */
+
+/*
+ * INI 格式，键为 "节.名称"，也可在 [节] 下只写名称：
+ *   [numa]      normal_node, cxl_node
+ *   [placement] thread (cross_core|different_thread|same_thread), data (normal|cxl|local)
+ *   [cpu]       attacker, victim, probe, monitor, workers (cpulist，如 "4-7,12")
+ *   [system]    prefetcher, isolcpus (0/1/true/false/yes/no/on/off)
+ *   [run]       iterations, warmup_iterations, sample_size
+ *   [buffer]    test_size (K/M/G 后缀), page_size (4k|thp|2m|1g)
+ * 每个键都可以用环境变量覆盖：CXL_<节>_<名称>（大写），如 CXL_CPU_ATTACKER=3。
+ */
+#define CXL_CONFIG_ENV_FILE         "CXL_CONFIG"    /* 未指定配置名时使用的配置文件路径 */
+#define CXL_CONFIG_ENV_PREFIX       "CXL_"
+#define CXL_CONFIG_DIR              "configs"       /* 按名称查找 <CXL_CONFIG_DIR>/<name>.ini */
+#define CXL_CONFIG_LINE_MAX         1024
+
+/**
+ * @brief 设置单个配置项
+ * @param config 框架配置
+ * @param key 键（"节.名称"，如 "cpu.attacker"）
+ * @param value 值字符串
+ * @return 0 成功，-1 未知键或值非法
+ */
+int cxl_config_set(cxl_config_t *config, const char *key, const char *value);
+
+/**
+ * @brief 从 INI 文件加载配置（文件中未出现的键保持原值）
+ * @param config 框架配置（通常先用 cxl_config_init 填充默认值）
+ * @param path 文件路径
+ * @return 0 成功，-1 失败（错误信息包含行号）
+ */
+int cxl_config_load(cxl_config_t *config, const char *path);
+
+/**
+ * @brief 应用环境变量覆盖（CXL_<节>_<名称>）
+ * @param config 框架配置
+ * @return 应用的覆盖数，值非法时返回 -1
+ */
+int cxl_config_apply_env(cxl_config_t *config);
+
+/**
+ * @brief 把配置名解析为文件路径
+ * @param config_name 配置名：NULL 或 "default" 时使用 CXL_CONFIG 环境变量；
+ *                    否则先按路径查找，再查找 configs/<name>.ini
+ * @param path 返回的路径
+ * @param size 缓冲区大小
+ * @return 1 找到文件，0 使用内置默认值，-1 指定的配置不存在
+ */
+int cxl_config_resolve(const char *config_name, char *path, size_t size);
+
+/**
+ * @brief 以 INI 格式保存配置（可作为 cxl_config_load 的输入，用于复现实验）
+ * @param config 框架配置
+ * @param path 文件路径
+ * @return 0 成功，-1 失败
+ */
+int cxl_config_save(const cxl_config_t *config, const char *path);
+
 /**
  * @brief 设置 NUMA 节点配置
  * @param config 框架配置
@@ -93,8 +152,8 @@ int cxl_validate_config(const cxl_config_t *config);
 int cxl_check_system_support(void);
 
 /**
- * @brief 获取 CXL Memory 节点信息
- * @return 节点 ID，失败返回 -1
+ * @brief 获取 CXL Memory 节点（由 cxl_topology 从 sysfs 探测）
+ * @return 节点 ID，未检测到 CXL 节点返回 -1
  */
 int cxl_get_cxl_node(void);
 
@@ -0,0 +1,118 @@
+#ifndef CXL_PROFILER_H
+#define CXL_PROFILER_H
+
+#include <sys/types.h>
+#include "cxl_common.h"
+
+/* ====== 页访问频率分析（冷热页分层） ====== */
+
+/*
+ * 采样源为空闲页跟踪（/sys/kernel/mm/page_idle/bitmap）：每个采样间隔开始时
+ * 从 /proc/<pid>/pagemap 取得区域内各页的 PFN 并把它们标记为空闲，间隔结束时
+ * 重新读取位图，空闲位被清除的页即在间隔内被访问过。页的访问频率为被访问的
+ * 间隔数（0 到 num_intervals），访问频率不低于阈值的页为热页。
+ *
+ * 需要 CONFIG_IDLE_PAGE_TRACKING 与 CAP_SYS_ADMIN（pagemap 中的 PFN 和位图都只对特权进程可见）；
+ * 分析其他进程还需要对其有 ptrace 权限。只跟踪位于 LRU 上的用户页：标记前按 PFN 查
+ * /proc/kpageflags 的 KPF_LRU，不在 LRU 上的页本间隔不参与统计。页大小按基础页计算，透明大页的各个基础页共享同一访问位。
+ */
+#define CXL_PROF_MAX_INTERVALS          255
+#define CXL_PROF_DEFAULT_INTERVAL_US    100000      /* 100 ms */
+#define CXL_PROF_DEFAULT_INTERVALS      20
+#define CXL_PROF_DEFAULT_HOT_FRACTION   0.5
+
+/* ====== 页分类 ====== */
+typedef enum {
+    PAGE_CLASS_UNMAPPED,        /* 所有间隔内都不在内存中（未缺页或已换出）或不可跟踪（不在 LRU 上） */
+    PAGE_CLASS_COLD,            /* 访问频率低于阈值 */
+    PAGE_CLASS_HOT              /* 访问频率不低于阈值 */
+} page_class_t;
+
+/* ====== 分析参数 ====== */
+typedef struct {
+    pid_t pid;                  /* 目标进程，0 表示调用进程 */
+    uintptr_t start;            /* 目标进程中的虚拟地址区域（按页向外对齐） */
+    size_t size;
+    uint32_t interval_us;       /* 采样间隔（微秒） */
+    uint32_t num_intervals;     /* 采样间隔数（不超过 CXL_PROF_MAX_INTERVALS） */
+    double hot_fraction;        /* 被访问间隔占比不低于该值的页为热页 */
+} page_profile_params_t;
+
+/* ====== 分析结果 ====== */
+typedef struct {
+    pid_t pid;
+    uintptr_t start;            /* 对齐后的区域起始地址 */
+    size_t page_size;           /* 基础页大小 */
+    uint64_t num_pages;
+    uint32_t num_intervals;     /* 实际完成的采样间隔数 */
+    uint32_t hot_threshold;     /* 热页的最低访问频率（间隔数） */
+    uint8_t *counts;            /* 每页的访问频率 */
+    uint8_t *present;           /* 每页是否至少在一个间隔内位于内存中且可跟踪 */
+    int *nodes;                 /* 每页最后一次所在的 NUMA 节点，未知为 -1 */
+    uint64_t freq_hist[CXL_PROF_MAX_INTERVALS + 1]; /* 访问频率直方图（只含驻留页） */
+    uint64_t num_hot;
+    uint64_t num_cold;
+    uint64_t num_unmapped;
+} page_profile_t;
+
+/**
+ * @brief 检查空闲页跟踪是否可用（位图存在且可读写）
+ * @return 1 可用，0 不可用
+ */
+int cxl_profile_available(void);
+
+/**
+ * @brief 对目标进程的一段地址区域做页访问频率分析
+ * @param params 分析参数
+ * @param profile 返回的结果（数组由本函数分配，用 cxl_profile_free 释放）
+ * @return 0 成功，-1 失败
+ */
+int cxl_profile_pages(const page_profile_params_t *params, page_profile_t *profile);
+
+/**
+ * @brief 找到目标进程最大的私有可写匿名映射（堆或大块 mmap），作为默认分析区域
+ * @param pid 目标进程，0 表示调用进程
+ * @param start 返回区域起始地址
+ * @param size 返回区域大小
+ * @return 0 成功，-1 失败
+ */
+int cxl_profile_find_region(pid_t pid, uintptr_t *start, size_t *size);
+
+/**
+ * @brief 获取一页的分类
+ * @param profile 分析结果
+ * @param page 页序号（0 到 num_pages - 1）
+ * @return 页分类
+ */
+page_class_t cxl_profile_page_class(const page_profile_t *profile, uint64_t page);
+
+/**
+ * @brief 获取页分类名称
+ * @param page_class 页分类
+ * @return 名称字符串（unmapped/cold/hot）
+ */
+const char *cxl_profile_class_name(page_class_t page_class);
+
+/**
+ * @brief 打印访问频率直方图，以及冷热页在各节点上的分布（位于 CXL 节点的热页为提升候选，
+ *        位于普通节点的冷页为降级候选）
+ * @param profile 分析结果
+ * @param cxl_node CXL 节点 ID，-1 表示不区分
+ */
+void cxl_profile_print(const page_profile_t *profile, int cxl_node);
+
+/**
+ * @brief 导出每页的访问频率、分类与所在节点（CSV）
+ * @param profile 分析结果
+ * @param filepath 输出文件路径
+ * @return 0 成功，-1 失败
+ */
+int cxl_profile_export_csv(const page_profile_t *profile, const char *filepath);
+
+/**
+ * @brief 释放分析结果中的数组
+ * @param profile 分析结果
+ */
+void cxl_profile_free(page_profile_t *profile);
+
+#endif /* CXL_PROFILER_H */
@@ -0,0 +1,88 @@
+#ifndef CXL_RUNNER_H
+#define CXL_RUNNER_H
+
+#include "cxl_common.h"
+#include "cxl_histogram.h"
+#include "cxl_perf.h"
+
+/* ====== 多核并行轮次运行器 ====== */
+
+/*
+ * 相互独立的测试轮次分发到一组绑核的工作线程上执行：轮次编号由原子计数器领取，
+ * 先完成的线程领取下一轮，因此各轮耗时不均时负载也能自动均衡。每个工作线程在自己
+ * CPU 所在的 NUMA 节点上分配暂存区与直方图累加器，轮次之间复用，运行结束后由调用
+ * 线程合并。逐轮结果由轮次回调按轮次编号写入调用者的数组，互不冲突，无需加锁。
+ * 每个工作线程绑核后打开自己的硬件计数器组（worker->perf），轮次回调用 cxl_perf_read
+ * 包围测量阶段；PMU 不可用时计数器组为空，读数的 valid 为 0。
+ */
+#define CXL_RUNNER_MAX_HISTS    4
+
+/* ====== 工作线程上下文（传给轮次回调） ====== */
+typedef struct {
+    int id;                     /* 工作线程编号 */
+    int cpu;                    /* 绑定的 CPU */
+    int node;                   /* CPU 所在 NUMA 节点，暂存区与累加器分配于此 */
+    void *scratch;              /* NUMA 本地暂存区，整个运行期间复用 */
+    size_t scratch_size;
+    cxl_histogram_t *hists[CXL_RUNNER_MAX_HISTS];   /* 本线程的直方图累加器 */
+    int num_hists;
+    cxl_perf_t perf;            /* 本线程的硬件计数器组 */
+    uint64_t rounds_done;       /* 成功完成的轮次 */
+    uint64_t rounds_failed;     /* 回调返回负值的轮次 */
+    int status;
+} runner_worker_t;
+
+/**
+ * @brief 轮次回调，在工作线程中执行
+ * @param worker 当前工作线程上下文
+ * @param round 轮次编号（0 起）
+ * @param arg 调用者参数
+ * @return 成功返回 0，失败返回 -1
+ */
+typedef int (*runner_round_fn_t)(runner_worker_t *worker, int round, void *arg);
+
+/* ====== 运行参数 ====== */
+typedef struct {
+    int num_rounds;             /* 总轮次 */
+    int num_workers;            /* 工作线程数（不超过轮次数与可用 CPU 数） */
+    int cpu_node;               /* 在此节点上选择 CPU，-1 表示任意节点 */
+    const int *cpus;            /* 显式 CPU 列表，非 NULL 时代替自动选择（忽略 cpu_node） */
+    int num_cpus;               /* cpus 中的 CPU 数，0 表示自动选择 */
+    size_t scratch_size;        /* 每个工作线程的暂存区字节数，0 表示不分配 */
+    int num_hists;              /* 每个工作线程的直方图数量 */
+    runner_round_fn_t round_fn;
+    void *arg;
+} runner_params_t;
+
+/* ====== 运行结果 ====== */
+typedef struct {
+    int num_workers;            /* 实际启动的工作线程数 */
+    int cpus[CXL_MAX_THREADS];  /* 各工作线程绑定的 CPU */
+    uint64_t rounds_done;
+    uint64_t rounds_failed;
+    double seconds;             /* 墙钟耗时 */
+    cxl_histogram_t *hists[CXL_RUNNER_MAX_HISTS];   /* 合并后的直方图 */
+    int num_hists;
+} runner_result_t;
+
+/**
+ * @brief 在绑核的工作线程池上并行执行所有轮次，并合并各线程的直方图
+ * @param params 运行参数
+ * @param result 输出结果，使用后调用 cxl_runner_result_free 释放
+ * @return 成功返回 0，失败返回 -1（部分轮次失败仍返回 0，见 rounds_failed）
+ */
+int cxl_runner_run(const runner_params_t *params, runner_result_t *result);
+
+/**
+ * @brief 释放运行结果中的合并直方图
+ * @param result 运行结果
+ */
+void cxl_runner_result_free(runner_result_t *result);
+
+/**
+ * @brief 打印运行摘要（线程数、CPU 列表、耗时）
+ * @param result 运行结果
+ */
+void cxl_runner_print_summary(const runner_result_t *result);
+
+#endif /* CXL_RUNNER_H */
@@ -0,0 +1,85 @@
+#ifndef CXL_STATS_H
+#define CXL_STATS_H
+
+#include "cxl_common.h"
+
+/* ====== 单遍统计内核 ====== */
+
+/*
+ * 样本按 CXL_STATS_BLOCK_SAMPLES 分块：每块先用 SIMD 整数指令求最小值、最大值和精确整数和，
+ * 再在块仍位于 L1 时以块均值为中心累加离差平方和（两遍都不再访问内存）。块结果按
+ * Chan 并行公式合并到运行中的 (count, mean, m2)，因此整个数组只从内存读一次，
+ * 且不会出现 E[x^2] - E[x]^2 的相消误差。
+ *
+ * 运行时按 CPU 支持选择 AVX-512 / AVX2 / 标量实现。SIMD 路径要求块内样本小于 2^52
+ * （按 3 GHz 计约 17 天的周期数），否则该块自动退回标量实现。
+ */
+#define CXL_STATS_BLOCK_SAMPLES     2048    /* 16 KiB，块内两遍扫描都命中 L1 */
+
+/* ====== 累加器 ====== */
+typedef struct {
+    uint64_t count;             /* 样本数 */
+    uint64_t min;               /* 最小值，count 为 0 时为 UINT64_MAX */
+    uint64_t max;               /* 最大值 */
+    double mean;                /* 平均值 */
+    double m2;                  /* 离均差平方和 */
+} cxl_stats_t;
+
+/**
+ * @brief 初始化累加器
+ * @param stats 累加器
+ */
+void cxl_stats_init(cxl_stats_t *stats);
+
+/**
+ * @brief 单遍累加一组样本（可多次调用，等价于对所有样本一次计算）
+ * @param stats 累加器
+ * @param samples 样本数组
+ * @param num_samples 样本数量
+ */
+void cxl_stats_update(cxl_stats_t *stats, const uint64_t *samples, size_t num_samples);
+
+/**
+ * @brief 合并两个累加器（用于多线程或分块处理）
+ * @param dst 目标累加器
+ * @param src 源累加器
+ */
+void cxl_stats_merge(cxl_stats_t *dst, const cxl_stats_t *src);
+
+/**
+ * @brief 初始化并累加一组样本
+ * @param samples 样本数组
+ * @param num_samples 样本数量
+ * @param stats 返回的统计结果
+ * @return 0 成功，-1 参数错误
+ */
+int cxl_stats_compute(const uint64_t *samples, size_t num_samples, cxl_stats_t *stats);
+
+/**
+ * @brief 总体方差（m2 / n）
+ * @param stats 累加器
+ * @return 方差，样本为空时返回 0
+ */
+double cxl_stats_variance(const cxl_stats_t *stats);
+
+/**
+ * @brief 样本方差（m2 / (n - 1)）
+ * @param stats 累加器
+ * @return 方差，样本数不足 2 时返回 0
+ */
+double cxl_stats_sample_variance(const cxl_stats_t *stats);
+
+/**
+ * @brief 总体标准差
+ * @param stats 累加器
+ * @return 标准差
+ */
+double cxl_stats_stddev(const cxl_stats_t *stats);
+
+/**
+ * @brief 获取运行时选择的统计内核
+ * @return "avx512"、"avx2" 或 "scalar"
+ */
+const char *cxl_stats_simd_level(void);
+
+#endif /* CXL_STATS_H */
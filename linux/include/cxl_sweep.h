@@ -0,0 +1,170 @@
+#ifndef CXL_SWEEP_H
+#define CXL_SWEEP_H
+
+#include "cxl_common.h"
+#include "cxl_perf.h"
+
+/* ====== 参数扫描引擎 ====== */
+
+/*
+ * 实验矩阵列出线程放置、数据放置/节点、CPU、工作集和步长，引擎枚举其笛卡尔积，
+ * 每个单元测量一次指针追逐延迟，所有单元在同一进程内完成。
+ *
+ * 单元测量：先批量清除工作集（cxl_flush_bulk），所有者线程（矩阵中的 CPU）再遍历一遍链表，再由探测线程遍历一遍并计时（首轮延迟，
+ * 反映数据位于所有者缓存或内存中时的访问代价），随后继续追逐得到稳态延迟。探测线程的 CPU 由线程放置决定：
+ * SAME_THREAD 与所有者相同，DIFFERENT_THREAD 为所有者的 SMT 兄弟线程，CROSS_CORE 为另一物理核心
+ * （优先同一节点）。
+ *
+ * 每个数据节点只分配一次最大工作集大小的缓冲区，每个（工作集，步长）组合只构造一次链表，
+ * 所有落在该组合上的单元复用。
+ *
+ * 矩阵文件格式（# 开头为注释，列表以逗号分隔）：
+ *   thread_placement = same_thread, different_thread, cross_core
+ *   data_placement   = normal, cxl, local      # 配置中的普通/CXL 节点，或所有者 CPU 所在节点
+ *   nodes            = 0, 2-3                 # 显式节点，与 data_placement 合并为同一维度
+ *   cpus             = 0, 16
+ *   working_sets     = 4K..1G                 # A..B 表示按 2 倍步进
+ *   strides          = 64, 4096
+ *   loads            = 1000000                # 每个单元稳态计时的加载次数
+ */
+#define CXL_SWEEP_MAX_VALUES        64      /* 每个维度的取值上限 */
+#define CXL_SWEEP_LINE_MAX          1024
+#define CXL_SWEEP_DEFAULT_LOADS     1000000ULL
+#define CXL_SWEEP_MAGIC             "CXLSWEEP"
+#define CXL_SWEEP_VERSION           3       /* 2：单元测量前清除工作集（cache_reset）；3：探测线程的硬件计数 */
+
+/* ====== 数据目标 ====== */
+typedef enum {
+    SWEEP_DATA_NORMAL,          /* 配置中的普通节点 */
+    SWEEP_DATA_CXL,             /* 配置中的 CXL 节点 */
+    SWEEP_DATA_LOCAL,           /* 所有者 CPU 所在节点 */
+    SWEEP_DATA_NODE             /* 显式指定的节点 */
+} sweep_data_kind_t;
+
+typedef struct {
+    sweep_data_kind_t kind;
+    int node;                   /* 仅 SWEEP_DATA_NODE 有效 */
+} sweep_data_t;
+
+/* ====== 实验矩阵 ====== */
+typedef struct {
+    thread_placement_t thread_placements[CXL_SWEEP_MAX_VALUES];
+    int num_thread_placements;
+    sweep_data_t data[CXL_SWEEP_MAX_VALUES];
+    int num_data;
+    int cpus[CXL_SWEEP_MAX_VALUES];
+    int num_cpus;
+    size_t working_sets[CXL_SWEEP_MAX_VALUES];
+    int num_working_sets;
+    size_t strides[CXL_SWEEP_MAX_VALUES];
+    int num_strides;
+    uint64_t num_loads;         /* 每个单元稳态计时的加载次数 */
+} sweep_matrix_t;
+
+/* ====== 单元结果（二进制文件中的定长记录） ====== */
+typedef struct {
+    uint32_t index;             /* 在笛卡尔积中的序号 */
+    int32_t thread_placement;   /* thread_placement_t */
+    int32_t data_kind;          /* sweep_data_kind_t */
+    int32_t node;               /* 解析后的数据节点 */
+    int32_t cpu;                /* 所有者 CPU */
+    int32_t probe_cpu;          /* 探测 CPU，-1 表示该放置不可用 */
+    int32_t status;             /* 0 成功，-1 跳过或失败 */
+    int32_t cache_reset;        /* 测量前清除工作集所用的指令（flush_insn_t），-1 表示未清除 */
+    uint64_t working_set;       /* 字节 */
+    uint64_t stride;            /* 字节 */
+    uint64_t page_size;         /* 缓冲区实际页大小 */
+    uint64_t num_loads;         /* 稳态计时的加载次数 */
+    double first_pass_ns;       /* 所有者遍历后，探测线程首轮每次加载的纳秒数 */
+    double ns_per_load;         /* 稳态每次加载的纳秒数 */
+    double cycles_per_load;     /* 稳态每次加载的 TSC 周期数 */
+    cxl_perf_counts_t first_pass_perf; /* 探测线程首轮的硬件计数 */
+    cxl_perf_counts_t perf;     /* 探测线程稳态计时的硬件计数 */
+} sweep_cell_t;
+
+/* ====== 二进制结果文件头（其后紧跟 num_cells 条 sweep_cell_t） ====== */
+typedef struct {
+    char magic[8];              /* CXL_SWEEP_MAGIC，不含结尾 '\0' */
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_size;       /* sizeof(sweep_cell_t) */
+    uint32_t num_cells;
+    uint64_t tsc_hz;
+    uint64_t created_ns;        /* CLOCK_REALTIME */
+} sweep_file_header_t;
+
+/**
+ * @brief 填充默认矩阵：SAME_THREAD；普通与 CXL 节点；普通节点的第一个 CPU；
+ *        4 KiB 到 max_working_set 按 4 倍步进；步长 64
+ * @param matrix 矩阵
+ * @param config 框架配置（取普通/CXL 节点）
+ * @param max_working_set 最大工作集（字节）
+ */
+void cxl_sweep_matrix_default(sweep_matrix_t *matrix, const cxl_config_t *config,
+                              size_t max_working_set);
+
+/**
+ * @brief 从矩阵文件加载（未出现的键保留 matrix 中原有的值）
+ * @param path 文件路径
+ * @param matrix 矩阵（通常先用 cxl_sweep_matrix_default 填充）
+ * @return 0 成功，-1 失败
+ */
+int cxl_sweep_load_matrix(const char *path, sweep_matrix_t *matrix);
+
+/**
+ * @brief 计算单元总数
+ * @param matrix 矩阵
+ * @return 各维度取值数之积
+ */
+int cxl_sweep_num_cells(const sweep_matrix_t *matrix);
+
+/**
+ * @brief 打印矩阵
+ * @param matrix 矩阵
+ */
+void cxl_sweep_print_matrix(const sweep_matrix_t *matrix);
+
+/**
+ * @brief 执行扫描
+ * @param matrix 矩阵
+ * @param config 框架配置（解析 normal/cxl 数据目标）
+ * @param cells 结果数组，按笛卡尔积顺序（线程放置、数据、CPU、工作集、步长，最后一维变化最快）
+ * @param max_cells 结果数组容量（至少 cxl_sweep_num_cells）
+ * @return 成功测量的单元数，参数错误返回 -1
+ */
+int cxl_sweep_run(const sweep_matrix_t *matrix, const cxl_config_t *config,
+                  sweep_cell_t *cells, int max_cells);
+
+/**
+ * @brief 导出 CSV 结果表
+ * @param cells 结果数组
+ * @param num_cells 单元数
+ * @param output_file 输出文件路径
+ * @return 0 成功，-1 失败
+ */
+int cxl_sweep_export_csv(const sweep_cell_t *cells, int num_cells, const char *output_file);
+
+/**
+ * @brief 导出二进制结果表（sweep_file_header_t + 定长记录）
+ * @param cells 结果数组
+ * @param num_cells 单元数
+ * @param output_file 输出文件路径
+ * @return 0 成功，-1 失败
+ */
+int cxl_sweep_export_binary(const sweep_cell_t *cells, int num_cells, const char *output_file);
+
+/**
+ * @brief 获取线程放置名称（与矩阵文件中的关键字相同）
+ * @param placement 线程放置
+ * @return 名称字符串
+ */
+const char *cxl_sweep_placement_name(thread_placement_t placement);
+
+/**
+ * @brief 获取数据目标名称（与矩阵文件中的关键字相同，显式节点为 "node"）
+ * @param kind 数据目标类型
+ * @return 名称字符串
+ */
+const char *cxl_sweep_data_name(sweep_data_kind_t kind);
+
+#endif /* CXL_SWEEP_H */
@@ -0,0 +1,109 @@
+#ifndef CXL_TOPOLOGY_H
+#define CXL_TOPOLOGY_H
+
+#include "cxl_common.h"
+
+/* ====== CXL / NUMA 拓扑探测接口 ====== */
+
+/*
+ * 从 sysfs 读取 NUMA 节点（cpulist、meminfo、distance、HMAT access0/access1）
+ * 与 /sys/bus/cxl/devices，识别无 CPU 的 CXL 内存节点及其最近的发起节点。
+ * sysfs 根目录可以替换（参数或 CXL_SYSFS_ROOT 环境变量），便于用伪造的目录树测试。
+ */
+#define CXL_TOPO_MAX_NODES          64      /* 发起节点集合用 uint64_t 位图表示 */
+#define CXL_TOPO_MAX_DEVICES        64
+#define CXL_TOPO_PATH_MAX           512
+#define CXL_SYSFS_ROOT_DEFAULT      "/sys"
+#define CXL_SYSFS_ROOT_ENV          "CXL_SYSFS_ROOT"
+
+/* ====== 节点类型 ====== */
+typedef enum {
+    TOPO_NODE_CPU,              /* 有 CPU 的普通节点 */
+    TOPO_NODE_CXL,              /* CXL region/dax 的目标节点 */
+    TOPO_NODE_CPULESS           /* 无 CPU 但有内存，来源未知（按 CXL 候选处理） */
+} topo_node_kind_t;
+
+/* ====== HMAT 访问类（access0：任意发起者，access1：仅 CPU） ====== */
+typedef struct {
+    int valid;                  /* 是否存在该访问类 */
+    uint64_t initiators;        /* 发起节点位图 */
+    uint32_t read_latency;      /* ns，0 表示未知 */
+    uint32_t write_latency;     /* ns */
+    uint32_t read_bandwidth;    /* MB/s */
+    uint32_t write_bandwidth;   /* MB/s */
+} topo_access_t;
+
+/* ====== 单个 NUMA 节点 ====== */
+typedef struct {
+    int present;                /* 节点目录是否存在 */
+    topo_node_kind_t kind;      /* 节点类型 */
+    int num_cpus;               /* cpulist 中的 CPU 数 */
+    int first_cpu;              /* 第一个 CPU，无 CPU 时为 -1 */
+    uint64_t mem_total_kb;      /* meminfo MemTotal */
+    uint64_t mem_free_kb;       /* meminfo MemFree */
+    int nearest_initiator;      /* 最近的有 CPU 节点，-1 表示未知 */
+    uint8_t distance[CXL_TOPO_MAX_NODES];  /* SLIT 距离，0 表示未知 */
+    topo_access_t access[2];    /* access0 / access1 */
+} topo_node_t;
+
+/* ====== CXL 设备（/sys/bus/cxl/devices 下的 memdev 与 region） ====== */
+typedef struct {
+    char name[32];              /* mem0、region0 等 */
+    int numa_node;              /* memdev：设备所属节点；region：目标节点；-1 表示未知 */
+} topo_device_t;
+
+/* ====== 拓扑 ====== */
+typedef struct {
+    char sysfs_root[CXL_TOPO_PATH_MAX];
+    int num_nodes;              /* 存在的节点数 */
+    int max_node;               /* 最大节点编号 */
+    topo_node_t nodes[CXL_TOPO_MAX_NODES];
+    int num_devices;
+    topo_device_t devices[CXL_TOPO_MAX_DEVICES];
+    int num_cxl_nodes;
+    int cxl_nodes[CXL_TOPO_MAX_NODES];     /* 按节点编号升序 */
+} cxl_topology_t;
+
+/**
+ * @brief 从 sysfs 探测拓扑
+ * @param sysfs_root sysfs 根目录，NULL 时依次使用 CXL_SYSFS_ROOT 环境变量和 /sys
+ * @param topo 返回的拓扑
+ * @return 0 成功，-1 失败（节点目录不可读）
+ */
+int cxl_topology_discover(const char *sysfs_root, cxl_topology_t *topo);
+
+/**
+ * @brief 获取本机拓扑（首次调用时探测并缓存）
+ * @return 拓扑指针，探测失败返回 NULL
+ */
+const cxl_topology_t *cxl_topology_get(void);
+
+/**
+ * @brief 获取第一个 CXL 内存节点
+ * @param topo 拓扑
+ * @return 节点 ID，没有 CXL 节点返回 -1
+ */
+int cxl_topology_cxl_node(const cxl_topology_t *topo);
+
+/**
+ * @brief 获取节点最近的有 CPU 的发起节点
+ * @param topo 拓扑
+ * @param node 节点 ID
+ * @return 发起节点 ID，未知返回 -1（有 CPU 的节点返回自身）
+ */
+int cxl_topology_nearest_initiator(const cxl_topology_t *topo, int node);
+
+/**
+ * @brief 获取节点类型名称
+ * @param kind 节点类型
+ * @return 名称字符串
+ */
+const char *cxl_topology_kind_name(topo_node_kind_t kind);
+
+/**
+ * @brief 打印拓扑
+ * @param topo 拓扑
+ */
+void cxl_topology_print(const cxl_topology_t *topo);
+
+#endif /* CXL_TOPOLOGY_H */
@@ -0,0 +1,189 @@
+#ifndef CXL_TRACE_H
+#define CXL_TRACE_H
+
+#include "cxl_common.h"
+#include "cxl_histogram.h"
+
+/* ====== 二进制延迟样本文件（.cxltrace） ====== */
+
+/*
+ * 文件布局（小端）：
+ *   cxl_trace_header_t                       配置、TSC 频率、拓扑快照
+ *   { cxl_trace_chunk_t, payload } * N       每块最多 CXL_TRACE_CHUNK_SAMPLES 个样本，
+ *                                            payload 为相邻样本差值的 zigzag + LEB128 变长编码
+ *   0~7 字节填充                             使块索引 8 字节对齐
+ *   cxl_trace_chunk_t[N]                     块索引（与各块前的块头相同）
+ *   cxl_trace_trailer_t                      索引位置与样本总数
+ * 写入端只追加，不回写文件头，可以直接写到管道；
+ * 缺少尾部（写入端异常退出）时，读取端沿块头重建索引。
+ */
+#define CXL_TRACE_MAGIC             "CXLTRACE"
+#define CXL_TRACE_END_MAGIC         "CXLTEND"
+#define CXL_TRACE_VERSION           1
+#define CXL_TRACE_CHUNK_SAMPLES     65536
+#define CXL_TRACE_MAX_NODES         16
+#define CXL_TRACE_LABEL_SIZE        64
+
+/* ====== 拓扑快照中的节点 ====== */
+typedef struct {
+    int32_t id;
+    int32_t kind;               /* topo_node_kind_t */
+    int32_t num_cpus;
+    int32_t nearest_initiator;
+    uint64_t mem_total_kb;
+    uint32_t read_latency;      /* HMAT，ns */
+    uint32_t read_bandwidth;    /* HMAT，MB/s */
+} cxl_trace_node_t;
+
+/* ====== 文件头 ====== */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;       /* sizeof(cxl_trace_header_t) */
+    uint64_t tsc_hz;            /* 0 表示未知 */
+    uint64_t created_ns;        /* CLOCK_REALTIME */
+    char label[CXL_TRACE_LABEL_SIZE];
+    uint32_t chunk_samples;
+    int32_t has_config;
+    
+    /* cxl_config_t 快照 */
+    int32_t numa_node_normal;
+    int32_t numa_node_cxl;
+    int32_t thread_placement;
+    int32_t data_placement;
+    int32_t attacker_cpu;
+    int32_t victim_cpu;
+    int32_t probe_cpu;
+    int32_t monitor_cpu;
+    int32_t prefetcher_enabled;
+    int32_t isolcpus_enabled;
+    uint64_t iterations;
+    uint64_t warmup_iterations;
+    uint32_t sample_size;
+    
+    /* 拓扑快照 */
+    int32_t num_nodes;
+    int32_t cxl_node;
+    int32_t reserved;
+    cxl_trace_node_t nodes[CXL_TRACE_MAX_NODES];
+} cxl_trace_header_t;
+
+/* ====== 块头 / 块索引项 ====== */
+typedef struct {
+    uint64_t offset;            /* payload 在文件中的偏移 */
+    uint64_t first_sample;      /* 块内第一个样本的全局序号 */
+    uint32_t num_samples;
+    uint32_t payload_bytes;
+    uint64_t min;               /* 块内统计，无需解码即可得到 min/max/mean */
+    uint64_t max;
+    uint64_t sum;
+} cxl_trace_chunk_t;
+
+/* ====== 文件尾 ====== */
+typedef struct {
+    uint64_t index_offset;
+    uint64_t num_chunks;
+    uint64_t total_samples;
+    char magic[8];
+} cxl_trace_trailer_t;
+
+typedef struct cxl_trace_writer cxl_trace_writer_t;
+typedef struct cxl_trace_reader cxl_trace_reader_t;
+
+/**
+ * @brief 创建样本文件并写入文件头（拓扑快照来自 cxl_topology_get）
+ * @param path 输出文件路径
+ * @param label 数据标签
+ * @param config 框架配置，可为 NULL
+ * @param tsc_hz TSC 频率（Hz），未知时为 0
+ * @return 写入器，失败返回 NULL
+ */
+cxl_trace_writer_t *cxl_trace_writer_open(const char *path, const char *label,
+                                          const cxl_config_t *config, uint64_t tsc_hz);
+
+/**
+ * @brief 追加样本（满一块即编码写出）
+ * @param writer 写入器
+ * @param samples 样本数组
+ * @param num_samples 样本数量
+ * @return 0 成功，-1 失败
+ */
+int cxl_trace_writer_append(cxl_trace_writer_t *writer, const uint64_t *samples, size_t num_samples);
+
+/**
+ * @brief 写出剩余样本、块索引和文件尾，并释放写入器
+ * @param writer 写入器
+ * @return 0 成功，-1 失败
+ */
+int cxl_trace_writer_close(cxl_trace_writer_t *writer);
+
+/**
+ * @brief 以 mmap 方式打开样本文件
+ * @param path 文件路径
+ * @return 读取器，失败返回 NULL
+ */
+cxl_trace_reader_t *cxl_trace_open(const char *path);
+
+/**
+ * @brief 关闭读取器并解除映射
+ * @param reader 读取器
+ */
+void cxl_trace_close(cxl_trace_reader_t *reader);
+
+/**
+ * @brief 获取文件头（指向映射区域，无拷贝）
+ * @param reader 读取器
+ * @return 文件头指针
+ */
+const cxl_trace_header_t *cxl_trace_get_header(const cxl_trace_reader_t *reader);
+
+/**
+ * @brief 获取样本总数
+ * @param reader 读取器
+ * @return 样本总数
+ */
+uint64_t cxl_trace_num_samples(const cxl_trace_reader_t *reader);
+
+/**
+ * @brief 获取块数量
+ * @param reader 读取器
+ * @return 块数量
+ */
+uint64_t cxl_trace_num_chunks(const cxl_trace_reader_t *reader);
+
+/**
+ * @brief 获取块索引项（含块内 min/max/sum）
+ * @param reader 读取器
+ * @param chunk 块序号
+ * @return 索引项指针，越界返回 NULL
+ */
+const cxl_trace_chunk_t *cxl_trace_get_chunk(const cxl_trace_reader_t *reader, uint64_t chunk);
+
+/**
+ * @brief 解码一个块
+ * @param reader 读取器
+ * @param chunk 块序号
+ * @param samples 输出缓冲区（容量至少 CXL_TRACE_CHUNK_SAMPLES）
+ * @return 解码的样本数，失败返回 -1
+ */
+int cxl_trace_decode_chunk(const cxl_trace_reader_t *reader, uint64_t chunk, uint64_t *samples);
+
+/**
+ * @brief 随机读取一段样本（按块索引二分定位，只解码涉及的块）
+ * @param reader 读取器
+ * @param first 起始样本序号
+ * @param count 样本数量
+ * @param samples 输出缓冲区
+ * @return 0 成功，-1 失败
+ */
+int cxl_trace_read(const cxl_trace_reader_t *reader, uint64_t first, uint64_t count, uint64_t *samples);
+
+/**
+ * @brief 将全部样本记录到直方图
+ * @param reader 读取器
+ * @param hist 直方图（追加，不清空）
+ * @return 0 成功，-1 失败
+ */
+int cxl_trace_to_histogram(const cxl_trace_reader_t *reader, cxl_histogram_t *hist);
+
+#endif /* CXL_TRACE_H */
@@ -0,0 +1,90 @@
+#ifndef CXL_TSC_H
+#define CXL_TSC_H
+
+#include "cxl_common.h"
+
+/* ====== TSC 频率校准与 cycles/ns 换算 ====== */
+
+/*
+ * 频率来源优先级：CPUID 0x15（晶振频率 × TSC/晶振比，精确）、CPUID 0x16（基准频率，MHz 取整），
+ * 两者都与 CLOCK_MONOTONIC_RAW 的测量值交叉检验，偏差超过 CXL_TSC_MAX_DEVIATION 时
+ * （常见于虚拟机）改用测量值。换算为定点乘法加移位，不使用除法和浮点。
+ */
+#define CXL_TSC_SHIFT               32
+#define CXL_TSC_CALIBRATE_ROUNDS    5       /* 取中位数 */
+#define CXL_TSC_CALIBRATE_NS        10000000ULL
+#define CXL_TSC_MAX_DEVIATION       0.01
+
+/* ====== 频率来源 ====== */
+typedef enum {
+    TSC_SOURCE_CPUID_15H,       /* CPUID 0x15：晶振频率 × 比例 */
+    TSC_SOURCE_CPUID_16H,       /* CPUID 0x16：处理器基准频率 */
+    TSC_SOURCE_CALIBRATED       /* 对照 CLOCK_MONOTONIC_RAW 测量 */
+} tsc_source_t;
+
+/* ====== TSC 信息 ====== */
+typedef struct {
+    int invariant;              /* CPUID 0x80000007 EDX[8]：频率恒定、不随 C/P 状态停止 */
+    tsc_source_t source;
+    uint64_t tsc_hz;            /* 采用的频率 */
+    uint64_t cpuid_hz;          /* CPUID 给出的频率，0 表示不可用 */
+    uint64_t calibrated_hz;     /* 测量得到的频率 */
+    uint64_t ns_mult;           /* ns = (cycles * ns_mult) >> CXL_TSC_SHIFT */
+    uint64_t cycles_mult;       /* cycles = (ns * cycles_mult) >> CXL_TSC_SHIFT */
+} cxl_tsc_info_t;
+
+/* ====== 内联函数：定点换算 ====== */
+static inline uint64_t cxl_tsc_to_ns(const cxl_tsc_info_t *tsc, uint64_t cycles) {
+    return (uint64_t)(((unsigned __int128)cycles * tsc->ns_mult) >> CXL_TSC_SHIFT);
+}
+
+static inline uint64_t cxl_tsc_from_ns(const cxl_tsc_info_t *tsc, uint64_t ns) {
+    return (uint64_t)(((unsigned __int128)ns * tsc->cycles_mult) >> CXL_TSC_SHIFT);
+}
+
+/**
+ * @brief 获取 TSC 信息（首次调用时检测并校准，约 50 ms）
+ * @return TSC 信息指针（不会为 NULL）
+ */
+const cxl_tsc_info_t *cxl_tsc_get(void);
+
+/**
+ * @brief 获取 TSC 频率
+ * @return 频率（Hz）
+ */
+uint64_t cxl_tsc_hz(void);
+
+/**
+ * @brief 将 cycles 换算为纳秒
+ * @param cycles TSC 周期数
+ * @return 纳秒
+ */
+uint64_t cxl_cycles_to_ns(uint64_t cycles);
+
+/**
+ * @brief 将 cycles 换算为纳秒（浮点，用于平均值、标准差等统计量）
+ * @param cycles TSC 周期数
+ * @return 纳秒
+ */
+double cxl_cycles_to_ns_f(double cycles);
+
+/**
+ * @brief 将纳秒换算为 cycles
+ * @param ns 纳秒
+ * @return TSC 周期数
+ */
+uint64_t cxl_ns_to_cycles(uint64_t ns);
+
+/**
+ * @brief 获取频率来源名称
+ * @param source 频率来源
+ * @return 名称字符串
+ */
+const char *cxl_tsc_source_name(tsc_source_t source);
+
+/**
+ * @brief 打印 TSC 信息
+ */
+void cxl_tsc_print(void);
+
+#endif /* CXL_TSC_H */
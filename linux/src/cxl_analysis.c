@@ -5,12 +5,18 @@
 #include <math.h>
 #include <errno.h>
 #include "cxl_analysis.h"
+#include "cxl_histogram.h"
+#include "cxl_trace.h"
+#include "cxl_stats.h"
+#include "cxl_tsc.h"
 #include "cxl_common.h"
 
 /* ====== 分析模块状态 ====== */
 static struct {
     char output_dir[256];
     int initialized;
+    uint64_t *scratch;          /* 分位数选择用的复用暂存区 */
+    size_t scratch_capacity;    /* 暂存区容量（元素个数） */
 } analysis_state = {0};
 
 /* ====== 初始化与清理 ====== */
@@ -36,11 +42,184 @@ int cxl_analysis_init(const char *output_dir) {
 int cxl_analysis_cleanup(void) {
     analysis_state.initialized = 0;
     
+    free(analysis_state.scratch);
+    analysis_state.scratch = NULL;
+    analysis_state.scratch_capacity = 0;
+    
     fprintf(stdout, "[INFO] Analysis module cleanup completed\n");
     
     return 0;
 }
 
+/* ====== 分位数选择引擎 ====== */
+#define SELECT_INSERTION_CUTOFF 16
+
+static uint64_t *analysis_get_scratch(size_t count) {
+    if (count > analysis_state.scratch_capacity) {
+        uint64_t *grown = realloc(analysis_state.scratch, count * sizeof(uint64_t));
+        if (!grown) {
+            return NULL;
+        }
+        analysis_state.scratch = grown;
+        analysis_state.scratch_capacity = count;
+    }
+    
+    return analysis_state.scratch;
+}
+
+static void select_insertion_sort(uint64_t *data, size_t lo, size_t hi) {
+    for (size_t i = lo + 1; i <= hi; i++) {
+        uint64_t value = data[i];
+        size_t j = i;
+        while (j > lo && data[j - 1] > value) {
+            data[j] = data[j - 1];
+            j--;
+        }
+        data[j] = value;
+    }
+}
+
+static void select_sift_down(uint64_t *heap, size_t root, size_t count) {
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= count) break;
+        if (child + 1 < count && heap[child + 1] > heap[child]) child++;
+        if (heap[root] >= heap[child]) break;
+        
+        uint64_t tmp = heap[root];
+        heap[root] = heap[child];
+        heap[child] = tmp;
+        root = child;
+    }
+}
+
+/* 递归过深时退化为堆排序，保证最坏 O(n log n) */
+static void select_heap_sort(uint64_t *data, size_t lo, size_t hi) {
+    uint64_t *heap = data + lo;
+    size_t count = hi - lo + 1;
+    
+    for (size_t i = count / 2; i-- > 0;) {
+        select_sift_down(heap, i, count);
+    }
+    
+    for (size_t end = count - 1; end > 0; end--) {
+        uint64_t tmp = heap[0];
+        heap[0] = heap[end];
+        heap[end] = tmp;
+        select_sift_down(heap, 0, end);
+    }
+}
+
+static uint64_t select_median_of_three(uint64_t a, uint64_t b, uint64_t c) {
+    if (a > b) { uint64_t t = a; a = b; b = t; }
+    if (b > c) { b = c; }
+    return (a > b) ? a : b;
+}
+
+/*
+ * Introselect：三路划分快速选择（计时数据重复值多），深度超限时退化为堆排序。
+ * 返回后 data[k] 即第 k 小元素，且 [lo, k) <= data[k] <= (k, hi]。
+ */
+static void analysis_introselect(uint64_t *data, size_t lo, size_t hi, size_t k) {
+    int depth_limit = 0;
+    for (size_t n = hi - lo + 1; n > 1; n >>= 1) depth_limit += 2;
+    
+    while (hi > lo) {
+        if (hi - lo < SELECT_INSERTION_CUTOFF) {
+            select_insertion_sort(data, lo, hi);
+            return;
+        }
+        
+        if (depth_limit-- <= 0) {
+            select_heap_sort(data, lo, hi);
+            return;
+        }
+        
+        uint64_t pivot = select_median_of_three(data[lo], data[lo + (hi - lo) / 2], data[hi]);
+        
+        /* 三路划分：[lo, lt) < pivot, [lt, gt] == pivot, (gt, hi] > pivot */
+        size_t lt = lo, i = lo, gt = hi;
+        while (i <= gt) {
+            if (data[i] < pivot) {
+                uint64_t tmp = data[lt]; data[lt] = data[i]; data[i] = tmp;
+                lt++;
+                i++;
+            } else if (data[i] > pivot) {
+                uint64_t tmp = data[gt]; data[gt] = data[i]; data[i] = tmp;
+                if (gt == 0) break;
+                gt--;
+            } else {
+                i++;
+            }
+        }
+        
+        if (k < lt) {
+            hi = lt - 1;
+        } else if (k > gt) {
+            lo = gt + 1;
+        } else {
+            return;
+        }
+    }
+}
+
+int cxl_analysis_quantiles(const uint64_t *timings, int num_samples,
+                           const double *quantiles, int num_quantiles,
+                           double *values) {
+    if (!timings || num_samples <= 0 || !quantiles || !values ||
+        num_quantiles <= 0 || num_quantiles > CXL_ANALYSIS_MAX_QUANTILES) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    for (int i = 0; i < num_quantiles; i++) {
+        if (!(quantiles[i] >= 0.0 && quantiles[i] <= 1.0)) {
+            fprintf(stderr, "[ERROR] Quantile %f out of range [0, 1]\n", quantiles[i]);
+            return -1;
+        }
+    }
+    
+    size_t n = (size_t)num_samples;
+    uint64_t *data = analysis_get_scratch(n);
+    if (!data) {
+        fprintf(stderr, "[ERROR] Failed to allocate quantile scratch buffer\n");
+        return -1;
+    }
+    memcpy(data, timings, n * sizeof(uint64_t));
+    
+    /* 按分位数升序处理，使每次选择只作用在上一次结果右侧的子区间 */
+    int order[CXL_ANALYSIS_MAX_QUANTILES];
+    for (int i = 0; i < num_quantiles; i++) {
+        int j = i;
+        while (j > 0 && quantiles[order[j - 1]] > quantiles[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    
+    size_t left = 0;
+    for (int i = 0; i < num_quantiles; i++) {
+        double q = quantiles[order[i]];
+        double h = q * (double)(n - 1);
+        size_t k = (size_t)h;
+        double frac = h - (double)k;
+        
+        analysis_introselect(data, left, n - 1, k);
+        double value = (double)data[k];
+        
+        if (frac > 0.0 && k + 1 < n) {
+            analysis_introselect(data, k + 1, n - 1, k + 1);
+            value += frac * ((double)data[k + 1] - (double)data[k]);
+        }
+        
+        values[order[i]] = value;
+        left = k;
+    }
+    
+    return 0;
+}
+
 /* ====== 基本统计 ====== */
 int cxl_analysis_compute_statistics(const uint64_t *timings, int num_samples,
                                     uint64_t *min, uint64_t *max, 
@@ -50,91 +229,331 @@ int cxl_analysis_compute_statistics(const uint64_t *timings, int num_samples,
         return -1;
     }
     
-    *min = timings[0];
-    *max = timings[0];
-    *mean = 0.0;
+    /* 单遍计算最小值、最大值、平均值和标准差 */
+    cxl_stats_t stats;
+    cxl_stats_compute(timings, (size_t)num_samples, &stats);
+    *min = stats.min;
+    *max = stats.max;
+    *mean = stats.mean;
+    *stddev = cxl_stats_stddev(&stats);
     
-    /* 计算最小值、最大值和平均值 */
-    for (int i = 0; i < num_samples; i++) {
-        if (timings[i] < *min) *min = timings[i];
-        if (timings[i] > *max) *max = timings[i];
-        *mean += timings[i];
+    /* 计算中位数 */
+    const double half = 0.5;
+    if (cxl_analysis_quantiles(timings, num_samples, &half, 1, median) < 0) {
+        return -1;
     }
-    *mean /= num_samples;
     
-    /* 计算中位数 */
-    uint64_t *sorted = malloc(num_samples * sizeof(uint64_t));
-    memcpy(sorted, timings, num_samples * sizeof(uint64_t));
+    return 0;
+}
+
+/* ====== 分布对比 ====== */
+int cxl_analysis_compare_distributions(const uint64_t *timings_a, int num_a,
+                                       const uint64_t *timings_b, int num_b,
+                                       double *difference, double *p_value) {
+    if (!timings_a || num_a <= 0 || !timings_b || num_b <= 0) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
     
-    for (int i = 0; i < num_samples; i++) {
-        for (int j = i + 1; j < num_samples; j++) {
-            if (sorted[i] > sorted[j]) {
-                uint64_t tmp = sorted[i];
-                sorted[i] = sorted[j];
-                sorted[j] = tmp;
-            }
-        }
+    /* 每组单遍计算平均值与样本方差 */
+    cxl_stats_t stats_a, stats_b;
+    cxl_stats_compute(timings_a, (size_t)num_a, &stats_a);
+    cxl_stats_compute(timings_b, (size_t)num_b, &stats_b);
+    
+    *difference = stats_a.mean - stats_b.mean;
+    
+    /* Welch t 检验，p 值取自 Student t 分布 */
+    cxl_test_result_t welch;
+    if (cxl_analysis_welch_test(&stats_a, &stats_b, &welch) < 0) {
+        return -1;
     }
+    *p_value = welch.p_value;
     
-    if (num_samples % 2 == 0) {
-        *median = (sorted[num_samples / 2 - 1] + sorted[num_samples / 2]) / 2.0;
-    } else {
-        *median = sorted[num_samples / 2];
+    return 0;
+}
+
+/* ====== 显著性检验 ====== */
+
+/* 正则化不完全 Beta 函数的连分式展开（修正 Lentz 算法） */
+static double analysis_beta_cf(double a, double b, double x) {
+    const double tiny = 1e-300;
+    double qab = a + b, qap = a + 1.0, qam = a - 1.0;
+    double c = 1.0;
+    double d = 1.0 - qab * x / qap;
+    
+    if (fabs(d) < tiny) d = tiny;
+    d = 1.0 / d;
+    double h = d;
+    
+    for (int m = 1; m <= CXL_ANALYSIS_BETA_MAX_ITER; m++) {
+        int m2 = 2 * m;
+        double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+        
+        d = 1.0 + aa * d;
+        if (fabs(d) < tiny) d = tiny;
+        c = 1.0 + aa / c;
+        if (fabs(c) < tiny) c = tiny;
+        d = 1.0 / d;
+        h *= d * c;
+        
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+        d = 1.0 + aa * d;
+        if (fabs(d) < tiny) d = tiny;
+        c = 1.0 + aa / c;
+        if (fabs(c) < tiny) c = tiny;
+        d = 1.0 / d;
+        
+        double delta = d * c;
+        h *= delta;
+        if (fabs(delta - 1.0) < 1e-15) break;
     }
     
-    /* 计算标准差 */
-    double variance = 0.0;
-    for (int i = 0; i < num_samples; i++) {
-        double diff = timings[i] - *mean;
-        variance += diff * diff;
+    return h;
+}
+
+static double analysis_inc_beta(double a, double b, double x) {
+    if (x <= 0.0) return 0.0;
+    if (x >= 1.0) return 1.0;
+    
+    double front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log1p(-x));
+    
+    if (x < (a + 1.0) / (a + b + 2.0)) {
+        return front * analysis_beta_cf(a, b, x) / a;
+    }
+    return 1.0 - front * analysis_beta_cf(b, a, 1.0 - x) / b;
+}
+
+/* Student t 分布的双侧尾概率 P(|T| >= |t|) */
+static double analysis_student_t_two_tailed(double t, double df) {
+    if (isnan(t)) return 1.0;
+    if (isinf(t)) return 0.0;
+    
+    /* 自由度很大时 t 分布趋近正态（df >= 1e5 时 p 值的相对误差在 1e-3 以内），且连分式收敛变慢 */
+    if (df >= CXL_ANALYSIS_NORMAL_DF) {
+        return erfc(fabs(t) / M_SQRT2);
+    }
+    
+    return analysis_inc_beta(df / 2.0, 0.5, df / (df + t * t));
+}
+
+/* Kolmogorov 分布的尾概率 Q(lambda) = 2 * sum (-1)^(k-1) exp(-2 k^2 lambda^2) */
+static double analysis_kolmogorov_q(double lambda) {
+    if (lambda < 0.2) return 1.0;
+    
+    double sum = 0.0, sign = 1.0;
+    for (int k = 1; k <= 100; k++) {
+        double term = sign * exp(-2.0 * k * k * lambda * lambda);
+        sum += term;
+        if (fabs(term) < 1e-16 * fabs(sum)) break;
+        sign = -sign;
+    }
+    
+    double p = 2.0 * sum;
+    if (p < 0.0) p = 0.0;
+    if (p > 1.0) p = 1.0;
+    return p;
+}
+
+int cxl_analysis_welch_test(const cxl_stats_t *a, const cxl_stats_t *b, cxl_test_result_t *result) {
+    if (!a || !b || !result || a->count < 2 || b->count < 2) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    double n_a = (double)a->count, n_b = (double)b->count;
+    double se_a = cxl_stats_sample_variance(a) / n_a;
+    double se_b = cxl_stats_sample_variance(b) / n_b;
+    double se = se_a + se_b;
+    double diff = a->mean - b->mean;
+    
+    memset(result, 0, sizeof(cxl_test_result_t));
+    result->effect = diff;
+    
+    if (se <= 0.0) {
+        /* 两组都没有离散：均值相同则无差异，否则差异确定 */
+        result->statistic = (diff == 0.0) ? 0.0 : copysign(INFINITY, diff);
+        result->df = n_a + n_b - 2.0;
+        result->p_value = (diff == 0.0) ? 1.0 : 0.0;
+        return 0;
     }
-    variance /= num_samples;
-    *stddev = sqrt(variance);
     
-    free(sorted);
+    /* Welch-Satterthwaite 自由度 */
+    result->statistic = diff / sqrt(se);
+    result->df = (se * se) / (se_a * se_a / (n_a - 1.0) + se_b * se_b / (n_b - 1.0));
+    result->p_value = analysis_student_t_two_tailed(result->statistic, result->df);
     
     return 0;
 }
 
-/* ====== 分布对比 ====== */
-int cxl_analysis_compare_distributions(const uint64_t *timings_a, int num_a,
-                                       const uint64_t *timings_b, int num_b,
-                                       double *difference, double *p_value) {
-    if (!timings_a || num_a <= 0 || !timings_b || num_b <= 0) {
+int cxl_analysis_ks_test(const cxl_histogram_t *a, const cxl_histogram_t *b, cxl_test_result_t *result) {
+    if (!a || !b || !result || a->total_count == 0 || b->total_count == 0) {
         fprintf(stderr, "[ERROR] Invalid parameters\n");
         return -1;
     }
     
-    /* 计算平均值 */
-    double mean_a = 0.0, mean_b = 0.0;
-    for (int i = 0; i < num_a; i++) mean_a += timings_a[i];
-    for (int i = 0; i < num_b; i++) mean_b += timings_b[i];
-    mean_a /= num_a;
-    mean_b /= num_b;
+    double n_a = (double)a->total_count, n_b = (double)b->total_count;
+    uint64_t cum_a = 0, cum_b = 0;
+    double d_max = 0.0;
+    
+    /* 两个直方图桶边界相同，逐桶推进经验分布函数 */
+    for (int i = 0; i < CXL_HIST_NUM_BUCKETS; i++) {
+        if (a->counts[i] == 0 && b->counts[i] == 0) continue;
+        
+        cum_a += a->counts[i];
+        cum_b += b->counts[i];
+        
+        double d = fabs((double)cum_a / n_a - (double)cum_b / n_b);
+        if (d > d_max) d_max = d;
+    }
+    
+    /* 渐近分布加 Stephens 有限样本修正 */
+    double n_eff = n_a * n_b / (n_a + n_b);
+    double sqrt_n = sqrt(n_eff);
     
-    *difference = mean_a - mean_b;
+    memset(result, 0, sizeof(cxl_test_result_t));
+    result->statistic = d_max;
+    result->effect = d_max;
+    result->p_value = analysis_kolmogorov_q((sqrt_n + 0.12 + 0.11 / sqrt_n) * d_max);
     
-    /* 简化的 t-test p 值计算 */
-    double var_a = 0.0, var_b = 0.0;
-    for (int i = 0; i < num_a; i++) {
-        double diff = timings_a[i] - mean_a;
-        var_a += diff * diff;
+    return 0;
+}
+
+int cxl_analysis_mann_whitney(const cxl_histogram_t *a, const cxl_histogram_t *b, cxl_test_result_t *result) {
+    if (!a || !b || !result || a->total_count == 0 || b->total_count == 0) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
     }
-    for (int i = 0; i < num_b; i++) {
-        double diff = timings_b[i] - mean_b;
-        var_b += diff * diff;
+    
+    double n_a = (double)a->total_count, n_b = (double)b->total_count;
+    double n = n_a + n_b;
+    double below_b = 0.0;
+    double u = 0.0;
+    double ties = 0.0;
+    
+    /* 同一桶内的样本视为并列：U 计半，方差按并列组修正 */
+    for (int i = 0; i < CXL_HIST_NUM_BUCKETS; i++) {
+        double c_a = (double)a->counts[i], c_b = (double)b->counts[i];
+        if (c_a == 0.0 && c_b == 0.0) continue;
+        
+        u += c_a * (below_b + 0.5 * c_b);
+        below_b += c_b;
+        
+        double t = c_a + c_b;
+        ties += t * t * t - t;
     }
-    var_a /= (num_a - 1);
-    var_b /= (num_b - 1);
     
-    double t_stat = *difference / sqrt((var_a / num_a) + (var_b / num_b));
+    double mean_u = n_a * n_b / 2.0;
+    double var_u = n_a * n_b / 12.0 * ((n + 1.0) - ties / (n * (n - 1.0)));
+    
+    memset(result, 0, sizeof(cxl_test_result_t));
+    result->statistic = u;
+    result->effect = u / (n_a * n_b);
     
-    /* 简化的 p 值估计 */
-    *p_value = 1.0 / (1.0 + fabs(t_stat));
+    if (var_u <= 0.0) {
+        /* 所有样本落在同一桶 */
+        result->p_value = 1.0;
+        return 0;
+    }
+    
+    double z = (u - mean_u) / sqrt(var_u);
+    result->p_value = erfc(fabs(z) / M_SQRT2);
     
     return 0;
 }
 
+int cxl_analysis_compare_histograms(const cxl_histogram_t *a, const cxl_histogram_t *b,
+                                    cxl_compare_result_t *result) {
+    if (!a || !b || !result) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    /* 均值由精确累加和得到，方差按桶中点估计 */
+    cxl_stats_t stats_a, stats_b;
+    cxl_stats_init(&stats_a);
+    cxl_stats_init(&stats_b);
+    stats_a.count = a->total_count;
+    stats_a.mean = cxl_histogram_mean(a);
+    stats_a.m2 = pow(cxl_histogram_stddev(a), 2.0) * (double)a->total_count;
+    stats_b.count = b->total_count;
+    stats_b.mean = cxl_histogram_mean(b);
+    stats_b.m2 = pow(cxl_histogram_stddev(b), 2.0) * (double)b->total_count;
+    
+    if (cxl_analysis_welch_test(&stats_a, &stats_b, &result->welch) < 0 ||
+        cxl_analysis_ks_test(a, b, &result->ks) < 0 ||
+        cxl_analysis_mann_whitney(a, b, &result->mann_whitney) < 0) {
+        return -1;
+    }
+    
+    return 0;
+}
+
+int cxl_analysis_compare_samples(const uint64_t *timings_a, size_t num_a,
+                                 const uint64_t *timings_b, size_t num_b,
+                                 cxl_compare_result_t *result) {
+    if (!timings_a || !timings_b || num_a < 2 || num_b < 2 || !result) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    cxl_stats_t stats_a, stats_b;
+    cxl_stats_compute(timings_a, num_a, &stats_a);
+    cxl_stats_compute(timings_b, num_b, &stats_b);
+    
+    cxl_histogram_t *hist_a = cxl_histogram_create();
+    cxl_histogram_t *hist_b = cxl_histogram_create();
+    int ret = -1;
+    
+    if (hist_a && hist_b) {
+        cxl_histogram_record_array(hist_a, timings_a, num_a);
+        cxl_histogram_record_array(hist_b, timings_b, num_b);
+        
+        if (cxl_analysis_welch_test(&stats_a, &stats_b, &result->welch) == 0 &&
+            cxl_analysis_ks_test(hist_a, hist_b, &result->ks) == 0 &&
+            cxl_analysis_mann_whitney(hist_a, hist_b, &result->mann_whitney) == 0) {
+            ret = 0;
+        }
+    }
+    
+    cxl_histogram_destroy(hist_a);
+    cxl_histogram_destroy(hist_b);
+    
+    return ret;
+}
+
+int cxl_analysis_shift_detected(const cxl_compare_result_t *result, double alpha) {
+    if (!result) return 0;
+    
+    /* 三个检验按 Bonferroni 校正，任一拒绝即判定分布发生偏移 */
+    double level = alpha / 3.0;
+    
+    return result->welch.p_value < level ||
+           result->ks.p_value < level ||
+           result->mann_whitney.p_value < level;
+}
+
+void cxl_analysis_print_comparison(const cxl_compare_result_t *result, const char *label, double alpha) {
+    if (!result) return;
+    
+    double level = alpha / 3.0;
+    
+    fprintf(stdout, "\n%s:\n", label ? label : "Distribution Comparison");
+    fprintf(stdout, "  Welch t-test:       t = %.3f, df = %.1f, p = %.3g (mean diff %.2f cycles, %.1f ns)%s\n",
+            result->welch.statistic, result->welch.df, result->welch.p_value,
+            result->welch.effect, cxl_cycles_to_ns_f(result->welch.effect),
+            result->welch.p_value < level ? " *" : "");
+    fprintf(stdout, "  Kolmogorov-Smirnov: D = %.4f, p = %.3g%s\n",
+            result->ks.statistic, result->ks.p_value,
+            result->ks.p_value < level ? " *" : "");
+    fprintf(stdout, "  Mann-Whitney U:     U = %.0f, p = %.3g (P(A > B) = %.3f)%s\n",
+            result->mann_whitney.statistic, result->mann_whitney.p_value,
+            result->mann_whitney.effect, result->mann_whitney.p_value < level ? " *" : "");
+    fprintf(stdout, "  Verdict:            %s (alpha = %.3g, Bonferroni over 3 tests)\n",
+            cxl_analysis_shift_detected(result, alpha) ? "SIGNIFICANT SHIFT" : "no significant shift",
+            alpha);
+}
+
+
 /* ====== CSV 导出 ====== */
 int cxl_analysis_export_csv(const uint64_t *timings, int num_samples,
                             const char *label, const char *output_file) {
@@ -149,10 +568,12 @@ int cxl_analysis_export_csv(const uint64_t *timings, int num_samples,
         return -1;
     }
     
-    fprintf(file, "sample_id,%s\n", label);
+    const cxl_tsc_info_t *tsc = cxl_tsc_get();
+    
+    fprintf(file, "sample_id,%s,%s_ns\n", label, label);
     
     for (int i = 0; i < num_samples; i++) {
-        fprintf(file, "%d,%lu\n", i, timings[i]);
+        fprintf(file, "%d,%lu,%lu\n", i, timings[i], cxl_tsc_to_ns(tsc, timings[i]));
     }
     
     fclose(file);
@@ -162,6 +583,118 @@ int cxl_analysis_export_csv(const uint64_t *timings, int num_samples,
     return 0;
 }
 
+/* ====== 二进制样本文件 ====== */
+int cxl_analysis_export_binary(const uint64_t *timings, int num_samples,
+                               const char *label, const char *output_file) {
+    if (!timings || num_samples <= 0 || !label || !output_file) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    cxl_trace_writer_t *writer = cxl_trace_writer_open(output_file, label, NULL, cxl_tsc_hz());
+    if (!writer) {
+        return -1;
+    }
+    
+    int ret = cxl_trace_writer_append(writer, timings, (size_t)num_samples);
+    if (cxl_trace_writer_close(writer) < 0) ret = -1;
+    
+    if (ret == 0) {
+        fprintf(stdout, "[INFO] Binary trace exported to: %s\n", output_file);
+    }
+    
+    return ret;
+}
+
+int cxl_analysis_compute_statistics_trace(const char *trace_file,
+                                          uint64_t *min, uint64_t *max,
+                                          double *mean, double *median, double *stddev) {
+    if (!trace_file || !min || !max || !mean || !median || !stddev) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    cxl_trace_reader_t *reader = cxl_trace_open(trace_file);
+    if (!reader) {
+        return -1;
+    }
+    
+    uint64_t total = cxl_trace_num_samples(reader);
+    uint64_t num_chunks = cxl_trace_num_chunks(reader);
+    if (total == 0) {
+        fprintf(stderr, "[ERROR] Trace file is empty: %s\n", trace_file);
+        cxl_trace_close(reader);
+        return -1;
+    }
+    
+    /* 一次解码同时累计单遍统计和直方图 */
+    cxl_histogram_t *hist = cxl_histogram_create();
+    uint64_t *chunk_buf = malloc(CXL_TRACE_CHUNK_SAMPLES * sizeof(uint64_t));
+    if (!hist || !chunk_buf) {
+        fprintf(stderr, "[ERROR] Failed to allocate trace buffers\n");
+        cxl_histogram_destroy(hist);
+        free(chunk_buf);
+        cxl_trace_close(reader);
+        return -1;
+    }
+    
+    int ret = 0;
+    cxl_stats_t stats;
+    cxl_stats_init(&stats);
+    for (uint64_t c = 0; c < num_chunks; c++) {
+        int n = cxl_trace_decode_chunk(reader, c, chunk_buf);
+        if (n < 0) {
+            ret = -1;
+            break;
+        }
+        cxl_stats_update(&stats, chunk_buf, (size_t)n);
+        cxl_histogram_record_array(hist, chunk_buf, (size_t)n);
+    }
+    
+    if (ret == 0) {
+        *min = stats.min;
+        *max = stats.max;
+        *mean = stats.mean;
+        *stddev = cxl_stats_stddev(&stats);
+        *median = (double)cxl_histogram_quantile(hist, 0.5);
+    }
+    
+    cxl_histogram_destroy(hist);
+    free(chunk_buf);
+    cxl_trace_close(reader);
+    
+    return ret;
+}
+
+int cxl_analysis_quantiles_trace(const char *trace_file, const double *quantiles,
+                                 int num_quantiles, uint64_t *values) {
+    if (!trace_file || !quantiles || num_quantiles <= 0 || !values) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    cxl_trace_reader_t *reader = cxl_trace_open(trace_file);
+    if (!reader) {
+        return -1;
+    }
+    
+    cxl_histogram_t *hist = cxl_histogram_create();
+    if (!hist) {
+        cxl_trace_close(reader);
+        return -1;
+    }
+    
+    int ret = cxl_trace_to_histogram(reader, hist);
+    if (ret == 0) {
+        ret = cxl_histogram_quantiles(hist, quantiles, num_quantiles, values);
+    }
+    
+    cxl_histogram_destroy(hist);
+    cxl_trace_close(reader);
+    
+    return ret;
+}
+
 /* ====== 直方图 ====== */
 int cxl_analysis_histogram(const uint64_t *timings, int num_samples,
                           int num_buckets, uint32_t *histogram) {
@@ -281,27 +814,16 @@ int cxl_analysis_latency_difference(const uint64_t *cxl_timings,
         return -1;
     }
     
-    /* 计算平均延迟 */
-    double cxl_avg = 0.0, normal_avg = 0.0;
-    for (int i = 0; i < num_samples; i++) {
-        cxl_avg += cxl_timings[i];
-        normal_avg += normal_timings[i];
-    }
-    cxl_avg /= num_samples;
-    normal_avg /= num_samples;
+    /* 计算平均延迟与方差 */
+    cxl_stats_t cxl_stats, normal_stats;
+    cxl_stats_compute(cxl_timings, (size_t)num_samples, &cxl_stats);
+    cxl_stats_compute(normal_timings, (size_t)num_samples, &normal_stats);
     
-    *latency_diff = cxl_avg - normal_avg;
+    *latency_diff = cxl_stats.mean - normal_stats.mean;
     
     /* 计算信噪比 */
-    double cxl_var = 0.0, normal_var = 0.0;
-    for (int i = 0; i < num_samples; i++) {
-        double diff = cxl_timings[i] - cxl_avg;
-        cxl_var += diff * diff;
-        diff = normal_timings[i] - normal_avg;
-        normal_var += diff * diff;
-    }
-    cxl_var /= num_samples;
-    normal_var /= num_samples;
+    double cxl_var = cxl_stats_variance(&cxl_stats);
+    double normal_var = cxl_stats_variance(&normal_stats);
     
     double signal = fabs(*latency_diff);
     double noise = sqrt((cxl_var + normal_var) / 2.0);
@@ -320,26 +842,12 @@ int cxl_analysis_hit_miss_separation(const uint64_t *hit_timings, int num_hits,
         return -1;
     }
     
-    double hit_mean = 0.0, miss_mean = 0.0;
-    for (int i = 0; i < num_hits; i++) hit_mean += hit_timings[i];
-    for (int i = 0; i < num_misses; i++) miss_mean += miss_timings[i];
-    hit_mean /= num_hits;
-    miss_mean /= num_misses;
+    cxl_stats_t hit_stats, miss_stats;
+    cxl_stats_compute(hit_timings, (size_t)num_hits, &hit_stats);
+    cxl_stats_compute(miss_timings, (size_t)num_misses, &miss_stats);
     
-    double hit_var = 0.0, miss_var = 0.0;
-    for (int i = 0; i < num_hits; i++) {
-        double diff = hit_timings[i] - hit_mean;
-        hit_var += diff * diff;
-    }
-    for (int i = 0; i < num_misses; i++) {
-        double diff = miss_timings[i] - miss_mean;
-        miss_var += diff * diff;
-    }
-    hit_var /= num_hits;
-    miss_var /= num_misses;
-    
-    double numerator = fabs(hit_mean - miss_mean);
-    double denominator = sqrt(hit_var + miss_var);
+    double numerator = fabs(hit_stats.mean - miss_stats.mean);
+    double denominator = sqrt(cxl_stats_variance(&hit_stats) + cxl_stats_variance(&miss_stats));
     
     *separation_ratio = numerator / (denominator + 1e-9);
     
@@ -349,6 +857,266 @@ int cxl_analysis_hit_miss_separation(const uint64_t *hit_timings, int num_hits,
     return 0;
 }
 
+/* ====== 双峰阈值拟合 ====== */
+
+/* 桶的代表值（ln 周期）：精确桶取其值，其余取区间中点；0 周期按 1 处理 */
+static double analysis_bucket_log(int index) {
+    double low = (double)cxl_histogram_bucket_lowest(index);
+    double high = (double)cxl_histogram_bucket_highest(index);
+    double mid = (low + high) / 2.0;
+    
+    return log(mid < 1.0 ? 1.0 : mid);
+}
+
+/* 非空桶工作区：每个数组 CXL_HIST_NUM_BUCKETS 项，合计约 100 KB，放在堆上 */
+typedef struct {
+    int n;                                  /* 非空桶个数 */
+    int index[CXL_HIST_NUM_BUCKETS];        /* 桶下标 */
+    double x[CXL_HIST_NUM_BUCKETS];         /* ln 周期 */
+    double w[CXL_HIST_NUM_BUCKETS];         /* 样本数 */
+    double resp[CXL_HIST_NUM_BUCKETS];      /* GMM：属于高延迟分量的后验概率 */
+} analysis_buckets_t;
+
+/* 收集非空桶，分配失败返回 NULL */
+static analysis_buckets_t *analysis_collect_buckets(const cxl_histogram_t *hist) {
+    analysis_buckets_t *buckets = malloc(sizeof(analysis_buckets_t));
+    if (!buckets) {
+        fprintf(stderr, "[ERROR] Failed to allocate threshold fitting workspace\n");
+        return NULL;
+    }
+    
+    buckets->n = 0;
+    for (int b = 0; b < CXL_HIST_NUM_BUCKETS; b++) {
+        if (hist->counts[b] == 0) continue;
+        buckets->index[buckets->n] = b;
+        buckets->x[buckets->n] = analysis_bucket_log(b);
+        buckets->w[buckets->n] = (double)hist->counts[b];
+        buckets->n++;
+    }
+    
+    return buckets;
+}
+
+/* Otsu：返回最佳分割位置 k（前 k 个非空桶为低延迟类），失败返回 -1 */
+static int analysis_otsu_split(const double *x, const double *w, int n) {
+    double total = 0.0, total_sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        total += w[i];
+        total_sum += w[i] * x[i];
+    }
+    
+    double w0 = 0.0, sum0 = 0.0, best = -1.0;
+    int best_k = -1;
+    
+    for (int k = 1; k < n; k++) {
+        w0 += w[k - 1];
+        sum0 += w[k - 1] * x[k - 1];
+        
+        double w1 = total - w0;
+        if (w0 <= 0.0 || w1 <= 0.0) continue;
+        
+        double mu0 = sum0 / w0;
+        double mu1 = (total_sum - sum0) / w1;
+        double between = w0 * w1 * (mu0 - mu1) * (mu0 - mu1);
+        
+        if (between > best) {
+            best = between;
+            best_k = k;
+        }
+    }
+    
+    return best_k;
+}
+
+uint64_t cxl_analysis_otsu_threshold(const cxl_histogram_t *hist) {
+    if (!hist || hist->total_count == 0) {
+        return 0;
+    }
+    
+    analysis_buckets_t *buckets = analysis_collect_buckets(hist);
+    if (!buckets) {
+        return 0;
+    }
+    
+    /* 阈值取高延迟类第一个非空桶的下界：小于阈值判为命中 */
+    int k = analysis_otsu_split(buckets->x, buckets->w, buckets->n);
+    uint64_t threshold = (k < 0) ? 0 : cxl_histogram_bucket_lowest(buckets->index[k]);
+    
+    free(buckets);
+    
+    return threshold;
+}
+
+static double analysis_log_normal_pdf(double x, double mean, double var) {
+    double d = x - mean;
+    return -0.5 * (log(2.0 * M_PI * var) + d * d / var);
+}
+
+/* 在非空桶上运行 EM */
+static int analysis_gmm2_em(const double *x, const double *w, double *resp, int n, cxl_gmm2_t *model) {
+    int k = analysis_otsu_split(x, w, n);
+    if (k < 0) {
+        fprintf(stderr, "[WARNING] Histogram has a single mode, cannot fit two components\n");
+        return -1;
+    }
+    
+    /* 以 Otsu 分割初始化两个分量 */
+    double total = 0.0;
+    for (int c = 0; c < 2; c++) {
+        int lo = (c == 0) ? 0 : k;
+        int hi = (c == 0) ? k : n;
+        double sw = 0.0, sx = 0.0, sxx = 0.0;
+        
+        for (int i = lo; i < hi; i++) {
+            sw += w[i];
+            sx += w[i] * x[i];
+        }
+        double mean = sx / sw;
+        for (int i = lo; i < hi; i++) {
+            sxx += w[i] * (x[i] - mean) * (x[i] - mean);
+        }
+        
+        model->weight[c] = sw;
+        model->mean[c] = mean;
+        model->variance[c] = sxx / sw + CXL_GMM_MIN_VARIANCE;
+        total += sw;
+    }
+    model->weight[0] /= total;
+    model->weight[1] /= total;
+    
+    double prev_ll = -INFINITY;
+    
+    for (int iter = 1; iter <= CXL_GMM_MAX_ITER; iter++) {
+        /* E 步：每个桶属于高延迟分量的后验概率 */
+        double ll = 0.0;
+        for (int i = 0; i < n; i++) {
+            double l0 = log(model->weight[0]) + analysis_log_normal_pdf(x[i], model->mean[0], model->variance[0]);
+            double l1 = log(model->weight[1]) + analysis_log_normal_pdf(x[i], model->mean[1], model->variance[1]);
+            double lmax = (l0 > l1) ? l0 : l1;
+            double lsum = lmax + log(exp(l0 - lmax) + exp(l1 - lmax));
+            
+            resp[i] = exp(l1 - lsum);
+            ll += w[i] * lsum;
+        }
+        
+        /* M 步 */
+        double sw[2] = {0.0, 0.0}, sx[2] = {0.0, 0.0};
+        for (int i = 0; i < n; i++) {
+            sw[0] += w[i] * (1.0 - resp[i]);
+            sw[1] += w[i] * resp[i];
+            sx[0] += w[i] * (1.0 - resp[i]) * x[i];
+            sx[1] += w[i] * resp[i] * x[i];
+        }
+        
+        if (sw[0] <= 0.0 || sw[1] <= 0.0) {
+            fprintf(stderr, "[WARNING] GMM component collapsed after %d iterations\n", iter);
+            return -1;
+        }
+        
+        for (int c = 0; c < 2; c++) {
+            model->mean[c] = sx[c] / sw[c];
+        }
+        
+        double sxx[2] = {0.0, 0.0};
+        for (int i = 0; i < n; i++) {
+            double d0 = x[i] - model->mean[0];
+            double d1 = x[i] - model->mean[1];
+            sxx[0] += w[i] * (1.0 - resp[i]) * d0 * d0;
+            sxx[1] += w[i] * resp[i] * d1 * d1;
+        }
+        
+        for (int c = 0; c < 2; c++) {
+            model->weight[c] = sw[c] / total;
+            model->variance[c] = sxx[c] / sw[c] + CXL_GMM_MIN_VARIANCE;
+        }
+        
+        model->iterations = iter;
+        model->log_likelihood = ll;
+        
+        if (fabs(ll - prev_ll) <= CXL_GMM_TOLERANCE * fabs(ll)) {
+            model->converged = 1;
+            break;
+        }
+        prev_ll = ll;
+    }
+    
+    /* 分量 0 为低延迟模式 */
+    if (model->mean[0] > model->mean[1]) {
+        double t;
+        t = model->weight[0]; model->weight[0] = model->weight[1]; model->weight[1] = t;
+        t = model->mean[0]; model->mean[0] = model->mean[1]; model->mean[1] = t;
+        t = model->variance[0]; model->variance[0] = model->variance[1]; model->variance[1] = t;
+    }
+    
+    return 0;
+}
+
+int cxl_analysis_gmm2_fit(const cxl_histogram_t *hist, cxl_gmm2_t *model) {
+    if (!hist || !model || hist->total_count == 0) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    memset(model, 0, sizeof(cxl_gmm2_t));
+    
+    analysis_buckets_t *buckets = analysis_collect_buckets(hist);
+    if (!buckets) {
+        return -1;
+    }
+    
+    int ret = analysis_gmm2_em(buckets->x, buckets->w, buckets->resp, buckets->n, model);
+    free(buckets);
+    
+    return ret;
+}
+
+uint64_t cxl_analysis_gmm2_threshold(const cxl_gmm2_t *model) {
+    if (!model || model->weight[0] <= 0.0 || model->weight[1] <= 0.0) {
+        return 0;
+    }
+    
+    /* 在两个均值之间按直方图桶边界扫描，取高延迟分量后验首次占优的位置 */
+    uint64_t low = (uint64_t)exp(model->mean[0]);
+    uint64_t high = (uint64_t)ceil(exp(model->mean[1]));
+    int first = cxl_histogram_bucket_index(low) + 1;
+    int last = cxl_histogram_bucket_index(high);
+    
+    for (int b = first; b <= last; b++) {
+        uint64_t v = cxl_histogram_bucket_lowest(b);
+        double lx = log((double)(v < 1 ? 1 : v));
+        double l0 = log(model->weight[0]) + analysis_log_normal_pdf(lx, model->mean[0], model->variance[0]);
+        double l1 = log(model->weight[1]) + analysis_log_normal_pdf(lx, model->mean[1], model->variance[1]);
+        
+        if (l1 >= l0) {
+            return v;
+        }
+    }
+    
+    /* 两个均值之间低延迟分量始终占优（权重悬殊），退回几何中点 */
+    return (uint64_t)exp((model->mean[0] + model->mean[1]) / 2.0);
+}
+
+uint64_t cxl_analysis_fit_threshold(const cxl_histogram_t *hist, cxl_threshold_method_t method) {
+    if (!hist || hist->total_count == 0) {
+        return 0;
+    }
+    
+    if (method == CXL_THRESHOLD_GMM) {
+        cxl_gmm2_t model;
+        if (cxl_analysis_gmm2_fit(hist, &model) == 0) {
+            uint64_t threshold = cxl_analysis_gmm2_threshold(&model);
+            if (threshold > 0) return threshold;
+        }
+        fprintf(stderr, "[WARNING] GMM fit failed, falling back to Otsu threshold\n");
+    }
+    
+    return cxl_analysis_otsu_threshold(hist);
+}
+
+const char *cxl_analysis_threshold_method_name(cxl_threshold_method_t method) {
+    return (method == CXL_THRESHOLD_GMM) ? "gmm" : "otsu";
+}
+
 /* ====== 推荐阈值 ====== */
 uint64_t cxl_analysis_recommend_threshold(const uint64_t *hit_timings, int num_hits,
                                           const uint64_t *miss_timings, int num_misses) {
@@ -356,17 +1124,20 @@ uint64_t cxl_analysis_recommend_threshold(const uint64_t *hit_timings, int num_h
         return 0;
     }
     
-    /* 计算平均值 */
-    double hit_avg = 0.0, miss_avg = 0.0;
-    for (int i = 0; i < num_hits; i++) hit_avg += hit_timings[i];
-    for (int i = 0; i < num_misses; i++) miss_avg += miss_timings[i];
-    hit_avg /= num_hits;
-    miss_avg /= num_misses;
+    /* 两组样本合并成一个双峰直方图，用对数域双分量 GMM 找两个模式的分界。
+     * 均值中点对 CXL 不适用：未命中模式远离命中模式且更宽，中点会把大量命中后的慢样本误判 */
+    cxl_histogram_t *hist = cxl_histogram_create();
+    if (!hist) {
+        return 0;
+    }
+    cxl_histogram_record_array(hist, hit_timings, (size_t)num_hits);
+    cxl_histogram_record_array(hist, miss_timings, (size_t)num_misses);
     
-    /* 推荐阈值为两者的中点 */
-    uint64_t threshold = (uint64_t)((hit_avg + miss_avg) / 2.0);
+    uint64_t threshold = cxl_analysis_fit_threshold(hist, CXL_THRESHOLD_GMM);
+    cxl_histogram_destroy(hist);
     
-    fprintf(stdout, "[INFO] Recommended timing threshold: %lu cycles\n", threshold);
+    fprintf(stdout, "[INFO] Recommended timing threshold: %lu cycles (%.1f ns)\n",
+            threshold, cxl_cycles_to_ns_f(threshold));
     
     return threshold;
 }
@@ -468,13 +1239,14 @@ int cxl_analysis_export_json(const attack_result_t *results, int num_results,
         return -1;
     }
     
-    fprintf(file, "{\n  \"results\": [\n");
+    fprintf(file, "{\n  \"tsc_hz\": %lu,\n  \"results\": [\n", cxl_tsc_hz());
     
     for (int i = 0; i < num_results; i++) {
         fprintf(file, "    {\n");
         fprintf(file, "      \"attack_id\": %lu,\n", results[i].attack_id);
         fprintf(file, "      \"is_hit\": %d,\n", results[i].is_hit);
         fprintf(file, "      \"latency_diff\": %lu,\n", results[i].latency_diff);
+        fprintf(file, "      \"latency_diff_ns\": %.1f,\n", cxl_cycles_to_ns_f(results[i].latency_diff));
         fprintf(file, "      \"hit_count\": %u,\n", results[i].hit_count);
         fprintf(file, "      \"miss_count\": %u\n", results[i].miss_count);
         fprintf(file, "    }");
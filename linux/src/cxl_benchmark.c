@@ -0,0 +1,1248 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <numa.h>
+#include <numaif.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <linux/capability.h>
+#include <immintrin.h>
+#include "cxl_benchmark.h"
+#include "cxl_common.h"
+
+/* ====== 模块状态 ====== */
+static struct {
+    page_mode_t page_mode;      /* 所有测试缓冲区的页大小模式 */
+} bench_state = {PAGE_MODE_4K};
+
+/* 防止编译器消除追逐循环 */
+static void * volatile chase_sink;
+
+/* ====== 辅助函数 ====== */
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* 测试缓冲区：按当前页大小模式分配、绑定节点并预先缺页 */
+static void *bench_alloc(size_t size, int node, size_t *page_size) {
+    return cxl_malloc_on_node_pages(size, node, bench_state.page_mode, page_size);
+}
+
+static void bench_free(void *ptr, size_t size) {
+    cxl_free_pages(ptr, size, bench_state.page_mode);
+}
+
+/* xorshift64*：rand() 的 RAND_MAX 不足以打乱数 GiB 的工作集 */
+static uint64_t bench_random(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+/* ====== 链表构造 ====== */
+void *cxl_chase_build(void *buffer, size_t size, size_t stride, uint64_t seed) {
+    if (!buffer || stride < sizeof(uint64_t) || stride % sizeof(uint64_t) != 0) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return NULL;
+    }
+    
+    size_t num_nodes = size / stride;
+    if (num_nodes < 2) {
+        fprintf(stderr, "[ERROR] Working set too small for stride %zu\n", stride);
+        return NULL;
+    }
+    
+    uint8_t *base = (uint8_t *)buffer;
+    uint64_t state = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    
+    /* 每个节点的第一个字先存放索引 */
+    for (size_t i = 0; i < num_nodes; i++) {
+        *(uint64_t *)(base + i * stride) = i;
+    }
+    
+    /* Sattolo 洗牌：结果 i -> a[i] 恰好是一个覆盖全部节点的单环 */
+    for (size_t i = num_nodes - 1; i > 0; i--) {
+        size_t j = (size_t)(bench_random(&state) % i);
+        uint64_t *slot_i = (uint64_t *)(base + i * stride);
+        uint64_t *slot_j = (uint64_t *)(base + j * stride);
+        uint64_t tmp = *slot_i;
+        *slot_i = *slot_j;
+        *slot_j = tmp;
+    }
+    
+    /* 索引转换为指针 */
+    for (size_t i = 0; i < num_nodes; i++) {
+        uint64_t *slot = (uint64_t *)(base + i * stride);
+        *slot = (uint64_t)(uintptr_t)(base + (*slot) * stride);
+    }
+    
+    return buffer;
+}
+
+/* ====== 链表追逐 ====== */
+static void *chase_loop(void *head, uint64_t num_loads) {
+    void **p = (void **)head;
+    uint64_t i = 0;
+    
+    /* 8 路展开，循环控制开销分摊到依赖链上 */
+    for (; i + 8 <= num_loads; i += 8) {
+        p = (void **)*p; p = (void **)*p; p = (void **)*p; p = (void **)*p;
+        p = (void **)*p; p = (void **)*p; p = (void **)*p; p = (void **)*p;
+    }
+    for (; i < num_loads; i++) {
+        p = (void **)*p;
+    }
+    
+    return (void *)p;
+}
+
+int cxl_chase_run(void *head, uint64_t num_loads, chase_result_t *result) {
+    if (!head || num_loads == 0 || !result) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    cxl_mfence();
+    uint64_t start_ns = bench_now_ns();
+    uint64_t start_tsc = cxl_rdtscp(NULL);
+    
+    chase_sink = chase_loop(head, num_loads);
+    
+    uint64_t end_tsc = cxl_rdtscp(NULL);
+    uint64_t end_ns = bench_now_ns();
+    
+    result->num_loads = num_loads;
+    result->ns_per_load = (double)(end_ns - start_ns) / (double)num_loads;
+    result->cycles_per_load = (double)(end_tsc - start_tsc) / (double)num_loads;
+    
+    return 0;
+}
+
+/* ====== 单点测量 ====== */
+int cxl_bench_pointer_chase(int node, size_t working_set, uint64_t num_loads,
+                            chase_result_t *result) {
+    if (node < 0 || working_set < 2 * CXL_CACHE_LINE_SIZE || num_loads == 0 || !result) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    size_t page_size = 0;
+    void *buffer = bench_alloc(working_set, node, &page_size);
+    if (!buffer) {
+        return -1;
+    }
+    
+    void *head = cxl_chase_build(buffer, working_set, CXL_CACHE_LINE_SIZE,
+                                 0x5DEECE66DULL ^ working_set);
+    if (!head) {
+        bench_free(buffer, working_set);
+        return -1;
+    }
+    
+    /* 预热：填充缓存与 TLB，但不超过计时加载次数 */
+    uint64_t num_lines = working_set / CXL_CACHE_LINE_SIZE;
+    chase_result_t warmup;
+    cxl_chase_run(head, (num_lines < num_loads) ? num_lines : num_loads, &warmup);
+    
+    memset(result, 0, sizeof(chase_result_t));
+    
+    /* 硬件计数只包围计时的追逐，不含分配、建链与预热 */
+    cxl_perf_t perf;
+    cxl_perf_counts_t perf_start, perf_end;
+    cxl_perf_open(&perf);
+    cxl_perf_read(&perf, &perf_start);
+    int ret = cxl_chase_run(head, num_loads, result);
+    cxl_perf_read(&perf, &perf_end);
+    cxl_perf_close(&perf);
+    cxl_perf_diff(&perf_end, &perf_start, &result->perf);
+    result->node = node;
+    result->working_set = working_set;
+    result->stride = CXL_CACHE_LINE_SIZE;
+    result->page_size = page_size;
+    
+    bench_free(buffer, working_set);
+    
+    return ret;
+}
+
+/* ====== 工作集扫描 ====== */
+int cxl_bench_latency_sweep(int node, size_t min_working_set, size_t max_working_set,
+                            uint64_t num_loads, chase_result_t *results, int max_results) {
+    if (node < 0 || !results || max_results <= 0 || min_working_set == 0 ||
+        max_working_set < min_working_set) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    /* 不要把节点内存耗尽 */
+    long long free_bytes = 0;
+    if (numa_node_size64(node, &free_bytes) > 0 && free_bytes > 0 &&
+        max_working_set > (size_t)(free_bytes / 2)) {
+        max_working_set = (size_t)(free_bytes / 2);
+        fprintf(stdout, "[INFO] Node %d: max working set capped to %zu MiB (free memory)\n",
+                node, max_working_set >> 20);
+    }
+    
+    int count = 0;
+    for (size_t ws = min_working_set; ws <= max_working_set && count < max_results; ws *= 2) {
+        if (cxl_bench_pointer_chase(node, ws, num_loads, &results[count]) < 0) {
+            fprintf(stderr, "[WARNING] Pointer chase failed on node %d at %zu bytes\n", node, ws);
+            break;
+        }
+        count++;
+    }
+    
+    return count;
+}
+
+/* ====== 带宽内核：标量实现 ====== */
+static double bw_read_scalar(const double *a, size_t n) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    for (size_t i = 0; i < n; i += 4) {
+        s0 += a[i];
+        s1 += a[i + 1];
+        s2 += a[i + 2];
+        s3 += a[i + 3];
+    }
+    return s0 + s1 + s2 + s3;
+}
+
+static void bw_write_scalar(double *a, size_t n, double scalar) {
+    for (size_t i = 0; i < n; i++) a[i] = scalar;
+}
+
+static void bw_copy_scalar(double *a, const double *b, size_t n) {
+    for (size_t i = 0; i < n; i++) a[i] = b[i];
+}
+
+static void bw_triad_scalar(double *a, const double *b, const double *c, size_t n, double scalar) {
+    for (size_t i = 0; i < n; i++) a[i] = b[i] + scalar * c[i];
+}
+
+/* ====== 带宽内核：AVX2 实现 ====== */
+__attribute__((target("avx2")))
+static double bw_read_avx2(const double *a, size_t n) {
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+    for (size_t i = 0; i < n; i += 16) {
+        s0 = _mm256_add_pd(s0, _mm256_load_pd(a + i));
+        s1 = _mm256_add_pd(s1, _mm256_load_pd(a + i + 4));
+        s2 = _mm256_add_pd(s2, _mm256_load_pd(a + i + 8));
+        s3 = _mm256_add_pd(s3, _mm256_load_pd(a + i + 12));
+    }
+    __m256d sum = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+    double lanes[4];
+    _mm256_storeu_pd(lanes, sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+__attribute__((target("avx2")))
+static void bw_write_avx2(double *a, size_t n, double scalar) {
+    __m256d v = _mm256_set1_pd(scalar);
+    for (size_t i = 0; i < n; i += 8) {
+        _mm256_store_pd(a + i, v);
+        _mm256_store_pd(a + i + 4, v);
+    }
+}
+
+__attribute__((target("avx2")))
+static void bw_copy_avx2(double *a, const double *b, size_t n) {
+    for (size_t i = 0; i < n; i += 8) {
+        _mm256_store_pd(a + i, _mm256_load_pd(b + i));
+        _mm256_store_pd(a + i + 4, _mm256_load_pd(b + i + 4));
+    }
+}
+
+__attribute__((target("avx2")))
+static void bw_triad_avx2(double *a, const double *b, const double *c, size_t n, double scalar) {
+    __m256d s = _mm256_set1_pd(scalar);
+    for (size_t i = 0; i < n; i += 4) {
+        _mm256_store_pd(a + i, _mm256_add_pd(_mm256_load_pd(b + i),
+                                             _mm256_mul_pd(s, _mm256_load_pd(c + i))));
+    }
+}
+
+/* ====== 带宽内核：AVX-512 实现 ====== */
+__attribute__((target("avx512f")))
+static double bw_read_avx512(const double *a, size_t n) {
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    for (size_t i = 0; i < n; i += 16) {
+        s0 = _mm512_add_pd(s0, _mm512_load_pd(a + i));
+        s1 = _mm512_add_pd(s1, _mm512_load_pd(a + i + 8));
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+}
+
+__attribute__((target("avx512f")))
+static void bw_write_avx512(double *a, size_t n, double scalar) {
+    __m512d v = _mm512_set1_pd(scalar);
+    for (size_t i = 0; i < n; i += 8) {
+        _mm512_store_pd(a + i, v);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void bw_copy_avx512(double *a, const double *b, size_t n) {
+    for (size_t i = 0; i < n; i += 8) {
+        _mm512_store_pd(a + i, _mm512_load_pd(b + i));
+    }
+}
+
+__attribute__((target("avx512f")))
+static void bw_triad_avx512(double *a, const double *b, const double *c, size_t n, double scalar) {
+    __m512d s = _mm512_set1_pd(scalar);
+    for (size_t i = 0; i < n; i += 8) {
+        _mm512_store_pd(a + i, _mm512_add_pd(_mm512_load_pd(b + i),
+                                             _mm512_mul_pd(s, _mm512_load_pd(c + i))));
+    }
+}
+
+/* ====== 运行时 SIMD 分派 ====== */
+static struct {
+    const char *name;
+    double (*read)(const double *a, size_t n);
+    void (*write)(double *a, size_t n, double scalar);
+    void (*copy)(double *a, const double *b, size_t n);
+    void (*triad)(double *a, const double *b, const double *c, size_t n, double scalar);
+} bw_dispatch = {0};
+
+static pthread_once_t bw_dispatch_once = PTHREAD_ONCE_INIT;
+
+static void bw_select_kernels(void) {
+    __builtin_cpu_init();
+    
+    if (__builtin_cpu_supports("avx512f")) {
+        bw_dispatch.name = "avx512";
+        bw_dispatch.read = bw_read_avx512;
+        bw_dispatch.write = bw_write_avx512;
+        bw_dispatch.copy = bw_copy_avx512;
+        bw_dispatch.triad = bw_triad_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        bw_dispatch.name = "avx2";
+        bw_dispatch.read = bw_read_avx2;
+        bw_dispatch.write = bw_write_avx2;
+        bw_dispatch.copy = bw_copy_avx2;
+        bw_dispatch.triad = bw_triad_avx2;
+    } else {
+        bw_dispatch.name = "scalar";
+        bw_dispatch.read = bw_read_scalar;
+        bw_dispatch.write = bw_write_scalar;
+        bw_dispatch.copy = bw_copy_scalar;
+        bw_dispatch.triad = bw_triad_scalar;
+    }
+}
+
+const char *cxl_bench_simd_level(void) {
+    pthread_once(&bw_dispatch_once, bw_select_kernels);
+    return bw_dispatch.name;
+}
+
+const char *cxl_bench_kernel_name(bw_kernel_t kernel) {
+    static const char *names[] = {"read", "write", "copy", "triad"};
+    
+    if (kernel < 0 || kernel >= BW_KERNEL_COUNT) {
+        return "unknown";
+    }
+    
+    return names[kernel];
+}
+
+/* ====== 线程屏障 ====== */
+
+/* 参与者数量可以下调：线程创建失败时已启动的线程不会永远阻塞 */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int count;
+    int waiting;
+    unsigned int generation;
+} bench_barrier_t;
+
+static void bench_barrier_init(bench_barrier_t *barrier, int count) {
+    pthread_mutex_init(&barrier->lock, NULL);
+    pthread_cond_init(&barrier->cond, NULL);
+    barrier->count = count;
+    barrier->waiting = 0;
+    barrier->generation = 0;
+}
+
+static void bench_barrier_destroy(bench_barrier_t *barrier) {
+    pthread_mutex_destroy(&barrier->lock);
+    pthread_cond_destroy(&barrier->cond);
+}
+
+static void bench_barrier_release_locked(bench_barrier_t *barrier) {
+    barrier->waiting = 0;
+    barrier->generation++;
+    pthread_cond_broadcast(&barrier->cond);
+}
+
+static void bench_barrier_wait(bench_barrier_t *barrier) {
+    pthread_mutex_lock(&barrier->lock);
+    
+    unsigned int generation = barrier->generation;
+    if (++barrier->waiting >= barrier->count) {
+        bench_barrier_release_locked(barrier);
+    } else {
+        while (generation == barrier->generation) {
+            pthread_cond_wait(&barrier->cond, &barrier->lock);
+        }
+    }
+    
+    pthread_mutex_unlock(&barrier->lock);
+}
+
+static void bench_barrier_set_count(bench_barrier_t *barrier, int count) {
+    pthread_mutex_lock(&barrier->lock);
+    
+    barrier->count = count;
+    if (barrier->waiting > 0 && barrier->waiting >= barrier->count) {
+        bench_barrier_release_locked(barrier);
+    }
+    
+    pthread_mutex_unlock(&barrier->lock);
+}
+
+/* ====== 带宽测试线程 ====== */
+typedef struct {
+    int cpu;
+    int node;
+    bw_kernel_t kernel;
+    size_t num_elements;
+    int repeats;
+    bench_barrier_t *barrier;
+    uint64_t *start_ns;         /* [repeats] */
+    uint64_t *end_ns;           /* [repeats] */
+    cxl_perf_counts_t *perf;    /* [repeats]，每次重复的硬件计数 */
+    size_t page_size;           /* 实际页大小 */
+    int status;
+} bw_worker_t;
+
+static volatile double bw_sink;
+
+static void *bw_worker_main(void *arg) {
+    bw_worker_t *worker = (bw_worker_t *)arg;
+    size_t bytes = worker->num_elements * sizeof(double);
+    double *a = NULL, *b = NULL, *c = NULL;
+    cxl_perf_t perf;
+    cxl_perf_counts_t perf_start, perf_end;
+    
+    worker->status = -1;
+    memset(&perf, 0, sizeof(perf));
+    
+    if (cxl_bind_to_cpu(worker->cpu) == 0) {
+        a = bench_alloc(bytes, worker->node, &worker->page_size);
+        b = bench_alloc(bytes, worker->node, NULL);
+        c = bench_alloc(bytes, worker->node, NULL);
+    }
+    
+    if (a && b && c) {
+        for (size_t i = 0; i < worker->num_elements; i++) {
+            a[i] = 1.0;
+            b[i] = 2.0;
+            c[i] = 0.5;
+        }
+        cxl_perf_open(&perf);
+        worker->status = 0;
+    }
+    
+    for (int r = 0; r < worker->repeats; r++) {
+        bench_barrier_wait(worker->barrier);
+        
+        worker->start_ns[r] = bench_now_ns();
+        cxl_perf_read(&perf, &perf_start);
+        
+        if (worker->status == 0) {
+            switch (worker->kernel) {
+                case BW_KERNEL_READ:
+                    bw_sink = bw_dispatch.read(a, worker->num_elements);
+                    break;
+                case BW_KERNEL_WRITE:
+                    bw_dispatch.write(a, worker->num_elements, (double)r);
+                    break;
+                case BW_KERNEL_COPY:
+                    bw_dispatch.copy(a, b, worker->num_elements);
+                    break;
+                case BW_KERNEL_TRIAD:
+                    bw_dispatch.triad(a, b, c, worker->num_elements, 3.0);
+                    break;
+                default:
+                    break;
+            }
+        }
+        
+        cxl_perf_read(&perf, &perf_end);
+        worker->end_ns[r] = bench_now_ns();
+        
+        cxl_perf_diff(&perf_end, &perf_start, &worker->perf[r]);
+    }
+    
+    cxl_perf_close(&perf);
+    if (a) bench_free(a, bytes);
+    if (b) bench_free(b, bytes);
+    if (c) bench_free(c, bytes);
+    
+    return NULL;
+}
+
+/* ====== 页大小模式 ====== */
+void cxl_bench_set_page_mode(page_mode_t mode) {
+    bench_state.page_mode = mode;
+}
+
+page_mode_t cxl_bench_get_page_mode(void) {
+    return bench_state.page_mode;
+}
+
+/* ====== CPU 选择 ====== */
+int cxl_bench_select_cpus(int node, int *cpus, int max_cpus) {
+    if (!cpus || max_cpus <= 0) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) < 0) {
+        fprintf(stderr, "[ERROR] Failed to get CPU affinity\n");
+        return -1;
+    }
+    
+    int count = 0;
+    for (int cpu = 0; cpu < CXL_MAX_CORES && count < max_cpus; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        if (node >= 0 && numa_node_of_cpu(cpu) != node) continue;
+        cpus[count++] = cpu;
+    }
+    
+    if (count == 0 && node >= 0) {
+        return cxl_bench_select_cpus(-1, cpus, max_cpus);
+    }
+    
+    return count;
+}
+
+/* ====== 多线程带宽测试 ====== */
+int cxl_bench_bandwidth(int node, const int *cpus, int num_threads, bw_kernel_t kernel,
+                        size_t bytes_per_thread, int repeats, bandwidth_result_t *result) {
+    if (node < 0 || !cpus || num_threads <= 0 || num_threads > CXL_MAX_THREADS ||
+        kernel < 0 || kernel >= BW_KERNEL_COUNT || repeats <= 0 || !result) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    pthread_once(&bw_dispatch_once, bw_select_kernels);
+    
+    /* 元素数对齐到 64，满足所有展开内核的步长 */
+    size_t num_elements = (bytes_per_thread / sizeof(double)) & ~(size_t)63;
+    if (num_elements == 0) {
+        fprintf(stderr, "[ERROR] Bandwidth array too small: %zu bytes\n", bytes_per_thread);
+        return -1;
+    }
+    
+    bw_worker_t workers[CXL_MAX_THREADS];
+    pthread_t threads[CXL_MAX_THREADS];
+    bench_barrier_t barrier;
+    uint64_t *timestamps = calloc((size_t)num_threads * repeats * 2, sizeof(uint64_t));
+    cxl_perf_counts_t *perf = calloc((size_t)num_threads * repeats, sizeof(cxl_perf_counts_t));
+    
+    if (!timestamps || !perf) {
+        fprintf(stderr, "[ERROR] Failed to allocate timestamp buffer\n");
+        free(timestamps);
+        free(perf);
+        return -1;
+    }
+    
+    bench_barrier_init(&barrier, num_threads);
+    
+    int created = 0;
+    for (int t = 0; t < num_threads; t++) {
+        workers[t].cpu = cpus[t];
+        workers[t].node = node;
+        workers[t].kernel = kernel;
+        workers[t].num_elements = num_elements;
+        workers[t].repeats = repeats;
+        workers[t].barrier = &barrier;
+        workers[t].start_ns = timestamps + (size_t)t * repeats * 2;
+        workers[t].end_ns = workers[t].start_ns + repeats;
+        workers[t].perf = perf + (size_t)t * repeats;
+        workers[t].status = -1;
+        
+        if (pthread_create(&threads[t], NULL, bw_worker_main, &workers[t]) != 0) {
+            fprintf(stderr, "[ERROR] Failed to create bandwidth thread %d\n", t);
+            break;
+        }
+        created++;
+    }
+    
+    /* 创建失败：让已启动的线程跑完后整体判定失败 */
+    if (created < num_threads) {
+        bench_barrier_set_count(&barrier, created);
+    }
+    
+    int failed = num_threads - created;
+    for (int t = 0; t < created; t++) {
+        pthread_join(threads[t], NULL);
+        if (workers[t].status < 0) failed++;
+    }
+    
+    bench_barrier_destroy(&barrier);
+    
+    if (failed > 0) {
+        fprintf(stderr, "[ERROR] %d bandwidth threads failed to set up on node %d\n", failed, node);
+        free(timestamps);
+        free(perf);
+        return -1;
+    }
+    
+    /* 每次重复的耗时 = 最晚结束 - 最早开始，取最快的一次 */
+    double best = 0.0;
+    int best_repeat = 0;
+    for (int r = 0; r < repeats; r++) {
+        uint64_t first_start = UINT64_MAX, last_end = 0;
+        for (int t = 0; t < num_threads; t++) {
+            if (workers[t].start_ns[r] < first_start) first_start = workers[t].start_ns[r];
+            if (workers[t].end_ns[r] > last_end) last_end = workers[t].end_ns[r];
+        }
+        double seconds = (double)(last_end - first_start) / 1e9;
+        if (r == 0 || seconds < best) {
+            best = seconds;
+            best_repeat = r;
+        }
+    }
+    
+    static const int arrays_touched[] = {1, 1, 2, 3};
+    
+    memset(result, 0, sizeof(bandwidth_result_t));
+    for (int t = 0; t < num_threads; t++) {
+        cxl_perf_accumulate(&result->perf, &workers[t].perf[best_repeat]);
+    }
+    
+    free(timestamps);
+    free(perf);
+    
+    result->node = node;
+    result->num_threads = num_threads;
+    result->kernel = kernel;
+    result->bytes_per_thread = num_elements * sizeof(double);
+    result->page_size = workers[0].page_size;
+    result->bytes_moved = (uint64_t)num_threads * arrays_touched[kernel] * result->bytes_per_thread;
+    result->seconds = best;
+    result->gbps = (best > 0.0) ? (double)result->bytes_moved / best / 1e9 : 0.0;
+    
+    return 0;
+}
+
+/* ====== 负载延迟测试 ====== */
+const char *cxl_bench_traffic_name(inject_traffic_t traffic) {
+    static const char *names[] = {"read", "write", "rw"};
+    
+    if (traffic < 0 || traffic >= INJECT_COUNT) {
+        return "unknown";
+    }
+    
+    return names[traffic];
+}
+
+static inline void bench_pause(void) {
+    asm volatile("pause" ::: "memory");
+}
+
+/* 注入线程：进度计数器独占缓存行，避免与追逐线程读取时产生伪共享 */
+typedef struct {
+    volatile uint64_t bytes;    /* 已产生的流量（字节），每 4 KiB 发布一次 */
+    int cpu;
+    uint8_t *buffer;
+    size_t size;
+    inject_traffic_t traffic;
+    uint32_t delay;
+    volatile int *stop;
+    bench_barrier_t *barrier;
+    int status;
+} __attribute__((aligned(CXL_CACHE_LINE_SIZE))) injector_t;
+
+static void *injector_main(void *arg) {
+    injector_t *injector = (injector_t *)arg;
+    uint64_t local_bytes = 0;
+    uint64_t acc = 0;
+    size_t bytes_per_line = (injector->traffic == INJECT_READ_WRITE) ?
+                            2 * CXL_CACHE_LINE_SIZE : CXL_CACHE_LINE_SIZE;
+    
+    injector->status = (cxl_bind_to_cpu(injector->cpu) == 0) ? 0 : -1;
+    
+    /* 即使绑定失败也必须到达屏障，否则其他线程会永远等待 */
+    bench_barrier_wait(injector->barrier);
+    
+    while (injector->status == 0 && !__atomic_load_n(injector->stop, __ATOMIC_RELAXED)) {
+        for (size_t off = 0; off < injector->size; off += CXL_CACHE_LINE_SIZE) {
+            uint64_t *line = (uint64_t *)(injector->buffer + off);
+            
+            switch (injector->traffic) {
+                case INJECT_READ:
+                    acc += *(volatile uint64_t *)line;
+                    break;
+                case INJECT_WRITE:
+                    for (int w = 0; w < CXL_CACHE_LINE_SIZE / 8; w++) {
+                        _mm_stream_si64((long long *)&line[w], (long long)off);
+                    }
+                    break;
+                case INJECT_READ_WRITE:
+                    *(volatile uint64_t *)line = *(volatile uint64_t *)line + 1;
+                    break;
+                default:
+                    break;
+            }
+            
+            for (uint32_t d = 0; d < injector->delay; d++) {
+                bench_pause();
+            }
+            
+            local_bytes += bytes_per_line;
+            if ((off & (CXL_PAGE_SIZE - 1)) == 0) {
+                __atomic_store_n(&injector->bytes, local_bytes, __ATOMIC_RELAXED);
+                if (__atomic_load_n(injector->stop, __ATOMIC_RELAXED)) break;
+            }
+        }
+    }
+    
+    if (injector->traffic == INJECT_WRITE) {
+        _mm_sfence();
+    }
+    bw_sink = (double)acc;
+    
+    return NULL;
+}
+
+/* 追逐线程：所有注入线程就位后预热，然后在计时窗口前后读取注入进度 */
+typedef struct {
+    int cpu;
+    void *head;
+    uint64_t num_loads;
+    uint64_t warmup_loads;
+    injector_t *injectors;
+    int num_injectors;
+    volatile int *stop;
+    bench_barrier_t *barrier;
+    chase_result_t chase;
+    double injected_gbps;
+    int status;
+} chase_worker_t;
+
+static uint64_t injected_bytes(const injector_t *injectors, int num_injectors) {
+    uint64_t total = 0;
+    for (int i = 0; i < num_injectors; i++) {
+        total += __atomic_load_n(&injectors[i].bytes, __ATOMIC_RELAXED);
+    }
+    return total;
+}
+
+static void *chase_worker_main(void *arg) {
+    chase_worker_t *worker = (chase_worker_t *)arg;
+    
+    worker->status = (cxl_bind_to_cpu(worker->cpu) == 0) ? 0 : -1;
+    
+    bench_barrier_wait(worker->barrier);
+    
+    if (worker->status == 0) {
+        chase_result_t warmup;
+        cxl_chase_run(worker->head, worker->warmup_loads, &warmup);
+        
+        cxl_perf_t perf;
+        cxl_perf_counts_t perf_start, perf_end;
+        cxl_perf_open(&perf);
+        
+        uint64_t bytes_before = injected_bytes(worker->injectors, worker->num_injectors);
+        uint64_t start_ns = bench_now_ns();
+        cxl_perf_read(&perf, &perf_start);
+        
+        worker->status = cxl_chase_run(worker->head, worker->num_loads, &worker->chase);
+        
+        cxl_perf_read(&perf, &perf_end);
+        uint64_t end_ns = bench_now_ns();
+        uint64_t bytes_after = injected_bytes(worker->injectors, worker->num_injectors);
+        
+        cxl_perf_close(&perf);
+        cxl_perf_diff(&perf_end, &perf_start, &worker->chase.perf);
+        
+        worker->injected_gbps = (end_ns > start_ns) ?
+                                (double)(bytes_after - bytes_before) / (double)(end_ns - start_ns) : 0.0;
+    }
+    
+    __atomic_store_n(worker->stop, 1, __ATOMIC_RELAXED);
+    
+    return NULL;
+}
+
+/* 扫描过程中复用的缓冲区 */
+typedef struct {
+    void *chase_buffer;
+    void *chase_head;
+    uint8_t *inject_buffers[CXL_MAX_THREADS];
+    size_t inject_bytes;
+    int num_buffers;
+    size_t page_size;           /* 追逐缓冲区的实际页大小 */
+} loaded_setup_t;
+
+static void loaded_teardown(const loaded_latency_params_t *params, loaded_setup_t *setup) {
+    if (setup->chase_buffer) {
+        bench_free(setup->chase_buffer, params->chase_working_set);
+    }
+    for (int i = 0; i < setup->num_buffers; i++) {
+        bench_free(setup->inject_buffers[i], setup->inject_bytes);
+    }
+    memset(setup, 0, sizeof(loaded_setup_t));
+}
+
+static int loaded_setup(const loaded_latency_params_t *params, loaded_setup_t *setup) {
+    memset(setup, 0, sizeof(loaded_setup_t));
+    
+    setup->chase_buffer = bench_alloc(params->chase_working_set, params->node, &setup->page_size);
+    if (!setup->chase_buffer) {
+        return -1;
+    }
+    
+    setup->chase_head = cxl_chase_build(setup->chase_buffer, params->chase_working_set,
+                                        CXL_CACHE_LINE_SIZE,
+                                        0x5DEECE66DULL ^ params->chase_working_set);
+    if (!setup->chase_head) {
+        loaded_teardown(params, setup);
+        return -1;
+    }
+    
+    setup->inject_bytes = params->inject_bytes & ~(size_t)(CXL_PAGE_SIZE - 1);
+    for (int i = 0; i < params->num_injectors; i++) {
+        setup->inject_buffers[i] = bench_alloc(setup->inject_bytes, params->node, NULL);
+        if (!setup->inject_buffers[i]) {
+            loaded_teardown(params, setup);
+            return -1;
+        }
+        setup->num_buffers++;
+    }
+    
+    return 0;
+}
+
+static int loaded_measure(const loaded_latency_params_t *params, loaded_setup_t *setup,
+                          int num_injectors, uint32_t delay, loaded_latency_result_t *result) {
+    injector_t injectors[CXL_MAX_THREADS];
+    pthread_t threads[CXL_MAX_THREADS];
+    chase_worker_t chaser;
+    pthread_t chase_thread;
+    bench_barrier_t barrier;
+    volatile int stop = 0;
+    
+    bench_barrier_init(&barrier, num_injectors + 1);
+    
+    int created = 0;
+    for (int i = 0; i < num_injectors; i++) {
+        memset(&injectors[i], 0, sizeof(injector_t));
+        injectors[i].cpu = params->injector_cpus[i];
+        injectors[i].buffer = setup->inject_buffers[i];
+        injectors[i].size = setup->inject_bytes;
+        injectors[i].traffic = params->traffic;
+        injectors[i].delay = delay;
+        injectors[i].stop = &stop;
+        injectors[i].barrier = &barrier;
+        
+        if (pthread_create(&threads[i], NULL, injector_main, &injectors[i]) != 0) {
+            fprintf(stderr, "[ERROR] Failed to create injector thread %d\n", i);
+            break;
+        }
+        created++;
+    }
+    
+    memset(&chaser, 0, sizeof(chase_worker_t));
+    chaser.cpu = params->chase_cpu;
+    chaser.head = setup->chase_head;
+    chaser.num_loads = params->num_loads;
+    chaser.warmup_loads = params->chase_working_set / CXL_CACHE_LINE_SIZE;
+    if (chaser.warmup_loads > params->num_loads) chaser.warmup_loads = params->num_loads;
+    chaser.injectors = injectors;
+    chaser.num_injectors = created;
+    chaser.stop = &stop;
+    chaser.barrier = &barrier;
+    chaser.status = -1;
+    
+    int chase_created = 0;
+    if (created == num_injectors) {
+        if (pthread_create(&chase_thread, NULL, chase_worker_main, &chaser) == 0) {
+            chase_created = 1;
+        } else {
+            fprintf(stderr, "[ERROR] Failed to create chase thread\n");
+        }
+    }
+    
+    /* 创建失败：通知已启动的注入线程退出 */
+    if (!chase_created) {
+        __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+        bench_barrier_set_count(&barrier, created);
+    }
+    
+    int failed = chase_created ? 0 : 1;
+    if (chase_created) {
+        pthread_join(chase_thread, NULL);
+        if (chaser.status < 0) failed++;
+    }
+    for (int i = 0; i < created; i++) {
+        pthread_join(threads[i], NULL);
+        if (injectors[i].status < 0) failed++;
+    }
+    
+    bench_barrier_destroy(&barrier);
+    
+    if (failed > 0) {
+        fprintf(stderr, "[ERROR] Loaded latency measurement failed on node %d\n", params->node);
+        return -1;
+    }
+    
+    memset(result, 0, sizeof(loaded_latency_result_t));
+    result->node = params->node;
+    result->num_injectors = num_injectors;
+    result->traffic = params->traffic;
+    result->delay = delay;
+    result->injected_gbps = chaser.injected_gbps;
+    result->ns_per_load = chaser.chase.ns_per_load;
+    result->cycles_per_load = chaser.chase.cycles_per_load;
+    result->num_loads = chaser.chase.num_loads;
+    result->page_size = setup->page_size;
+    result->perf = chaser.chase.perf;
+    
+    return 0;
+}
+
+static int loaded_params_valid(const loaded_latency_params_t *params) {
+    return params && params->node >= 0 && params->chase_cpu >= 0 &&
+           params->num_injectors >= 0 && params->num_injectors < CXL_MAX_THREADS &&
+           (params->num_injectors == 0 || params->injector_cpus) &&
+           params->traffic >= 0 && params->traffic < INJECT_COUNT &&
+           params->chase_working_set >= 2 * CXL_CACHE_LINE_SIZE &&
+           (params->num_injectors == 0 || params->inject_bytes >= CXL_PAGE_SIZE) &&
+           params->num_loads > 0;
+}
+
+int cxl_bench_loaded_latency(const loaded_latency_params_t *params, uint32_t delay,
+                             loaded_latency_result_t *result) {
+    if (!loaded_params_valid(params) || !result) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    loaded_setup_t setup;
+    if (loaded_setup(params, &setup) < 0) {
+        return -1;
+    }
+    
+    int ret = loaded_measure(params, &setup, params->num_injectors, delay, result);
+    
+    loaded_teardown(params, &setup);
+    
+    return ret;
+}
+
+int cxl_bench_loaded_latency_sweep(const loaded_latency_params_t *params, const uint32_t *delays,
+                                   int num_delays, loaded_latency_result_t *results) {
+    if (!loaded_params_valid(params) || !results || num_delays < 0 ||
+        num_delays > CXL_BENCH_MAX_DELAYS || (num_delays > 0 && !delays)) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    loaded_setup_t setup;
+    if (loaded_setup(params, &setup) < 0) {
+        return -1;
+    }
+    
+    /* 第一个点为空载基线 */
+    int count = 0;
+    if (loaded_measure(params, &setup, 0, 0, &results[count]) == 0) {
+        count++;
+    }
+    
+    for (int d = 0; d < num_delays && params->num_injectors > 0; d++) {
+        if (loaded_measure(params, &setup, params->num_injectors, delays[d], &results[count]) < 0) {
+            fprintf(stderr, "[WARNING] Loaded latency failed on node %d at delay %u\n",
+                    params->node, delays[d]);
+            continue;
+        }
+        count++;
+    }
+    
+    loaded_teardown(params, &setup);
+    
+    return count;
+}
+
+/* ====== 页迁移基准 ====== */
+const char *cxl_bench_migrate_method_name(migrate_method_t method) {
+    switch (method) {
+        case MIGRATE_MOVE_PAGES:    return "move_pages";
+        case MIGRATE_MIGRATE_PAGES: return "migrate_pages";
+        default:                    return "unknown";
+    }
+}
+
+/* 每页一个追逐节点：每次加载都落在不同页上，迁移后的 TLB 与缓存冷启动全部计入；counts 非空时记录本遍的硬件计数 */
+static double migrate_chase_pass(void *head, uint64_t num_pages, const cxl_perf_t *perf,
+                                 cxl_perf_counts_t *counts) {
+    chase_result_t pass;
+    cxl_perf_counts_t perf_start, perf_end;
+    
+    cxl_perf_read(perf, &perf_start);
+    cxl_chase_run(head, num_pages, &pass);
+    cxl_perf_read(perf, &perf_end);
+    
+    if (counts) {
+        cxl_perf_diff(&perf_end, &perf_start, counts);
+    }
+    
+    return pass.ns_per_load;
+}
+
+/* 用不带目标节点的 move_pages 查询区域内各页所在节点，统计已位于 node 的页数 */
+static uint64_t migrate_count_on_node(void **pages, int *status, uint64_t num_pages, int node) {
+    uint64_t count = 0;
+    
+    if (move_pages(0, (unsigned long)num_pages, pages, NULL, status, 0) < 0) {
+        return 0;
+    }
+    for (uint64_t i = 0; i < num_pages; i++) {
+        if (status[i] == node) count++;
+    }
+    
+    return count;
+}
+
+static int migrate_run_move_pages(void **pages, int *nodes, int *status, uint64_t num_pages,
+                                  size_t batch_pages, int dst_node) {
+    for (uint64_t i = 0; i < num_pages; i++) {
+        nodes[i] = dst_node;
+    }
+    
+    for (uint64_t i = 0; i < num_pages; i += batch_pages) {
+        uint64_t n = num_pages - i;
+        if (n > batch_pages) n = batch_pages;
+        
+        /* 返回值大于 0 表示有页未能迁移，逐页原因在 status 中，由调用者统计 */
+        if (move_pages(0, (unsigned long)n, pages + i, nodes + i, status + i, MPOL_MF_MOVE) < 0) {
+            fprintf(stderr, "[ERROR] move_pages failed: %s\n", strerror(errno));
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+static int migrate_run_migrate_pages(int src_node, int dst_node) {
+    struct bitmask *from = numa_allocate_nodemask();
+    struct bitmask *to = numa_allocate_nodemask();
+    int ret = -1;
+    
+    if (from && to) {
+        numa_bitmask_setbit(from, (unsigned int)src_node);
+        numa_bitmask_setbit(to, (unsigned int)dst_node);
+        
+        /* 迁移整个（子）进程位于 src_node 上的页；返回未能迁移的页数 */
+        if (numa_migrate_pages(0, from, to) < 0) {
+            fprintf(stderr, "[ERROR] migrate_pages failed: %s\n", strerror(errno));
+        } else {
+            ret = 0;
+        }
+    }
+    
+    if (from) numa_free_nodemask(from);
+    if (to) numa_free_nodemask(to);
+    
+    return ret;
+}
+
+static int migrate_measure(const migration_params_t *params, migration_result_t *result) {
+    size_t page_size = 0;
+    void *region = cxl_malloc_on_node_pages(params->region_size, params->src_node,
+                                            params->page_mode, &page_size);
+    if (!region) {
+        return -1;
+    }
+    if (page_size == 0) page_size = CXL_PAGE_SIZE;
+    
+    uint64_t num_pages = params->region_size / page_size;
+    void **pages = malloc(num_pages * sizeof(void *));
+    int *nodes = malloc(num_pages * sizeof(int));
+    int *status = malloc(num_pages * sizeof(int));
+    void *head = NULL;
+    cxl_perf_t perf;
+    int ret = -1;
+    
+    memset(&perf, 0, sizeof(perf));
+    if (pages && nodes && status && num_pages > 0) {
+        head = cxl_chase_build(region, num_pages * page_size, page_size, 0x9E3779B97F4A7C15ULL);
+    }
+    
+    if (head) {
+        for (uint64_t i = 0; i < num_pages; i++) {
+            pages[i] = (char *)region + i * page_size;
+        }
+        
+        size_t batch = params->batch_pages;
+        if (params->method != MIGRATE_MOVE_PAGES || batch == 0 || batch > num_pages) {
+            batch = (size_t)num_pages;
+        }
+        
+        result->page_size = page_size;
+        result->num_pages = num_pages;
+        result->batch_pages = batch;
+        
+        /* 迁移前的稳态延迟：先走两遍预热缓存与 TLB；计数器只计用户态，迁移系统调用本身不计入 */
+        cxl_perf_open(&perf);
+        migrate_chase_pass(head, num_pages, &perf, NULL);
+        migrate_chase_pass(head, num_pages, &perf, NULL);
+        result->ns_before = migrate_chase_pass(head, num_pages, &perf, &result->perf_before);
+        
+        cxl_mfence();
+        uint64_t start_ns = bench_now_ns();
+        
+        int moved = (params->method == MIGRATE_MOVE_PAGES) ?
+                    migrate_run_move_pages(pages, nodes, status, num_pages, batch, params->dst_node) :
+                    migrate_run_migrate_pages(params->src_node, params->dst_node);
+        
+        uint64_t end_ns = bench_now_ns();
+        
+        if (moved == 0) {
+            /* 页 -> 节点缓存中的旧条目已失效 */
+            cxl_addr_node_invalidate();
+            
+            /* 迁移后的瞬态：第一遍承担新页的 TLB 缺失与缓存冷启动 */
+            for (int p = 0; p < CXL_BENCH_MIGRATE_PASSES; p++) {
+                result->ns_after[p] = migrate_chase_pass(head, num_pages, &perf,
+                                                         (p == 0) ? &result->perf_after : NULL);
+            }
+            
+            result->pages_moved = migrate_count_on_node(pages, status, num_pages, params->dst_node);
+            result->pages_failed = num_pages - result->pages_moved;
+            result->seconds = (double)(end_ns - start_ns) / 1e9;
+            if (result->seconds > 0.0) {
+                result->pages_per_sec = (double)result->pages_moved / result->seconds;
+                result->gbps = (double)result->pages_moved * (double)page_size / result->seconds / 1e9;
+            }
+            ret = 0;
+        }
+    }
+    
+    cxl_perf_close(&perf);
+    free(pages);
+    free(nodes);
+    free(status);
+    cxl_free_pages(region, params->region_size, params->page_mode);
+    
+    return ret;
+}
+
+/*
+ * 带 CAP_SYS_NICE 调用 migrate_pages 时内核按 MPOL_MF_MOVE_ALL 处理，会连同与父进程共享的
+ * 写时复制页一起迁走；去掉该能力后只迁移本进程独占的页。
+ */
+static int migrate_drop_sys_nice(void) {
+    struct __user_cap_header_struct header = {_LINUX_CAPABILITY_VERSION_3, 0};
+    struct __user_cap_data_struct data[_LINUX_CAPABILITY_U32S_3];
+    
+    if (syscall(SYS_capget, &header, data) < 0) {
+        return -1;
+    }
+    
+    data[CAP_TO_INDEX(CAP_SYS_NICE)].effective &= ~CAP_TO_MASK(CAP_SYS_NICE);
+    
+    return (int)syscall(SYS_capset, &header, data);
+}
+
+/*
+ * migrate_pages 迁移的是整个进程位于源节点上的页。在子进程中分配区域并完成整个测量，
+ * 子进程独占的页只有区域本身和少量栈/堆页，吞吐与 move_pages 可比，父进程的内存也不会被迁走。
+ * 计时在子进程内完成（父进程调用 migrate_pages 会带 MPOL_MF_MOVE_ALL），结果经管道传回。
+ */
+static int migrate_in_child(const migration_params_t *params, migration_result_t *result) {
+    int fds[2];
+    
+    if (pipe(fds) < 0) {
+        fprintf(stderr, "[ERROR] pipe failed: %s\n", strerror(errno));
+        return -1;
+    }
+    
+    fflush(stdout);
+    fflush(stderr);
+    
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "[ERROR] fork failed: %s\n", strerror(errno));
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    
+    if (pid == 0) {
+        close(fds[0]);
+        
+        int ret = migrate_drop_sys_nice();
+        if (ret < 0) {
+            fprintf(stderr, "[ERROR] Failed to drop CAP_SYS_NICE: %s\n", strerror(errno));
+        } else {
+            ret = migrate_measure(params, result);
+        }
+        
+        if (ret == 0 && write(fds[1], result, sizeof(migration_result_t)) != (ssize_t)sizeof(migration_result_t)) {
+            ret = -1;
+        }
+        close(fds[1]);
+        _exit(ret == 0 ? 0 : 1);
+    }
+    
+    close(fds[1]);
+    
+    size_t received = 0;
+    while (received < sizeof(migration_result_t)) {
+        ssize_t n = read(fds[0], (char *)result + received, sizeof(migration_result_t) - received);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        received += (size_t)n;
+    }
+    close(fds[0]);
+    
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    
+    if (received != sizeof(migration_result_t) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+    
+    return 0;
+}
+
+int cxl_bench_migration(const migration_params_t *params, migration_result_t *result) {
+    if (!params || !result || params->src_node < 0 || params->dst_node < 0 ||
+        params->method < 0 || params->method >= MIGRATE_METHOD_COUNT ||
+        params->region_size < CXL_PAGE_SIZE) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    memset(result, 0, sizeof(migration_result_t));
+    result->src_node = params->src_node;
+    result->dst_node = params->dst_node;
+    result->method = params->method;
+    result->region_size = params->region_size;
+    
+    if (params->method == MIGRATE_MIGRATE_PAGES) {
+        return migrate_in_child(params, result);
+    }
+    
+    return migrate_measure(params, result);
+}
@@ -0,0 +1,378 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <numa.h>
+#include "cxl_cache.h"
+#include "cxl_benchmark.h"
+#include "cxl_topology.h"
+#include "cxl_common.h"
+
+/* 探测失败时的保守默认值：按较大的服务器缓存估计，宁可多扫也不要驱逐不干净 */
+#define CACHE_DEFAULT_L1_SIZE       (48UL * 1024)
+#define CACHE_DEFAULT_L2_SIZE       (2UL * 1024 * 1024)
+#define CACHE_DEFAULT_LLC_SIZE      (64UL * 1024 * 1024)
+
+/* ====== 驱逐缓冲区 ====== */
+typedef struct {
+    void *buffer;
+    size_t size;
+    void *heads[CXL_EVICT_CHAINS];  /* 环上等距的起点 */
+    uint64_t steps;                 /* 每条链的步数 */
+} evict_buffer_t;
+
+/* ====== 模块状态 ====== */
+static struct {
+    cxl_cache_geometry_t geo;
+    pthread_once_t once;
+    pthread_mutex_t evict_lock;     /* 驱逐缓冲区分配 */
+    evict_buffer_t evict[CXL_MAX_NODES][CXL_MAX_CACHE_LEVELS];
+} cache_state = {
+    .once = PTHREAD_ONCE_INIT,
+    .evict_lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/* 防止编译器消除遍历循环 */
+static void * volatile evict_sink;
+
+/*
+ * 记录一级缓存。比 LLC 更深的缓存级（L4 eDRAM 等）并入 LLC 一项，保留容量较大者，
+ * 驱逐缓冲区按最大的末级容量计算。
+ */
+static cxl_cache_level_t *cache_level_slot(cxl_cache_geometry_t *geo, int level, size_t size) {
+    if (level < 1) return NULL;
+    if (level > CXL_MAX_CACHE_LEVELS) level = CXL_CACHE_LEVEL_LLC;
+    
+    cxl_cache_level_t *entry = &geo->levels[level - 1];
+    if (entry->size > size) return NULL;
+    
+    if (level > geo->num_levels) geo->num_levels = level;
+    return entry;
+}
+
+/* ====== sysfs 读取 ====== */
+static long cache_read_long(const char *dir, const char *name) {
+    char path[CXL_TOPO_PATH_MAX + 32], buf[64];
+    
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    if (cxl_read_sysfs_line(path, buf, sizeof(buf)) < 0) {
+        return -1;
+    }
+    
+    /* size 带 K/M 后缀 */
+    char *end = NULL;
+    long value = strtol(buf, &end, 10);
+    if (end == buf) return -1;
+    if (*end == 'K') value <<= 10;
+    if (*end == 'M') value <<= 20;
+    
+    return value;
+}
+
+/* cpulist 格式："0-3,8"，返回 CPU 数 */
+static int cache_count_cpulist(const char *list) {
+    int count = 0;
+    const char *p = list;
+    
+    while (*p) {
+        char *end = NULL;
+        long lo = strtol(p, &end, 10);
+        if (end == p) break;
+        
+        long hi = lo;
+        if (*end == '-') {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+        }
+        count += (int)(hi - lo + 1);
+        
+        p = (*end == ',') ? end + 1 : end;
+        if (end == p && *p) break;
+    }
+    
+    return count;
+}
+
+static int cache_discover_sysfs(int cpu, const char *sysfs_root, cxl_cache_geometry_t *geo) {
+    int found = 0;
+    
+    for (int index = 0; index < 16; index++) {
+        char dir[CXL_TOPO_PATH_MAX], path[CXL_TOPO_PATH_MAX + 32], buf[256];
+        
+        snprintf(dir, sizeof(dir), "%s/devices/system/cpu/cpu%d/cache/index%d", sysfs_root, cpu, index);
+        snprintf(path, sizeof(path), "%s/type", dir);
+        if (cxl_read_sysfs_line(path, buf, sizeof(buf)) < 0) break;
+        if (strcmp(buf, "Data") != 0 && strcmp(buf, "Unified") != 0) continue;
+        
+        long level = cache_read_long(dir, "level");
+        long size = cache_read_long(dir, "size");
+        if (size <= 0) continue;
+        
+        cxl_cache_level_t *entry = cache_level_slot(geo, (int)level, (size_t)size);
+        if (!entry) continue;
+        
+        entry->size = (size_t)size;
+        entry->ways = (int)cache_read_long(dir, "ways_of_associativity");
+        entry->sets = (int)cache_read_long(dir, "number_of_sets");
+        entry->line_size = (int)cache_read_long(dir, "coherency_line_size");
+        
+        snprintf(path, sizeof(path), "%s/shared_cpu_list", dir);
+        entry->shared_cpus = (cxl_read_sysfs_line(path, buf, sizeof(buf)) == 0) ? cache_count_cpulist(buf) : 0;
+        found++;
+    }
+    
+    return found > 0 ? 0 : -1;
+}
+
+/* ====== CPUID 叶 4 / 0x8000001D ====== */
+static int cache_discover_cpuid(cxl_cache_geometry_t *geo) {
+    uint32_t eax, ebx, ecx, edx;
+    
+    /* "AuthenticAMD" / "HygonGenuine" 用扩展叶 0x8000001D，格式与叶 4 相同 */
+    cxl_cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+    uint32_t max_leaf = eax;
+    int amd = (ebx == 0x68747541 || ebx == 0x6f677948);
+    uint32_t leaf = 4;
+    
+    /* 0x8000001D 只在 TOPOEXT（CPUID 0x80000001 ECX 第 22 位）置位时有效 */
+    if (amd) {
+        cxl_cpuid(0x80000000, 0, &eax, &ebx, &ecx, &edx);
+        if (eax < 0x8000001D) return -1;
+        cxl_cpuid(0x80000001, 0, &eax, &ebx, &ecx, &edx);
+        if (!((ecx >> 22) & 1)) return -1;
+        leaf = 0x8000001D;
+    } else if (max_leaf < 4) {
+        return -1;
+    }
+    
+    int found = 0;
+    for (uint32_t sub = 0; sub < 16; sub++) {
+        cxl_cpuid(leaf, sub, &eax, &ebx, &ecx, &edx);
+        
+        uint32_t type = eax & 0x1f;     /* 0 无，1 数据，2 指令，3 统一 */
+        if (type == 0) break;
+        if (type == 2) continue;
+        
+        int level = (int)((eax >> 5) & 0x7);
+        int line_size = (int)(ebx & 0xfff) + 1;
+        int ways = (int)((ebx >> 22) & 0x3ff) + 1;
+        int sets = (int)ecx + 1;
+        uint32_t partitions = ((ebx >> 12) & 0x3ff) + 1;
+        size_t size = (size_t)ways * partitions * (size_t)line_size * (size_t)sets;
+        
+        cxl_cache_level_t *entry = cache_level_slot(geo, level, size);
+        if (!entry) continue;
+        
+        entry->size = size;
+        entry->line_size = line_size;
+        entry->ways = ways;
+        entry->sets = sets;
+        entry->shared_cpus = (int)((eax >> 14) & 0xfff) + 1;    /* 上限值，非实际数目 */
+        found++;
+    }
+    
+    return found > 0 ? 0 : -1;
+}
+
+static void cache_set_defaults(cxl_cache_geometry_t *geo) {
+    static const size_t sizes[CXL_MAX_CACHE_LEVELS] = {CACHE_DEFAULT_L1_SIZE, CACHE_DEFAULT_L2_SIZE, CACHE_DEFAULT_LLC_SIZE};
+    
+    for (int l = 0; l < CXL_MAX_CACHE_LEVELS; l++) {
+        geo->levels[l].size = sizes[l];
+        geo->levels[l].line_size = CXL_CACHE_LINE_SIZE;
+    }
+    geo->num_levels = CXL_MAX_CACHE_LEVELS;
+    geo->source = CACHE_SOURCE_NONE;
+}
+
+/* ====== 探测 ====== */
+int cxl_cache_discover(int cpu, const char *sysfs_root, cxl_cache_geometry_t *geo) {
+    if (!geo) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    memset(geo, 0, sizeof(cxl_cache_geometry_t));
+    geo->cpu = cpu;
+    
+    if (!sysfs_root) sysfs_root = getenv(CXL_SYSFS_ROOT_ENV);
+    if (!sysfs_root || !sysfs_root[0]) sysfs_root = CXL_SYSFS_ROOT_DEFAULT;
+    
+    if (cache_discover_sysfs(cpu, sysfs_root, geo) == 0) {
+        geo->source = CACHE_SOURCE_SYSFS;
+        return 0;
+    }
+    
+    memset(geo->levels, 0, sizeof(geo->levels));
+    geo->num_levels = 0;
+    if (cache_discover_cpuid(geo) == 0) {
+        geo->source = CACHE_SOURCE_CPUID;
+        return 0;
+    }
+    
+    cache_set_defaults(geo);
+    return -1;
+}
+
+static void cache_discover_once(void) {
+    int cpu = sched_getcpu();
+    
+    if (cxl_cache_discover(cpu < 0 ? 0 : cpu, NULL, &cache_state.geo) < 0) {
+        fprintf(stderr, "[WARNING] Cache geometry unavailable, assuming %lu MiB LLC\n",
+                CACHE_DEFAULT_LLC_SIZE >> 20);
+    }
+}
+
+const cxl_cache_geometry_t *cxl_cache_get(void) {
+    pthread_once(&cache_state.once, cache_discover_once);
+    
+    return &cache_state.geo;
+}
+
+/* 缓存级换算为 levels[] 下标，超过最高级或该级不存在时取 LLC */
+static int cache_level_index(const cxl_cache_geometry_t *geo, int level) {
+    if (level < 1) level = 1;
+    if (level > geo->num_levels) level = geo->num_levels;
+    
+    while (level > 1 && geo->levels[level - 1].size == 0) level--;
+    
+    return level - 1;
+}
+
+size_t cxl_cache_level_size(int level) {
+    const cxl_cache_geometry_t *geo = cxl_cache_get();
+    
+    return geo->levels[cache_level_index(geo, level)].size;
+}
+
+static const char *cache_source_name(cache_source_t source) {
+    switch (source) {
+        case CACHE_SOURCE_SYSFS:    return "sysfs";
+        case CACHE_SOURCE_CPUID:    return "cpuid";
+        default:                    return "default";
+    }
+}
+
+void cxl_cache_print(const cxl_cache_geometry_t *geo) {
+    if (!geo) return;
+    
+    fprintf(stdout, "\nCache Geometry (cpu %d, %s):\n", geo->cpu, cache_source_name(geo->source));
+    for (int l = 0; l < geo->num_levels; l++) {
+        const cxl_cache_level_t *entry = &geo->levels[l];
+        if (entry->size == 0) continue;
+        
+        fprintf(stdout, "  L%d: %8zu KiB, %2d-way, %6d sets, %d B lines", l + 1, entry->size >> 10,
+               entry->ways, entry->sets, entry->line_size);
+        if (entry->shared_cpus > 0) {
+            fprintf(stdout, ", shared by %d CPUs", entry->shared_cpus);
+        }
+        fprintf(stdout, "\n");
+    }
+}
+
+/* ====== 驱逐 ====== */
+size_t cxl_evict_buffer_size(int level) {
+    return cxl_cache_level_size(level) * CXL_EVICT_SIZE_FACTOR;
+}
+
+static int evict_build(evict_buffer_t *evict, int node, size_t size) {
+    void *buffer = cxl_malloc_on_node_pages(size, node, PAGE_MODE_THP, NULL);
+    if (!buffer) {
+        return -1;
+    }
+    
+    void *head = cxl_chase_build(buffer, size, CXL_CACHE_LINE_SIZE, 0xC0FFEE5EEDULL + (uint64_t)node);
+    if (!head) {
+        cxl_free_pages(buffer, size, PAGE_MODE_THP);
+        return -1;
+    }
+    
+    /* 沿环走一遍，取等距的起点，各链合起来恰好覆盖每一行一次 */
+    uint64_t num_lines = size / CXL_CACHE_LINE_SIZE;
+    uint64_t steps = num_lines / CXL_EVICT_CHAINS;
+    void **p = (void **)head;
+    
+    for (int c = 0; c < CXL_EVICT_CHAINS; c++) {
+        evict->heads[c] = p;
+        for (uint64_t s = 0; s < steps; s++) {
+            p = (void **)*p;
+        }
+    }
+    
+    evict->buffer = buffer;
+    evict->size = size;
+    evict->steps = steps;
+    
+    return 0;
+}
+
+static void evict_sweep(const evict_buffer_t *evict) {
+    void **p0 = evict->heads[0], **p1 = evict->heads[1], **p2 = evict->heads[2], **p3 = evict->heads[3];
+    void **p4 = evict->heads[4], **p5 = evict->heads[5], **p6 = evict->heads[6], **p7 = evict->heads[7];
+    
+    /* 8 条互不依赖的链交错推进：每条链内是依赖加载，链间可以并行缺失 */
+    for (uint64_t s = 0; s < evict->steps; s++) {
+        p0 = (void **)*p0; p1 = (void **)*p1; p2 = (void **)*p2; p3 = (void **)*p3;
+        p4 = (void **)*p4; p5 = (void **)*p5; p6 = (void **)*p6; p7 = (void **)*p7;
+    }
+    
+    evict_sink = (void *)((uintptr_t)p0 ^ (uintptr_t)p1 ^ (uintptr_t)p2 ^ (uintptr_t)p3 ^
+                          (uintptr_t)p4 ^ (uintptr_t)p5 ^ (uintptr_t)p6 ^ (uintptr_t)p7);
+}
+
+int cxl_evict_level(int level) {
+    const cxl_cache_geometry_t *geo = cxl_cache_get();
+    int index = cache_level_index(geo, level);
+    
+    /* 缓冲区放在调用线程所在节点上，遍历本身不产生跨节点流量 */
+    int cpu = sched_getcpu();
+    int node = (cpu >= 0) ? numa_node_of_cpu(cpu) : 0;
+    if (node < 0 || node >= CXL_MAX_NODES) node = 0;
+    
+    evict_buffer_t *evict = &cache_state.evict[node][index];
+    
+    if (!__atomic_load_n(&evict->buffer, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_lock(&cache_state.evict_lock);
+        
+        int ret = 0;
+        if (!evict->buffer) {
+            evict_buffer_t built;
+            memset(&built, 0, sizeof(built));
+            ret = evict_build(&built, node, geo->levels[index].size * CXL_EVICT_SIZE_FACTOR);
+            if (ret == 0) {
+                memcpy(evict->heads, built.heads, sizeof(built.heads));
+                evict->size = built.size;
+                evict->steps = built.steps;
+                __atomic_store_n(&evict->buffer, built.buffer, __ATOMIC_RELEASE);
+            }
+        }
+        
+        pthread_mutex_unlock(&cache_state.evict_lock);
+        if (ret < 0) {
+            fprintf(stderr, "[ERROR] Failed to allocate L%d eviction buffer on node %d\n", index + 1, node);
+            return -1;
+        }
+    }
+    
+    evict_sweep(evict);
+    
+    return 0;
+}
+
+void cxl_evict_cleanup(void) {
+    pthread_mutex_lock(&cache_state.evict_lock);
+    
+    for (int n = 0; n < CXL_MAX_NODES; n++) {
+        for (int l = 0; l < CXL_MAX_CACHE_LEVELS; l++) {
+            evict_buffer_t *evict = &cache_state.evict[n][l];
+            if (!evict->buffer) continue;
+            
+            cxl_free_pages(evict->buffer, evict->size, PAGE_MODE_THP);
+            memset(evict, 0, sizeof(evict_buffer_t));
+        }
+    }
+    
+    pthread_mutex_unlock(&cache_state.evict_lock);
+}
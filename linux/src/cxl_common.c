@@ -6,9 +6,23 @@
 #include <stdarg.h>
 #include <pthread.h>
 #include <numa.h>
+#include <numaif.h>
+#include <sys/mman.h>
 #include <sched.h>
 #include <errno.h>
 #include "cxl_common.h"
+#include "cxl_topology.h"
+
+/* 旧版 glibc 的 sys/mman.h 不提供 hugetlb 页大小编码 */
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
 
 /* ====== NUMA 内存分配 ====== */
 void *cxl_malloc_on_node(size_t size, int node) {
@@ -43,6 +57,263 @@ void cxl_free(void *ptr, size_t size) {
     numa_free(ptr, size);
 }
 
+/* ====== 指定页大小的 NUMA 内存分配 ====== */
+static size_t page_mode_size(page_mode_t mode) {
+    switch (mode) {
+        case PAGE_MODE_THP:
+        case PAGE_MODE_HUGETLB_2M:
+            return CXL_HUGE_PAGE_SIZE_2M;
+        case PAGE_MODE_HUGETLB_1G:
+            return CXL_HUGE_PAGE_SIZE_1G;
+        default:
+            return CXL_PAGE_SIZE;
+    }
+}
+
+const char *cxl_page_mode_name(page_mode_t mode) {
+    switch (mode) {
+        case PAGE_MODE_4K:          return "4k";
+        case PAGE_MODE_THP:         return "thp";
+        case PAGE_MODE_HUGETLB_2M:  return "2m";
+        case PAGE_MODE_HUGETLB_1G:  return "1g";
+        default:                    return "unknown";
+    }
+}
+
+/*
+ * hugetlb 页在 mmap 时全局预留，但 MPOL_BIND 下缺页时只能从目标节点取，节点不足会 SIGBUS。
+ * 这里决定真实的分配，必须读取内核的 /sys，不受 CXL_SYSFS_ROOT（只用于拓扑与缓存发现）影响。
+ */
+static long node_free_hugepages(int node, size_t page_size) {
+    char path[128];
+    FILE *file;
+    long free_pages = -1;
+    
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/hugepages/hugepages-%zukB/free_hugepages",
+             node, page_size >> 10);
+    
+    file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    if (fscanf(file, "%ld", &free_pages) != 1) {
+        free_pages = -1;
+    }
+    fclose(file);
+    
+    return free_pages;
+}
+
+/* 从 /proc/self/smaps 读取映射实际使用的页大小 */
+static size_t mapping_page_size(void *addr, size_t len) {
+    FILE *file = fopen("/proc/self/smaps", "r");
+    if (!file) {
+        return 0;
+    }
+    
+    char line[256];
+    int in_vma = 0;
+    size_t kernel_page_kb = 0, anon_huge_kb = 0;
+    uintptr_t target = (uintptr_t)addr;
+    
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long start, end;
+        
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            if (in_vma) break;
+            in_vma = (target >= start && target < end);
+            continue;
+        }
+        if (!in_vma) continue;
+        
+        sscanf(line, "KernelPageSize: %zu kB", &kernel_page_kb);
+        sscanf(line, "AnonHugePages: %zu kB", &anon_huge_kb);
+    }
+    fclose(file);
+    
+    if (kernel_page_kb > CXL_PAGE_SIZE >> 10) {
+        return kernel_page_kb << 10;
+    }
+    
+    /* 透明大页：只有整个区域都由大页支撑才报告 2 MiB */
+    if ((anon_huge_kb << 10) >= len) {
+        return CXL_HUGE_PAGE_SIZE_2M;
+    }
+    if (anon_huge_kb > 0) {
+        fprintf(stdout, "[INFO] THP covers %zu of %zu MiB, reporting 4 KiB pages\n",
+                anon_huge_kb >> 10, len >> 20);
+    }
+    
+    return CXL_PAGE_SIZE;
+}
+
+static void *map_hugetlb(size_t len, size_t page_size, int node) {
+    long free_pages = node_free_hugepages(node, page_size);
+    if (free_pages < (long)(len / page_size)) {
+        fprintf(stderr, "[WARNING] Node %d has %ld free %zu KiB huge pages, %zu needed\n",
+                node, free_pages < 0 ? 0 : free_pages, page_size >> 10, len / page_size);
+        return NULL;
+    }
+    
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                ((page_size == CXL_HUGE_PAGE_SIZE_1G) ? MAP_HUGE_1GB : MAP_HUGE_2MB);
+    void *ptr = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+    
+    return (ptr == MAP_FAILED) ? NULL : ptr;
+}
+
+/* 普通匿名映射，按 align 对齐（多映射一段再裁掉首尾） */
+static void *map_aligned(size_t len, size_t align) {
+    size_t span = len + align;
+    uint8_t *raw = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return NULL;
+    }
+    
+    uint8_t *aligned = (uint8_t *)(((uintptr_t)raw + align - 1) & ~(uintptr_t)(align - 1));
+    size_t head = (size_t)(aligned - raw);
+    size_t tail = span - head - len;
+    
+    if (head) munmap(raw, head);
+    if (tail) munmap(aligned + len, tail);
+    
+    return aligned;
+}
+
+void *cxl_malloc_on_node_pages(size_t size, int node, page_mode_t mode, size_t *actual_page_size) {
+    if (size == 0 || node < 0 || mode < PAGE_MODE_4K || mode > PAGE_MODE_HUGETLB_1G) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return NULL;
+    }
+    
+    /* 长度按请求的页大小取整，回退到更小的页时长度不变，释放时只需知道 mode */
+    size_t len = (size + page_mode_size(mode) - 1) & ~(page_mode_size(mode) - 1);
+    void *ptr = NULL;
+    int hugetlb = 0;
+    
+    if (mode == PAGE_MODE_HUGETLB_1G) {
+        ptr = map_hugetlb(len, CXL_HUGE_PAGE_SIZE_1G, node);
+        if (!ptr) {
+            fprintf(stderr, "[WARNING] 1 GiB huge pages unavailable on node %d, trying 2 MiB\n", node);
+            mode = PAGE_MODE_HUGETLB_2M;
+        }
+    }
+    if (!ptr && mode == PAGE_MODE_HUGETLB_2M) {
+        ptr = map_hugetlb(len, CXL_HUGE_PAGE_SIZE_2M, node);
+        if (!ptr) {
+            fprintf(stderr, "[WARNING] 2 MiB huge pages unavailable on node %d, falling back to THP\n", node);
+            mode = PAGE_MODE_THP;
+        }
+    }
+    hugetlb = (ptr != NULL);
+    
+    if (!ptr) {
+        ptr = map_aligned(len, page_mode_size(mode));
+        if (!ptr) {
+            fprintf(stderr, "[ERROR] Failed to map %zu bytes\n", len);
+            return NULL;
+        }
+        /* 4K 模式显式关闭 THP，否则 enabled=always 时仍可能得到大页 */
+        madvise(ptr, len, (mode == PAGE_MODE_THP) ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+    }
+    
+    /* 缺页前绑定节点 */
+    struct bitmask *nodeset = numa_allocate_nodemask();
+    if (!nodeset) {
+        fprintf(stderr, "[ERROR] Failed to allocate node mask\n");
+        munmap(ptr, len);
+        return NULL;
+    }
+    numa_bitmask_setbit(nodeset, node);
+    int ret = mbind(ptr, len, MPOL_BIND, nodeset->maskp, nodeset->size + 1, 0);
+    numa_free_nodemask(nodeset);
+    
+    if (ret < 0) {
+        fprintf(stderr, "[ERROR] mbind to node %d failed: %s\n", node, strerror(errno));
+        munmap(ptr, len);
+        return NULL;
+    }
+    
+    /* 预先缺页：每个基本页写一次（hugetlb 每个大页写一次即可）；
+     * 回退后只触碰按实际页大小取整的部分，多出的尾部只占虚拟地址 */
+    size_t touch_len = (size + page_mode_size(mode) - 1) & ~(page_mode_size(mode) - 1);
+    size_t step = hugetlb ? page_mode_size(mode) : CXL_PAGE_SIZE;
+    for (size_t off = 0; off < touch_len; off += step) {
+        ((volatile uint8_t *)ptr)[off] = 0;
+    }
+    
+    if (actual_page_size) {
+        size_t page_size = mapping_page_size(ptr, touch_len);
+        *actual_page_size = page_size ? page_size : (hugetlb ? page_mode_size(mode) : CXL_PAGE_SIZE);
+    }
+    
+    return ptr;
+}
+
+void cxl_free_pages(void *ptr, size_t size, page_mode_t mode) {
+    if (!ptr) return;
+    
+    size_t len = (size + page_mode_size(mode) - 1) & ~(page_mode_size(mode) - 1);
+    munmap(ptr, len);
+}
+
+/* ====== 地址所在 NUMA 节点 ====== */
+/*
+ * 每线程一张直接映射的页 -> 节点缓存，命中时不进入内核。页迁移后由
+ * cxl_addr_node_invalidate 递增全局代数，所有线程的旧条目随之失效。
+ */
+typedef struct {
+    uintptr_t page;
+    int node;
+    uint32_t generation;
+} addr_node_entry_t;
+
+static __thread addr_node_entry_t addr_node_cache[CXL_ADDR_NODE_CACHE_ENTRIES];
+static uint32_t addr_node_generation = 1;   /* 从 1 开始，清零的条目天然无效 */
+
+static int addr_query_node(const void *addr) {
+    void *page = (void *)((uintptr_t)addr & ~((uintptr_t)CXL_PAGE_SIZE - 1));
+    int status = -1;
+    
+    /* move_pages 不传目标节点时只查询，不迁移也不触发缺页 */
+    if (move_pages(0, 1, &page, NULL, &status, 0) == 0 && status >= 0) {
+        return status;
+    }
+    
+    /* 页尚未分配（-ENOENT）或 move_pages 不可用：get_mempolicy 会先触发缺页再返回节点 */
+    int node = -1;
+    if (get_mempolicy(&node, NULL, 0, (void *)addr, MPOL_F_NODE | MPOL_F_ADDR) == 0) {
+        return node;
+    }
+    
+    return -1;
+}
+
+int cxl_addr_to_node(const void *addr) {
+    if (!addr) return -1;
+    
+    uintptr_t page = (uintptr_t)addr / CXL_PAGE_SIZE;
+    uint32_t generation = __atomic_load_n(&addr_node_generation, __ATOMIC_ACQUIRE);
+    addr_node_entry_t *entry = &addr_node_cache[page & (CXL_ADDR_NODE_CACHE_ENTRIES - 1)];
+    
+    if (entry->page == page && entry->generation == generation) {
+        return entry->node;
+    }
+    
+    int node = addr_query_node(addr);
+    if (node >= 0) {
+        entry->page = page;
+        entry->node = node;
+        entry->generation = generation;
+    }
+    
+    return node;
+}
+
+void cxl_addr_node_invalidate(void) {
+    __atomic_add_fetch(&addr_node_generation, 1, __ATOMIC_RELEASE);
+}
+
 /* ====== CPU 亲和性绑定 ====== */
 int cxl_bind_to_cpu(int cpu_id) {
     cpu_set_t set;
@@ -77,6 +348,22 @@ int cxl_bind_to_node(int node_id) {
     return 0;
 }
 
+/* ====== sysfs 读取 ====== */
+int cxl_read_sysfs_line(const char *path, char *buf, size_t size) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    
+    if (!fgets(buf, (int)size, file)) {
+        buf[0] = '\0';
+    }
+    fclose(file);
+    
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
 /* ====== 系统信息查询 ====== */
 int cxl_get_num_cpus(void) {
     int num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
@@ -98,16 +385,12 @@ int cxl_get_num_numa_nodes(void) {
 
 /* ====== 获取 APIC ID ====== */
 static uint32_t cxl_get_apic_id(void) {
-    uint32_t eax, edx;
+    uint32_t eax, ebx, ecx, edx;
     
-    asm volatile(
-        "cpuid"
-        : "=a" (eax), "=d" (edx)
-        : "a" (0x1)
-        : "ebx", "ecx"
-    );
+    /* 初始 APIC ID 位于 CPUID.1:EBX[31:24]，EDX 是特性位 */
+    cxl_cpuid(0x1, 0, &eax, &ebx, &ecx, &edx);
     
-    return (edx >> 24) & 0xFF;
+    return (ebx >> 24) & 0xFF;
 }
 
 /* ====== 检查 CXL 支持 ====== */
@@ -126,12 +409,8 @@ int cxl_check_system_support(void) {
 }
 
 int cxl_get_cxl_node(void) {
-    /* 简单实现：假设 CXL Memory 在节点 1 */
-    /* 实际应该通过 sysfs 或 CXL 驱动获取 */
-    if (cxl_get_num_numa_nodes() > 1) {
-        return 1;
-    }
-    return -1;
+    /* 由 sysfs 拓扑确定：CXL region 的目标节点，其次是无 CPU 的内存节点 */
+    return cxl_topology_cxl_node(cxl_topology_get());
 }
 
 /* ====== 时间相关函数 ====== */
@@ -5,13 +5,22 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <errno.h>
+#include <sched.h>
 #include "cxl_common.h"
 #include "cxl_prepreparation.h"
 #include "cxl_attack_primitives.h"
 #include "cxl_victim.h"
 #include "cxl_attacker.h"
 #include "cxl_observation.h"
+#include "cxl_tsc.h"
 #include "cxl_analysis.h"
+#include "cxl_benchmark.h"
+#include "cxl_topology.h"
+#include "cxl_runner.h"
+#include "cxl_perf.h"
+#include "cxl_sweep.h"
+#include "cxl_profiler.h"
+#include "cxl_cache.h"
 
 /* ====== 全局框架状态 ====== */
 static struct {
@@ -28,12 +37,30 @@ int cxl_framework_init(const char *config_name) {
     fprintf(stdout, "Version 1.0 - Linux CXL Memory Security Analysis\n");
     fprintf(stdout, "=========================================================\n\n");
     
-    /* 初始化配置 */
+    /* 初始化配置：内置默认值 -> 配置文件 -> 环境变量 */
     if (cxl_config_init(&framework_state.config) < 0) {
         fprintf(stderr, "[ERROR] Failed to initialize configuration\n");
         return -1;
     }
     
+    char config_path[512];
+    int found = cxl_config_resolve(config_name, config_path, sizeof(config_path));
+    if (found < 0) {
+        return -1;
+    }
+    if (found > 0) {
+        if (cxl_config_load(&framework_state.config, config_path) < 0) {
+            fprintf(stderr, "[ERROR] Failed to load configuration: %s\n", config_path);
+            return -1;
+        }
+    } else {
+        fprintf(stdout, "[INFO] Using built-in default configuration\n");
+    }
+    
+    if (cxl_config_apply_env(&framework_state.config) < 0) {
+        return -1;
+    }
+    
     /* 检查系统支持 */
     if (cxl_check_system_support() < 1) {
         fprintf(stderr, "[WARNING] CXL system support check returned warning\n");
@@ -45,6 +72,17 @@ int cxl_framework_init(const char *config_name) {
         return -1;
     }
     
+    /* 校准每核 rdtscp 计时开销 */
+    if (cxl_probe_calibrate_all(CXL_PROBE_CALIBRATION_SAMPLES) <= 0) {
+        fprintf(stderr, "[WARNING] Probe timer calibration failed, latencies are uncorrected\n");
+    }
+    
+    /* 在每个内存节点上拟合命中/未命中阈值（CXL 节点的未命中延迟远高于本地 DRAM） */
+    if (cxl_calibrate_thresholds(CXL_THRESHOLD_CALIBRATION_SAMPLES, CXL_THRESHOLD_GMM) <= 0) {
+        fprintf(stderr, "[WARNING] Threshold calibration failed, using static threshold of %lu cycles\n",
+                cxl_get_timing_threshold());
+    }
+    
     framework_state.initialized = 1;
     
     fprintf(stdout, "[INFO] Framework initialized successfully\n\n");
@@ -55,6 +93,7 @@ int cxl_framework_init(const char *config_name) {
 /* ====== 框架清理 ====== */
 int cxl_framework_cleanup(void) {
     framework_state.initialized = 0;
+    cxl_evict_cleanup();
     
     fprintf(stdout, "[INFO] Framework cleanup completed\n");
     
@@ -84,6 +123,11 @@ void cxl_framework_print_info(void) {
     fprintf(stdout, "  Cache Line Size:   %d bytes\n", CXL_CACHE_LINE_SIZE);
     fprintf(stdout, "  CXL Node:          %d\n", cxl_get_cxl_node());
     
+    cxl_topology_print(cxl_topology_get());
+    cxl_cache_print(cxl_cache_get());
+    cxl_tsc_print();
+    cxl_print_thresholds();
+    
     fprintf(stdout, "\nCurrent Configuration:\n");
     cxl_print_config(&framework_state.config);
 }
@@ -176,23 +220,30 @@ int cxl_framework_test_cxl_latency(void *cxl_addr, void *normal_addr, int num_sa
     
     fprintf(stdout, "[RESULT] CXL Memory Latency Test Summary\n");
     fprintf(stdout, "\nCXL Memory Latency:\n");
-    fprintf(stdout, "  Min:      %lu cycles\n", cxl_min);
-    fprintf(stdout, "  Max:      %lu cycles\n", cxl_max);
-    fprintf(stdout, "  Mean:     %.2f cycles\n", cxl_mean);
-    fprintf(stdout, "  Median:   %.2f cycles\n", cxl_median);
-    fprintf(stdout, "  StdDev:   %.2f cycles\n", cxl_stddev);
+    fprintf(stdout, "  Min:      %lu cycles (%.1f ns)\n", cxl_min, cxl_cycles_to_ns_f(cxl_min));
+    fprintf(stdout, "  Max:      %lu cycles (%.1f ns)\n", cxl_max, cxl_cycles_to_ns_f(cxl_max));
+    fprintf(stdout, "  Mean:     %.2f cycles (%.1f ns)\n", cxl_mean, cxl_cycles_to_ns_f(cxl_mean));
+    fprintf(stdout, "  Median:   %.2f cycles (%.1f ns)\n", cxl_median, cxl_cycles_to_ns_f(cxl_median));
+    fprintf(stdout, "  StdDev:   %.2f cycles (%.1f ns)\n", cxl_stddev, cxl_cycles_to_ns_f(cxl_stddev));
     
     fprintf(stdout, "\nNormal Memory Latency:\n");
-    fprintf(stdout, "  Min:      %lu cycles\n", normal_min);
-    fprintf(stdout, "  Max:      %lu cycles\n", normal_max);
-    fprintf(stdout, "  Mean:     %.2f cycles\n", normal_mean);
-    fprintf(stdout, "  Median:   %.2f cycles\n", normal_median);
-    fprintf(stdout, "  StdDev:   %.2f cycles\n", normal_stddev);
+    fprintf(stdout, "  Min:      %lu cycles (%.1f ns)\n", normal_min, cxl_cycles_to_ns_f(normal_min));
+    fprintf(stdout, "  Max:      %lu cycles (%.1f ns)\n", normal_max, cxl_cycles_to_ns_f(normal_max));
+    fprintf(stdout, "  Mean:     %.2f cycles (%.1f ns)\n", normal_mean, cxl_cycles_to_ns_f(normal_mean));
+    fprintf(stdout, "  Median:   %.2f cycles (%.1f ns)\n", normal_median, cxl_cycles_to_ns_f(normal_median));
+    fprintf(stdout, "  StdDev:   %.2f cycles (%.1f ns)\n", normal_stddev, cxl_cycles_to_ns_f(normal_stddev));
     
     fprintf(stdout, "\nLatency Difference Analysis:\n");
-    fprintf(stdout, "  Latency Difference:  %.2f cycles\n", latency_diff);
+    fprintf(stdout, "  Latency Difference:  %.2f cycles (%.1f ns)\n", latency_diff, cxl_cycles_to_ns_f(latency_diff));
     fprintf(stdout, "  Signal Strength:     %.2f\n", signal_strength);
     
+    cxl_compare_result_t comparison;
+    if (cxl_analysis_compare_samples(cxl_timings, (size_t)num_samples,
+                                     normal_timings, (size_t)num_samples, &comparison) == 0) {
+        cxl_analysis_print_comparison(&comparison, "CXL vs Normal Significance",
+                                      CXL_ANALYSIS_DEFAULT_ALPHA);
+    }
+    
     free(cxl_timings);
     free(normal_timings);
     
@@ -269,6 +320,13 @@ int cxl_framework_run_full_demo(void *test_data, const char *output_dir) {
     return 0;
 }
 
+/* ====== 原始样本导出格式 ====== */
+typedef enum {
+    SAMPLE_EXPORT_NONE,             /* 只导出统计与逐轮结果 */
+    SAMPLE_EXPORT_CSV,              /* cxl_analysis_export_csv */
+    SAMPLE_EXPORT_TRACE             /* cxl_analysis_export_binary（.cxltrace） */
+} sample_export_t;
+
 /* ====== 测试配置结构 ====== */
 typedef struct {
     int test_mode;                  /* 测试模式 */
@@ -279,6 +337,14 @@ typedef struct {
     int compare_cxl_normal;         /* 是否对比 CXL vs Normal */
     int enable_stats;               /* 是否启用统计 */
     int verbose;                    /* 详细输出 */
+    size_t max_working_set;         /* 扫描测试的最大工作集 */
+    inject_traffic_t inject_traffic;/* 负载延迟测试的注入流量类型 */
+    page_mode_t page_mode;          /* 基准测试缓冲区的页大小模式 */
+    int page_mode_set;              /* 命令行是否指定了 -p（否则使用配置文件） */
+    char matrix_file[256];          /* 参数扫描的实验矩阵文件 */
+    char config_name[256];          /* 框架配置名或配置文件路径 */
+    int profile_pid;                /* 页访问分析的目标进程（0 表示分析内置的冷热负载） */
+    sample_export_t sample_export;  /* 延迟测试逐轮原始样本的导出格式 */
 } test_config_t;
 
 /* ====== 打印帮助信息 ====== */
@@ -290,28 +356,66 @@ void print_usage(const char *prog_name) {
     fprintf(stdout, "  -m 2   : Multi-threading Test\n");
     fprintf(stdout, "  -m 3   : Single-thread Isolation Test\n");
     fprintf(stdout, "  -m 4   : Full Demonstration (All Tests)\n");
+    fprintf(stdout, "  -m 5   : Pointer-Chase Latency Sweep (per NUMA node)\n");
+    fprintf(stdout, "  -m 6   : Memory Bandwidth Scaling (per NUMA node)\n");
+    fprintf(stdout, "  -m 7   : Loaded Latency (latency vs. injected bandwidth)\n");
+    fprintf(stdout, "  -m 8   : Parameter Sweep (experiment matrix, see -x)\n");
+    fprintf(stdout, "  -m 9   : Page Migration Throughput (normal <-> CXL)\n");
+    fprintf(stdout, "  -m 10  : Hot/Cold Page Access Profile (see -P)\n");
     
     fprintf(stdout, "\nOptions:\n");
-    fprintf(stdout, "  -i ITER    : Number of iterations (default: 1000)\n");
+    fprintf(stdout, "  -C CONFIG  : Config name (configs/NAME.ini) or INI file (default: $CXL_CONFIG or built-in)\n");
+    fprintf(stdout, "  -i ITER    : Number of iterations (default: run.iterations from config, 1000)\n");
     fprintf(stdout, "  -r ROUNDS  : Number of rounds for statistics (default: 5)\n");
     fprintf(stdout, "  -t THREADS : Number of threads (default: 4)\n");
     fprintf(stdout, "  -o OUTDIR  : Output directory (default: ./results)\n");
+    fprintf(stdout, "  -w SIZE    : Max working set for sweeps, K/M/G suffix (default: 4G)\n");
+    fprintf(stdout, "  -l TYPE    : Loaded latency injector traffic: read|write|rw (default: read)\n");
+    fprintf(stdout, "  -p PAGES   : Benchmark page size: 4k|thp|2m|1g (default: buffer.page_size from config, 4k)\n");
+    fprintf(stdout, "  -x FILE    : Sweep matrix file for -m 8 (default: built-in matrix)\n");
+    fprintf(stdout, "  -P PID     : Process to profile with -m 10 (default: built-in hot/cold workload)\n");
+    fprintf(stdout, "  -S FORMAT  : Export raw per-round samples of -m 1: csv|trace (default: none)\n");
     fprintf(stdout, "  -c         : Compare CXL vs Normal memory\n");
     fprintf(stdout, "  -s         : Enable detailed statistics\n");
     fprintf(stdout, "  -v         : Verbose output\n");
     fprintf(stdout, "  -h         : Print this help\n\n");
 }
 
+/* ====== 解析带 K/M/G 后缀的大小 ====== */
+static size_t parse_size(const char *str) {
+    char *end = NULL;
+    unsigned long long value = strtoull(str, &end, 10);
+    
+    if (end) {
+        switch (*end) {
+            case 'G': case 'g': value <<= 30; break;
+            case 'M': case 'm': value <<= 20; break;
+            case 'K': case 'k': value <<= 10; break;
+            default: break;
+        }
+    }
+    
+    return (size_t)value;
+}
+
 /* ====== 解析命令行参数 ====== */
 int parse_args(int argc, char *argv[], test_config_t *config) {
     /* 默认配置 */
     config->test_mode = 0;
-    config->num_iterations = 1000;
+    config->num_iterations = 0;     /* 0 表示使用配置中的 run.iterations */
     config->num_rounds = 5;
     config->num_threads = 4;
     config->compare_cxl_normal = 0;
     config->enable_stats = 0;
     config->verbose = 0;
+    config->max_working_set = CXL_BENCH_MAX_WORKING_SET;
+    config->inject_traffic = INJECT_READ;
+    config->page_mode = PAGE_MODE_4K;
+    config->page_mode_set = 0;
+    config->matrix_file[0] = '\0';
+    config->profile_pid = 0;
+    config->sample_export = SAMPLE_EXPORT_NONE;
+    strncpy(config->config_name, "default", sizeof(config->config_name) - 1);
     strncpy(config->output_dir, "./results", sizeof(config->output_dir) - 1);
     
     /* 解析参数 */
@@ -335,6 +439,68 @@ int parse_args(int argc, char *argv[], test_config_t *config) {
                 if (i + 1 < argc) strncpy(config->output_dir, argv[++i], 
                                          sizeof(config->output_dir) - 1);
                 break;
+            case 'w':
+                if (i + 1 < argc) config->max_working_set = parse_size(argv[++i]);
+                break;
+            case 'l':
+                if (i + 1 < argc) {
+                    const char *traffic = argv[++i];
+                    if (strcmp(traffic, "read") == 0) {
+                        config->inject_traffic = INJECT_READ;
+                    } else if (strcmp(traffic, "write") == 0) {
+                        config->inject_traffic = INJECT_WRITE;
+                    } else if (strcmp(traffic, "rw") == 0) {
+                        config->inject_traffic = INJECT_READ_WRITE;
+                    } else {
+                        fprintf(stderr, "[ERROR] Unknown traffic type: %s\n", traffic);
+                        return -1;
+                    }
+                }
+                break;
+            case 'p':
+                if (i + 1 < argc) {
+                    const char *pages = argv[++i];
+                    if (strcmp(pages, "4k") == 0) {
+                        config->page_mode = PAGE_MODE_4K;
+                    } else if (strcmp(pages, "thp") == 0) {
+                        config->page_mode = PAGE_MODE_THP;
+                    } else if (strcmp(pages, "2m") == 0) {
+                        config->page_mode = PAGE_MODE_HUGETLB_2M;
+                    } else if (strcmp(pages, "1g") == 0) {
+                        config->page_mode = PAGE_MODE_HUGETLB_1G;
+                    } else {
+                        fprintf(stderr, "[ERROR] Unknown page size: %s\n", pages);
+                        return -1;
+                    }
+                    config->page_mode_set = 1;
+                }
+                break;
+            case 'C':
+                if (i + 1 < argc) strncpy(config->config_name, argv[++i],
+                                         sizeof(config->config_name) - 1);
+                break;
+            case 'x':
+                if (i + 1 < argc) strncpy(config->matrix_file, argv[++i],
+                                         sizeof(config->matrix_file) - 1);
+                break;
+            case 'P':
+                if (i + 1 < argc) config->profile_pid = atoi(argv[++i]);
+                break;
+            case 'S':
+                if (i + 1 < argc) {
+                    const char *format = argv[++i];
+                    if (strcmp(format, "csv") == 0) {
+                        config->sample_export = SAMPLE_EXPORT_CSV;
+                    } else if (strcmp(format, "trace") == 0) {
+                        config->sample_export = SAMPLE_EXPORT_TRACE;
+                    } else if (strcmp(format, "none") == 0) {
+                        config->sample_export = SAMPLE_EXPORT_NONE;
+                    } else {
+                        fprintf(stderr, "[ERROR] Unknown sample format: %s\n", format);
+                        return -1;
+                    }
+                }
+                break;
             case 'c':
                 config->compare_cxl_normal = 1;
                 break;
@@ -357,138 +523,953 @@ int parse_args(int argc, char *argv[], test_config_t *config) {
     return 0;
 }
 
+/* ====== 初始化攻击者模块（保持主线程亲和性不变） ====== */
+static int framework_init_attacker(int cpu) {
+    cpu_set_t saved;
+    
+    /* 攻击者初始化会把调用线程绑到单个 CPU 上；各轮次由运行器的工作线程自行绑核，
+     * 主线程若保持绑定，后续测试的选核就只能看到这一个 CPU */
+    if (sched_getaffinity(0, sizeof(saved), &saved) < 0) {
+        fprintf(stderr, "[ERROR] Failed to get CPU affinity\n");
+        return -1;
+    }
+    
+    int ret = cxl_attacker_init(cpu);
+    sched_setaffinity(0, sizeof(saved), &saved);
+    
+    return ret;
+}
+
+/* ====== 选择工作线程 CPU：配置了 cpu.workers 时使用其列表，否则在节点上自动选择 ====== */
+static int framework_select_cpus(int node, int *cpus, int max_cpus) {
+    const cxl_config_t *cfg = &framework_state.config;
+    
+    if (cfg->num_worker_cpus == 0) {
+        return cxl_bench_select_cpus(node, cpus, max_cpus);
+    }
+    
+    int count = (cfg->num_worker_cpus < max_cpus) ? cfg->num_worker_cpus : max_cpus;
+    memcpy(cpus, cfg->worker_cpus, (size_t)count * sizeof(int));
+    return count;
+}
+
 /* ====== 执行 Flush+Reload 完整测试 ====== */
+typedef struct {
+    int status;
+    int cpu;
+    int success_count;
+    cxl_perf_counts_t perf;     /* 攻击阶段的硬件计数 */
+} flush_reload_round_t;
+
+typedef struct {
+    const test_config_t *config;
+    int data_node;
+    flush_reload_round_t *rounds;   /* [num_rounds]，按轮次编号写入 */
+} flush_reload_job_t;
+
+static int flush_reload_round(runner_worker_t *worker, int round, void *arg) {
+    flush_reload_job_t *job = (flush_reload_job_t *)arg;
+    flush_reload_round_t *out = &job->rounds[round];
+    attack_result_t *results = (attack_result_t *)worker->scratch;
+    size_t test_size = framework_state.config.test_buffer_size;
+    
+    out->status = -1;
+    out->cpu = worker->cpu;
+    
+    void *test_data = cxl_malloc_on_node(test_size, job->data_node);
+    if (!test_data) {
+        fprintf(stderr, "[ERROR] Round %d: failed to allocate test data\n", round + 1);
+        return -1;
+    }
+    
+    /* 执行攻击，硬件计数只包围攻击循环，不含缓冲区分配 */
+    cxl_perf_counts_t perf_start, perf_end;
+    int success_count = 0;
+    cxl_perf_read(&worker->perf, &perf_start);
+    for (int i = 0; i < job->config->num_iterations; i++) {
+        if (cxl_attacker_flush_reload(test_data, &results[i]) >= 0) {
+            cxl_histogram_record(worker->hists[0], results[i].attacker_probe_time);
+            if (results[i].is_hit) {
+                success_count++;
+            }
+        }
+    }
+    cxl_perf_read(&worker->perf, &perf_end);
+    cxl_perf_diff(&perf_end, &perf_start, &out->perf);
+    
+    cxl_free(test_data, test_size);
+    
+    out->success_count = success_count;
+    out->status = 0;
+    
+    return 0;
+}
+
 int run_flush_reload_test(test_config_t *config) {
     fprintf(stdout, "\n============== Flush + Reload Attack Test ==============\n");
-    fprintf(stdout, "Iterations: %d, Rounds: %d\n\n", 
-           config->num_iterations, config->num_rounds);
+    fprintf(stdout, "Iterations: %d, Rounds: %d, Threads: %d\n\n", 
+           config->num_iterations, config->num_rounds, config->num_threads);
+    
+    if (config->num_iterations <= 0 || config->num_rounds <= 0) {
+        fprintf(stderr, "[ERROR] Iterations and rounds must be positive\n");
+        return -1;
+    }
+    
+    if (framework_init_attacker(framework_state.config.attacker_cpu) < 0) {
+        fprintf(stderr, "[ERROR] Failed to initialize attacker\n");
+        return -1;
+    }
+    
+    flush_reload_job_t job = {
+        .config = config,
+        .data_node = framework_state.config.numa_node_normal,
+        .rounds = calloc((size_t)config->num_rounds, sizeof(flush_reload_round_t)),
+    };
+    if (!job.rounds) {
+        fprintf(stderr, "[ERROR] Failed to allocate results\n");
+        return -1;
+    }
+    
+    /* 各轮次相互独立，分发到绑核的工作线程上并行执行 */
+    runner_params_t params = {
+        .num_rounds = config->num_rounds,
+        .num_workers = config->num_threads,
+        .cpu_node = -1,
+        .cpus = framework_state.config.worker_cpus,
+        .num_cpus = framework_state.config.num_worker_cpus,
+        .scratch_size = (size_t)config->num_iterations * sizeof(attack_result_t),
+        .num_hists = 1,
+        .round_fn = flush_reload_round,
+        .arg = &job,
+    };
+    runner_result_t run;
+    
+    if (cxl_runner_run(&params, &run) < 0) {
+        fprintf(stderr, "[ERROR] Flush + Reload runner failed\n");
+        free(job.rounds);
+        return -1;
+    }
     
     double total_success_rate = 0.0;
     uint64_t min_success = UINT64_MAX, max_success = 0;
+    cxl_perf_counts_t perf_total = {0};
+    int completed = 0;
     
-    /* 多轮测试 */
+    /* 按轮次顺序输出 */
     for (int round = 0; round < config->num_rounds; round++) {
-        fprintf(stdout, "[Round %d/%d]", round + 1, config->num_rounds);
+        const flush_reload_round_t *r = &job.rounds[round];
         
-        size_t test_size = 4096;
-        void *test_data = cxl_malloc_on_node(test_size, 0);
-        
-        if (!test_data) {
-            fprintf(stderr, " [ERROR] Failed to allocate test data\n");
-            continue;
-        }
-        
-        attack_result_t *results = malloc(config->num_iterations * 
-                                         sizeof(attack_result_t));
-        if (!results) {
-            fprintf(stderr, " [ERROR] Failed to allocate results\n");
-            cxl_free(test_data, test_size);
+        fprintf(stdout, "[Round %d/%d]", round + 1, config->num_rounds);
+        if (r->status < 0) {
+            fprintf(stdout, " FAILED\n");
             continue;
         }
         
-        /* 执行攻击 */
-        int success_count = 0;
-        for (int i = 0; i < config->num_iterations; i++) {
-            if (cxl_attacker_flush_reload(test_data, &results[i]) >= 0 && 
-                results[i].is_hit) {
-                success_count++;
-            }
-            
-            if (config->verbose && i % 100 == 0 && i > 0) {
-                fprintf(stdout, ".");
-            }
-        }
-        
+        uint64_t success_count = (uint64_t)r->success_count;
         double success_rate = (double)success_count / config->num_iterations;
         total_success_rate += success_rate;
         min_success = (success_count < min_success) ? success_count : min_success;
         max_success = (success_count > max_success) ? success_count : max_success;
+        cxl_perf_accumulate(&perf_total, &r->perf);
+        completed++;
         
-        fprintf(stdout, " Success Rate: %.2f%% (%d/%d hits)\n", 
-               success_rate * 100.0, success_count, config->num_iterations);
-        
-        free(results);
-        cxl_free(test_data, test_size);
+        fprintf(stdout, " Success Rate: %.2f%% (%d/%d hits)", 
+               success_rate * 100.0, r->success_count, config->num_iterations);
+        if (config->verbose) {
+            fprintf(stdout, " [CPU %d]", r->cpu);
+        }
+        fprintf(stdout, "\n");
     }
     
     /* 汇总统计 */
     fprintf(stdout, "\n[SUMMARY] Flush + Reload Test Results:\n");
-    fprintf(stdout, "  Average Success Rate: %.2f%%\n", 
-           (total_success_rate / config->num_rounds) * 100.0);
-    fprintf(stdout, "  Min Hits per Round:   %lu\n", min_success);
-    fprintf(stdout, "  Max Hits per Round:   %lu\n", max_success);
+    cxl_runner_print_summary(&run);
+    if (completed > 0) {
+        fprintf(stdout, "  Average Success Rate: %.2f%%\n", 
+               (total_success_rate / completed) * 100.0);
+        fprintf(stdout, "  Min Hits per Round:   %lu\n", min_success);
+        fprintf(stdout, "  Max Hits per Round:   %lu\n", max_success);
+    }
+    cxl_histogram_print_summary(run.hists[0], "Reload Probe Time (all rounds)");
+    cxl_perf_print(&perf_total, "Hardware Counters (attack phase, all rounds)",
+                   (uint64_t)completed * (uint64_t)config->num_iterations);
+    
+    /* 导出逐轮结果与攻击阶段的硬件计数 */
+    if (cxl_analysis_init(config->output_dir) == 0) {
+        char filepath[512];
+        snprintf(filepath, sizeof(filepath), "%s/flush_reload_rounds.csv", config->output_dir);
+        
+        FILE *file = fopen(filepath, "w");
+        if (file) {
+            fprintf(file, "round,cpu,status,hits,iterations");
+            cxl_perf_csv_header(file, NULL);
+            fprintf(file, "\n");
+            for (int round = 0; round < config->num_rounds; round++) {
+                const flush_reload_round_t *r = &job.rounds[round];
+                fprintf(file, "%d,%d,%s,%d,%d", round + 1, r->cpu, r->status == 0 ? "ok" : "failed",
+                       r->success_count, config->num_iterations);
+                cxl_perf_csv_row(file, &r->perf);
+                fprintf(file, "\n");
+            }
+            fclose(file);
+            fprintf(stdout, "\n[INFO] Round results exported to: %s\n", filepath);
+        }
+        cxl_analysis_cleanup();
+    }
     
-    return 0;
+    cxl_runner_result_free(&run);
+    free(job.rounds);
+    
+    return completed > 0 ? 0 : -1;
 }
 
 /* ====== 执行延迟测试与对比 ====== */
+typedef struct {
+    int status;
+    int cpu;
+    double latency_diff;
+    double signal_strength;
+    cxl_perf_counts_t perf;     /* 测量阶段的硬件计数 */
+} latency_round_t;
+
+typedef struct {
+    const test_config_t *config;
+    latency_round_t *rounds;        /* [num_rounds]，按轮次编号写入 */
+} latency_job_t;
+
+/* 按 -S 指定的格式导出一轮的原始样本：latency_r<轮次>_<标签>.csv / .cxltrace */
+static void export_round_samples(const test_config_t *config, int round, const char *label,
+                                 const uint64_t *timings) {
+    char filepath[512];
+    
+    if (config->sample_export == SAMPLE_EXPORT_CSV) {
+        snprintf(filepath, sizeof(filepath), "%s/latency_r%03d_%s.csv", config->output_dir, round + 1, label);
+        cxl_analysis_export_csv(timings, config->num_iterations, label, filepath);
+    } else if (config->sample_export == SAMPLE_EXPORT_TRACE) {
+        snprintf(filepath, sizeof(filepath), "%s/latency_r%03d_%s.cxltrace", config->output_dir, round + 1, label);
+        cxl_analysis_export_binary(timings, config->num_iterations, label, filepath);
+    }
+}
+
+static int latency_round(runner_worker_t *worker, int round, void *arg) {
+    latency_job_t *job = (latency_job_t *)arg;
+    const test_config_t *config = job->config;
+    latency_round_t *out = &job->rounds[round];
+    
+    /* 计时缓冲区在工作线程的本地节点上，被测数据按配置放在 Normal / CXL 节点 */
+    uint64_t *cxl_timings = (uint64_t *)worker->scratch;
+    uint64_t *normal_timings = cxl_timings + config->num_iterations;
+    size_t test_size = framework_state.config.test_buffer_size;
+    
+    out->status = -1;
+    out->cpu = worker->cpu;
+    
+    void *normal_addr = cxl_malloc_on_node(test_size, framework_state.config.numa_node_normal);
+    void *cxl_addr = config->compare_cxl_normal ? 
+                    cxl_malloc_on_node(test_size, framework_state.config.numa_node_cxl) :
+                    normal_addr;
+    
+    cxl_perf_counts_t perf_start, perf_end;
+    int measured = -1;
+    
+    if (normal_addr && cxl_addr) {
+        cxl_perf_read(&worker->perf, &perf_start);
+        measured = cxl_observe_cxl_latency(cxl_addr, normal_addr, cxl_timings,
+                                           normal_timings, config->num_iterations);
+        cxl_perf_read(&worker->perf, &perf_end);
+        cxl_perf_diff(&perf_end, &perf_start, &out->perf);
+    }
+    
+    if (measured >= 0) {
+        cxl_analysis_latency_difference(cxl_timings, normal_timings, 
+                                       config->num_iterations, 
+                                       &out->latency_diff, &out->signal_strength);
+        cxl_histogram_record_array(worker->hists[0], cxl_timings, (size_t)config->num_iterations);
+        cxl_histogram_record_array(worker->hists[1], normal_timings, (size_t)config->num_iterations);
+        out->status = 0;
+        
+        if (config->compare_cxl_normal) {
+            export_round_samples(config, round, "cxl", cxl_timings);
+            export_round_samples(config, round, "normal", normal_timings);
+        } else {
+            export_round_samples(config, round, "access", cxl_timings);
+        }
+    } else {
+        fprintf(stderr, "[ERROR] Round %d: latency measurement failed\n", round + 1);
+    }
+    
+    if (cxl_addr && cxl_addr != normal_addr) {
+        cxl_free(cxl_addr, test_size);
+    }
+    if (normal_addr) {
+        cxl_free(normal_addr, test_size);
+    }
+    
+    return out->status;
+}
+
 int run_latency_test(test_config_t *config) {
     fprintf(stdout, "\n============== CXL Memory Latency Test ==============\n");
-    fprintf(stdout, "Samples: %d per access, Rounds: %d\n", 
-           config->num_iterations, config->num_rounds);
+    fprintf(stdout, "Samples: %d per access, Rounds: %d, Threads: %d\n", 
+           config->num_iterations, config->num_rounds, config->num_threads);
     
     if (!config->compare_cxl_normal) {
         fprintf(stdout, "[Note] Run with -c flag to compare CXL vs Normal memory\n\n");
     }
     
+    if (config->num_iterations <= 0 || config->num_rounds <= 0) {
+        fprintf(stderr, "[ERROR] Iterations and rounds must be positive\n");
+        return -1;
+    }
+    
+    /* 原始样本由各工作线程在本轮结束时写出，输出目录要先建好 */
+    if (config->sample_export != SAMPLE_EXPORT_NONE && cxl_analysis_init(config->output_dir) < 0) {
+        return -1;
+    }
+    
+    latency_job_t job = {
+        .config = config,
+        .rounds = calloc((size_t)config->num_rounds, sizeof(latency_round_t)),
+    };
+    if (!job.rounds) {
+        fprintf(stderr, "[ERROR] Failed to allocate results\n");
+        return -1;
+    }
+    
+    runner_params_t params = {
+        .num_rounds = config->num_rounds,
+        .num_workers = config->num_threads,
+        .cpu_node = -1,
+        .cpus = framework_state.config.worker_cpus,
+        .num_cpus = framework_state.config.num_worker_cpus,
+        .scratch_size = 2 * (size_t)config->num_iterations * sizeof(uint64_t),
+        .num_hists = 2,
+        .round_fn = latency_round,
+        .arg = &job,
+    };
+    runner_result_t run;
+    
+    if (cxl_runner_run(&params, &run) < 0) {
+        fprintf(stderr, "[ERROR] Latency runner failed\n");
+        free(job.rounds);
+        return -1;
+    }
+    
     double total_diff = 0.0;
     double total_signal = 0.0;
+    cxl_perf_counts_t perf_total = {0};
+    int completed = 0;
     
-    /* 多轮测试 */
+    /* 按轮次顺序输出 */
     for (int round = 0; round < config->num_rounds; round++) {
-        fprintf(stdout, "\n[Round %d/%d]\n", round + 1, config->num_rounds);
+        const latency_round_t *r = &job.rounds[round];
         
-        /* 在 Normal Node 上分配数据 */
-        size_t test_size = 4096;
-        void *normal_addr = cxl_malloc_on_node(NUMA_NODE_NORMAL, test_size);
-        void *cxl_addr = config->compare_cxl_normal ? 
-                        cxl_malloc_on_node(NUMA_NODE_CXL_MEMORY, test_size) :
-                        normal_addr;
+        fprintf(stdout, "\n[Round %d/%d]", round + 1, config->num_rounds);
+        if (config->verbose) {
+            fprintf(stdout, " [CPU %d]", r->cpu);
+        }
+        fprintf(stdout, "\n");
         
-        if (!normal_addr || !cxl_addr) {
-            fprintf(stderr, "[ERROR] Memory allocation failed\n");
+        if (r->status < 0) {
+            fprintf(stdout, "  FAILED\n");
             continue;
         }
         
-        uint64_t *cxl_timings = malloc(config->num_iterations * sizeof(uint64_t));
-        uint64_t *normal_timings = malloc(config->num_iterations * sizeof(uint64_t));
+        total_diff += r->latency_diff;
+        total_signal += r->signal_strength;
+        cxl_perf_accumulate(&perf_total, &r->perf);
+        completed++;
         
-        if (!cxl_timings || !normal_timings) {
-            fprintf(stderr, "[ERROR] Timing buffer allocation failed\n");
-            free(cxl_timings);
-            free(normal_timings);
-            continue;
+        fprintf(stdout, "  Latency Difference: %.2f cycles (%.1f ns)\n", r->latency_diff, cxl_cycles_to_ns_f(r->latency_diff));
+        fprintf(stdout, "  Signal Strength:    %.2f\n", r->signal_strength);
+    }
+    
+    /* 汇总统计 */
+    fprintf(stdout, "\n[SUMMARY] CXL Latency Test Results:\n");
+    cxl_runner_print_summary(&run);
+    if (completed > 0) {
+        fprintf(stdout, "  Average Latency Difference: %.2f cycles (%.1f ns)\n", 
+               total_diff / completed, cxl_cycles_to_ns_f(total_diff / completed));
+        fprintf(stdout, "  Average Signal Strength:    %.2f\n", 
+               total_signal / completed);
+    }
+    cxl_histogram_print_summary(run.hists[0], config->compare_cxl_normal ?
+                                "CXL Access Time (all rounds)" : "Access Time (all rounds)");
+    if (config->compare_cxl_normal) {
+        cxl_histogram_print_summary(run.hists[1], "Normal Access Time (all rounds)");
+        
+        cxl_compare_result_t comparison;
+        if (cxl_analysis_compare_histograms(run.hists[0], run.hists[1], &comparison) == 0) {
+            cxl_analysis_print_comparison(&comparison, "CXL vs Normal Significance (all rounds)",
+                                          CXL_ANALYSIS_DEFAULT_ALPHA);
+        }
+    }
+    /* 每轮对两块内存各测 num_iterations 次 */
+    cxl_perf_print(&perf_total, "Hardware Counters (measurement phase, all rounds)",
+                   2 * (uint64_t)completed * (uint64_t)config->num_iterations);
+    
+    /* 导出逐轮结果与测量阶段的硬件计数 */
+    if (cxl_analysis_init(config->output_dir) == 0) {
+        char filepath[512];
+        snprintf(filepath, sizeof(filepath), "%s/latency_rounds.csv", config->output_dir);
+        
+        FILE *file = fopen(filepath, "w");
+        if (file) {
+            fprintf(file, "round,cpu,status,samples,latency_diff_cycles,signal_strength");
+            cxl_perf_csv_header(file, NULL);
+            fprintf(file, "\n");
+            for (int round = 0; round < config->num_rounds; round++) {
+                const latency_round_t *r = &job.rounds[round];
+                fprintf(file, "%d,%d,%s,%d,%.3f,%.3f", round + 1, r->cpu,
+                       r->status == 0 ? "ok" : "failed", 2 * config->num_iterations,
+                       r->latency_diff, r->signal_strength);
+                cxl_perf_csv_row(file, &r->perf);
+                fprintf(file, "\n");
+            }
+            fclose(file);
+            fprintf(stdout, "\n[INFO] Round results exported to: %s\n", filepath);
+        }
+        cxl_analysis_cleanup();
+    }
+    
+    cxl_runner_result_free(&run);
+    free(job.rounds);
+    
+    return completed > 0 ? 0 : -1;
+}
+
+/* ====== 执行指针追逐延迟曲线测试 ====== */
+int run_pointer_chase_test(test_config_t *config) {
+    fprintf(stdout, "\n============== Pointer-Chase Latency Sweep ==============\n");
+    
+    int nodes[2] = {framework_state.config.numa_node_normal, framework_state.config.numa_node_cxl};
+    int num_nodes = (nodes[1] >= 0 && nodes[1] != nodes[0]) ? 2 : 1;
+    uint64_t num_loads = (uint64_t)config->num_iterations * 1000;
+    
+    fprintf(stdout, "Working set: %lu KiB - %zu MiB, Loads per point: %lu\n",
+           CXL_BENCH_MIN_WORKING_SET >> 10, config->max_working_set >> 20, num_loads);
+    
+    chase_result_t results[2][CXL_BENCH_MAX_POINTS];
+    int counts[2] = {0, 0};
+    
+    for (int n = 0; n < num_nodes; n++) {
+        fprintf(stdout, "\n[Node %d] Sweeping...\n", nodes[n]);
+        counts[n] = cxl_bench_latency_sweep(nodes[n], CXL_BENCH_MIN_WORKING_SET,
+                                            config->max_working_set, num_loads,
+                                            results[n], CXL_BENCH_MAX_POINTS);
+        if (counts[n] < 0) counts[n] = 0;
+        if (counts[n] > 0) {
+            fprintf(stdout, "[Node %d] Page size: %zu KiB\n", nodes[n], results[n][0].page_size >> 10);
         }
+    }
+    
+    /* 输出延迟曲线 */
+    fprintf(stdout, "\n[RESULT] Idle Load-to-Use Latency (ns/load)\n");
+    fprintf(stdout, "  %-14s", "Working Set");
+    for (int n = 0; n < num_nodes; n++) {
+        fprintf(stdout, "  Node %-6d", nodes[n]);
+    }
+    fprintf(stdout, "\n");
+    
+    int rows = (counts[0] > counts[1]) ? counts[0] : counts[1];
+    for (int r = 0; r < rows; r++) {
+        size_t ws = (r < counts[0]) ? results[0][r].working_set : results[1][r].working_set;
+        fprintf(stdout, "  %10zu KiB", ws >> 10);
+        for (int n = 0; n < num_nodes; n++) {
+            if (r < counts[n]) {
+                fprintf(stdout, "  %11.2f", results[n][r].ns_per_load);
+            } else {
+                fprintf(stdout, "  %11s", "-");
+            }
+        }
+        fprintf(stdout, "\n");
+    }
+    
+    /* 导出 CSV */
+    if (cxl_analysis_init(config->output_dir) == 0) {
+        char filepath[512];
+        snprintf(filepath, sizeof(filepath), "%s/latency_curve.csv", config->output_dir);
         
-        if (cxl_observe_cxl_latency(cxl_addr, normal_addr, cxl_timings, 
-                                    normal_timings, config->num_iterations) >= 0) {
-            double latency_diff = 0.0, signal_strength = 0.0;
+        FILE *file = fopen(filepath, "w");
+        if (file) {
+            fprintf(file, "node,working_set_bytes,page_size,num_loads,ns_per_load,cycles_per_load");
+            cxl_perf_csv_header(file, NULL);
+            fprintf(file, "\n");
+            for (int n = 0; n < num_nodes; n++) {
+                for (int r = 0; r < counts[n]; r++) {
+                    fprintf(file, "%d,%zu,%zu,%lu,%.3f,%.3f", results[n][r].node,
+                           results[n][r].working_set, results[n][r].page_size,
+                           results[n][r].num_loads, results[n][r].ns_per_load,
+                           results[n][r].cycles_per_load);
+                    cxl_perf_csv_row(file, &results[n][r].perf);
+                    fprintf(file, "\n");
+                }
+            }
+            fclose(file);
+            fprintf(stdout, "\n[INFO] Latency curve exported to: %s\n", filepath);
+        }
+        cxl_analysis_cleanup();
+    }
+    
+    return (counts[0] > 0) ? 0 : -1;
+}
+
+/* ====== 执行带宽扩展测试 ====== */
+int run_bandwidth_test(test_config_t *config) {
+    fprintf(stdout, "\n============== Memory Bandwidth Scaling Test ==============\n");
+    
+    int nodes[2] = {framework_state.config.numa_node_normal, framework_state.config.numa_node_cxl};
+    int num_nodes = (nodes[1] >= 0 && nodes[1] != nodes[0]) ? 2 : 1;
+    
+    /* 线程运行在普通节点（发起访问的一侧），数据分别放在两个节点上 */
+    int cpus[CXL_MAX_THREADS];
+    int max_threads = (config->num_threads < CXL_MAX_THREADS) ? config->num_threads : CXL_MAX_THREADS;
+    int num_cpus = framework_select_cpus(nodes[0], cpus, max_threads);
+    if (num_cpus <= 0) {
+        fprintf(stderr, "[ERROR] No CPUs available for bandwidth test\n");
+        return -1;
+    }
+    if (num_cpus < max_threads) {
+        fprintf(stdout, "[Note] Only %d CPUs available, limiting thread count\n", num_cpus);
+        max_threads = num_cpus;
+    }
+    
+    size_t bytes_per_thread = (config->max_working_set < CXL_BENCH_BW_ARRAY_SIZE) ?
+                              config->max_working_set : CXL_BENCH_BW_ARRAY_SIZE;
+    
+    fprintf(stdout, "Threads: 1-%d, Array: %zu MiB per thread, SIMD: %s, Repeats: %d\n",
+           max_threads, bytes_per_thread >> 20, cxl_bench_simd_level(), CXL_BENCH_BW_REPEATS);
+    
+    FILE *csv = NULL;
+    if (cxl_analysis_init(config->output_dir) == 0) {
+        char filepath[512];
+        snprintf(filepath, sizeof(filepath), "%s/bandwidth.csv", config->output_dir);
+        csv = fopen(filepath, "w");
+        if (csv) {
+            fprintf(csv, "node,threads,kernel,bytes_per_thread,page_size,gbps");
+            cxl_perf_csv_header(csv, NULL);
+            fprintf(csv, "\n");
+        }
+    }
+    
+    int measured = 0;
+    for (int n = 0; n < num_nodes; n++) {
+        fprintf(stdout, "\n[RESULT] Node %d Bandwidth (GB/s)\n", nodes[n]);
+        fprintf(stdout, "  %-8s", "Threads");
+        for (int k = 0; k < BW_KERNEL_COUNT; k++) {
+            fprintf(stdout, "  %10s", cxl_bench_kernel_name((bw_kernel_t)k));
+        }
+        fprintf(stdout, "\n");
+        
+        /* 线程数按 2 倍增长，最后一定包含最大线程数 */
+        for (int threads = 1; threads <= max_threads; ) {
+            fprintf(stdout, "  %-8d", threads);
+            for (int k = 0; k < BW_KERNEL_COUNT; k++) {
+                bandwidth_result_t result;
+                if (cxl_bench_bandwidth(nodes[n], cpus, threads, (bw_kernel_t)k,
+                                        bytes_per_thread, CXL_BENCH_BW_REPEATS, &result) < 0) {
+                    fprintf(stdout, "  %10s", "-");
+                    continue;
+                }
+                fprintf(stdout, "  %10.2f", result.gbps);
+                fflush(stdout);
+                measured++;
+                
+                if (csv) {
+                    fprintf(csv, "%d,%d,%s,%zu,%zu,%.3f", result.node, result.num_threads,
+                           cxl_bench_kernel_name(result.kernel), result.bytes_per_thread,
+                           result.page_size, result.gbps);
+                    cxl_perf_csv_row(csv, &result.perf);
+                    fprintf(csv, "\n");
+                }
+            }
+            fprintf(stdout, "\n");
             
-            cxl_analysis_latency_difference(cxl_timings, normal_timings, 
-                                           config->num_iterations, 
-                                           &latency_diff, &signal_strength);
+            if (threads == max_threads) break;
+            threads = (threads * 2 < max_threads) ? threads * 2 : max_threads;
+        }
+    }
+    
+    if (csv) {
+        fclose(csv);
+        fprintf(stdout, "\n[INFO] Bandwidth results exported to: %s/bandwidth.csv\n", config->output_dir);
+    }
+    cxl_analysis_cleanup();
+    
+    return (measured > 0) ? 0 : -1;
+}
+
+/* ====== 执行负载延迟测试 ====== */
+int run_loaded_latency_test(test_config_t *config) {
+    fprintf(stdout, "\n============== Loaded Latency Test ==============\n");
+    
+    /* 节流强度从轻到重：每个缓存行之后的 pause 次数 */
+    static const uint32_t delays[] = {1000, 500, 200, 100, 50, 20, 10, 5, 2, 1, 0};
+    const int num_delays = sizeof(delays) / sizeof(delays[0]);
+    
+    int nodes[2] = {framework_state.config.numa_node_cxl, framework_state.config.numa_node_normal};
+    int num_nodes = (nodes[0] >= 0 && nodes[0] != nodes[1]) ? 2 : 1;
+    if (num_nodes == 1) nodes[0] = nodes[1];
+    
+    /* 追逐线程与注入线程都运行在普通节点的 CPU 上，第一个 CPU 留给追逐线程 */
+    int cpus[CXL_MAX_THREADS];
+    int num_cpus = framework_select_cpus(framework_state.config.numa_node_normal, cpus, CXL_MAX_THREADS);
+    if (num_cpus <= 0) {
+        fprintf(stderr, "[ERROR] No CPUs available for loaded latency test\n");
+        return -1;
+    }
+    
+    int num_injectors = config->num_threads - 1;
+    if (num_injectors >= CXL_MAX_THREADS) num_injectors = CXL_MAX_THREADS - 1;
+    if (num_injectors < 0) num_injectors = 0;
+    
+    int injector_cpus[CXL_MAX_THREADS];
+    if (num_cpus == 1) {
+        fprintf(stdout, "[Note] Only 1 CPU available, injectors share the chase CPU\n");
+        for (int i = 0; i < num_injectors; i++) injector_cpus[i] = cpus[0];
+    } else {
+        if (num_injectors > num_cpus - 1) {
+            fprintf(stdout, "[Note] Only %d CPUs available, limiting injectors to %d\n",
+                   num_cpus, num_cpus - 1);
+            num_injectors = num_cpus - 1;
+        }
+        for (int i = 0; i < num_injectors; i++) injector_cpus[i] = cpus[i + 1];
+    }
+    
+    loaded_latency_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.chase_cpu = cpus[0];
+    params.injector_cpus = injector_cpus;
+    params.num_injectors = num_injectors;
+    params.traffic = config->inject_traffic;
+    params.chase_working_set = (config->max_working_set < CXL_BENCH_LOADED_WORKING_SET) ?
+                               config->max_working_set : CXL_BENCH_LOADED_WORKING_SET;
+    params.inject_bytes = (config->max_working_set < CXL_BENCH_BW_ARRAY_SIZE) ?
+                          config->max_working_set : CXL_BENCH_BW_ARRAY_SIZE;
+    params.num_loads = (uint64_t)config->num_iterations * 1000;
+    
+    fprintf(stdout, "Chase CPU: %d, Injectors: %d (%s), Chase WS: %zu MiB, Loads per point: %lu\n",
+           params.chase_cpu, num_injectors, cxl_bench_traffic_name(params.traffic),
+           params.chase_working_set >> 20, params.num_loads);
+    
+    FILE *csv = NULL;
+    if (cxl_analysis_init(config->output_dir) == 0) {
+        char filepath[512];
+        snprintf(filepath, sizeof(filepath), "%s/loaded_latency.csv", config->output_dir);
+        csv = fopen(filepath, "w");
+        if (csv) {
+            fprintf(csv, "node,injectors,traffic,delay,page_size,injected_gbps,num_loads,ns_per_load,"
+                        "cycles_per_load");
+            cxl_perf_csv_header(csv, NULL);
+            fprintf(csv, "\n");
+        }
+    }
+    
+    int measured = 0;
+    for (int n = 0; n < num_nodes; n++) {
+        loaded_latency_result_t results[CXL_BENCH_MAX_DELAYS + 1];
+        params.node = nodes[n];
+        
+        fprintf(stdout, "\n[Node %d] Sweeping injection rate...\n", nodes[n]);
+        int count = cxl_bench_loaded_latency_sweep(&params, delays, num_delays, results);
+        if (count <= 0) continue;
+        measured += count;
+        
+        fprintf(stdout, "\n[RESULT] Node %d Loaded Latency\n", nodes[n]);
+        fprintf(stdout, "  %-8s  %12s  %12s  %12s\n", "Delay", "Bandwidth", "Latency", "Cycles");
+        for (int r = 0; r < count; r++) {
+            if (results[r].num_injectors == 0) {
+                fprintf(stdout, "  %-8s", "idle");
+            } else {
+                fprintf(stdout, "  %-8u", results[r].delay);
+            }
+            fprintf(stdout, "  %7.2f GB/s  %9.2f ns  %12.1f\n", results[r].injected_gbps,
+                   results[r].ns_per_load, results[r].cycles_per_load);
             
-            total_diff += latency_diff;
-            total_signal += signal_strength;
+            if (csv) {
+                fprintf(csv, "%d,%d,%s,%u,%zu,%.3f,%lu,%.3f,%.3f", results[r].node,
+                       results[r].num_injectors, cxl_bench_traffic_name(results[r].traffic),
+                       results[r].delay, results[r].page_size, results[r].injected_gbps,
+                       results[r].num_loads, results[r].ns_per_load, results[r].cycles_per_load);
+                cxl_perf_csv_row(csv, &results[r].perf);
+                fprintf(csv, "\n");
+            }
+        }
+    }
+    
+    if (csv) {
+        fclose(csv);
+        fprintf(stdout, "\n[INFO] Loaded latency curve exported to: %s/loaded_latency.csv\n", config->output_dir);
+    }
+    cxl_analysis_cleanup();
+    
+    return (measured > 0) ? 0 : -1;
+}
+
+/* ====== 执行参数扫描 ====== */
+int run_sweep_test(test_config_t *config) {
+    fprintf(stdout, "\n============== Parameter Sweep ==============\n");
+    
+    sweep_matrix_t matrix;
+    cxl_sweep_matrix_default(&matrix, &framework_state.config, config->max_working_set);
+    
+    if (config->matrix_file[0] != '\0') {
+        if (cxl_sweep_load_matrix(config->matrix_file, &matrix) < 0) {
+            return -1;
+        }
+        fprintf(stdout, "Matrix file: %s\n", config->matrix_file);
+    }
+    
+    cxl_sweep_print_matrix(&matrix);
+    fprintf(stdout, "\n");
+    
+    int num_cells = cxl_sweep_num_cells(&matrix);
+    sweep_cell_t *cells = calloc((size_t)num_cells, sizeof(sweep_cell_t));
+    if (!cells) {
+        fprintf(stderr, "[ERROR] Failed to allocate sweep results\n");
+        return -1;
+    }
+    
+    int measured = cxl_sweep_run(&matrix, &framework_state.config, cells, num_cells);
+    if (measured < 0) {
+        free(cells);
+        return -1;
+    }
+    
+    /* 输出结果表 */
+    fprintf(stdout, "\n[RESULT] Sweep (%d/%d cells measured)\n", measured, num_cells);
+    fprintf(stdout, "  %-16s %-6s %4s %4s %5s %12s %7s %12s %12s\n", "Placement", "Data", "Node",
+           "CPU", "Probe", "Working Set", "Stride", "First ns", "Steady ns");
+    for (int i = 0; i < num_cells; i++) {
+        const sweep_cell_t *cell = &cells[i];
+        if (cell->status != 0) continue;
+        
+        fprintf(stdout, "  %-16s %-6s %4d %4d %5d %8lu KiB %7lu %12.2f %12.2f\n",
+               cxl_sweep_placement_name((thread_placement_t)cell->thread_placement),
+               cxl_sweep_data_name((sweep_data_kind_t)cell->data_kind), cell->node, cell->cpu,
+               cell->probe_cpu, cell->working_set >> 10, cell->stride,
+               cell->first_pass_ns, cell->ns_per_load);
+    }
+    
+    /* 导出合并结果表 */
+    if (cxl_analysis_init(config->output_dir) == 0) {
+        char filepath[512];
+        
+        snprintf(filepath, sizeof(filepath), "%s/sweep.csv", config->output_dir);
+        cxl_sweep_export_csv(cells, num_cells, filepath);
+        
+        snprintf(filepath, sizeof(filepath), "%s/sweep.bin", config->output_dir);
+        cxl_sweep_export_binary(cells, num_cells, filepath);
+        
+        cxl_analysis_cleanup();
+    }
+    
+    free(cells);
+    
+    return (measured > 0) ? 0 : -1;
+}
+
+/* ====== 执行页迁移测试 ====== */
+int run_migration_test(test_config_t *config) {
+    fprintf(stdout, "\n============== Page Migration Test ==============\n");
+    
+    /* move_pages 每次调用的页数，0 表示整个区域一次提交 */
+    static const size_t batches[] = {1, 16, 64, 256, 1024, 0};
+    const int num_batches = sizeof(batches) / sizeof(batches[0]);
+    static const page_mode_t page_modes[] = {PAGE_MODE_4K, PAGE_MODE_THP, PAGE_MODE_HUGETLB_2M};
+    const int num_page_modes = sizeof(page_modes) / sizeof(page_modes[0]);
+    
+    int normal = framework_state.config.numa_node_normal;
+    int cxl = framework_state.config.numa_node_cxl;
+    if (cxl < 0 || cxl == normal) {
+        fprintf(stderr, "[ERROR] Page migration test needs distinct normal and CXL nodes\n");
+        return -1;
+    }
+    
+    /* 先降级（普通 -> CXL）再提升（CXL -> 普通）；migrate_pages 在子进程中执行，不影响本进程的内存 */
+    int directions[2][2] = {{normal, cxl}, {cxl, normal}};
+    
+    migration_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.region_size = (config->max_working_set < CXL_BENCH_MIGRATE_REGION) ?
+                         config->max_working_set : CXL_BENCH_MIGRATE_REGION;
+    
+    fprintf(stdout, "Region: %zu MiB, Post-migration passes: %d\n",
+           params.region_size >> 20, CXL_BENCH_MIGRATE_PASSES);
+    
+    FILE *csv = NULL;
+    if (cxl_analysis_init(config->output_dir) == 0) {
+        char filepath[512];
+        snprintf(filepath, sizeof(filepath), "%s/migration.csv", config->output_dir);
+        csv = fopen(filepath, "w");
+        if (csv) {
+            fprintf(csv, "src_node,dst_node,method,page_size,batch_pages,num_pages,pages_moved,"
+                        "pages_failed,seconds,pages_per_sec,gbps,ns_before");
+            for (int p = 0; p < CXL_BENCH_MIGRATE_PASSES; p++) fprintf(csv, ",ns_after_%d", p);
+            cxl_perf_csv_header(csv, "before_");
+            cxl_perf_csv_header(csv, "after_");
+            fprintf(csv, "\n");
+        }
+    }
+    
+    int measured = 0;
+    for (int d = 0; d < 2; d++) {
+        params.src_node = directions[d][0];
+        params.dst_node = directions[d][1];
+        
+        fprintf(stdout, "\n[RESULT] Node %d -> Node %d\n", params.src_node, params.dst_node);
+        fprintf(stdout, "  %-13s %-5s %6s %12s %8s %10s %10s\n", "Method", "Pages", "Batch",
+               "Pages/s", "GB/s", "Before ns", "After ns");
+        
+        for (int pm = 0; pm < num_page_modes; pm++) {
+            params.page_mode = page_modes[pm];
             
-            fprintf(stdout, "  Latency Difference: %.2f cycles\n", latency_diff);
-            fprintf(stdout, "  Signal Strength:    %.2f\n", signal_strength);
+            /* move_pages 按批大小扫描，最后用 migrate_pages 迁移整个节点 */
+            for (int b = 0; b <= num_batches; b++) {
+                migration_result_t result;
+                params.method = (b < num_batches) ? MIGRATE_MOVE_PAGES : MIGRATE_MIGRATE_PAGES;
+                params.batch_pages = (b < num_batches) ? batches[b] : 0;
+                
+                if (cxl_bench_migration(&params, &result) < 0) continue;
+                measured++;
+                
+                /* 大页区域的页数少于批大小时，后续批大小的结果相同 */
+                int whole_region = (result.batch_pages == result.num_pages);
+                
+                fprintf(stdout, "  %-13s %-5s %6zu %12.0f %8.2f %10.1f %10.1f\n",
+                       cxl_bench_migrate_method_name(result.method),
+                       cxl_page_mode_name(params.page_mode), result.batch_pages,
+                       result.pages_per_sec, result.gbps, result.ns_before, result.ns_after[0]);
+                if (result.pages_failed > 0) {
+                    fprintf(stdout, "  [Note] %lu of %lu pages not on node %d after migration\n",
+                           result.pages_failed, result.num_pages, result.dst_node);
+                }
+                
+                if (csv) {
+                    fprintf(csv, "%d,%d,%s,%zu,%zu,%lu,%lu,%lu,%.6f,%.1f,%.3f,%.3f",
+                           result.src_node, result.dst_node,
+                           cxl_bench_migrate_method_name(result.method), result.page_size,
+                           result.batch_pages, result.num_pages, result.pages_moved,
+                           result.pages_failed, result.seconds, result.pages_per_sec,
+                           result.gbps, result.ns_before);
+                    for (int p = 0; p < CXL_BENCH_MIGRATE_PASSES; p++) {
+                        fprintf(csv, ",%.3f", result.ns_after[p]);
+                    }
+                    cxl_perf_csv_row(csv, &result.perf_before);
+                    cxl_perf_csv_row(csv, &result.perf_after);
+                    fprintf(csv, "\n");
+                }
+                
+                if (whole_region && b < num_batches) b = num_batches - 1;
+            }
+        }
+    }
+    
+    if (csv) {
+        fclose(csv);
+        fprintf(stdout, "\n[INFO] Migration results exported to: %s/migration.csv\n", config->output_dir);
+    }
+    cxl_analysis_cleanup();
+    
+    return (measured > 0) ? 0 : -1;
+}
+
+/* ====== 执行页访问频率分析 ====== */
+typedef struct {
+    volatile uint8_t *region;
+    size_t hot_bytes;
+    volatile int stop;
+} profile_workload_t;
+
+/* 内置负载：反复访问区域开头的热集，其余页只在分配时缺页一次 */
+static void *profile_workload_thread(void *arg) {
+    profile_workload_t *workload = (profile_workload_t *)arg;
+    uint64_t sum = 0;
+    
+    while (!workload->stop) {
+        for (size_t off = 0; off < workload->hot_bytes; off += CXL_CACHE_LINE_SIZE) {
+            sum += workload->region[off];
+        }
+    }
+    
+    return (void *)(uintptr_t)sum;
+}
+
+int run_profile_test(test_config_t *config) {
+    fprintf(stdout, "\n============== Page Access Profile ==============\n");
+    
+    if (!cxl_profile_available()) {
+        fprintf(stderr, "[ERROR] Idle page tracking unavailable (needs CONFIG_IDLE_PAGE_TRACKING and root)\n");
+        return -1;
+    }
+    
+    page_profile_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.pid = config->profile_pid;
+    params.interval_us = CXL_PROF_DEFAULT_INTERVAL_US;
+    params.num_intervals = CXL_PROF_DEFAULT_INTERVALS;
+    params.hot_fraction = CXL_PROF_DEFAULT_HOT_FRACTION;
+    
+    /* 没有指定目标进程时，在 CXL 节点上运行一个已知热集为 1/8 的负载，用于验证分类 */
+    profile_workload_t workload;
+    pthread_t workload_thread;
+    int workload_running = 0;
+    size_t region_size = 0;
+    int node = (framework_state.config.numa_node_cxl >= 0) ? framework_state.config.numa_node_cxl :
+               framework_state.config.numa_node_normal;
+    
+    memset(&workload, 0, sizeof(workload));
+    if (params.pid == 0) {
+        size_t page_size = 0;
+        region_size = (config->max_working_set < CXL_BENCH_MIGRATE_REGION) ?
+                      config->max_working_set : CXL_BENCH_MIGRATE_REGION;
+        workload.region = cxl_malloc_on_node_pages(region_size, node, PAGE_MODE_4K, &page_size);
+        if (!workload.region) {
+            return -1;
         }
+        workload.hot_bytes = region_size / 8;
         
-        free(cxl_timings);
-        free(normal_timings);
-        if (config->compare_cxl_normal && cxl_addr != normal_addr) {
-            cxl_free(cxl_addr, test_size);
+        if (pthread_create(&workload_thread, NULL, profile_workload_thread, &workload) == 0) {
+            workload_running = 1;
         }
-        cxl_free(normal_addr, test_size);
+        params.start = (uintptr_t)workload.region;
+        params.size = region_size;
+        fprintf(stdout, "Built-in workload: %zu MiB on node %d, hot set %zu MiB\n",
+               region_size >> 20, node, workload.hot_bytes >> 20);
+    } else if (cxl_profile_find_region(params.pid, &params.start, &params.size) < 0) {
+        return -1;
     }
     
-    /* 汇总统计 */
-    fprintf(stdout, "\n[SUMMARY] CXL Latency Test Results:\n");
-    fprintf(stdout, "  Average Latency Difference: %.2f cycles\n", 
-           total_diff / config->num_rounds);
-    fprintf(stdout, "  Average Signal Strength:    %.2f\n", 
-           total_signal / config->num_rounds);
+    fprintf(stdout, "Target: pid %d, region 0x%lx + %zu MiB, %u x %u ms intervals\n",
+           params.pid, (unsigned long)params.start, params.size >> 20, params.num_intervals,
+           params.interval_us / 1000);
+    
+    page_profile_t profile;
+    int ret = cxl_profile_pages(&params, &profile);
+    
+    if (workload_running) {
+        workload.stop = 1;
+        pthread_join(workload_thread, NULL);
+    }
+    if (workload.region) {
+        cxl_free_pages((void *)workload.region, region_size, PAGE_MODE_4K);
+    }
+    if (ret < 0) {
+        return -1;
+    }
+    
+    cxl_profile_print(&profile, framework_state.config.numa_node_cxl);
+    
+    if (cxl_analysis_init(config->output_dir) == 0) {
+        char filepath[512];
+        snprintf(filepath, sizeof(filepath), "%s/page_profile.csv", config->output_dir);
+        if (cxl_profile_export_csv(&profile, filepath) == 0) {
+            fprintf(stdout, "\n[INFO] Page profile exported to: %s\n", filepath);
+        }
+        cxl_analysis_cleanup();
+    }
+    
+    cxl_profile_free(&profile);
     
     return 0;
 }
@@ -552,22 +1533,43 @@ int main(int argc, char *argv[]) {
     fprintf(stdout, "║         Linux CXL Security Analysis Platform           ║\n");
     fprintf(stdout, "╚════════════════════════════════════════════════════════╝\n");
     
-    if (cxl_framework_init("default") < 0) {
+    if (cxl_framework_init(config.config_name) < 0) {
         fprintf(stderr, "[ERROR] Framework initialization failed\n");
         return 1;
     }
     
+    /* 命令行未指定的参数取自框架配置 */
+    if (config.num_iterations == 0) {
+        config.num_iterations = (int)framework_state.config.iterations;
+    }
+    if (!config.page_mode_set) {
+        config.page_mode = framework_state.config.page_mode;
+    }
+    
     /* 打印系统配置 */
     cxl_framework_print_info();
     
     fprintf(stdout, "\n[CONFIG] Test Parameters:\n");
     fprintf(stdout, "  Test Mode:       %d\n", config.test_mode);
+    fprintf(stdout, "  Config:          %s\n", config.config_name);
     fprintf(stdout, "  Iterations:      %d\n", config.num_iterations);
     fprintf(stdout, "  Rounds:          %d\n", config.num_rounds);
     fprintf(stdout, "  Threads:         %d\n", config.num_threads);
     fprintf(stdout, "  Output Dir:      %s\n", config.output_dir);
     fprintf(stdout, "  Compare CXL/Normal: %s\n", 
            config.compare_cxl_normal ? "Yes" : "No");
+    fprintf(stdout, "  Page Mode:       %s\n", cxl_page_mode_name(config.page_mode));
+    
+    cxl_bench_set_page_mode(config.page_mode);
+    
+    /* 保存生效的配置（含环境变量覆盖），便于复现实验 */
+    if (cxl_analysis_init(config.output_dir) == 0) {
+        char config_file[512];
+        snprintf(config_file, sizeof(config_file), "%s/config.ini", config.output_dir);
+        if (cxl_config_save(&framework_state.config, config_file) == 0) {
+            fprintf(stdout, "  Effective config saved to: %s\n", config_file);
+        }
+    }
     
     /* 执行相应的测试 */
     int result = 0;
@@ -587,6 +1589,24 @@ int main(int argc, char *argv[]) {
         case 4:
             result = run_full_demo(&config);
             break;
+        case 5:
+            result = run_pointer_chase_test(&config);
+            break;
+        case 6:
+            result = run_bandwidth_test(&config);
+            break;
+        case 7:
+            result = run_loaded_latency_test(&config);
+            break;
+        case 8:
+            result = run_sweep_test(&config);
+            break;
+        case 9:
+            result = run_migration_test(&config);
+            break;
+        case 10:
+            result = run_profile_test(&config);
+            break;
         default:
             fprintf(stderr, "[ERROR] Invalid test mode: %d\n", config.test_mode);
             print_usage(argv[0]);
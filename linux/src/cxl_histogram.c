@@ -0,0 +1,253 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cxl_histogram.h"
+#include "cxl_tsc.h"
+#include "cxl_common.h"
+
+#define HIST_MAX_QUANTILES 64
+
+/* ====== 初始化与释放 ====== */
+void cxl_histogram_init(cxl_histogram_t *hist) {
+    if (!hist) return;
+    
+    memset(hist, 0, sizeof(cxl_histogram_t));
+    hist->min_value = UINT64_MAX;
+}
+
+cxl_histogram_t *cxl_histogram_create(void) {
+    cxl_histogram_t *hist = malloc(sizeof(cxl_histogram_t));
+    if (!hist) {
+        fprintf(stderr, "[ERROR] Failed to allocate histogram\n");
+        return NULL;
+    }
+    
+    cxl_histogram_init(hist);
+    return hist;
+}
+
+void cxl_histogram_destroy(cxl_histogram_t *hist) {
+    free(hist);
+}
+
+/* ====== 记录 ====== */
+void cxl_histogram_record_n(cxl_histogram_t *hist, uint64_t value, uint64_t count) {
+    if (!hist || count == 0) return;
+    
+    hist->counts[cxl_histogram_bucket_index(value)] += count;
+    hist->total_count += count;
+    hist->sum += value * count;
+    if (value < hist->min_value) hist->min_value = value;
+    if (value > hist->max_value) hist->max_value = value;
+}
+
+int cxl_histogram_record_array(cxl_histogram_t *hist, const uint64_t *samples, size_t num_samples) {
+    if (!hist || !samples) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    for (size_t i = 0; i < num_samples; i++) {
+        cxl_histogram_record(hist, samples[i]);
+    }
+    
+    return 0;
+}
+
+int cxl_histogram_merge(cxl_histogram_t *dst, const cxl_histogram_t *src) {
+    if (!dst || !src) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    if (src->total_count == 0) return 0;
+    
+    for (int i = 0; i < CXL_HIST_NUM_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    
+    dst->total_count += src->total_count;
+    dst->sum += src->sum;
+    if (src->min_value < dst->min_value) dst->min_value = src->min_value;
+    if (src->max_value > dst->max_value) dst->max_value = src->max_value;
+    
+    return 0;
+}
+
+/* ====== 桶边界 ====== */
+uint64_t cxl_histogram_bucket_lowest(int index) {
+    if (index < CXL_HIST_SUB_BUCKET_COUNT) {
+        return (uint64_t)index;
+    }
+    
+    int exponent = index / CXL_HIST_SUB_BUCKET_HALF - 1;
+    uint64_t sub_bucket = (uint64_t)(index - exponent * CXL_HIST_SUB_BUCKET_HALF);
+    
+    return sub_bucket << exponent;
+}
+
+uint64_t cxl_histogram_bucket_highest(int index) {
+    if (index < CXL_HIST_SUB_BUCKET_COUNT) {
+        return (uint64_t)index;
+    }
+    
+    int exponent = index / CXL_HIST_SUB_BUCKET_HALF - 1;
+    
+    return cxl_histogram_bucket_lowest(index) + ((1ULL << exponent) - 1);
+}
+
+/* ====== 分位数查询 ====== */
+static uint64_t hist_clamp(const cxl_histogram_t *hist, uint64_t value) {
+    if (value < hist->min_value) return hist->min_value;
+    if (value > hist->max_value) return hist->max_value;
+    return value;
+}
+
+static uint64_t hist_rank(const cxl_histogram_t *hist, double quantile) {
+    if (quantile < 0.0) quantile = 0.0;
+    if (quantile > 1.0) quantile = 1.0;
+    
+    uint64_t rank = (uint64_t)ceil(quantile * (double)hist->total_count);
+    if (rank < 1) rank = 1;
+    if (rank > hist->total_count) rank = hist->total_count;
+    
+    return rank;
+}
+
+uint64_t cxl_histogram_quantile(const cxl_histogram_t *hist, double quantile) {
+    uint64_t value = 0;
+    
+    if (cxl_histogram_quantiles(hist, &quantile, 1, &value) < 0) {
+        return 0;
+    }
+    
+    return value;
+}
+
+int cxl_histogram_quantiles(const cxl_histogram_t *hist, const double *quantiles,
+                            int num_quantiles, uint64_t *values) {
+    if (!hist || !quantiles || !values || num_quantiles <= 0 ||
+        num_quantiles > HIST_MAX_QUANTILES) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    if (hist->total_count == 0) {
+        memset(values, 0, num_quantiles * sizeof(uint64_t));
+        return 0;
+    }
+    
+    /* 按分位数升序排列，桶只需遍历一遍 */
+    int order[HIST_MAX_QUANTILES];
+    for (int i = 0; i < num_quantiles; i++) {
+        int j = i;
+        while (j > 0 && quantiles[order[j - 1]] > quantiles[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    
+    int next = 0;
+    uint64_t cumulative = 0;
+    
+    for (int b = 0; b < CXL_HIST_NUM_BUCKETS && next < num_quantiles; b++) {
+        if (hist->counts[b] == 0) continue;
+        cumulative += hist->counts[b];
+        
+        while (next < num_quantiles && cumulative >= hist_rank(hist, quantiles[order[next]])) {
+            values[order[next]] = hist_clamp(hist, cxl_histogram_bucket_highest(b));
+            next++;
+        }
+    }
+    
+    /* 数值误差兜底 */
+    while (next < num_quantiles) {
+        values[order[next]] = hist->max_value;
+        next++;
+    }
+    
+    return 0;
+}
+
+/* ====== 矩统计 ====== */
+double cxl_histogram_mean(const cxl_histogram_t *hist) {
+    if (!hist || hist->total_count == 0) return 0.0;
+    
+    return (double)hist->sum / (double)hist->total_count;
+}
+
+double cxl_histogram_stddev(const cxl_histogram_t *hist) {
+    if (!hist || hist->total_count == 0) return 0.0;
+    
+    double mean = cxl_histogram_mean(hist);
+    double variance = 0.0;
+    
+    for (int b = 0; b < CXL_HIST_NUM_BUCKETS; b++) {
+        if (hist->counts[b] == 0) continue;
+        
+        double mid = ((double)cxl_histogram_bucket_lowest(b) +
+                      (double)cxl_histogram_bucket_highest(b)) / 2.0;
+        double diff = mid - mean;
+        variance += diff * diff * (double)hist->counts[b];
+    }
+    
+    return sqrt(variance / (double)hist->total_count);
+}
+
+/* ====== 报告与导出 ====== */
+void cxl_histogram_print_summary(const cxl_histogram_t *hist, const char *label) {
+    if (!hist) return;
+    
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999, 0.9999};
+    uint64_t values[5] = {0};
+    cxl_histogram_quantiles(hist, quantiles, 5, values);
+    
+    fprintf(stdout, "\n%s (%lu samples):\n", label ? label : "Histogram", hist->total_count);
+    if (hist->total_count == 0) return;
+    
+    double mean = cxl_histogram_mean(hist);
+    double stddev = cxl_histogram_stddev(hist);
+    
+    fprintf(stdout, "  Min:      %lu cycles (%.1f ns)\n", hist->min_value, cxl_cycles_to_ns_f(hist->min_value));
+    fprintf(stdout, "  Max:      %lu cycles (%.1f ns)\n", hist->max_value, cxl_cycles_to_ns_f(hist->max_value));
+    fprintf(stdout, "  Mean:     %.2f cycles (%.1f ns)\n", mean, cxl_cycles_to_ns_f(mean));
+    fprintf(stdout, "  StdDev:   %.2f cycles (%.1f ns)\n", stddev, cxl_cycles_to_ns_f(stddev));
+    fprintf(stdout, "  P50:      %lu cycles (%.1f ns)\n", values[0], cxl_cycles_to_ns_f(values[0]));
+    fprintf(stdout, "  P90:      %lu cycles (%.1f ns)\n", values[1], cxl_cycles_to_ns_f(values[1]));
+    fprintf(stdout, "  P99:      %lu cycles (%.1f ns)\n", values[2], cxl_cycles_to_ns_f(values[2]));
+    fprintf(stdout, "  P99.9:    %lu cycles (%.1f ns)\n", values[3], cxl_cycles_to_ns_f(values[3]));
+    fprintf(stdout, "  P99.99:   %lu cycles (%.1f ns)\n", values[4], cxl_cycles_to_ns_f(values[4]));
+}
+
+int cxl_histogram_export_csv(const cxl_histogram_t *hist, const char *label,
+                             const char *output_file) {
+    if (!hist || !label || !output_file) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    FILE *file = fopen(output_file, "w");
+    if (!file) {
+        fprintf(stderr, "[ERROR] Failed to open output file: %s\n", output_file);
+        return -1;
+    }
+    
+    fprintf(file, "bucket_low,bucket_high,bucket_low_ns,bucket_high_ns,%s\n", label);
+    
+    for (int b = 0; b < CXL_HIST_NUM_BUCKETS; b++) {
+        if (hist->counts[b] == 0) continue;
+        uint64_t low = cxl_histogram_bucket_lowest(b);
+        uint64_t high = cxl_histogram_bucket_highest(b);
+        fprintf(file, "%lu,%lu,%.1f,%.1f,%lu\n", low, high,
+                cxl_cycles_to_ns_f(low), cxl_cycles_to_ns_f(high), hist->counts[b]);
+    }
+    
+    fclose(file);
+    
+    fprintf(stdout, "[INFO] Histogram exported to: %s\n", output_file);
+    
+    return 0;
+}
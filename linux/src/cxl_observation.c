@@ -7,22 +7,56 @@
 #include <unistd.h>
 #include <errno.h>
 #include <time.h>
+#include <sched.h>
+#include <numa.h>
 #include "cxl_observation.h"
+#include "cxl_attack_primitives.h"
+#include "cxl_tsc.h"
+#include "cxl_stats.h"
+#include "cxl_profiler.h"
+#include "cxl_perf.h"
+#include "cxl_topology.h"
+#include "cxl_trace.h"
 #include "cxl_common.h"
 
 /* ====== 观测缓冲区管理 ====== */
 static struct {
     observation_type_t type;
-    void *buffer;
-    size_t buffer_size;
-    size_t current_pos;
+    size_t ring_slots;                  /* 每个环形缓冲区的槽位数 */
     int initialized;
+    unsigned int generation;            /* 每次初始化递增，使线程缓存的缓冲区指针失效 */
+    pthread_mutex_t ring_lock;          /* 缓冲区注册 */
+    pthread_mutex_t consume_lock;       /* 消费端互斥（排空线程、get_data、clear） */
+    cxl_obs_ring_t *rings[CXL_OBS_MAX_RINGS];
+    int num_rings;
+    pthread_t drain_thread;
+    int drain_running;
+    int drain_cpu;
+    obs_sink_t sink;
+    cxl_trace_writer_t *sink_trace;
+    int drain_started_by_monitor;
     pthread_t monitor_thread;
     int monitor_running;
-    void *monitor_target;
+    void **monitor_targets;
+    int monitor_num_targets;
+    int monitor_cpu;
+    int monitor_flush;
+    uint64_t monitor_period;            /* 节拍周期（cycles） */
     observation_callback_t monitor_callback;
     void *monitor_context;
-} observation_state = {0};
+    realtime_stats_t monitor_stats;     /* 采样线程定期发布 */
+    uint64_t monitor_elapsed;           /* 采样线程运行的 cycles */
+} observation_state = {
+    .ring_lock = PTHREAD_MUTEX_INITIALIZER,
+    .consume_lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static __thread cxl_obs_ring_t *thread_ring;
+static __thread unsigned int thread_ring_generation;
+
+/* 线程私有数据的析构函数在线程退出时退役缓冲区；值编码（代数，下标 + 1），重新初始化后旧值失效 */
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
 
 /* ====== 初始化与清理 ====== */
 int cxl_observation_init(observation_type_t observation_type, size_t buffer_size) {
@@ -31,20 +65,25 @@ int cxl_observation_init(observation_type_t observation_type, size_t buffer_size
         return -1;
     }
     
-    observation_state.type = observation_type;
-    observation_state.buffer = malloc(buffer_size);
+    if (observation_state.initialized) {
+        cxl_observation_cleanup();
+    }
     
-    if (!observation_state.buffer) {
-        fprintf(stderr, "[ERROR] Failed to allocate observation buffer\n");
-        return -1;
+    /* 槽位数取 2 的幂，读写位置只需掩码 */
+    size_t slots = CXL_OBS_RING_MIN_SLOTS;
+    while (slots * 2 * sizeof(observation_data_t) <= buffer_size) {
+        slots *= 2;
     }
     
-    observation_state.buffer_size = buffer_size;
-    observation_state.current_pos = 0;
-    observation_state.initialized = 1;
+    observation_state.type = observation_type;
+    observation_state.ring_slots = slots;
+    observation_state.num_rings = 0;
+    observation_state.generation++;
     observation_state.monitor_running = 0;
+    observation_state.drain_running = 0;
+    observation_state.initialized = 1;
     
-    fprintf(stdout, "[INFO] Observation module initialized\n");
+    fprintf(stdout, "[INFO] Observation module initialized (%zu samples per thread buffer)\n", slots);
     
     return 0;
 }
@@ -54,12 +93,23 @@ int cxl_observation_cleanup(void) {
         cxl_observe_realtime_stop();
     }
     
-    if (observation_state.buffer) {
-        free(observation_state.buffer);
-        observation_state.buffer = NULL;
+    if (__atomic_load_n(&observation_state.drain_running, __ATOMIC_ACQUIRE)) {
+        cxl_observation_drain_stop();
     }
     
+    pthread_mutex_lock(&observation_state.ring_lock);
+    for (int i = 0; i < observation_state.num_rings; i++) {
+        cxl_obs_ring_t *ring = observation_state.rings[i];
+        numa_free(ring, ring->alloc_size);
+        observation_state.rings[i] = NULL;
+    }
+    observation_state.num_rings = 0;
+    observation_state.generation++;
     observation_state.initialized = 0;
+    pthread_mutex_unlock(&observation_state.ring_lock);
+    
+    free(observation_state.monitor_targets);
+    observation_state.monitor_targets = NULL;
     
     fprintf(stdout, "[INFO] Observation module cleanup completed\n");
     
@@ -100,6 +150,39 @@ int cxl_observe_access_timing(void *addr, int num_samples, uint64_t *samples) {
     return num_samples;
 }
 
+int cxl_observe_access_timing_hist(void *addr, uint64_t num_samples, cxl_histogram_t *hist) {
+    if (!addr || !hist || num_samples == 0) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    if (!observation_state.initialized) {
+        fprintf(stderr, "[ERROR] Observation module not initialized\n");
+        return -1;
+    }
+    
+    volatile uint64_t *ptr = (volatile uint64_t *)addr;
+    
+    cxl_lfence();
+    
+    for (uint64_t i = 0; i < num_samples; i++) {
+        uint32_t cpu_id;
+        uint64_t start = cxl_rdtscp(&cpu_id);
+        
+        (void)(*ptr);
+        
+        uint64_t end = cxl_rdtscp(&cpu_id);
+        cxl_histogram_record(hist, end - start);
+        
+        /* 小延迟避免连续缓存命中 */
+        for (volatile int j = 0; j < 100; j++) {}
+    }
+    
+    cxl_lfence();
+    
+    return 0;
+}
+
 /* ====== 缓存模式观测 ====== */
 int cxl_observe_cache_pattern(void **addrs, int num_addrs, int num_probes, 
                               uint8_t *hit_patterns) {
@@ -113,10 +196,12 @@ int cxl_observe_cache_pattern(void **addrs, int num_addrs, int num_probes,
         return -1;
     }
     
-    uint64_t threshold = cxl_get_timing_threshold();
     int pattern_idx = 0;
     
     for (int addr_idx = 0; addr_idx < num_addrs; addr_idx++) {
+        /* 每个地址按其所在节点选择阈值 */
+        uint64_t threshold = cxl_get_addr_threshold(addrs[addr_idx], CXL_CACHE_LEVEL_LLC);
+        
         for (int probe = 0; probe < num_probes; probe++) {
             uint64_t access_time = cxl_probe_access_time(addrs[addr_idx], NULL);
             
@@ -133,19 +218,110 @@ int cxl_observe_cache_pattern(void **addrs, int num_addrs, int num_probes,
 }
 
 /* ====== 访问痕迹观测 ====== */
+int cxl_observe_access_samples(void *addr_range_start, size_t addr_range_size, uint32_t window_us,
+                               cxl_mem_sample_t *samples, int max_samples) {
+    if (!addr_range_start || addr_range_size == 0 || !samples || max_samples <= 0) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    cxl_mem_sampler_t sampler;
+    if (cxl_mem_sampler_open(&sampler, 0, 0, 0) < 0) {
+        return -1;
+    }
+    
+    uint64_t lo = (uint64_t)(uintptr_t)addr_range_start;
+    uint64_t hi = lo + addr_range_size;
+    uint32_t window = window_us ? window_us : CXL_OBS_TRACE_WINDOW_US;
+    int count = 0;
+    
+    /* 窗口内定期排空，避免每个事件的环形缓冲区写满丢样本 */
+    for (uint32_t elapsed = 0; elapsed < window && count < max_samples; ) {
+        uint32_t slice = (window - elapsed < CXL_OBS_TRACE_DRAIN_US) ? window - elapsed : CXL_OBS_TRACE_DRAIN_US;
+        usleep(slice);
+        elapsed += slice;
+        
+        count += cxl_mem_sampler_read(&sampler, lo, hi, samples + count, max_samples - count);
+    }
+    
+    if (sampler.lost > 0) {
+        fprintf(stderr, "[WARNING] %lu memory samples lost (ring buffer full)\n", sampler.lost);
+    }
+    cxl_mem_sampler_close(&sampler);
+    
+    /* 不报告 CXL 层级的 PMU 把 CXL 内存记为本地/远端内存，按地址所在节点改正 */
+    const cxl_topology_t *topo = cxl_topology_get();
+    for (int i = 0; topo && i < count; i++) {
+        if (samples[i].source != CXL_MEM_SRC_LOCAL_DRAM && samples[i].source != CXL_MEM_SRC_REMOTE) continue;
+        
+        int node = cxl_addr_to_node((const void *)(uintptr_t)samples[i].addr);
+        if (node >= 0 && node < CXL_TOPO_MAX_NODES && topo->nodes[node].present &&
+            topo->nodes[node].kind != TOPO_NODE_CPU) {
+            samples[i].source = CXL_MEM_SRC_CXL;
+        }
+    }
+    
+    return count;
+}
+
+/* 退回方案：一个空闲页跟踪间隔内被访问过的页 */
+static int observe_trace_idle_pages(void *addr_range_start, size_t addr_range_size,
+                                    int capacity, uint32_t *traces) {
+    page_profile_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.start = (uintptr_t)addr_range_start;
+    params.size = addr_range_size;
+    params.interval_us = CXL_PROF_DEFAULT_INTERVAL_US;
+    params.num_intervals = 1;
+    params.hot_fraction = 1.0;
+    
+    page_profile_t profile;
+    if (cxl_profile_pages(&params, &profile) < 0) {
+        return -1;
+    }
+    
+    int count = 0;
+    for (uint64_t i = 0; i < profile.num_pages && count < capacity; i++) {
+        if (cxl_profile_page_class(&profile, i) != PAGE_CLASS_HOT) continue;
+        
+        /* 区域起始地址可能不在页边界上，第一页的偏移记为 0 */
+        uintptr_t page_addr = profile.start + i * profile.page_size;
+        traces[count++] = (page_addr > params.start) ? (uint32_t)(page_addr - params.start) : 0;
+    }
+    cxl_profile_free(&profile);
+    
+    return count;
+}
+
 int cxl_observe_access_trace(void *addr_range_start, size_t addr_range_size,
                              int *num_traces, uint32_t *traces) {
-    if (!addr_range_start || addr_range_size == 0 || !traces) {
+    if (!addr_range_start || addr_range_size == 0 || addr_range_size > UINT32_MAX ||
+        !num_traces || *num_traces <= 0 || !traces) {
         fprintf(stderr, "[ERROR] Invalid parameters\n");
         return -1;
     }
     
-    /* 这是一个简化的实现 */
-    /* 实际的访问痕迹需要硬件支持（如 Intel PT 或类似机制） */
-    
+    int capacity = *num_traces;
+    int count = -1;
     *num_traces = 0;
     
-    return 0;
+    cxl_mem_sample_t *samples = malloc((size_t)capacity * sizeof(cxl_mem_sample_t));
+    if (samples) {
+        count = cxl_observe_access_samples(addr_range_start, addr_range_size, 0, samples, capacity);
+        for (int i = 0; i < count; i++) {
+            traces[i] = (uint32_t)(samples[i].addr - (uintptr_t)addr_range_start);
+        }
+        free(samples);
+    }
+    
+    if (count < 0) {
+        count = observe_trace_idle_pages(addr_range_start, addr_range_size, capacity, traces);
+        if (count < 0) return -1;
+    }
+    
+    *num_traces = count;
+    
+    return count;
 }
 
 /* ====== RDTSCP 样本采集 ====== */
@@ -160,13 +336,15 @@ int cxl_observe_rdtscp_samples(timing_sample_t *samples, int num_samples) {
         return -1;
     }
     
+    const cxl_tsc_info_t *tsc = cxl_tsc_get();
+    
     cxl_lfence();
     
     for (int i = 0; i < num_samples; i++) {
         uint32_t apic_id;
         samples[i].tsc = cxl_rdtscp(&apic_id);
         samples[i].apic_id = apic_id;
-        samples[i].timestamp = samples[i].tsc;  /* 简化，实际应转换为纳秒 */
+        samples[i].timestamp = cxl_tsc_to_ns(tsc, samples[i].tsc);
         
         /* 微小延迟 */
         for (volatile int j = 0; j < 10; j++) {}
@@ -286,8 +464,8 @@ int cxl_observe_cxl_latency(void *cxl_addr, void *normal_addr,
     }
     
     for (int i = 0; i < num_samples; i++) {
-        cxl_timings[i] = cxl_probe_access_time(cxl_addr, NULL);
-        normal_timings[i] = cxl_probe_access_time(normal_addr, NULL);
+        cxl_timings[i] = cxl_probe_access_time_corrected(cxl_addr);
+        normal_timings[i] = cxl_probe_access_time_corrected(normal_addr);
         
         /* 清除缓存以隔离测量 */
         cxl_flush_clflush(cxl_addr);
@@ -307,26 +485,13 @@ int cxl_observe_statistics(const uint64_t *samples, int num_samples,
         return -1;
     }
     
-    *min = samples[0];
-    *max = samples[0];
-    *mean = 0.0;
-    
-    /* 计算最小值、最大值和平均值 */
-    for (int i = 0; i < num_samples; i++) {
-        if (samples[i] < *min) *min = samples[i];
-        if (samples[i] > *max) *max = samples[i];
-        *mean += samples[i];
-    }
-    *mean /= num_samples;
-    
-    /* 计算标准差 */
-    double variance = 0.0;
-    for (int i = 0; i < num_samples; i++) {
-        double diff = samples[i] - *mean;
-        variance += diff * diff;
-    }
-    variance /= num_samples;
-    *stddev = sqrt(variance);
+    /* 单遍计算最小值、最大值、平均值和标准差 */
+    cxl_stats_t stats;
+    cxl_stats_compute(samples, (size_t)num_samples, &stats);
+    *min = stats.min;
+    *max = stats.max;
+    *mean = stats.mean;
+    *stddev = cxl_stats_stddev(&stats);
     
     return 0;
 }
@@ -362,54 +527,508 @@ int cxl_observe_detect_anomalies(const uint64_t *samples, int num_samples,
     return anomaly_count;
 }
 
+/* ====== 每线程环形缓冲区 ====== */
+static cxl_obs_ring_t *obs_ring_create(size_t slots) {
+    int cpu = sched_getcpu();
+    int node = (cpu >= 0) ? numa_node_of_cpu(cpu) : -1;
+    
+    /* 结构体与槽位放在同一块按页对齐的内存中，分配在生产者所在节点上 */
+    size_t header_size = (sizeof(cxl_obs_ring_t) + CXL_CACHE_LINE_SIZE - 1) & ~(size_t)(CXL_CACHE_LINE_SIZE - 1);
+    size_t alloc_size = header_size + slots * sizeof(observation_data_t);
+    void *mem = (node >= 0) ? numa_alloc_onnode(alloc_size, node) : numa_alloc_local(alloc_size);
+    
+    if (!mem) {
+        fprintf(stderr, "[ERROR] Failed to allocate observation ring (%zu bytes)\n", alloc_size);
+        return NULL;
+    }
+    
+    /* 由生产者线程预先触碰，避免采样路径上的缺页 */
+    memset(mem, 0, alloc_size);
+    
+    cxl_obs_ring_t *ring = (cxl_obs_ring_t *)mem;
+    ring->slots = (observation_data_t *)((uint8_t *)mem + header_size);
+    ring->mask = slots - 1;
+    ring->alloc_size = alloc_size;
+    ring->node = node;
+    ring->cpu = cpu;
+    
+    return ring;
+}
+
+static void obs_ring_thread_exit(void *value) {
+    uintptr_t key = (uintptr_t)value;
+    int index = (int)(key & 0xFFFF) - 1;
+    
+    pthread_mutex_lock(&observation_state.ring_lock);
+    if ((unsigned int)(key >> 16) == (observation_state.generation & 0xFFFF) &&
+        index >= 0 && index < observation_state.num_rings) {
+        __atomic_store_n(&observation_state.rings[index]->retired, 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&observation_state.ring_lock);
+}
+
+static void obs_ring_key_create(void) {
+    pthread_key_create(&ring_key, obs_ring_thread_exit);
+}
+
+/*
+ * 找一个可复用的缓冲区：生产者已退出且样本已被取走（head == tail）。生产者退出后 head 不再变化，
+ * 消费者也不会越过 head，因此不需要消费端锁。优先选同一节点上的缓冲区。调用者持有 ring_lock。
+ */
+static int obs_ring_reclaim(int node) {
+    int found = -1;
+    
+    for (int i = 0; i < observation_state.num_rings; i++) {
+        cxl_obs_ring_t *ring = observation_state.rings[i];
+        if (!__atomic_load_n(&ring->retired, __ATOMIC_ACQUIRE) ||
+            __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) != __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        
+        if (ring->node == node) return i;
+        if (found < 0) found = i;
+    }
+    
+    return found;
+}
+
+cxl_obs_ring_t *cxl_observation_thread_ring(void) {
+    if (thread_ring && thread_ring_generation == observation_state.generation) {
+        return thread_ring;
+    }
+    
+    pthread_once(&ring_key_once, obs_ring_key_create);
+    
+    pthread_mutex_lock(&observation_state.ring_lock);
+    
+    if (!observation_state.initialized) {
+        pthread_mutex_unlock(&observation_state.ring_lock);
+        fprintf(stderr, "[ERROR] Observation module not initialized\n");
+        return NULL;
+    }
+    
+    int cpu = sched_getcpu();
+    int node = (cpu >= 0) ? numa_node_of_cpu(cpu) : -1;
+    int index = obs_ring_reclaim(node);
+    cxl_obs_ring_t *ring = NULL;
+    
+    if (index >= 0) {
+        /* 读写位置保持不变，统计中的写入/取走数仍然单调 */
+        ring = observation_state.rings[index];
+        ring->cpu = cpu;
+        __atomic_store_n(&ring->retired, 0, __ATOMIC_RELEASE);
+    } else if (observation_state.num_rings >= CXL_OBS_MAX_RINGS) {
+        pthread_mutex_unlock(&observation_state.ring_lock);
+        fprintf(stderr, "[ERROR] Too many observation threads (max %d)\n", CXL_OBS_MAX_RINGS);
+        return NULL;
+    } else {
+        ring = obs_ring_create(observation_state.ring_slots);
+        if (ring) {
+            index = observation_state.num_rings;
+            observation_state.rings[index] = ring;
+            /* 先写入指针再发布数量，排空线程无锁遍历 */
+            __atomic_store_n(&observation_state.num_rings, index + 1, __ATOMIC_RELEASE);
+        }
+    }
+    
+    if (ring) {
+        thread_ring = ring;
+        thread_ring_generation = observation_state.generation;
+        pthread_setspecific(ring_key, (void *)(((uintptr_t)(observation_state.generation & 0xFFFF) << 16) |
+                                               (uintptr_t)(index + 1)));
+    }
+    
+    pthread_mutex_unlock(&observation_state.ring_lock);
+    
+    return ring;
+}
+
+int cxl_observation_record(const observation_data_t *data) {
+    cxl_obs_ring_t *ring = cxl_observation_thread_ring();
+    if (!ring || !data) {
+        return -1;
+    }
+    
+    return cxl_obs_ring_push(ring, data);
+}
+
+int cxl_observation_num_rings(void) {
+    return __atomic_load_n(&observation_state.num_rings, __ATOMIC_ACQUIRE);
+}
+
+/* 消费端：返回从 tail 开始到回绕处为止的连续样本数 */
+static size_t obs_ring_readable(const cxl_obs_ring_t *ring) {
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t available = head - ring->tail;
+    uint64_t to_end = ring->mask + 1 - (ring->tail & ring->mask);
+    
+    return (size_t)((available < to_end) ? available : to_end);
+}
+
+static void obs_ring_consume(cxl_obs_ring_t *ring, size_t count) {
+    __atomic_store_n(&ring->tail, ring->tail + count, __ATOMIC_RELEASE);
+}
+
+/* ====== 排空线程 ====== */
+#define OBS_SINK_TRACE_BATCH    1024
+
+/* 取出 access_time 分批追加到样本文件 */
+static void obs_sink_write_trace(const observation_data_t *data, size_t count) {
+    uint64_t batch[OBS_SINK_TRACE_BATCH];
+    
+    for (size_t done = 0; done < count; ) {
+        size_t n = count - done;
+        if (n > OBS_SINK_TRACE_BATCH) n = OBS_SINK_TRACE_BATCH;
+        
+        for (size_t i = 0; i < n; i++) {
+            batch[i] = data[done + i].access_time;
+        }
+        if (cxl_trace_writer_append(observation_state.sink_trace, batch, n) < 0) {
+            fprintf(stderr, "[ERROR] Failed to write observation data\n");
+            return;
+        }
+        
+        done += n;
+    }
+}
+
+static void obs_sink_deliver(const observation_data_t *data, size_t count) {
+    switch (observation_state.sink.type) {
+        case OBS_SINK_FILE:
+            obs_sink_write_trace(data, count);
+            break;
+        case OBS_SINK_HISTOGRAM:
+            for (size_t i = 0; i < count; i++) {
+                cxl_histogram_record(observation_state.sink.hist, data[i].access_time);
+            }
+            break;
+        case OBS_SINK_CALLBACK:
+            observation_state.sink.callback(data, count, observation_state.sink.ctx);
+            break;
+    }
+}
+
+static size_t obs_drain_all(void) {
+    size_t drained = 0;
+    int num_rings = cxl_observation_num_rings();
+    
+    pthread_mutex_lock(&observation_state.consume_lock);
+    
+    for (int i = 0; i < num_rings; i++) {
+        cxl_obs_ring_t *ring = observation_state.rings[i];
+        size_t count;
+        
+        /* 最多两段：回绕前和回绕后 */
+        while ((count = obs_ring_readable(ring)) > 0) {
+            obs_sink_deliver(&ring->slots[ring->tail & ring->mask], count);
+            obs_ring_consume(ring, count);
+            drained += count;
+        }
+    }
+    
+    pthread_mutex_unlock(&observation_state.consume_lock);
+    
+    return drained;
+}
+
+static void *observation_drain_thread(void *arg) {
+    (void)arg;
+    
+    if (observation_state.drain_cpu >= 0) {
+        cxl_bind_to_cpu(observation_state.drain_cpu);
+    }
+    
+    while (__atomic_load_n(&observation_state.drain_running, __ATOMIC_ACQUIRE)) {
+        if (obs_drain_all() == 0) {
+            usleep(CXL_OBS_DRAIN_INTERVAL_US);
+        }
+    }
+    
+    /* 停止前取走剩余样本 */
+    obs_drain_all();
+    
+    return NULL;
+}
+
+int cxl_observation_drain_start(const obs_sink_t *sink, int cpu) {
+    if (!sink ||
+        (sink->type == OBS_SINK_FILE && !sink->path) ||
+        (sink->type == OBS_SINK_HISTOGRAM && !sink->hist) ||
+        (sink->type == OBS_SINK_CALLBACK && !sink->callback)) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    if (!observation_state.initialized) {
+        fprintf(stderr, "[ERROR] Observation module not initialized\n");
+        return -1;
+    }
+    
+    if (__atomic_load_n(&observation_state.drain_running, __ATOMIC_ACQUIRE)) {
+        fprintf(stderr, "[WARNING] Observation drain thread already running\n");
+        return -1;
+    }
+    
+    observation_state.sink = *sink;
+    observation_state.sink_trace = NULL;
+    observation_state.drain_cpu = cpu;
+    
+    if (sink->type == OBS_SINK_FILE) {
+        observation_state.sink_trace = cxl_trace_writer_open(sink->path, "access_time", NULL, cxl_tsc_hz());
+        if (!observation_state.sink_trace) {
+            return -1;
+        }
+    }
+    
+    __atomic_store_n(&observation_state.drain_running, 1, __ATOMIC_RELEASE);
+    
+    if (pthread_create(&observation_state.drain_thread, NULL, observation_drain_thread, NULL) != 0) {
+        fprintf(stderr, "[ERROR] Failed to create drain thread\n");
+        __atomic_store_n(&observation_state.drain_running, 0, __ATOMIC_RELEASE);
+        if (observation_state.sink_trace) {
+            cxl_trace_writer_close(observation_state.sink_trace);
+            observation_state.sink_trace = NULL;
+        }
+        return -1;
+    }
+    
+    return 0;
+}
+
+int cxl_observation_drain_stop(void) {
+    if (!__atomic_load_n(&observation_state.drain_running, __ATOMIC_ACQUIRE)) {
+        return -1;
+    }
+    
+    __atomic_store_n(&observation_state.drain_running, 0, __ATOMIC_RELEASE);
+    pthread_join(observation_state.drain_thread, NULL);
+    
+    int ret = 0;
+    if (observation_state.sink_trace) {
+        ret = cxl_trace_writer_close(observation_state.sink_trace);
+        observation_state.sink_trace = NULL;
+    }
+    
+    return ret;
+}
+
 /* ====== 实时观测线程 ====== */
+static inline void obs_pause(void) {
+    asm volatile("pause" ::: "memory");
+}
+
+static void obs_monitor_publish(uint64_t samples, uint64_t dropped, uint64_t missed,
+                                uint64_t max_lateness, uint64_t elapsed) {
+    realtime_stats_t *stats = &observation_state.monitor_stats;
+    
+    __atomic_store_n(&stats->samples, samples, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->dropped, dropped, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->missed_deadlines, missed, __ATOMIC_RELAXED);
+    __atomic_store_n(&stats->max_lateness, max_lateness, __ATOMIC_RELAXED);
+    __atomic_store_n(&observation_state.monitor_elapsed, elapsed, __ATOMIC_RELAXED);
+}
+
+static void obs_monitor_callback_adapter(const observation_data_t *data, size_t count, void *ctx) {
+    (void)ctx;
+    
+    for (size_t i = 0; i < count; i++) {
+        observation_state.monitor_callback(&data[i], observation_state.monitor_context);
+    }
+}
+
 static void *observation_monitor_thread(void *arg) {
-    while (observation_state.monitor_running) {
-        observation_data_t data;
+    (void)arg;
+    
+    if (observation_state.monitor_cpu >= 0) {
+        cxl_bind_to_cpu(observation_state.monitor_cpu);
+    }
+    
+    /* 绑核之后再注册，缓冲区分配在采样核所在的节点上 */
+    cxl_obs_ring_t *ring = cxl_observation_thread_ring();
+    if (!ring) {
+        return NULL;
+    }
+    
+    void **targets = observation_state.monitor_targets;
+    int num_targets = observation_state.monitor_num_targets;
+    int flush = observation_state.monitor_flush;
+    uint64_t period = observation_state.monitor_period;
+    
+    /* 采样循环之前解析每个目标所在节点的阈值，循环内不再查询 */
+    uint64_t thresholds[CXL_OBS_REALTIME_MAX_TARGETS];
+    for (int i = 0; i < num_targets; i++) {
+        thresholds[i] = cxl_get_addr_threshold(targets[i], CXL_CACHE_LEVEL_LLC);
+    }
+    
+    uint64_t samples = 0, dropped = 0, missed = 0, max_lateness = 0;
+    uint64_t start = cxl_rdtscp(NULL);
+    uint64_t deadline = start;
+    int target_idx = 0;
+    
+    while (__atomic_load_n(&observation_state.monitor_running, __ATOMIC_ACQUIRE)) {
+        uint32_t cpu_id;
+        uint64_t now;
+        
+        /* 忙等到截止时间 */
+        while ((now = cxl_rdtscp(&cpu_id)) < deadline) {
+            obs_pause();
+        }
+        
+        /* 落后超过一个周期时跳过错过的节拍，保持平均采样率而不是补采 */
+        uint64_t lateness = now - deadline;
+        if (lateness > max_lateness) max_lateness = lateness;
+        if (lateness >= period) {
+            uint64_t skipped = lateness / period;
+            missed += skipped;
+            deadline += skipped * period;
+        }
+        deadline += period;
         
-        data.sample_id++;
-        data.timestamp = cxl_rdtscp(&data.cpu_id);
-        data.access_time = cxl_probe_access_time(observation_state.monitor_target, NULL);
-        data.address = (uint64_t)observation_state.monitor_target;
+        void *target = targets[target_idx];
+        uint64_t threshold = thresholds[target_idx];
+        if (++target_idx == num_targets) target_idx = 0;
         
-        uint64_t threshold = cxl_get_timing_threshold();
+        observation_data_t data;
+        data.sample_id = samples++;
+        data.timestamp = now;
+        data.cpu_id = cpu_id;
+        data.access_time = cxl_probe_access_time(target, NULL);
+        data.address = (uint64_t)target;
         data.is_hit = (data.access_time < threshold) ? 1 : 0;
         
-        if (observation_state.monitor_callback) {
-            observation_state.monitor_callback(&data, observation_state.monitor_context);
+        if (flush) {
+            cxl_flush_clflush(target);
         }
         
-        usleep(1000);  /* 每 1ms 采样一次 */
+        /* 回调和 I/O 由排空线程完成，采样线程只写缓冲区 */
+        if (cxl_obs_ring_push(ring, &data) < 0) {
+            dropped++;
+        }
+        
+        if ((samples & 0xFFF) == 0) {
+            obs_monitor_publish(samples, dropped, missed, max_lateness, now - start);
+        }
     }
     
+    obs_monitor_publish(samples, dropped, missed, max_lateness, cxl_rdtscp(NULL) - start);
+    
     return NULL;
 }
 
-int cxl_observe_realtime_start(void *target_addr, observation_type_t observation_type,
-                               observation_callback_t callback, void *ctx) {
-    if (!target_addr || !callback) {
+int cxl_observe_realtime_start_ex(const realtime_params_t *params,
+                                  observation_callback_t callback, void *ctx) {
+    if (!params || !params->targets || params->num_targets <= 0 ||
+        params->num_targets > CXL_OBS_REALTIME_MAX_TARGETS ||
+        params->rate_hz == 0 || params->rate_hz > CXL_OBS_REALTIME_MAX_RATE) {
         fprintf(stderr, "[ERROR] Invalid parameters\n");
         return -1;
     }
     
+    for (int i = 0; i < params->num_targets; i++) {
+        if (!params->targets[i]) {
+            fprintf(stderr, "[ERROR] Invalid target address %d\n", i);
+            return -1;
+        }
+    }
+    
+    if (!observation_state.initialized) {
+        fprintf(stderr, "[ERROR] Observation module not initialized\n");
+        return -1;
+    }
+    
     if (observation_state.monitor_running) {
         fprintf(stderr, "[WARNING] Realtime monitor already running\n");
         return -1;
     }
     
-    observation_state.monitor_target = target_addr;
+    /* 复制目标列表，调用者的数组可以在启动后释放 */
+    void **targets = malloc(params->num_targets * sizeof(void *));
+    if (!targets) {
+        fprintf(stderr, "[ERROR] Failed to allocate target list\n");
+        return -1;
+    }
+    memcpy(targets, params->targets, params->num_targets * sizeof(void *));
+    
+    uint64_t period = cxl_tsc_hz() / params->rate_hz;
+    
+    free(observation_state.monitor_targets);
+    observation_state.monitor_targets = targets;
+    observation_state.monitor_num_targets = params->num_targets;
+    observation_state.monitor_cpu = params->cpu;
+    observation_state.monitor_flush = params->flush_after_probe;
+    observation_state.monitor_period = (period > 0) ? period : 1;
     observation_state.monitor_callback = callback;
     observation_state.monitor_context = ctx;
-    observation_state.monitor_running = 1;
+    observation_state.drain_started_by_monitor = 0;
+    memset(&observation_state.monitor_stats, 0, sizeof(realtime_stats_t));
+    observation_state.monitor_stats.period_cycles = observation_state.monitor_period;
+    observation_state.monitor_elapsed = 0;
+    
+    if (callback && !__atomic_load_n(&observation_state.drain_running, __ATOMIC_ACQUIRE)) {
+        obs_sink_t sink = {
+            .type = OBS_SINK_CALLBACK,
+            .callback = obs_monitor_callback_adapter,
+        };
+        if (cxl_observation_drain_start(&sink, -1) < 0) {
+            return -1;
+        }
+        observation_state.drain_started_by_monitor = 1;
+    }
+    
+    __atomic_store_n(&observation_state.monitor_running, 1, __ATOMIC_RELEASE);
     
     if (pthread_create(&observation_state.monitor_thread, NULL, 
-                      observation_monitor_thread, NULL) < 0) {
+                      observation_monitor_thread, NULL) != 0) {
         fprintf(stderr, "[ERROR] Failed to create monitor thread\n");
         observation_state.monitor_running = 0;
+        if (observation_state.drain_started_by_monitor) {
+            cxl_observation_drain_stop();
+        }
         return -1;
     }
     
-    fprintf(stdout, "[INFO] Realtime observation started\n");
+    fprintf(stdout, "[INFO] Realtime observation started (%lu Hz, %d targets, CPU %d)\n",
+            params->rate_hz, params->num_targets, params->cpu);
+    
+    return 0;
+}
+
+int cxl_observe_realtime_start(void *target_addr, observation_type_t observation_type,
+                               observation_callback_t callback, void *ctx) {
+    (void)observation_type;
+    
+    if (!target_addr || !callback) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    realtime_params_t params = {
+        .targets = &target_addr,
+        .num_targets = 1,
+        .rate_hz = CXL_OBS_REALTIME_DEFAULT_RATE,
+        .cpu = -1,
+        .flush_after_probe = 0,
+    };
+    
+    return cxl_observe_realtime_start_ex(&params, callback, ctx);
+}
+
+int cxl_observe_realtime_get_stats(realtime_stats_t *stats) {
+    if (!stats) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    const realtime_stats_t *src = &observation_state.monitor_stats;
+    
+    stats->samples = __atomic_load_n(&src->samples, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&src->dropped, __ATOMIC_RELAXED);
+    stats->missed_deadlines = __atomic_load_n(&src->missed_deadlines, __ATOMIC_RELAXED);
+    stats->max_lateness = __atomic_load_n(&src->max_lateness, __ATOMIC_RELAXED);
+    stats->period_cycles = src->period_cycles;
+    
+    uint64_t elapsed = __atomic_load_n(&observation_state.monitor_elapsed, __ATOMIC_RELAXED);
+    stats->achieved_rate_hz = (elapsed > 0) ? (double)stats->samples * cxl_tsc_hz() / elapsed : 0.0;
     
     return 0;
 }
@@ -419,22 +1038,103 @@ int cxl_observe_realtime_stop(void) {
         return -1;
     }
     
-    observation_state.monitor_running = 0;
+    __atomic_store_n(&observation_state.monitor_running, 0, __ATOMIC_RELEASE);
     pthread_join(observation_state.monitor_thread, NULL);
     
-    fprintf(stdout, "[INFO] Realtime observation stopped\n");
+    if (observation_state.drain_started_by_monitor) {
+        cxl_observation_drain_stop();
+        observation_state.drain_started_by_monitor = 0;
+    }
+    
+    realtime_stats_t stats;
+    cxl_observe_realtime_get_stats(&stats);
+    fprintf(stdout, "[INFO] Realtime observation stopped: %lu samples (%.0f Hz), %lu dropped, %lu missed deadlines\n",
+            stats.samples, stats.achieved_rate_hz, stats.dropped, stats.missed_deadlines);
     
     return 0;
 }
 
 /* ====== 缓冲区管理 ====== */
+int cxl_observation_peek(int ring_id, const observation_data_t **data, size_t *count) {
+    if (!data || !count || ring_id < 0 || ring_id >= cxl_observation_num_rings()) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    if (__atomic_load_n(&observation_state.drain_running, __ATOMIC_ACQUIRE)) {
+        fprintf(stderr, "[ERROR] Observation buffers are owned by the drain thread\n");
+        return -1;
+    }
+    
+    cxl_obs_ring_t *ring = observation_state.rings[ring_id];
+    
+    pthread_mutex_lock(&observation_state.consume_lock);
+    *count = obs_ring_readable(ring);
+    *data = &ring->slots[ring->tail & ring->mask];
+    pthread_mutex_unlock(&observation_state.consume_lock);
+    
+    return 0;
+}
+
+int cxl_observation_release(int ring_id, size_t count) {
+    if (ring_id < 0 || ring_id >= cxl_observation_num_rings()) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    cxl_obs_ring_t *ring = observation_state.rings[ring_id];
+    int ret = -1;
+    
+    /* 与排空线程、get_data、clear 共用消费端锁；排空线程运行时缓冲区归它所有，peek 拿到的样本可能已被取走 */
+    pthread_mutex_lock(&observation_state.consume_lock);
+    
+    if (__atomic_load_n(&observation_state.drain_running, __ATOMIC_ACQUIRE)) {
+        fprintf(stderr, "[ERROR] Observation buffers are owned by the drain thread\n");
+    } else if (count > obs_ring_readable(ring)) {
+        fprintf(stderr, "[ERROR] Releasing more samples than available\n");
+    } else {
+        obs_ring_consume(ring, count);
+        ret = 0;
+    }
+    
+    pthread_mutex_unlock(&observation_state.consume_lock);
+    
+    return ret;
+}
+
+int cxl_observation_get_stats(obs_buffer_stats_t *stats) {
+    if (!stats) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    memset(stats, 0, sizeof(obs_buffer_stats_t));
+    stats->num_rings = cxl_observation_num_rings();
+    
+    for (int i = 0; i < stats->num_rings; i++) {
+        const cxl_obs_ring_t *ring = observation_state.rings[i];
+        stats->produced += __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        stats->consumed += __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        stats->dropped += __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    }
+    
+    return 0;
+}
+
 int cxl_observation_clear_buffer(void) {
     if (!observation_state.initialized) {
         return -1;
     }
     
-    memset(observation_state.buffer, 0, observation_state.buffer_size);
-    observation_state.current_pos = 0;
+    int num_rings = cxl_observation_num_rings();
+    
+    pthread_mutex_lock(&observation_state.consume_lock);
+    for (int i = 0; i < num_rings; i++) {
+        cxl_obs_ring_t *ring = observation_state.rings[i];
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        obs_ring_consume(ring, head - ring->tail);
+    }
+    pthread_mutex_unlock(&observation_state.consume_lock);
     
     return 0;
 }
@@ -445,10 +1145,26 @@ int cxl_observation_get_data(void *buffer, size_t buffer_size) {
         return -1;
     }
     
-    size_t copy_size = (buffer_size < observation_state.current_pos) ? 
-                       buffer_size : observation_state.current_pos;
+    observation_data_t *out = (observation_data_t *)buffer;
+    size_t capacity = buffer_size / sizeof(observation_data_t);
+    size_t copied = 0;
+    int num_rings = cxl_observation_num_rings();
+    
+    pthread_mutex_lock(&observation_state.consume_lock);
+    
+    for (int i = 0; i < num_rings && copied < capacity; i++) {
+        cxl_obs_ring_t *ring = observation_state.rings[i];
+        size_t count;
+        
+        while (copied < capacity && (count = obs_ring_readable(ring)) > 0) {
+            if (count > capacity - copied) count = capacity - copied;
+            memcpy(out + copied, &ring->slots[ring->tail & ring->mask], count * sizeof(observation_data_t));
+            obs_ring_consume(ring, count);
+            copied += count;
+        }
+    }
     
-    memcpy(buffer, observation_state.buffer, copy_size);
+    pthread_mutex_unlock(&observation_state.consume_lock);
     
-    return copy_size;
+    return (int)(copied * sizeof(observation_data_t));
 }
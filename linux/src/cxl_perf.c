@@ -0,0 +1,686 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "cxl_perf.h"
+#include "cxl_common.h"
+
+/* Intel MEM_LOAD_L3_MISS_RETIRED.REMOTE_DRAM（Skylake-SP 起，event 0xD3 umask 0x02） */
+#define PERF_INTEL_REMOTE_DRAM      0x02D3
+
+static const char *perf_event_names[CXL_PERF_NUM_EVENTS] = {
+    [CXL_PERF_CYCLES]       = "cycles",
+    [CXL_PERF_INSTRUCTIONS] = "instructions",
+    [CXL_PERF_LLC_MISSES]   = "LLC-load-misses",
+    [CXL_PERF_DTLB_MISSES]  = "dTLB-load-misses",
+    [CXL_PERF_REMOTE_LOADS] = "remote-dram-loads",
+};
+
+static const char *mem_source_names[CXL_MEM_SRC_COUNT] = {
+    [CXL_MEM_SRC_UNKNOWN]    = "unknown",
+    [CXL_MEM_SRC_L1]         = "L1",
+    [CXL_MEM_SRC_L2]         = "L2",
+    [CXL_MEM_SRC_LLC]        = "LLC",
+    [CXL_MEM_SRC_LOCAL_DRAM] = "local-dram",
+    [CXL_MEM_SRC_REMOTE]     = "remote",
+    [CXL_MEM_SRC_CXL]        = "cxl",
+};
+
+static int perf_warned = 0;
+static int mem_sampler_warned = 0;
+
+/* ====== 辅助函数 ====== */
+static long perf_event_open(struct perf_event_attr *attr, pid_t pid, int cpu, int group_fd,
+                            unsigned long flags) {
+    return syscall(__NR_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+
+static int perf_is_intel(void) {
+    uint32_t eax, ebx, ecx, edx;
+    
+    cxl_cpuid(0, 0, &eax, &ebx, &ecx, &edx);
+    
+    /* "GenuineIntel" */
+    return ebx == 0x756e6547 && edx == 0x49656e69 && ecx == 0x6c65746e;
+}
+
+/* 填写事件属性，事件在本机不存在时返回 -1 */
+static int perf_event_attr(cxl_perf_event_t event, struct perf_event_attr *attr) {
+    memset(attr, 0, sizeof(struct perf_event_attr));
+    attr->size = sizeof(struct perf_event_attr);
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+    
+    switch (event) {
+        case CXL_PERF_CYCLES:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_CPU_CYCLES;
+            return 0;
+        case CXL_PERF_INSTRUCTIONS:
+            attr->type = PERF_TYPE_HARDWARE;
+            attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+            return 0;
+        case CXL_PERF_LLC_MISSES:
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            return 0;
+        case CXL_PERF_DTLB_MISSES:
+            attr->type = PERF_TYPE_HW_CACHE;
+            attr->config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            return 0;
+        case CXL_PERF_REMOTE_LOADS:
+            /* 没有通用事件，只在 Intel 上使用原始编码 */
+            if (!perf_is_intel()) return -1;
+            attr->type = PERF_TYPE_RAW;
+            attr->config = PERF_INTEL_REMOTE_DRAM;
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+static void perf_warn_once(int err) {
+    if (__atomic_exchange_n(&perf_warned, 1, __ATOMIC_RELAXED)) return;
+    
+    if (err == EACCES || err == EPERM) {
+        fprintf(stderr, "[WARNING] Hardware counters not permitted (check /proc/sys/kernel/perf_event_paranoid), "
+                "continuing without them\n");
+    } else {
+        fprintf(stderr, "[WARNING] Hardware counters unavailable (%s), continuing without them\n", strerror(err));
+    }
+}
+
+/* ====== 打开与关闭 ====== */
+int cxl_perf_open(cxl_perf_t *perf) {
+    if (!perf) return 0;
+    
+    memset(perf, 0, sizeof(cxl_perf_t));
+    for (int e = 0; e < CXL_PERF_NUM_EVENTS; e++) {
+        perf->fds[e] = -1;
+    }
+    
+    long page_size = sysconf(_SC_PAGESIZE);
+    int opened = 0;
+    
+    for (int e = 0; e < CXL_PERF_NUM_EVENTS; e++) {
+        struct perf_event_attr attr;
+        if (perf_event_attr((cxl_perf_event_t)e, &attr) < 0) continue;
+        
+        /* 组长是 cycles；组内事件必须能同时调度，放不下的成员在打开时即失败 */
+        int leader = perf->fds[CXL_PERF_CYCLES];
+        int fd = (int)perf_event_open(&attr, 0, -1, leader, 0);
+        if (fd < 0) {
+            if (e == CXL_PERF_CYCLES) {
+                perf_warn_once(errno);
+                return 0;
+            }
+            continue;
+        }
+        
+        perf->fds[e] = fd;
+        perf->valid |= 1u << e;
+        opened++;
+        
+        void *page = mmap(NULL, (size_t)page_size, PROT_READ, MAP_SHARED, fd, 0);
+        perf->pages[e] = (page == MAP_FAILED) ? NULL : page;
+    }
+    
+    return opened;
+}
+
+void cxl_perf_close(cxl_perf_t *perf) {
+    if (!perf) return;
+    
+    long page_size = sysconf(_SC_PAGESIZE);
+    
+    /* 先关闭成员再关闭组长；按 valid 判断，全零（从未打开）的结构不会误关 fd 0 */
+    for (int e = CXL_PERF_NUM_EVENTS - 1; e >= 0; e--) {
+        if (perf->pages[e]) {
+            munmap(perf->pages[e], (size_t)page_size);
+            perf->pages[e] = NULL;
+        }
+        if ((perf->valid & (1u << e)) && perf->fds[e] >= 0) {
+            close(perf->fds[e]);
+            perf->fds[e] = -1;
+        }
+    }
+    perf->valid = 0;
+}
+
+/* ====== 读取 ====== */
+static inline uint64_t perf_rdpmc(uint32_t counter) {
+    uint32_t lo, hi;
+    
+    asm volatile("rdpmc" : "=a" (lo), "=d" (hi) : "c" (counter));
+    
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* 按内核文档的 seqlock 协议读取计数器页；计数器未调度或不允许 rdpmc 时返回 -1 */
+static int perf_read_mmap(const struct perf_event_mmap_page *pc, uint64_t *value) {
+    uint32_t seq, index;
+    uint64_t count;
+    
+    do {
+        seq = pc->lock;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        
+        index = pc->index;
+        if (!pc->cap_user_rdpmc || index == 0) return -1;
+        
+        /* 硬件计数器只有 pmc_width 位，符号扩展后与内核维护的偏移相加 */
+        int shift = 64 - pc->pmc_width;
+        int64_t pmc = (int64_t)(perf_rdpmc(index - 1) << shift) >> shift;
+        count = pc->offset + (uint64_t)pmc;
+        
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    } while (pc->lock != seq);
+    
+    *value = count;
+    return 0;
+}
+
+void cxl_perf_read(const cxl_perf_t *perf, cxl_perf_counts_t *counts) {
+    if (!counts) return;
+    
+    memset(counts, 0, sizeof(cxl_perf_counts_t));
+    if (!perf) return;
+    
+    for (int e = 0; e < CXL_PERF_NUM_EVENTS; e++) {
+        if (!(perf->valid & (1u << e))) continue;
+        
+        uint64_t value;
+        if (perf->pages[e] && perf_read_mmap(perf->pages[e], &value) == 0) {
+            counts->value[e] = value;
+        } else if (read(perf->fds[e], &value, sizeof(value)) == (ssize_t)sizeof(value)) {
+            counts->value[e] = value;
+        } else {
+            continue;
+        }
+        counts->valid |= 1u << e;
+    }
+}
+
+/* ====== 增量与累加 ====== */
+void cxl_perf_diff(const cxl_perf_counts_t *end, const cxl_perf_counts_t *start,
+                   cxl_perf_counts_t *delta) {
+    if (!end || !start || !delta) return;
+    
+    cxl_perf_counts_t d = {0};
+    d.valid = end->valid & start->valid;
+    for (int e = 0; e < CXL_PERF_NUM_EVENTS; e++) {
+        if (d.valid & (1u << e)) {
+            d.value[e] = end->value[e] - start->value[e];
+        }
+    }
+    *delta = d;
+}
+
+void cxl_perf_accumulate(cxl_perf_counts_t *total, const cxl_perf_counts_t *delta) {
+    if (!total || !delta || delta->valid == 0) return;
+    
+    /* 空累加器采用第一个增量的有效位，之后只保留所有增量都有的事件 */
+    total->valid = total->valid ? (total->valid & delta->valid) : delta->valid;
+    for (int e = 0; e < CXL_PERF_NUM_EVENTS; e++) {
+        total->value[e] = (total->valid & (1u << e)) ? total->value[e] + delta->value[e] : 0;
+    }
+}
+
+/* ====== 输出 ====== */
+const char *cxl_perf_event_name(cxl_perf_event_t event) {
+    if ((int)event < 0 || event >= CXL_PERF_NUM_EVENTS) return "unknown";
+    return perf_event_names[event];
+}
+
+void cxl_perf_print(const cxl_perf_counts_t *counts, const char *label, uint64_t num_ops) {
+    if (!counts) return;
+    
+    fprintf(stdout, "%s:\n", label ? label : "Hardware Counters");
+    if (counts->valid == 0) {
+        fprintf(stdout, "  unavailable\n");
+        return;
+    }
+    
+    for (int e = 0; e < CXL_PERF_NUM_EVENTS; e++) {
+        if (!(counts->valid & (1u << e))) continue;
+        
+        fprintf(stdout, "  %-18s %14lu", perf_event_names[e], counts->value[e]);
+        if (num_ops > 0) {
+            fprintf(stdout, "  (%.3f per op)", (double)counts->value[e] / (double)num_ops);
+        }
+        fprintf(stdout, "\n");
+    }
+    
+    uint32_t ipc_mask = (1u << CXL_PERF_CYCLES) | (1u << CXL_PERF_INSTRUCTIONS);
+    if ((counts->valid & ipc_mask) == ipc_mask && counts->value[CXL_PERF_CYCLES] > 0) {
+        fprintf(stdout, "  %-18s %14.3f\n", "IPC",
+               (double)counts->value[CXL_PERF_INSTRUCTIONS] / (double)counts->value[CXL_PERF_CYCLES]);
+    }
+}
+
+void cxl_perf_csv_header(FILE *file, const char *prefix) {
+    if (!file) return;
+    
+    for (int e = 0; e < CXL_PERF_NUM_EVENTS; e++) {
+        fprintf(file, ",%s%s", prefix ? prefix : "", perf_event_names[e]);
+    }
+}
+
+void cxl_perf_csv_row(FILE *file, const cxl_perf_counts_t *counts) {
+    if (!file) return;
+    
+    for (int e = 0; e < CXL_PERF_NUM_EVENTS; e++) {
+        if (counts && (counts->valid & (1u << e))) {
+            fprintf(file, ",%lu", counts->value[e]);
+        } else {
+            fprintf(file, ",");
+        }
+    }
+}
+
+/* ====== 内存加载采样 ====== */
+#ifndef PERF_MEM_LVLNUM_CXL
+#define PERF_MEM_LVLNUM_CXL         0x09
+#endif
+
+#define PERF_PMU_ROOT               "/sys/bus/event_source/devices"
+
+/* 样本记录布局（PERF_SAMPLE_TID | ADDR | WEIGHT | DATA_SRC，按位序排列） */
+typedef struct {
+    struct perf_event_header header;
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t addr;
+    uint64_t weight;
+    uint64_t data_src;
+} mem_sample_record_t;
+
+/* "event=0xcd,umask=0x1,ldlat=3" 中的字段值，不存在时返回 -1 */
+static long perf_event_field(const char *spec, const char *name) {
+    size_t len = strlen(name);
+    const char *p = spec;
+    
+    while (p) {
+        if (strncmp(p, name, len) == 0 && p[len] == '=') {
+            return strtol(p + len + 1, NULL, 0);
+        }
+        p = strchr(p, ',');
+        if (p) p++;
+    }
+    
+    return -1;
+}
+
+/*
+ * Intel 的 mem-loads 事件（混合架构在 cpu_core 上），其次是 AMD IBS op；system_wide 返回是否需要按 CPU 打开。
+ * Sapphire Rapids 起（以及混合架构的 cpu_core）mem-loads 必须以 mem-loads-aux 为组长，否则返回 ENODATA；
+ * 该 PMU 提供 mem-loads-aux 时填入 aux（只计数不采样），否则 aux->size 为 0。
+ */
+static int perf_mem_event_attr(struct perf_event_attr *attr, struct perf_event_attr *aux, uint64_t period,
+                               uint32_t ldlat, int *system_wide) {
+    static const char *pmus[] = {"cpu", "cpu_core"};
+    char path[256], buf[128];
+    
+    memset(aux, 0, sizeof(struct perf_event_attr));
+    memset(attr, 0, sizeof(struct perf_event_attr));
+    attr->size = sizeof(struct perf_event_attr);
+    attr->sample_period = period;
+    attr->sample_type = PERF_SAMPLE_TID | PERF_SAMPLE_ADDR | PERF_SAMPLE_WEIGHT | PERF_SAMPLE_DATA_SRC;
+    *system_wide = 0;
+    
+    for (size_t i = 0; i < sizeof(pmus) / sizeof(pmus[0]); i++) {
+        snprintf(path, sizeof(path), PERF_PMU_ROOT "/%s/events/mem-loads", pmus[i]);
+        if (cxl_read_sysfs_line(path, buf, sizeof(buf)) < 0) continue;
+        
+        long event = perf_event_field(buf, "event");
+        long umask = perf_event_field(buf, "umask");
+        
+        snprintf(path, sizeof(path), PERF_PMU_ROOT "/%s/type", pmus[i]);
+        char type[32];
+        if (event < 0 || cxl_read_sysfs_line(path, type, sizeof(type)) < 0) continue;
+        
+        /* 加载延迟事件只能精确采样；ldlat 在 config1 中 */
+        attr->type = (uint32_t)strtoul(type, NULL, 10);
+        attr->config = (uint64_t)event | ((uint64_t)(umask > 0 ? umask : 0) << 8);
+        attr->config1 = ldlat;
+        attr->precise_ip = 2;
+        attr->inherit = 1;
+        attr->exclude_kernel = 1;
+        attr->exclude_hv = 1;
+        
+        snprintf(path, sizeof(path), PERF_PMU_ROOT "/%s/events/mem-loads-aux", pmus[i]);
+        if (cxl_read_sysfs_line(path, buf, sizeof(buf)) == 0 && (event = perf_event_field(buf, "event")) >= 0) {
+            umask = perf_event_field(buf, "umask");
+            aux->size = sizeof(struct perf_event_attr);
+            aux->type = attr->type;
+            aux->config = (uint64_t)event | ((uint64_t)(umask > 0 ? umask : 0) << 8);
+            aux->inherit = 1;
+            aux->exclude_kernel = 1;
+            aux->exclude_hv = 1;
+        }
+        return 0;
+    }
+    
+    /*
+     * IBS 标记任意 op：PMU 带 PERF_PMU_CAP_NO_EXCLUDE，任何 exclude_* 位都会被拒绝（EINVAL），
+     * 也不支持按任务计数。内核态与其他进程的样本在读取时按地址范围和进程号过滤。
+     */
+    if (cxl_read_sysfs_line(PERF_PMU_ROOT "/ibs_op/type", buf, sizeof(buf)) == 0) {
+        attr->type = (uint32_t)strtoul(buf, NULL, 10);
+        attr->config = 0;
+        *system_wide = 1;
+        return 0;
+    }
+    
+    return -1;
+}
+
+static void perf_mem_warn_once(const char *reason, int err) {
+    if (__atomic_exchange_n(&mem_sampler_warned, 1, __ATOMIC_RELAXED)) return;
+    
+    if (err != 0) {
+        fprintf(stderr, "[WARNING] Memory load sampling unavailable: %s (%s)\n", reason, strerror(err));
+    } else {
+        fprintf(stderr, "[WARNING] Memory load sampling unavailable: %s\n", reason);
+    }
+}
+
+int cxl_mem_sampler_available(void) {
+    struct perf_event_attr attr, aux;
+    int system_wide;
+    
+    return perf_mem_event_attr(&attr, &aux, CXL_MEM_SAMPLER_DEFAULT_PERIOD, CXL_MEM_SAMPLER_DEFAULT_LDLAT,
+                               &system_wide) == 0;
+}
+
+/*
+ * 为一个线程（cpu = -1）或一个 CPU（tid = -1）打开事件并映射环形缓冲区；精确度不被支持时逐级降低。
+ * aux->size 非 0 时先打开 mem-loads-aux 作为组长，采样事件作为组员，样本只写入组员的缓冲区。
+ */
+static int perf_mem_open_event(cxl_mem_sampler_t *sampler, struct perf_event_attr *attr,
+                               struct perf_event_attr *aux, pid_t tid, int cpu) {
+    int leader = -1;
+    int fd = -1;
+    
+    if (aux->size != 0) {
+        leader = (int)perf_event_open(aux, tid, cpu, -1, PERF_FLAG_FD_CLOEXEC);
+        if (leader < 0) return -errno;
+    }
+    
+    while (fd < 0) {
+        fd = (int)perf_event_open(attr, tid, cpu, leader, PERF_FLAG_FD_CLOEXEC);
+        if (fd >= 0 || errno != EOPNOTSUPP || attr->precise_ip == 0) break;
+        attr->precise_ip--;
+    }
+    if (fd < 0) {
+        int err = errno;
+        if (leader >= 0) close(leader);
+        return -err;
+    }
+    
+    void *ring = mmap(NULL, sampler->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ring == MAP_FAILED) {
+        int err = errno;
+        close(fd);
+        if (leader >= 0) close(leader);
+        return -err;
+    }
+    
+    sampler->leader_fds[sampler->num_events] = leader;
+    sampler->fds[sampler->num_events] = fd;
+    sampler->rings[sampler->num_events] = ring;
+    sampler->num_events++;
+    
+    return 0;
+}
+
+/* 目标进程各线程允许运行的 CPU 的并集；sched_getaffinity(0) 只返回调用线程自己的掩码 */
+static int perf_mem_process_cpus(pid_t pid, cpu_set_t *cpus) {
+    char path[64];
+    
+    CPU_ZERO(cpus);
+    
+    if (pid == 0) {
+        snprintf(path, sizeof(path), "/proc/self/task");
+    } else {
+        snprintf(path, sizeof(path), "/proc/%d/task", (int)pid);
+    }
+    
+    DIR *dir = opendir(path);
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir))) {
+            if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+            
+            cpu_set_t mask;
+            if (sched_getaffinity((pid_t)atoi(entry->d_name), sizeof(mask), &mask) == 0) {
+                CPU_OR(cpus, cpus, &mask);
+            }
+        }
+        closedir(dir);
+    }
+    
+    /* 读不到线程掩码时退回所有在线 CPU */
+    if (CPU_COUNT(cpus) == 0) {
+        long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int cpu = 0; cpu < num_cpus && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, cpus);
+        }
+    }
+    
+    return CPU_COUNT(cpus);
+}
+
+/* IBS：在目标进程任一线程允许运行的每个 CPU 上打开系统范围事件 */
+static int perf_mem_open_cpus(cxl_mem_sampler_t *sampler, struct perf_event_attr *attr,
+                              struct perf_event_attr *aux, pid_t pid) {
+    cpu_set_t allowed;
+    int err = 0;
+    
+    if (perf_mem_process_cpus(pid, &allowed) == 0) {
+        return ENODEV;
+    }
+    
+    for (int cpu = 0; cpu < CPU_SETSIZE && sampler->num_events < CXL_MEM_SAMPLER_MAX_EVENTS; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        
+        int ret = perf_mem_open_event(sampler, attr, aux, -1, cpu);
+        if (ret < 0) err = -ret;
+    }
+    
+    return err;
+}
+
+/* mem-loads：每个现有线程一个事件；之后创建的线程由 inherit 继承 */
+static int perf_mem_open_threads(cxl_mem_sampler_t *sampler, struct perf_event_attr *attr,
+                                 struct perf_event_attr *aux, pid_t pid) {
+    char path[64];
+    int err = 0;
+    
+    if (pid == 0) {
+        snprintf(path, sizeof(path), "/proc/self/task");
+    } else {
+        snprintf(path, sizeof(path), "/proc/%d/task", (int)pid);
+    }
+    
+    DIR *dir = opendir(path);
+    if (!dir) {
+        return errno;
+    }
+    
+    struct dirent *entry;
+    while ((entry = readdir(dir)) && sampler->num_events < CXL_MEM_SAMPLER_MAX_EVENTS) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        
+        int ret = perf_mem_open_event(sampler, attr, aux, (pid_t)atoi(entry->d_name), -1);
+        if (ret < 0) err = -ret;
+    }
+    closedir(dir);
+    
+    return err;
+}
+
+int cxl_mem_sampler_open(cxl_mem_sampler_t *sampler, pid_t pid, uint64_t period, uint32_t ldlat) {
+    if (!sampler) return -1;
+    
+    memset(sampler, 0, sizeof(cxl_mem_sampler_t));
+    
+    struct perf_event_attr attr, aux;
+    int system_wide = 0;
+    if (perf_mem_event_attr(&attr, &aux, period ? period : CXL_MEM_SAMPLER_DEFAULT_PERIOD,
+                            ldlat ? ldlat : CXL_MEM_SAMPLER_DEFAULT_LDLAT, &system_wide) < 0) {
+        perf_mem_warn_once("no mem-loads event or IBS op PMU", 0);
+        return -1;
+    }
+    
+    long page_size = sysconf(_SC_PAGESIZE);
+    sampler->ring_size = (size_t)page_size * (1 + CXL_MEM_SAMPLER_RING_PAGES);
+    
+    int err;
+    if (system_wide) {
+        /* IBS 标记任意 op，存储、分支等也会产生样本 */
+        sampler->filter_pid = (pid == 0) ? getpid() : pid;
+        sampler->loads_only = 1;
+        err = perf_mem_open_cpus(sampler, &attr, &aux, pid);
+    } else {
+        err = perf_mem_open_threads(sampler, &attr, &aux, pid);
+    }
+    
+    if (sampler->num_events == 0) {
+        perf_mem_warn_once((err == EACCES || err == EPERM) ?
+                           (system_wide ? "IBS needs system-wide access (perf_event_paranoid <= 0 or CAP_PERFMON)" :
+                                          "not permitted (check /proc/sys/kernel/perf_event_paranoid)") :
+                           "perf_event_open failed", err);
+        return -1;
+    }
+    
+    return sampler->num_events;
+}
+
+/* 从环形缓冲区复制 len 字节，处理回绕 */
+static void perf_ring_copy(const char *data, uint64_t mask, uint64_t offset, void *dst, size_t len) {
+    uint64_t start = offset & mask;
+    size_t first = (size_t)((mask + 1) - start);
+    
+    if (first >= len) {
+        memcpy(dst, data + start, len);
+    } else {
+        memcpy(dst, data + start, first);
+        memcpy((char *)dst + first, data, len - first);
+    }
+}
+
+int cxl_mem_sampler_read(cxl_mem_sampler_t *sampler, uint64_t lo, uint64_t hi,
+                         cxl_mem_sample_t *samples, int max_samples) {
+    if (!sampler || !samples || max_samples <= 0) return 0;
+    
+    long page_size = sysconf(_SC_PAGESIZE);
+    uint64_t mask = (uint64_t)page_size * CXL_MEM_SAMPLER_RING_PAGES - 1;
+    int count = 0;
+    
+    for (int e = 0; e < sampler->num_events && count < max_samples; e++) {
+        struct perf_event_mmap_page *meta = sampler->rings[e];
+        const char *data = (const char *)meta + page_size;
+        
+        /* data_head 之前的记录已完整写入 */
+        uint64_t head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+        uint64_t tail = meta->data_tail;
+        
+        while (tail < head && count < max_samples) {
+            struct perf_event_header header;
+            perf_ring_copy(data, mask, tail, &header, sizeof(header));
+            if (header.size == 0) break;
+            
+            if (header.type == PERF_RECORD_SAMPLE && header.size >= sizeof(mem_sample_record_t)) {
+                mem_sample_record_t record;
+                perf_ring_copy(data, mask, tail, &record, sizeof(record));
+                
+                if (record.addr >= lo && record.addr < hi &&
+                    (sampler->filter_pid == 0 || record.pid == (uint32_t)sampler->filter_pid) &&
+                    (!sampler->loads_only || ((record.data_src >> PERF_MEM_OP_SHIFT) & PERF_MEM_OP_LOAD))) {
+                    cxl_mem_sample_t *sample = &samples[count++];
+                    sample->addr = record.addr;
+                    sample->weight = record.weight;
+                    sample->data_src = record.data_src;
+                    sample->tid = record.tid;
+                    sample->source = cxl_mem_decode_source(record.data_src);
+                } else {
+                    sampler->filtered++;
+                }
+            } else if (header.type == PERF_RECORD_LOST) {
+                uint64_t lost[2];   /* id, lost */
+                perf_ring_copy(data, mask, tail + sizeof(header), lost, sizeof(lost));
+                sampler->lost += lost[1];
+            }
+            
+            tail += header.size;
+        }
+        
+        __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+    }
+    
+    return count;
+}
+
+void cxl_mem_sampler_close(cxl_mem_sampler_t *sampler) {
+    if (!sampler) return;
+    
+    for (int e = 0; e < sampler->num_events; e++) {
+        munmap(sampler->rings[e], sampler->ring_size);
+        close(sampler->fds[e]);
+        if (sampler->leader_fds[e] >= 0) close(sampler->leader_fds[e]);
+    }
+    sampler->num_events = 0;
+}
+
+cxl_mem_source_t cxl_mem_decode_source(uint64_t data_src) {
+    uint64_t lvl = (data_src >> PERF_MEM_LVL_SHIFT) & 0x3fff;
+    uint64_t lvl_num = (data_src >> PERF_MEM_LVLNUM_SHIFT) & 0xf;
+    int remote = (int)((data_src >> PERF_MEM_REMOTE_SHIFT) & PERF_MEM_REMOTE_REMOTE);
+    
+    /* 新内核（4.14 起）在 mem_lvl_num 中给出层级，远端与否单独标记 */
+    switch (lvl_num) {
+        case PERF_MEM_LVLNUM_L1:
+        case PERF_MEM_LVLNUM_LFB:
+            return CXL_MEM_SRC_L1;
+        case PERF_MEM_LVLNUM_L2:
+            return remote ? CXL_MEM_SRC_REMOTE : CXL_MEM_SRC_L2;
+        case PERF_MEM_LVLNUM_L3:
+        case PERF_MEM_LVLNUM_L4:
+        case PERF_MEM_LVLNUM_ANY_CACHE:
+            return remote ? CXL_MEM_SRC_REMOTE : CXL_MEM_SRC_LLC;
+        case PERF_MEM_LVLNUM_CXL:
+            return CXL_MEM_SRC_CXL;
+        case PERF_MEM_LVLNUM_RAM:
+        case PERF_MEM_LVLNUM_PMEM:
+            return remote ? CXL_MEM_SRC_REMOTE : CXL_MEM_SRC_LOCAL_DRAM;
+        default:
+            break;
+    }
+    
+    /* 旧编码：mem_lvl 位图，只有命中层级有意义 */
+    if (!(lvl & PERF_MEM_LVL_HIT)) return CXL_MEM_SRC_UNKNOWN;
+    if (lvl & (PERF_MEM_LVL_L1 | PERF_MEM_LVL_LFB)) return CXL_MEM_SRC_L1;
+    if (lvl & PERF_MEM_LVL_L2) return CXL_MEM_SRC_L2;
+    if (lvl & PERF_MEM_LVL_L3) return CXL_MEM_SRC_LLC;
+    if (lvl & PERF_MEM_LVL_LOC_RAM) return CXL_MEM_SRC_LOCAL_DRAM;
+    if (lvl & (PERF_MEM_LVL_REM_RAM1 | PERF_MEM_LVL_REM_RAM2 |
+               PERF_MEM_LVL_REM_CCE1 | PERF_MEM_LVL_REM_CCE2)) return CXL_MEM_SRC_REMOTE;
+    
+    return CXL_MEM_SRC_UNKNOWN;
+}
+
+const char *cxl_mem_source_name(cxl_mem_source_t source) {
+    if ((int)source < 0 || source >= CXL_MEM_SRC_COUNT) return "unknown";
+    return mem_source_names[source];
+}
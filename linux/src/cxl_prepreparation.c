@@ -2,12 +2,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <limits.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <errno.h>
 #include <numa.h>
 #include <sched.h>
 #include "cxl_prepreparation.h"
 #include "cxl_common.h"
+#include "cxl_topology.h"
 
 /* ====== 初始化配置 ====== */
 int cxl_config_init(cxl_config_t *config) {
@@ -27,9 +32,18 @@ int cxl_config_init(cxl_config_t *config) {
         return -1;
     }
     
-    /* 设置默认配置 */
-    config->numa_node_normal = 0;
-    config->numa_node_cxl = (num_nodes > 1) ? 1 : 0;
+    /* 设置默认配置：CXL 节点来自 sysfs 拓扑，普通节点取其最近的发起节点 */
+    int cxl_node = cxl_get_cxl_node();
+    int initiator = cxl_topology_nearest_initiator(cxl_topology_get(), cxl_node);
+    
+    config->numa_node_normal = (initiator >= 0) ? initiator : NUMA_NODE_NORMAL;
+    if (cxl_node >= 0) {
+        config->numa_node_cxl = cxl_node;
+    } else {
+        config->numa_node_cxl = config->numa_node_normal;
+        fprintf(stderr, "[WARNING] No CXL memory node detected, using node %d for CXL tests\n",
+                config->numa_node_cxl);
+    }
     
     config->thread_placement = CROSS_CORE;
     config->data_placement = PLACEMENT_NORMAL_NODE;
@@ -48,11 +62,439 @@ int cxl_config_init(cxl_config_t *config) {
     config->warmup_iterations = 100;
     config->sample_size = 1000;
     
+    /* 缓冲区 */
+    config->test_buffer_size = 4096;
+    config->page_mode = PAGE_MODE_4K;
+    config->num_worker_cpus = 0;     /* 自动选择 */
+    
     fprintf(stdout, "[INFO] Configuration initialized\n");
     
     return 0;
 }
 
+/* ====== 配置文件 ====== */
+typedef enum {
+    CONFIG_INT,
+    CONFIG_CPU,
+    CONFIG_U64,
+    CONFIG_U32,
+    CONFIG_SIZE,
+    CONFIG_BOOL,
+    CONFIG_THREAD_PLACEMENT,
+    CONFIG_DATA_PLACEMENT,
+    CONFIG_CPU_LIST,
+    CONFIG_PAGE_MODE
+} config_type_t;
+
+typedef struct {
+    const char *section;
+    const char *name;
+    config_type_t type;
+    size_t offset;
+} config_key_t;
+
+static const config_key_t config_keys[] = {
+    {"numa",      "normal_node",       CONFIG_INT,              offsetof(cxl_config_t, numa_node_normal)},
+    {"numa",      "cxl_node",          CONFIG_INT,              offsetof(cxl_config_t, numa_node_cxl)},
+    {"placement", "thread",            CONFIG_THREAD_PLACEMENT, offsetof(cxl_config_t, thread_placement)},
+    {"placement", "data",              CONFIG_DATA_PLACEMENT,   offsetof(cxl_config_t, data_placement)},
+    {"cpu",       "attacker",          CONFIG_CPU,              offsetof(cxl_config_t, attacker_cpu)},
+    {"cpu",       "victim",            CONFIG_CPU,              offsetof(cxl_config_t, victim_cpu)},
+    {"cpu",       "probe",             CONFIG_CPU,              offsetof(cxl_config_t, probe_cpu)},
+    {"cpu",       "monitor",           CONFIG_CPU,              offsetof(cxl_config_t, monitor_cpu)},
+    {"cpu",       "workers",           CONFIG_CPU_LIST,         offsetof(cxl_config_t, worker_cpus)},
+    {"system",    "prefetcher",        CONFIG_BOOL,             offsetof(cxl_config_t, prefetcher_enabled)},
+    {"system",    "isolcpus",          CONFIG_BOOL,             offsetof(cxl_config_t, isolcpus_enabled)},
+    {"run",       "iterations",        CONFIG_U64,              offsetof(cxl_config_t, iterations)},
+    {"run",       "warmup_iterations", CONFIG_U64,              offsetof(cxl_config_t, warmup_iterations)},
+    {"run",       "sample_size",       CONFIG_U32,              offsetof(cxl_config_t, sample_size)},
+    {"buffer",    "test_size",         CONFIG_SIZE,             offsetof(cxl_config_t, test_buffer_size)},
+    {"buffer",    "page_size",         CONFIG_PAGE_MODE,        offsetof(cxl_config_t, page_mode)},
+};
+
+#define CONFIG_NUM_KEYS (sizeof(config_keys) / sizeof(config_keys[0]))
+
+static const char *config_thread_names[] = {"cross_core", "different_thread", "same_thread"};
+static const char *config_data_names[] = {"normal", "cxl", "local"};
+
+static char *config_trim(char *str) {
+    while (isspace((unsigned char)*str)) str++;
+    
+    char *end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    
+    return str;
+}
+
+static int config_parse_long(const char *value, long long *out) {
+    char *end = NULL;
+    errno = 0;
+    long long v = strtoll(value, &end, 0);
+    
+    if (end == value || *end != '\0' || errno != 0) return -1;
+    
+    *out = v;
+    return 0;
+}
+
+static int config_parse_size(const char *value, uint64_t *out) {
+    char *end = NULL;
+    errno = 0;
+    unsigned long long v = strtoull(value, &end, 10);
+    
+    if (end == value || errno != 0 || value[0] == '-') return -1;
+    
+    switch (*end) {
+        case 'G': case 'g': v <<= 30; end++; break;
+        case 'M': case 'm': v <<= 20; end++; break;
+        case 'K': case 'k': v <<= 10; end++; break;
+        default: break;
+    }
+    
+    if (*end != '\0') return -1;
+    
+    *out = v;
+    return 0;
+}
+
+static int config_parse_bool(const char *value, int *out) {
+    static const char *true_values[] = {"1", "true", "yes", "on"};
+    static const char *false_values[] = {"0", "false", "no", "off"};
+    
+    for (size_t i = 0; i < 4; i++) {
+        if (strcasecmp(value, true_values[i]) == 0) { *out = 1; return 0; }
+        if (strcasecmp(value, false_values[i]) == 0) { *out = 0; return 0; }
+    }
+    
+    return -1;
+}
+
+static int config_parse_name(const char *value, const char **names, int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcasecmp(value, names[i]) == 0) return i;
+    }
+    
+    return -1;
+}
+
+/* cpulist 格式："4-7,12"，返回 CPU 个数，格式错误或超出 max_cpus 返回 -1 */
+static int config_parse_cpus(const char *value, int *cpus, int max_cpus) {
+    int count = 0;
+    const char *p = value;
+    
+    while (*p) {
+        char *end = NULL;
+        long lo = strtol(p, &end, 10);
+        if (end == p || lo < 0) return -1;
+        
+        long hi = lo;
+        p = end;
+        if (*p == '-') {
+            hi = strtol(p + 1, &end, 10);
+            if (end == p + 1 || hi < lo) return -1;
+            p = end;
+        }
+        
+        for (long cpu = lo; cpu <= hi; cpu++) {
+            if (count >= max_cpus || cpu >= CXL_MAX_CORES) return -1;
+            cpus[count++] = (int)cpu;
+        }
+        
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == ',') {
+            p++;
+            while (isspace((unsigned char)*p)) p++;
+        } else if (*p != '\0') {
+            return -1;
+        }
+    }
+    
+    return count;
+}
+
+static int config_set_field(cxl_config_t *config, const config_key_t *key, const char *value) {
+    void *field = (char *)config + key->offset;
+    long long v;
+    uint64_t u;
+    int i;
+    
+    switch (key->type) {
+        case CONFIG_INT:
+            if (config_parse_long(value, &v) < 0 || v < INT_MIN || v > INT_MAX) return -1;
+            *(int *)field = (int)v;
+            return 0;
+        case CONFIG_CPU:
+            if (config_parse_long(value, &v) < 0 || v < 0 || v >= CXL_MAX_CORES) return -1;
+            *(int *)field = (int)v;
+            return 0;
+        case CONFIG_U64:
+            if (config_parse_size(value, &u) < 0) return -1;
+            *(uint64_t *)field = u;
+            return 0;
+        case CONFIG_U32:
+            if (config_parse_size(value, &u) < 0 || u > UINT32_MAX) return -1;
+            *(uint32_t *)field = (uint32_t)u;
+            return 0;
+        case CONFIG_SIZE:
+            if (config_parse_size(value, &u) < 0) return -1;
+            *(size_t *)field = (size_t)u;
+            return 0;
+        case CONFIG_BOOL:
+            return config_parse_bool(value, (int *)field);
+        case CONFIG_THREAD_PLACEMENT:
+            if ((i = config_parse_name(value, config_thread_names, 3)) < 0) return -1;
+            *(thread_placement_t *)field = (thread_placement_t)i;
+            return 0;
+        case CONFIG_DATA_PLACEMENT:
+            if ((i = config_parse_name(value, config_data_names, 3)) < 0) return -1;
+            *(data_placement_t *)field = (data_placement_t)i;
+            return 0;
+        case CONFIG_CPU_LIST:
+            /* 空字符串或 "auto" 表示自动选择 */
+            if (*value == '\0' || strcasecmp(value, "auto") == 0) {
+                config->num_worker_cpus = 0;
+                return 0;
+            }
+            if ((i = config_parse_cpus(value, (int *)field, CXL_MAX_THREADS)) <= 0) return -1;
+            config->num_worker_cpus = i;
+            return 0;
+        case CONFIG_PAGE_MODE:
+            for (i = PAGE_MODE_4K; i <= PAGE_MODE_HUGETLB_1G; i++) {
+                if (strcasecmp(value, cxl_page_mode_name((page_mode_t)i)) == 0) {
+                    *(page_mode_t *)field = (page_mode_t)i;
+                    return 0;
+                }
+            }
+            return -1;
+        default:
+            return -1;
+    }
+}
+
+static const config_key_t *config_find_key(const char *section, const char *name) {
+    for (size_t k = 0; k < CONFIG_NUM_KEYS; k++) {
+        if (strcasecmp(config_keys[k].section, section) == 0 &&
+            strcasecmp(config_keys[k].name, name) == 0) {
+            return &config_keys[k];
+        }
+    }
+    
+    return NULL;
+}
+
+int cxl_config_set(cxl_config_t *config, const char *key, const char *value) {
+    if (!config || !key || !value) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    const char *dot = strchr(key, '.');
+    char section[64];
+    
+    if (!dot || (size_t)(dot - key) >= sizeof(section)) {
+        fprintf(stderr, "[ERROR] Config key must be 'section.name': %s\n", key);
+        return -1;
+    }
+    
+    memcpy(section, key, (size_t)(dot - key));
+    section[dot - key] = '\0';
+    
+    const config_key_t *entry = config_find_key(section, dot + 1);
+    if (!entry) {
+        fprintf(stderr, "[ERROR] Unknown config key: %s\n", key);
+        return -1;
+    }
+    
+    if (config_set_field(config, entry, value) < 0) {
+        fprintf(stderr, "[ERROR] Invalid value for %s: '%s'\n", key, value);
+        return -1;
+    }
+    
+    return 0;
+}
+
+int cxl_config_load(cxl_config_t *config, const char *path) {
+    if (!config || !path) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "[ERROR] Failed to open config file: %s\n", path);
+        return -1;
+    }
+    
+    char line[CXL_CONFIG_LINE_MAX];
+    char section[64] = "";
+    int line_no = 0;
+    int ret = 0;
+    
+    while (fgets(line, sizeof(line), file)) {
+        line_no++;
+        
+        char *comment = strpbrk(line, "#;");
+        if (comment) *comment = '\0';
+        
+        char *text = config_trim(line);
+        if (*text == '\0') continue;
+        
+        if (*text == '[') {
+            char *close = strchr(text, ']');
+            if (!close || close[1] != '\0') {
+                fprintf(stderr, "[ERROR] %s:%d: malformed section header\n", path, line_no);
+                ret = -1;
+                break;
+            }
+            *close = '\0';
+            snprintf(section, sizeof(section), "%s", config_trim(text + 1));
+            continue;
+        }
+        
+        char *eq = strchr(text, '=');
+        if (!eq) {
+            fprintf(stderr, "[ERROR] %s:%d: expected 'key = value'\n", path, line_no);
+            ret = -1;
+            break;
+        }
+        
+        *eq = '\0';
+        char *name = config_trim(text);
+        char *value = config_trim(eq + 1);
+        
+        /* TOML 风格的带引号字符串 */
+        size_t len = strlen(value);
+        if (len >= 2 && value[0] == '"' && value[len - 1] == '"') {
+            value[len - 1] = '\0';
+            value++;
+        }
+        
+        char key[160];
+        if (strchr(name, '.') || section[0] == '\0') {
+            snprintf(key, sizeof(key), "%s", name);
+        } else {
+            snprintf(key, sizeof(key), "%s.%s", section, name);
+        }
+        
+        if (cxl_config_set(config, key, value) < 0) {
+            fprintf(stderr, "[ERROR] %s:%d: invalid config entry\n", path, line_no);
+            ret = -1;
+            break;
+        }
+    }
+    
+    fclose(file);
+    
+    if (ret == 0) {
+        fprintf(stdout, "[INFO] Configuration loaded from: %s\n", path);
+    }
+    
+    return ret;
+}
+
+int cxl_config_apply_env(cxl_config_t *config) {
+    if (!config) {
+        fprintf(stderr, "[ERROR] Invalid config pointer\n");
+        return -1;
+    }
+    
+    int applied = 0;
+    
+    for (size_t k = 0; k < CONFIG_NUM_KEYS; k++) {
+        char env_name[128];
+        char key[128];
+        
+        snprintf(env_name, sizeof(env_name), "%s%s_%s", CXL_CONFIG_ENV_PREFIX,
+                 config_keys[k].section, config_keys[k].name);
+        for (char *p = env_name; *p; p++) {
+            *p = (char)toupper((unsigned char)*p);
+        }
+        
+        const char *value = getenv(env_name);
+        if (!value) continue;
+        
+        snprintf(key, sizeof(key), "%s.%s", config_keys[k].section, config_keys[k].name);
+        if (cxl_config_set(config, key, value) < 0) {
+            fprintf(stderr, "[ERROR] Invalid environment override %s\n", env_name);
+            return -1;
+        }
+        
+        fprintf(stdout, "[INFO] %s=%s overrides %s\n", env_name, value, key);
+        applied++;
+    }
+    
+    return applied;
+}
+
+int cxl_config_resolve(const char *config_name, char *path, size_t size) {
+    if (!path || size == 0) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    if (!config_name || config_name[0] == '\0' || strcmp(config_name, "default") == 0) {
+        const char *env_path = getenv(CXL_CONFIG_ENV_FILE);
+        if (!env_path || env_path[0] == '\0') {
+            return 0;
+        }
+        config_name = env_path;
+    }
+    
+    if (access(config_name, R_OK) == 0) {
+        snprintf(path, size, "%s", config_name);
+        return 1;
+    }
+    
+    snprintf(path, size, "%s/%s.ini", CXL_CONFIG_DIR, config_name);
+    if (!strchr(config_name, '/') && access(path, R_OK) == 0) {
+        return 1;
+    }
+    
+    fprintf(stderr, "[ERROR] Configuration not found: %s\n", config_name);
+    return -1;
+}
+
+int cxl_config_save(const cxl_config_t *config, const char *path) {
+    if (!config || !path) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "[ERROR] Failed to open file: %s\n", path);
+        return -1;
+    }
+    
+    fprintf(file, "# CXL framework configuration\n");
+    fprintf(file, "\n[numa]\nnormal_node = %d\ncxl_node = %d\n",
+            config->numa_node_normal, config->numa_node_cxl);
+    fprintf(file, "\n[placement]\nthread = %s\ndata = %s\n",
+            config_thread_names[config->thread_placement], config_data_names[config->data_placement]);
+    fprintf(file, "\n[cpu]\nattacker = %d\nvictim = %d\nprobe = %d\nmonitor = %d\nworkers = ",
+            config->attacker_cpu, config->victim_cpu, config->probe_cpu, config->monitor_cpu);
+    if (config->num_worker_cpus == 0) {
+        fprintf(file, "auto");
+    }
+    for (int i = 0; i < config->num_worker_cpus; i++) {
+        fprintf(file, "%s%d", i ? "," : "", config->worker_cpus[i]);
+    }
+    fprintf(file, "\n\n[system]\nprefetcher = %d\nisolcpus = %d\n",
+            config->prefetcher_enabled, config->isolcpus_enabled);
+    fprintf(file, "\n[run]\niterations = %lu\nwarmup_iterations = %lu\nsample_size = %u\n",
+            config->iterations, config->warmup_iterations, config->sample_size);
+    fprintf(file, "\n[buffer]\ntest_size = %zu\npage_size = %s\n",
+            config->test_buffer_size, cxl_page_mode_name(config->page_mode));
+    
+    if (fclose(file) != 0) {
+        fprintf(stderr, "[ERROR] Failed to write file: %s\n", path);
+        return -1;
+    }
+    
+    return 0;
+}
+
 int cxl_set_numa_nodes(cxl_config_t *config, int normal_node, int cxl_node) {
     if (!config) {
         fprintf(stderr, "[ERROR] Invalid config pointer\n");
@@ -190,6 +632,14 @@ void cxl_print_config(const cxl_config_t *config) {
     fprintf(stdout, "  Victim CPU:         %d\n", config->victim_cpu);
     fprintf(stdout, "  Probe CPU:          %d\n", config->probe_cpu);
     fprintf(stdout, "  Monitor CPU:        %d\n", config->monitor_cpu);
+    fprintf(stdout, "  Worker CPUs:        ");
+    if (config->num_worker_cpus == 0) {
+        fprintf(stdout, "auto");
+    }
+    for (int i = 0; i < config->num_worker_cpus; i++) {
+        fprintf(stdout, "%s%d", i ? "," : "", config->worker_cpus[i]);
+    }
+    fprintf(stdout, "\n");
     fprintf(stdout, "\nData Configuration:\n");
     fprintf(stdout, "  Data Placement:     %s\n", data_placement_names[config->data_placement]);
     fprintf(stdout, "\nSystem Configuration:\n");
@@ -199,10 +649,50 @@ void cxl_print_config(const cxl_config_t *config) {
     fprintf(stdout, "  Iterations:         %lu\n", config->iterations);
     fprintf(stdout, "  Warmup Iterations:  %lu\n", config->warmup_iterations);
     fprintf(stdout, "  Sample Size:        %u\n", config->sample_size);
+    fprintf(stdout, "\nBuffer Configuration:\n");
+    fprintf(stdout, "  Test Buffer:        %zu bytes\n", config->test_buffer_size);
+    fprintf(stdout, "  Page Size:          %s\n", cxl_page_mode_name(config->page_mode));
     fprintf(stdout, "=================================================\n\n");
 }
 
 /* ====== 配置验证 ====== */
+
+/* isolcpus 只能在内核启动参数中设置，这里仅检查配置的 CPU 是否确实被隔离 */
+static void config_check_isolated(const cxl_config_t *config) {
+    char line[CXL_CONFIG_LINE_MAX] = "";
+    int isolated[CXL_MAX_CORES];
+    int num_isolated = 0;
+    
+    FILE *file = fopen("/sys/devices/system/cpu/isolated", "r");
+    if (file) {
+        if (fgets(line, sizeof(line), file)) {
+            num_isolated = config_parse_cpus(config_trim(line), isolated, CXL_MAX_CORES);
+        }
+        fclose(file);
+    }
+    
+    int cpus[4 + CXL_MAX_THREADS] = {
+        config->attacker_cpu, config->victim_cpu, config->probe_cpu, config->monitor_cpu
+    };
+    int num_cpus = 4;
+    for (int i = 0; i < config->num_worker_cpus; i++) {
+        cpus[num_cpus++] = config->worker_cpus[i];
+    }
+    
+    for (int i = 0; i < num_cpus; i++) {
+        int found = 0;
+        for (int j = 0; j < num_isolated; j++) {
+            if (isolated[j] == cpus[i]) {
+                found = 1;
+                break;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "[WARNING] isolcpus enabled but CPU %d is not isolated\n", cpus[i]);
+        }
+    }
+}
+
 int cxl_validate_config(const cxl_config_t *config) {
     if (!config) {
         fprintf(stderr, "[ERROR] Invalid config pointer\n");
@@ -224,6 +714,41 @@ int cxl_validate_config(const cxl_config_t *config) {
         return -1;
     }
     
+    if (config->attacker_cpu < 0 || config->victim_cpu < 0 ||
+        config->probe_cpu < 0 || config->monitor_cpu < 0) {
+        fprintf(stderr, "[ERROR] CPU IDs must be non-negative\n");
+        return -1;
+    }
+    
+    /* 默认的探测/监控 CPU 在小机器上可能越界，仅在使用时才需要 */
+    if (config->probe_cpu >= num_cpus) {
+        fprintf(stderr, "[WARNING] Probe CPU %d >= number of CPUs %d\n",
+                config->probe_cpu, num_cpus);
+    }
+    
+    if (config->monitor_cpu >= num_cpus) {
+        fprintf(stderr, "[WARNING] Monitor CPU %d >= number of CPUs %d\n",
+                config->monitor_cpu, num_cpus);
+    }
+    
+    if (config->num_worker_cpus < 0 || config->num_worker_cpus > CXL_MAX_THREADS) {
+        fprintf(stderr, "[ERROR] Invalid number of worker CPUs %d\n", config->num_worker_cpus);
+        return -1;
+    }
+    
+    for (int i = 0; i < config->num_worker_cpus; i++) {
+        if (config->worker_cpus[i] < 0 || config->worker_cpus[i] >= num_cpus) {
+            fprintf(stderr, "[ERROR] Worker CPU %d >= number of CPUs %d\n",
+                    config->worker_cpus[i], num_cpus);
+            return -1;
+        }
+    }
+    
+    if (config->numa_node_normal < 0 || config->numa_node_cxl < 0) {
+        fprintf(stderr, "[ERROR] NUMA node IDs must be non-negative\n");
+        return -1;
+    }
+    
     if (config->numa_node_normal >= num_nodes) {
         fprintf(stderr, "[ERROR] Normal node %d >= number of NUMA nodes %d\n", 
                 config->numa_node_normal, num_nodes);
@@ -236,6 +761,21 @@ int cxl_validate_config(const cxl_config_t *config) {
         return -1;
     }
     
+    if (config->iterations == 0 || config->sample_size == 0) {
+        fprintf(stderr, "[ERROR] Iterations and sample size must be positive\n");
+        return -1;
+    }
+    
+    if (config->test_buffer_size < 2 * CXL_CACHE_LINE_SIZE) {
+        fprintf(stderr, "[ERROR] Test buffer size %zu < %d bytes\n",
+                config->test_buffer_size, 2 * CXL_CACHE_LINE_SIZE);
+        return -1;
+    }
+    
+    if (config->isolcpus_enabled) {
+        config_check_isolated(config);
+    }
+    
     fprintf(stdout, "[INFO] Configuration validation passed\n");
     return 0;
 }
@@ -250,14 +790,6 @@ int cxl_check_system_support(void) {
     return 1;
 }
 
-int cxl_get_cxl_node(void) {
-    int num_nodes = cxl_get_num_numa_nodes();
-    if (num_nodes > 1) {
-        return 1;  /* 假设 CXL Memory 在节点 1 */
-    }
-    return -1;
-}
-
 int cxl_setup_multithreading(cxl_config_t *config, int num_threads) {
     if (!config || num_threads <= 0) {
         fprintf(stderr, "[ERROR] Invalid parameters\n");
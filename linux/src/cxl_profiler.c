@@ -0,0 +1,454 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <time.h>
+#include <numaif.h>
+#include "cxl_profiler.h"
+#include "cxl_common.h"
+
+#define PROF_IDLE_BITMAP        "/sys/kernel/mm/page_idle/bitmap"
+#define PROF_KPAGEFLAGS         "/proc/kpageflags"
+#define PROF_KPF_LRU            (1ULL << 5)
+#define PROF_PAGEMAP_PRESENT    (1ULL << 63)
+#define PROF_PAGEMAP_PFN_MASK   ((1ULL << 55) - 1)
+
+/* ====== 辅助函数 ====== */
+static int prof_open_proc(pid_t pid, const char *name, int flags) {
+    char path[64];
+    
+    if (pid == 0) {
+        snprintf(path, sizeof(path), "/proc/self/%s", name);
+    } else {
+        snprintf(path, sizeof(path), "/proc/%d/%s", (int)pid, name);
+    }
+    
+    return open(path, flags);
+}
+
+static void prof_sleep_us(uint32_t us) {
+    struct timespec ts = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+    
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {
+    }
+}
+
+/* 读取区域内各页的 pagemap 项，缺页或换出的页 PFN 为 0 */
+static int prof_read_pagemap(int fd, uintptr_t start, size_t page_size, uint64_t num_pages,
+                             uint64_t *entries) {
+    size_t bytes = (size_t)num_pages * sizeof(uint64_t);
+    off_t offset = (off_t)(start / page_size) * (off_t)sizeof(uint64_t);
+    size_t done = 0;
+    
+    while (done < bytes) {
+        ssize_t n = pread(fd, (char *)entries + done, bytes - done, offset + (off_t)done);
+        if (n <= 0) {
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    
+    for (uint64_t i = 0; i < num_pages; i++) {
+        entries[i] = (entries[i] & PROF_PAGEMAP_PRESENT) ? (entries[i] & PROF_PAGEMAP_PFN_MASK) : 0;
+    }
+    
+    return 0;
+}
+
+/* 把各页标记为空闲；位图按 64 位字读写，相邻页常落在同一个字上，合并成一次写入 */
+static int prof_mark_idle(int fd, const uint64_t *pfns, uint64_t num_pages) {
+    uint64_t word = UINT64_MAX;
+    uint64_t bits = 0;
+    
+    for (uint64_t i = 0; i <= num_pages; i++) {
+        uint64_t pfn = (i < num_pages) ? pfns[i] : 0;
+        
+        if ((i == num_pages || (pfn != 0 && pfn / 64 != word)) && word != UINT64_MAX) {
+            if (pwrite(fd, &bits, sizeof(bits), (off_t)(word * sizeof(uint64_t))) != sizeof(bits)) {
+                return -1;
+            }
+            word = UINT64_MAX;
+            bits = 0;
+        }
+        if (pfn == 0) continue;
+        
+        word = pfn / 64;
+        bits |= 1ULL << (pfn % 64);
+    }
+    
+    return 0;
+}
+
+/*
+ * 内核只为 LRU 上的页设置空闲位（zero page、驱动映射、暂时离开 LRU 的页写入后位仍为 0），
+ * 按 PFN 查 /proc/kpageflags 的 KPF_LRU，不在 LRU 上的页 PFN 置 0，本间隔不参与统计。
+ * 不能靠标记后读回位图判断：读回前页可能已被访问，热页会被误当作不可跟踪。返回可跟踪的页数。
+ */
+static int64_t prof_drop_untracked(int fd, uint64_t *pfns, uint64_t num_pages) {
+    int64_t tracked = 0;
+    
+    for (uint64_t i = 0; i < num_pages; i++) {
+        uint64_t pfn = pfns[i];
+        uint64_t flags;
+        if (pfn == 0) continue;
+        
+        if (pread(fd, &flags, sizeof(flags), (off_t)(pfn * sizeof(uint64_t))) != sizeof(flags)) {
+            return -1;
+        }
+        
+        if (flags & PROF_KPF_LRU) {
+            tracked++;
+        } else {
+            pfns[i] = 0;
+        }
+    }
+    
+    return tracked;
+}
+
+/* 读取各页的空闲位：位被清除表示标记后被访问过 */
+static int prof_collect_accessed(int fd, const uint64_t *pfns, uint64_t num_pages, uint8_t *counts) {
+    uint64_t word = UINT64_MAX;
+    uint64_t bits = 0;
+    
+    for (uint64_t i = 0; i < num_pages; i++) {
+        uint64_t pfn = pfns[i];
+        if (pfn == 0) continue;
+        
+        if (pfn / 64 != word) {
+            word = pfn / 64;
+            if (pread(fd, &bits, sizeof(bits), (off_t)(word * sizeof(uint64_t))) != sizeof(bits)) {
+                return -1;
+            }
+        }
+        
+        if (!(bits & (1ULL << (pfn % 64))) && counts[i] < UINT8_MAX) {
+            counts[i]++;
+        }
+    }
+    
+    return 0;
+}
+
+/* 查询各页当前所在节点（move_pages 不带目标节点时只返回位置） */
+static void prof_query_nodes(pid_t pid, uintptr_t start, size_t page_size, uint64_t num_pages,
+                             int *nodes) {
+    void **pages = malloc(num_pages * sizeof(void *));
+    
+    for (uint64_t i = 0; i < num_pages; i++) {
+        nodes[i] = -1;
+    }
+    if (!pages) return;
+    
+    for (uint64_t i = 0; i < num_pages; i++) {
+        pages[i] = (void *)(start + i * page_size);
+    }
+    
+    if (move_pages(pid, (unsigned long)num_pages, pages, NULL, nodes, 0) == 0) {
+        for (uint64_t i = 0; i < num_pages; i++) {
+            if (nodes[i] < 0) nodes[i] = -1;
+        }
+    }
+    
+    free(pages);
+}
+
+/* 逐个间隔标记空闲并收集访问位，累加到 profile->counts */
+static int prof_run_intervals(const page_profile_params_t *params, int bitmap_fd, int pagemap_fd,
+                              int kpageflags_fd, uint64_t *pfns, page_profile_t *profile) {
+    uintptr_t start = profile->start;
+    size_t page_size = profile->page_size;
+    uint64_t num_pages = profile->num_pages;
+    
+    for (uint32_t interval = 0; interval < params->num_intervals; interval++) {
+        /* 每个间隔重新取 PFN：页可能被迁移、换出或首次缺页 */
+        if (prof_read_pagemap(pagemap_fd, start, page_size, num_pages, pfns) < 0) {
+            fprintf(stderr, "[ERROR] Failed to read pagemap: %s\n", strerror(errno));
+            return -1;
+        }
+        
+        uint64_t resident = 0;
+        for (uint64_t i = 0; i < num_pages; i++) {
+            if (pfns[i] != 0) resident++;
+        }
+        
+        /* 没有特权时内核把 PFN 清零，所有页看起来都不在内存中 */
+        if (interval == 0 && resident == 0) {
+            fprintf(stderr, "[WARNING] No resident pages visible (not faulted in, or pagemap PFNs "
+                    "hidden without CAP_SYS_ADMIN)\n");
+        }
+        
+        int64_t tracked = prof_drop_untracked(kpageflags_fd, pfns, num_pages);
+        if (tracked < 0) {
+            fprintf(stderr, "[ERROR] Failed to read %s: %s\n", PROF_KPAGEFLAGS, strerror(errno));
+            return -1;
+        }
+        if (interval == 0 && resident > 0 && (uint64_t)tracked < resident) {
+            fprintf(stderr, "[WARNING] %lu of %lu resident pages are not on the LRU and cannot be tracked\n",
+                    resident - (uint64_t)tracked, resident);
+        }
+        
+        if (prof_mark_idle(bitmap_fd, pfns, num_pages) < 0) {
+            fprintf(stderr, "[ERROR] Failed to write idle page bitmap: %s\n", strerror(errno));
+            return -1;
+        }
+        
+        /* 只有 LRU 上的页才算在内存中，否则无法区分"被访问"与"不可跟踪" */
+        for (uint64_t i = 0; i < num_pages; i++) {
+            if (pfns[i] != 0) profile->present[i] = 1;
+        }
+        
+        prof_sleep_us(params->interval_us);
+        
+        if (prof_collect_accessed(bitmap_fd, pfns, num_pages, profile->counts) < 0) {
+            fprintf(stderr, "[ERROR] Failed to read idle page bitmap: %s\n", strerror(errno));
+            return -1;
+        }
+        
+        profile->num_intervals++;
+    }
+    
+    return 0;
+}
+
+/* ====== 可用性检查 ====== */
+int cxl_profile_available(void) {
+    int fd = open(PROF_IDLE_BITMAP, O_RDWR);
+    
+    if (fd < 0) {
+        return 0;
+    }
+    close(fd);
+    
+    return 1;
+}
+
+/* ====== 页访问频率分析 ====== */
+int cxl_profile_pages(const page_profile_params_t *params, page_profile_t *profile) {
+    if (!params || !profile || params->size == 0 || params->num_intervals == 0 ||
+        params->num_intervals > CXL_PROF_MAX_INTERVALS || params->hot_fraction < 0.0 ||
+        params->hot_fraction > 1.0) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    memset(profile, 0, sizeof(page_profile_t));
+    
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = params->start & ~(uintptr_t)(page_size - 1);
+    uintptr_t end = (params->start + params->size + page_size - 1) & ~(uintptr_t)(page_size - 1);
+    uint64_t num_pages = (end - start) / page_size;
+    
+    int bitmap_fd = open(PROF_IDLE_BITMAP, O_RDWR);
+    if (bitmap_fd < 0) {
+        fprintf(stderr, "[ERROR] Idle page tracking unavailable (%s): %s\n", PROF_IDLE_BITMAP, strerror(errno));
+        return -1;
+    }
+    
+    int pagemap_fd = prof_open_proc(params->pid, "pagemap", O_RDONLY);
+    if (pagemap_fd < 0) {
+        fprintf(stderr, "[ERROR] Failed to open pagemap of pid %d: %s\n", (int)params->pid, strerror(errno));
+        close(bitmap_fd);
+        return -1;
+    }
+    
+    int kpageflags_fd = open(PROF_KPAGEFLAGS, O_RDONLY);
+    if (kpageflags_fd < 0) {
+        fprintf(stderr, "[ERROR] Failed to open %s: %s\n", PROF_KPAGEFLAGS, strerror(errno));
+        close(pagemap_fd);
+        close(bitmap_fd);
+        return -1;
+    }
+    
+    uint64_t *pfns = malloc(num_pages * sizeof(uint64_t));
+    profile->counts = calloc(num_pages, sizeof(uint8_t));
+    profile->present = calloc(num_pages, sizeof(uint8_t));
+    profile->nodes = malloc(num_pages * sizeof(int));
+    
+    int ret = -1;
+    if (!pfns || !profile->counts || !profile->present || !profile->nodes) {
+        fprintf(stderr, "[ERROR] Failed to allocate profile for %lu pages\n", num_pages);
+    } else {
+        profile->pid = params->pid;
+        profile->start = start;
+        profile->page_size = page_size;
+        profile->num_pages = num_pages;
+        
+        ret = prof_run_intervals(params, bitmap_fd, pagemap_fd, kpageflags_fd, pfns, profile);
+    }
+    
+    if (ret == 0) {
+        prof_query_nodes(params->pid, start, page_size, num_pages, profile->nodes);
+        
+        /* 至少被访问一次才可能是热页 */
+        profile->hot_threshold = (uint32_t)ceil(params->hot_fraction * (double)profile->num_intervals);
+        if (profile->hot_threshold == 0) profile->hot_threshold = 1;
+        
+        for (uint64_t i = 0; i < num_pages; i++) {
+            switch (cxl_profile_page_class(profile, i)) {
+                case PAGE_CLASS_HOT:  profile->num_hot++; break;
+                case PAGE_CLASS_COLD: profile->num_cold++; break;
+                default:              profile->num_unmapped++; break;
+            }
+            if (profile->present[i]) {
+                profile->freq_hist[profile->counts[i]]++;
+            }
+        }
+    }
+    
+    free(pfns);
+    close(kpageflags_fd);
+    close(pagemap_fd);
+    close(bitmap_fd);
+    if (ret < 0) {
+        cxl_profile_free(profile);
+    }
+    
+    return ret;
+}
+
+/* ====== 默认分析区域 ====== */
+int cxl_profile_find_region(pid_t pid, uintptr_t *start, size_t *size) {
+    if (!start || !size) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    char path[64];
+    if (pid == 0) {
+        snprintf(path, sizeof(path), "/proc/self/maps");
+    } else {
+        snprintf(path, sizeof(path), "/proc/%d/maps", (int)pid);
+    }
+    
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "[ERROR] Failed to open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    
+    char line[512];
+    size_t best = 0;
+    
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long lo, hi, inode;
+        char perms[8];
+        char name[256] = "";
+        
+        if (sscanf(line, "%lx-%lx %7s %*s %*s %lu %255s", &lo, &hi, perms, &inode, name) < 4) {
+            continue;
+        }
+        
+        /* 私有可写的匿名映射；[heap] 计入，[stack] 等其他特殊映射不计入 */
+        if (perms[1] != 'w' || perms[3] != 'p' || inode != 0) continue;
+        if (name[0] != '\0' && strcmp(name, "[heap]") != 0) continue;
+        
+        if (hi - lo > best) {
+            best = hi - lo;
+            *start = lo;
+            *size = best;
+        }
+    }
+    fclose(file);
+    
+    if (best == 0) {
+        fprintf(stderr, "[ERROR] No anonymous writable mapping found in %s\n", path);
+        return -1;
+    }
+    
+    return 0;
+}
+
+/* ====== 分类 ====== */
+page_class_t cxl_profile_page_class(const page_profile_t *profile, uint64_t page) {
+    if (!profile || page >= profile->num_pages || !profile->present[page]) {
+        return PAGE_CLASS_UNMAPPED;
+    }
+    
+    return (profile->counts[page] >= profile->hot_threshold) ? PAGE_CLASS_HOT : PAGE_CLASS_COLD;
+}
+
+const char *cxl_profile_class_name(page_class_t page_class) {
+    switch (page_class) {
+        case PAGE_CLASS_UNMAPPED:   return "unmapped";
+        case PAGE_CLASS_COLD:       return "cold";
+        case PAGE_CLASS_HOT:        return "hot";
+        default:                    return "unknown";
+    }
+}
+
+/* ====== 输出 ====== */
+void cxl_profile_print(const page_profile_t *profile, int cxl_node) {
+    if (!profile || !profile->counts) return;
+    
+    uint64_t resident = profile->num_pages - profile->num_unmapped;
+    
+    fprintf(stdout, "\n[RESULT] Page Access Profile (pid %d, 0x%lx, %lu pages of %zu B, %u intervals)\n",
+           (int)profile->pid, (unsigned long)profile->start, profile->num_pages, profile->page_size,
+           profile->num_intervals);
+    fprintf(stdout, "  Resident: %lu, Hot: %lu (>= %u intervals), Cold: %lu, Unmapped: %lu\n",
+           resident, profile->num_hot, profile->hot_threshold, profile->num_cold, profile->num_unmapped);
+    
+    fprintf(stdout, "\n  %-10s  %10s  %8s\n", "Frequency", "Pages", "Share");
+    for (uint32_t f = 0; f <= profile->num_intervals; f++) {
+        if (profile->freq_hist[f] == 0) continue;
+        fprintf(stdout, "  %4u/%-5u  %10lu  %7.2f%%\n", f, profile->num_intervals, profile->freq_hist[f],
+               100.0 * (double)profile->freq_hist[f] / (double)resident);
+    }
+    
+    if (cxl_node < 0) return;
+    
+    /* 分层建议：CXL 上的热页应提升，普通内存上的冷页可以降级 */
+    uint64_t hot_on_cxl = 0, cold_on_normal = 0;
+    for (uint64_t i = 0; i < profile->num_pages; i++) {
+        page_class_t page_class = cxl_profile_page_class(profile, i);
+        if (profile->nodes[i] < 0) continue;
+        
+        if (page_class == PAGE_CLASS_HOT && profile->nodes[i] == cxl_node) hot_on_cxl++;
+        if (page_class == PAGE_CLASS_COLD && profile->nodes[i] != cxl_node) cold_on_normal++;
+    }
+    
+    fprintf(stdout, "\n  Promotion candidates (hot on CXL node %d):  %lu pages (%.1f MiB)\n", cxl_node,
+           hot_on_cxl, (double)(hot_on_cxl * profile->page_size) / (1024.0 * 1024.0));
+    fprintf(stdout, "  Demotion candidates (cold on other nodes):  %lu pages (%.1f MiB)\n",
+           cold_on_normal, (double)(cold_on_normal * profile->page_size) / (1024.0 * 1024.0));
+}
+
+int cxl_profile_export_csv(const page_profile_t *profile, const char *filepath) {
+    if (!profile || !profile->counts || !filepath) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    FILE *csv = fopen(filepath, "w");
+    if (!csv) {
+        fprintf(stderr, "[ERROR] Failed to open %s: %s\n", filepath, strerror(errno));
+        return -1;
+    }
+    
+    fprintf(csv, "page,address,frequency,intervals,class,node\n");
+    for (uint64_t i = 0; i < profile->num_pages; i++) {
+        fprintf(csv, "%lu,0x%lx,%u,%u,%s,%d\n", i,
+               (unsigned long)(profile->start + i * profile->page_size), profile->counts[i],
+               profile->num_intervals, cxl_profile_class_name(cxl_profile_page_class(profile, i)),
+               profile->nodes[i]);
+    }
+    fclose(csv);
+    
+    return 0;
+}
+
+void cxl_profile_free(page_profile_t *profile) {
+    if (!profile) return;
+    
+    free(profile->counts);
+    free(profile->present);
+    free(profile->nodes);
+    profile->counts = NULL;
+    profile->present = NULL;
+    profile->nodes = NULL;
+}
@@ -0,0 +1,215 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <numa.h>
+#include "cxl_runner.h"
+#include "cxl_benchmark.h"
+#include "cxl_common.h"
+
+/* ====== 共享调度状态 ====== */
+typedef struct {
+    const runner_params_t *params;
+    int next_round;             /* 原子领取的下一轮次编号 */
+} runner_shared_t;
+
+typedef struct {
+    runner_worker_t worker;
+    runner_shared_t *shared;
+} __attribute__((aligned(CXL_CACHE_LINE_SIZE))) runner_slot_t;
+
+static double runner_now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* ====== 工作线程 ====== */
+static void runner_worker_release(runner_worker_t *worker) {
+    cxl_perf_close(&worker->perf);
+    for (int h = 0; h < worker->num_hists; h++) {
+        if (worker->hists[h]) {
+            cxl_free(worker->hists[h], sizeof(cxl_histogram_t));
+            worker->hists[h] = NULL;
+        }
+    }
+    if (worker->scratch) {
+        cxl_free(worker->scratch, worker->scratch_size);
+        worker->scratch = NULL;
+    }
+}
+
+static void *runner_worker_main(void *arg) {
+    runner_slot_t *slot = (runner_slot_t *)arg;
+    runner_worker_t *worker = &slot->worker;
+    const runner_params_t *params = slot->shared->params;
+    
+    worker->status = -1;
+    
+    if (cxl_bind_to_cpu(worker->cpu) < 0) {
+        return NULL;
+    }
+    
+    /* 计数器组只计本线程，必须在绑核后的工作线程里打开 */
+    cxl_perf_open(&worker->perf);
+    
+    /* 绑核之后再分配，首次访问也发生在本地节点上 */
+    if (worker->scratch_size > 0) {
+        worker->scratch = cxl_malloc_on_node(worker->scratch_size, worker->node);
+        if (!worker->scratch) return NULL;
+        memset(worker->scratch, 0, worker->scratch_size);
+    }
+    
+    for (int h = 0; h < worker->num_hists; h++) {
+        worker->hists[h] = cxl_malloc_on_node(sizeof(cxl_histogram_t), worker->node);
+        if (!worker->hists[h]) return NULL;
+        cxl_histogram_init(worker->hists[h]);
+    }
+    
+    worker->status = 0;
+    
+    while (1) {
+        int round = __atomic_fetch_add(&slot->shared->next_round, 1, __ATOMIC_RELAXED);
+        if (round >= params->num_rounds) break;
+        
+        if (params->round_fn(worker, round, params->arg) < 0) {
+            worker->rounds_failed++;
+        } else {
+            worker->rounds_done++;
+        }
+    }
+    
+    return NULL;
+}
+
+/* ====== 运行 ====== */
+int cxl_runner_run(const runner_params_t *params, runner_result_t *result) {
+    if (!params || !result || !params->round_fn || params->num_rounds <= 0 ||
+        params->num_workers <= 0 || params->num_hists < 0 ||
+        params->num_hists > CXL_RUNNER_MAX_HISTS) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    memset(result, 0, sizeof(runner_result_t));
+    
+    int num_workers = params->num_workers;
+    if (num_workers > params->num_rounds) num_workers = params->num_rounds;
+    if (num_workers > CXL_MAX_THREADS) num_workers = CXL_MAX_THREADS;
+    
+    /* 每个工作线程独占一个 CPU，超额订阅会让计时轮次互相抢占 */
+    int available;
+    if (params->cpus && params->num_cpus > 0) {
+        available = (params->num_cpus < num_workers) ? params->num_cpus : num_workers;
+        memcpy(result->cpus, params->cpus, (size_t)available * sizeof(int));
+    } else {
+        available = cxl_bench_select_cpus(params->cpu_node, result->cpus, num_workers);
+    }
+    if (available <= 0) {
+        fprintf(stderr, "[ERROR] No CPUs available for runner\n");
+        return -1;
+    }
+    if (available < num_workers) {
+        fprintf(stderr, "[WARNING] Only %d CPUs available, using %d workers instead of %d\n",
+                available, available, num_workers);
+        num_workers = available;
+    }
+    
+    runner_slot_t *slots = calloc((size_t)num_workers, sizeof(runner_slot_t));
+    pthread_t threads[CXL_MAX_THREADS];
+    runner_shared_t shared = { .params = params, .next_round = 0 };
+    
+    if (!slots) {
+        fprintf(stderr, "[ERROR] Failed to allocate runner workers\n");
+        return -1;
+    }
+    
+    result->num_hists = params->num_hists;
+    for (int h = 0; h < params->num_hists; h++) {
+        result->hists[h] = cxl_histogram_create();
+        if (!result->hists[h]) {
+            cxl_runner_result_free(result);
+            free(slots);
+            return -1;
+        }
+    }
+    
+    double start = runner_now_seconds();
+    
+    int created = 0;
+    for (int t = 0; t < num_workers; t++) {
+        runner_worker_t *worker = &slots[t].worker;
+        worker->id = t;
+        worker->cpu = result->cpus[t];
+        worker->node = numa_node_of_cpu(worker->cpu);
+        worker->scratch_size = params->scratch_size;
+        worker->num_hists = params->num_hists;
+        slots[t].shared = &shared;
+        
+        if (pthread_create(&threads[t], NULL, runner_worker_main, &slots[t]) != 0) {
+            fprintf(stderr, "[ERROR] Failed to create runner worker %d\n", t);
+            break;
+        }
+        created++;
+    }
+    
+    for (int t = 0; t < created; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    
+    result->seconds = runner_now_seconds() - start;
+    result->num_workers = created;
+    
+    /* 合并各线程的累加器 */
+    int failed_workers = 0;
+    for (int t = 0; t < created; t++) {
+        runner_worker_t *worker = &slots[t].worker;
+        
+        if (worker->status < 0) {
+            fprintf(stderr, "[ERROR] Runner worker %d failed to start on CPU %d\n", t, worker->cpu);
+            failed_workers++;
+        }
+        
+        result->rounds_done += worker->rounds_done;
+        result->rounds_failed += worker->rounds_failed;
+        for (int h = 0; h < worker->num_hists; h++) {
+            if (worker->hists[h]) {
+                cxl_histogram_merge(result->hists[h], worker->hists[h]);
+            }
+        }
+        
+        runner_worker_release(worker);
+    }
+    
+    free(slots);
+    
+    if (created == 0 || failed_workers == created) {
+        cxl_runner_result_free(result);
+        return -1;
+    }
+    
+    return 0;
+}
+
+void cxl_runner_result_free(runner_result_t *result) {
+    if (!result) return;
+    
+    for (int h = 0; h < CXL_RUNNER_MAX_HISTS; h++) {
+        cxl_histogram_destroy(result->hists[h]);
+        result->hists[h] = NULL;
+    }
+}
+
+void cxl_runner_print_summary(const runner_result_t *result) {
+    if (!result) return;
+    
+    fprintf(stdout, "  Workers:  %d (CPUs", result->num_workers);
+    for (int t = 0; t < result->num_workers; t++) {
+        fprintf(stdout, "%s%d", t == 0 ? " " : ",", result->cpus[t]);
+    }
+    fprintf(stdout, ")\n");
+    fprintf(stdout, "  Rounds:   %lu completed, %lu failed\n", result->rounds_done, result->rounds_failed);
+    fprintf(stdout, "  Elapsed:  %.3f s\n", result->seconds);
+}
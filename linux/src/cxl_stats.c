@@ -0,0 +1,286 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <immintrin.h>
+#include "cxl_stats.h"
+#include "cxl_common.h"
+
+/* 低于 2^52 的整数与 2^52 的位模式按位或后即为 2^52 + x 的双精度表示 */
+#define STATS_EXACT_LIMIT       (1ULL << 52)
+#define STATS_MAGIC_BITS        0x4330000000000000ULL
+#define STATS_MAGIC_DOUBLE      4503599627370496.0
+
+/* ====== 块结果 ====== */
+typedef struct {
+    uint64_t min;
+    uint64_t max;
+    double mean;
+    double m2;
+} stats_block_t;
+
+/* ====== 标量实现 ====== */
+static void stats_block_scalar(const uint64_t *x, size_t n, stats_block_t *out) {
+    uint64_t min = x[0], max = x[0];
+    double shift = (double)x[0];
+    double sum = 0.0;
+    
+    /* 以首个样本为偏移累加，避免大数求和时丢失精度 */
+    for (size_t i = 0; i < n; i++) {
+        if (x[i] < min) min = x[i];
+        if (x[i] > max) max = x[i];
+        sum += (double)x[i] - shift;
+    }
+    
+    double mean = shift + sum / (double)n;
+    double m2 = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double d = (double)x[i] - mean;
+        m2 += d * d;
+    }
+    
+    out->min = min;
+    out->max = max;
+    out->mean = mean;
+    out->m2 = m2;
+}
+
+/* ====== AVX2 实现 ====== */
+__attribute__((target("avx2")))
+static void stats_block_avx2(const uint64_t *x, size_t n, stats_block_t *out) {
+    /* AVX2 只有有符号 64 位比较，翻转符号位后比较无符号数 */
+    const __m256i bias = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    __m256i vmin = _mm256_set1_epi64x(0x7fffffffffffffffLL);
+    __m256i vmax = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    __m256i vsum = _mm256_setzero_si256();
+    size_t i = 0;
+    
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(x + i));
+        __m256i vb = _mm256_xor_si256(v, bias);
+        vmin = _mm256_blendv_epi8(vmin, vb, _mm256_cmpgt_epi64(vmin, vb));
+        vmax = _mm256_blendv_epi8(vmax, vb, _mm256_cmpgt_epi64(vb, vmax));
+        vsum = _mm256_add_epi64(vsum, v);
+    }
+    
+    uint64_t lanes_min[4], lanes_max[4], lanes_sum[4];
+    _mm256_storeu_si256((__m256i *)lanes_min, _mm256_xor_si256(vmin, bias));
+    _mm256_storeu_si256((__m256i *)lanes_max, _mm256_xor_si256(vmax, bias));
+    _mm256_storeu_si256((__m256i *)lanes_sum, vsum);
+    
+    uint64_t min = UINT64_MAX, max = 0, sum = 0;
+    for (int l = 0; l < 4; l++) {
+        if (lanes_min[l] < min) min = lanes_min[l];
+        if (lanes_max[l] > max) max = lanes_max[l];
+        sum += lanes_sum[l];
+    }
+    for (size_t j = i; j < n; j++) {
+        if (x[j] < min) min = x[j];
+        if (x[j] > max) max = x[j];
+        sum += x[j];
+    }
+    
+    if (max >= STATS_EXACT_LIMIT) {
+        stats_block_scalar(x, n, out);
+        return;
+    }
+    
+    double mean = (double)sum / (double)n;
+    const __m256i magic_bits = _mm256_set1_epi64x((long long)STATS_MAGIC_BITS);
+    const __m256d magic = _mm256_set1_pd(STATS_MAGIC_DOUBLE);
+    const __m256d vmean = _mm256_set1_pd(mean);
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    
+    i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(x + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(x + i + 4));
+        __m256d d0 = _mm256_sub_pd(_mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(v0, magic_bits)), magic), vmean);
+        __m256d d1 = _mm256_sub_pd(_mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(v1, magic_bits)), magic), vmean);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(d0, d0));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(d1, d1));
+    }
+    
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    double m2 = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < n; i++) {
+        double d = (double)x[i] - mean;
+        m2 += d * d;
+    }
+    
+    out->min = min;
+    out->max = max;
+    out->mean = mean;
+    out->m2 = m2;
+}
+
+/* ====== AVX-512 实现 ====== */
+__attribute__((target("avx512f")))
+static void stats_block_avx512(const uint64_t *x, size_t n, stats_block_t *out) {
+    __m512i vmin = _mm512_set1_epi64(-1);
+    __m512i vmax = _mm512_setzero_si512();
+    __m512i vsum = _mm512_setzero_si512();
+    size_t i = 0;
+    
+    for (; i + 8 <= n; i += 8) {
+        __m512i v = _mm512_loadu_si512((const void *)(x + i));
+        vmin = _mm512_min_epu64(vmin, v);
+        vmax = _mm512_max_epu64(vmax, v);
+        vsum = _mm512_add_epi64(vsum, v);
+    }
+    
+    uint64_t min = (uint64_t)_mm512_reduce_min_epu64(vmin);
+    uint64_t max = (uint64_t)_mm512_reduce_max_epu64(vmax);
+    uint64_t sum = (uint64_t)_mm512_reduce_add_epi64(vsum);
+    for (size_t j = i; j < n; j++) {
+        if (x[j] < min) min = x[j];
+        if (x[j] > max) max = x[j];
+        sum += x[j];
+    }
+    
+    if (max >= STATS_EXACT_LIMIT) {
+        stats_block_scalar(x, n, out);
+        return;
+    }
+    
+    double mean = (double)sum / (double)n;
+    const __m512i magic_bits = _mm512_set1_epi64((long long)STATS_MAGIC_BITS);
+    const __m512d magic = _mm512_set1_pd(STATS_MAGIC_DOUBLE);
+    const __m512d vmean = _mm512_set1_pd(mean);
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    
+    i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v0 = _mm512_loadu_si512((const void *)(x + i));
+        __m512i v1 = _mm512_loadu_si512((const void *)(x + i + 8));
+        __m512d d0 = _mm512_sub_pd(_mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(v0, magic_bits)), magic), vmean);
+        __m512d d1 = _mm512_sub_pd(_mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(v1, magic_bits)), magic), vmean);
+        acc0 = _mm512_fmadd_pd(d0, d0, acc0);
+        acc1 = _mm512_fmadd_pd(d1, d1, acc1);
+    }
+    
+    double m2 = _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+    for (; i < n; i++) {
+        double d = (double)x[i] - mean;
+        m2 += d * d;
+    }
+    
+    out->min = min;
+    out->max = max;
+    out->mean = mean;
+    out->m2 = m2;
+}
+
+/* ====== 运行时 SIMD 分派 ====== */
+static struct {
+    const char *name;
+    void (*block)(const uint64_t *x, size_t n, stats_block_t *out);
+} stats_dispatch = {0};
+
+static pthread_once_t stats_dispatch_once = PTHREAD_ONCE_INIT;
+
+static void stats_select_kernel(void) {
+    __builtin_cpu_init();
+    
+    if (__builtin_cpu_supports("avx512f")) {
+        stats_dispatch.name = "avx512";
+        stats_dispatch.block = stats_block_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        stats_dispatch.name = "avx2";
+        stats_dispatch.block = stats_block_avx2;
+    } else {
+        stats_dispatch.name = "scalar";
+        stats_dispatch.block = stats_block_scalar;
+    }
+}
+
+const char *cxl_stats_simd_level(void) {
+    pthread_once(&stats_dispatch_once, stats_select_kernel);
+    return stats_dispatch.name;
+}
+
+/* ====== 累加与合并 ====== */
+void cxl_stats_init(cxl_stats_t *stats) {
+    if (!stats) return;
+    
+    memset(stats, 0, sizeof(cxl_stats_t));
+    stats->min = UINT64_MAX;
+}
+
+/* Chan 等人的并行方差合并公式 */
+static void stats_combine(cxl_stats_t *dst, uint64_t count, uint64_t min, uint64_t max,
+                          double mean, double m2) {
+    if (count == 0) return;
+    
+    if (dst->count == 0) {
+        dst->count = count;
+        dst->min = min;
+        dst->max = max;
+        dst->mean = mean;
+        dst->m2 = m2;
+        return;
+    }
+    
+    double n_a = (double)dst->count;
+    double n_b = (double)count;
+    double n = n_a + n_b;
+    double delta = mean - dst->mean;
+    
+    dst->mean += delta * (n_b / n);
+    dst->m2 += m2 + delta * delta * (n_a * n_b / n);
+    dst->count += count;
+    if (min < dst->min) dst->min = min;
+    if (max > dst->max) dst->max = max;
+}
+
+void cxl_stats_update(cxl_stats_t *stats, const uint64_t *samples, size_t num_samples) {
+    if (!stats || !samples || num_samples == 0) return;
+    
+    pthread_once(&stats_dispatch_once, stats_select_kernel);
+    
+    for (size_t i = 0; i < num_samples; i += CXL_STATS_BLOCK_SAMPLES) {
+        size_t n = num_samples - i;
+        if (n > CXL_STATS_BLOCK_SAMPLES) n = CXL_STATS_BLOCK_SAMPLES;
+        
+        stats_block_t block;
+        stats_dispatch.block(samples + i, n, &block);
+        stats_combine(stats, n, block.min, block.max, block.mean, block.m2);
+    }
+}
+
+void cxl_stats_merge(cxl_stats_t *dst, const cxl_stats_t *src) {
+    if (!dst || !src) return;
+    
+    stats_combine(dst, src->count, src->min, src->max, src->mean, src->m2);
+}
+
+int cxl_stats_compute(const uint64_t *samples, size_t num_samples, cxl_stats_t *stats) {
+    if (!samples || num_samples == 0 || !stats) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    cxl_stats_init(stats);
+    cxl_stats_update(stats, samples, num_samples);
+    
+    return 0;
+}
+
+double cxl_stats_variance(const cxl_stats_t *stats) {
+    if (!stats || stats->count == 0) return 0.0;
+    
+    return stats->m2 / (double)stats->count;
+}
+
+double cxl_stats_sample_variance(const cxl_stats_t *stats) {
+    if (!stats || stats->count < 2) return 0.0;
+    
+    return stats->m2 / (double)(stats->count - 1);
+}
+
+double cxl_stats_stddev(const cxl_stats_t *stats) {
+    return sqrt(cxl_stats_variance(stats));
+}
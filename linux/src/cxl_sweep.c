@@ -0,0 +1,664 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <sched.h>
+#include <numa.h>
+#include "cxl_sweep.h"
+#include "cxl_benchmark.h"
+#include "cxl_tsc.h"
+#include "cxl_attack_primitives.h"
+#include "cxl_common.h"
+
+/* ====== 名称 ====== */
+static const char *sweep_placement_names[] = {"cross_core", "different_thread", "same_thread"};
+static const char *sweep_data_names[] = {"normal", "cxl", "local", "node"};
+
+const char *cxl_sweep_placement_name(thread_placement_t placement) {
+    if (placement < CROSS_CORE || placement > SAME_THREAD) return "unknown";
+    return sweep_placement_names[placement];
+}
+
+const char *cxl_sweep_data_name(sweep_data_kind_t kind) {
+    if (kind < SWEEP_DATA_NORMAL || kind > SWEEP_DATA_NODE) return "unknown";
+    return sweep_data_names[kind];
+}
+
+/* ====== 默认矩阵 ====== */
+void cxl_sweep_matrix_default(sweep_matrix_t *matrix, const cxl_config_t *config,
+                              size_t max_working_set) {
+    if (!matrix) return;
+    
+    memset(matrix, 0, sizeof(sweep_matrix_t));
+    
+    matrix->thread_placements[matrix->num_thread_placements++] = SAME_THREAD;
+    
+    matrix->data[matrix->num_data++].kind = SWEEP_DATA_NORMAL;
+    if (config && config->numa_node_cxl >= 0 && config->numa_node_cxl != config->numa_node_normal) {
+        matrix->data[matrix->num_data++].kind = SWEEP_DATA_CXL;
+    }
+    
+    int cpu = 0;
+    if (cxl_bench_select_cpus(config ? config->numa_node_normal : -1, &cpu, 1) <= 0) {
+        cpu = 0;
+    }
+    matrix->cpus[matrix->num_cpus++] = cpu;
+    
+    for (size_t ws = CXL_BENCH_MIN_WORKING_SET;
+         ws <= max_working_set && matrix->num_working_sets < CXL_SWEEP_MAX_VALUES; ws *= 4) {
+        matrix->working_sets[matrix->num_working_sets++] = ws;
+    }
+    
+    matrix->strides[matrix->num_strides++] = CXL_CACHE_LINE_SIZE;
+    matrix->num_loads = CXL_SWEEP_DEFAULT_LOADS;
+}
+
+/* ====== 矩阵文件解析 ====== */
+static char *sweep_trim(char *str) {
+    while (isspace((unsigned char)*str)) str++;
+    
+    char *end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    
+    return str;
+}
+
+/* 带 K/M/G 后缀的大小，整个字符串必须被消耗 */
+static int sweep_parse_size(const char *str, size_t *value) {
+    char *end = NULL;
+    unsigned long long v = strtoull(str, &end, 10);
+    
+    if (end == str) return -1;
+    
+    switch (*end) {
+        case 'G': case 'g': v <<= 30; end++; break;
+        case 'M': case 'm': v <<= 20; end++; break;
+        case 'K': case 'k': v <<= 10; end++; break;
+        default: break;
+    }
+    
+    if (*end != '\0') return -1;
+    
+    *value = (size_t)v;
+    return 0;
+}
+
+/* 整数或 "lo-hi" 闭区间 */
+static int sweep_parse_range(const char *str, int *lo, int *hi) {
+    char *end = NULL;
+    long a = strtol(str, &end, 10);
+    
+    if (end == str || a < 0) return -1;
+    
+    long b = a;
+    if (*end == '-') {
+        const char *p = end + 1;
+        b = strtol(p, &end, 10);
+        if (end == p || b < a) return -1;
+    }
+    
+    if (*end != '\0') return -1;
+    
+    *lo = (int)a;
+    *hi = (int)b;
+    return 0;
+}
+
+static int sweep_parse_value(sweep_matrix_t *matrix, const char *key, char *value) {
+    if (strcmp(key, "thread_placement") == 0) {
+        for (int p = CROSS_CORE; p <= SAME_THREAD; p++) {
+            if (strcmp(value, sweep_placement_names[p]) == 0) {
+                if (matrix->num_thread_placements >= CXL_SWEEP_MAX_VALUES) return -1;
+                matrix->thread_placements[matrix->num_thread_placements++] = (thread_placement_t)p;
+                return 0;
+            }
+        }
+        return -1;
+    }
+    
+    if (strcmp(key, "data_placement") == 0 || strcmp(key, "nodes") == 0) {
+        for (int k = SWEEP_DATA_NORMAL; k < SWEEP_DATA_NODE; k++) {
+            if (strcmp(value, sweep_data_names[k]) == 0) {
+                if (matrix->num_data >= CXL_SWEEP_MAX_VALUES) return -1;
+                matrix->data[matrix->num_data].kind = (sweep_data_kind_t)k;
+                matrix->data[matrix->num_data++].node = -1;
+                return 0;
+            }
+        }
+        
+        int lo, hi;
+        if (sweep_parse_range(value, &lo, &hi) < 0) return -1;
+        for (int node = lo; node <= hi; node++) {
+            if (matrix->num_data >= CXL_SWEEP_MAX_VALUES) return -1;
+            matrix->data[matrix->num_data].kind = SWEEP_DATA_NODE;
+            matrix->data[matrix->num_data++].node = node;
+        }
+        return 0;
+    }
+    
+    if (strcmp(key, "cpus") == 0) {
+        int lo, hi;
+        if (sweep_parse_range(value, &lo, &hi) < 0) return -1;
+        for (int cpu = lo; cpu <= hi; cpu++) {
+            if (matrix->num_cpus >= CXL_SWEEP_MAX_VALUES || cpu >= CXL_MAX_CORES) return -1;
+            matrix->cpus[matrix->num_cpus++] = cpu;
+        }
+        return 0;
+    }
+    
+    if (strcmp(key, "working_sets") == 0) {
+        size_t lo, hi;
+        char *dots = strstr(value, "..");
+        
+        if (dots) {
+            *dots = '\0';
+            if (sweep_parse_size(sweep_trim(value), &lo) < 0 ||
+                sweep_parse_size(sweep_trim(dots + 2), &hi) < 0 || lo == 0 || hi < lo) {
+                return -1;
+            }
+        } else {
+            if (sweep_parse_size(value, &lo) < 0 || lo == 0) return -1;
+            hi = lo;
+        }
+        
+        for (size_t ws = lo; ws <= hi; ws *= 2) {
+            if (matrix->num_working_sets >= CXL_SWEEP_MAX_VALUES) return -1;
+            matrix->working_sets[matrix->num_working_sets++] = ws;
+        }
+        return 0;
+    }
+    
+    if (strcmp(key, "strides") == 0) {
+        size_t stride;
+        if (sweep_parse_size(value, &stride) < 0 || stride < sizeof(uint64_t) ||
+            stride % sizeof(uint64_t) != 0 || matrix->num_strides >= CXL_SWEEP_MAX_VALUES) {
+            return -1;
+        }
+        matrix->strides[matrix->num_strides++] = stride;
+        return 0;
+    }
+    
+    if (strcmp(key, "loads") == 0) {
+        size_t loads;
+        if (sweep_parse_size(value, &loads) < 0 || loads == 0) return -1;
+        matrix->num_loads = (uint64_t)loads;
+        return 0;
+    }
+    
+    return -1;
+}
+
+/* 文件中出现的键整体替换默认值；data_placement 与 nodes 共用一个维度 */
+static void sweep_reset_key(sweep_matrix_t *matrix, const char *key, unsigned int *seen) {
+    unsigned int bit = 0;
+    
+    if (strcmp(key, "thread_placement") == 0) bit = 1u << 0;
+    else if (strcmp(key, "data_placement") == 0 || strcmp(key, "nodes") == 0) bit = 1u << 1;
+    else if (strcmp(key, "cpus") == 0) bit = 1u << 2;
+    else if (strcmp(key, "working_sets") == 0) bit = 1u << 3;
+    else if (strcmp(key, "strides") == 0) bit = 1u << 4;
+    
+    if (bit == 0 || (*seen & bit)) return;
+    *seen |= bit;
+    
+    switch (bit) {
+        case 1u << 0: matrix->num_thread_placements = 0; break;
+        case 1u << 1: matrix->num_data = 0; break;
+        case 1u << 2: matrix->num_cpus = 0; break;
+        case 1u << 3: matrix->num_working_sets = 0; break;
+        case 1u << 4: matrix->num_strides = 0; break;
+        default: break;
+    }
+}
+
+int cxl_sweep_load_matrix(const char *path, sweep_matrix_t *matrix) {
+    if (!path || !matrix) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "[ERROR] Failed to open sweep matrix: %s\n", path);
+        return -1;
+    }
+    
+    char line[CXL_SWEEP_LINE_MAX];
+    unsigned int seen = 0;
+    int line_no = 0;
+    int ret = 0;
+    
+    while (fgets(line, sizeof(line), file)) {
+        line_no++;
+        
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+        
+        char *text = sweep_trim(line);
+        if (*text == '\0') continue;
+        
+        char *eq = strchr(text, '=');
+        if (!eq) {
+            fprintf(stderr, "[ERROR] %s:%d: expected 'key = value'\n", path, line_no);
+            ret = -1;
+            break;
+        }
+        
+        *eq = '\0';
+        char *key = sweep_trim(text);
+        sweep_reset_key(matrix, key, &seen);
+        
+        char *saveptr = NULL;
+        for (char *tok = strtok_r(eq + 1, ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr)) {
+            char *value = sweep_trim(tok);
+            if (*value == '\0') continue;
+            
+            if (sweep_parse_value(matrix, key, value) < 0) {
+                fprintf(stderr, "[ERROR] %s:%d: invalid value '%s' for '%s'\n", path, line_no, value, key);
+                ret = -1;
+                break;
+            }
+        }
+        if (ret < 0) break;
+    }
+    
+    fclose(file);
+    
+    if (ret == 0 && cxl_sweep_num_cells(matrix) == 0) {
+        fprintf(stderr, "[ERROR] %s: sweep matrix has an empty dimension\n", path);
+        ret = -1;
+    }
+    
+    return ret;
+}
+
+int cxl_sweep_num_cells(const sweep_matrix_t *matrix) {
+    if (!matrix) return 0;
+    
+    return matrix->num_thread_placements * matrix->num_data * matrix->num_cpus *
+           matrix->num_working_sets * matrix->num_strides;
+}
+
+void cxl_sweep_print_matrix(const sweep_matrix_t *matrix) {
+    if (!matrix) return;
+    
+    fprintf(stdout, "Sweep Matrix (%d cells):\n", cxl_sweep_num_cells(matrix));
+    
+    fprintf(stdout, "  Thread Placement: ");
+    for (int i = 0; i < matrix->num_thread_placements; i++) {
+        fprintf(stdout, "%s%s", i ? ", " : "", cxl_sweep_placement_name(matrix->thread_placements[i]));
+    }
+    
+    fprintf(stdout, "\n  Data:             ");
+    for (int i = 0; i < matrix->num_data; i++) {
+        if (matrix->data[i].kind == SWEEP_DATA_NODE) {
+            fprintf(stdout, "%snode %d", i ? ", " : "", matrix->data[i].node);
+        } else {
+            fprintf(stdout, "%s%s", i ? ", " : "", cxl_sweep_data_name(matrix->data[i].kind));
+        }
+    }
+    
+    fprintf(stdout, "\n  CPUs:             ");
+    for (int i = 0; i < matrix->num_cpus; i++) {
+        fprintf(stdout, "%s%d", i ? ", " : "", matrix->cpus[i]);
+    }
+    
+    fprintf(stdout, "\n  Working Sets:     ");
+    for (int i = 0; i < matrix->num_working_sets; i++) {
+        fprintf(stdout, "%s%zu KiB", i ? ", " : "", matrix->working_sets[i] >> 10);
+    }
+    
+    fprintf(stdout, "\n  Strides:          ");
+    for (int i = 0; i < matrix->num_strides; i++) {
+        fprintf(stdout, "%s%zu", i ? ", " : "", matrix->strides[i]);
+    }
+    
+    fprintf(stdout, "\n  Loads per Cell:   %lu\n", matrix->num_loads);
+    fprintf(stdout, "  Cache Reset:      %s over each cell's working set before measuring\n",
+           cxl_flush_insn_name(cxl_flush_insn()));
+}
+
+/* ====== CPU 与节点解析 ====== */
+static void sweep_read_siblings(int cpu, cpu_set_t *siblings) {
+    char path[128];
+    char list[256];
+    
+    CPU_ZERO(siblings);
+    CPU_SET(cpu, siblings);
+    
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+    FILE *file = fopen(path, "r");
+    if (!file) return;
+    
+    if (fgets(list, sizeof(list), file)) {
+        char *saveptr = NULL;
+        for (char *tok = strtok_r(list, ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr)) {
+            int lo, hi;
+            if (sweep_parse_range(sweep_trim(tok), &lo, &hi) < 0) continue;
+            for (int c = lo; c <= hi && c < CPU_SETSIZE; c++) {
+                CPU_SET(c, siblings);
+            }
+        }
+    }
+    
+    fclose(file);
+}
+
+static int sweep_probe_cpu(thread_placement_t placement, int cpu, const cpu_set_t *allowed) {
+    cpu_set_t siblings;
+    
+    if (placement == SAME_THREAD) {
+        return cpu;
+    }
+    
+    sweep_read_siblings(cpu, &siblings);
+    
+    if (placement == DIFFERENT_THREAD) {
+        for (int c = 0; c < CXL_MAX_CORES; c++) {
+            if (c != cpu && CPU_ISSET(c, &siblings) && CPU_ISSET(c, allowed)) return c;
+        }
+        return -1;
+    }
+    
+    /* CROSS_CORE：先在同一节点上找另一个物理核心，找不到再放宽到任意节点 */
+    int node = numa_node_of_cpu(cpu);
+    for (int pass = 0; pass < 2; pass++) {
+        for (int c = 0; c < CXL_MAX_CORES; c++) {
+            if (CPU_ISSET(c, &siblings) || !CPU_ISSET(c, allowed)) continue;
+            if (pass == 0 && numa_node_of_cpu(c) != node) continue;
+            return c;
+        }
+    }
+    
+    return -1;
+}
+
+static int sweep_resolve_node(const sweep_data_t *data, int cpu, const cxl_config_t *config) {
+    int node;
+    
+    switch (data->kind) {
+        case SWEEP_DATA_NORMAL: node = config->numa_node_normal; break;
+        case SWEEP_DATA_CXL:    node = config->numa_node_cxl; break;
+        case SWEEP_DATA_LOCAL:  node = numa_node_of_cpu(cpu); break;
+        default:                node = data->node; break;
+    }
+    
+    if (node < 0 || node > numa_max_node()) return -1;
+    
+    return node;
+}
+
+/* ====== 单元测量 ====== */
+static int sweep_measure(sweep_cell_t *cell, void *head, uint64_t num_loads) {
+    uint64_t chain = cell->working_set / cell->stride;
+    uint64_t pass = (chain < num_loads) ? chain : num_loads;
+    chase_result_t owner, first, steady;
+    cxl_perf_counts_t perf_start, perf_mid, perf_end;
+    cxl_perf_t perf;
+    
+    /* 所有者遍历一遍，把链表留在自己的缓存中（超出缓存的部分留在内存） */
+    if (cxl_bind_to_cpu(cell->cpu) < 0) return -1;
+    if (cxl_chase_run(head, pass, &owner) < 0) return -1;
+    
+    if (cell->probe_cpu != cell->cpu && cxl_bind_to_cpu(cell->probe_cpu) < 0) return -1;
+    
+    /* 计数器在探测线程绑核后打开，分别包围首轮与稳态两段计时 */
+    cxl_perf_open(&perf);
+    cxl_perf_read(&perf, &perf_start);
+    int ret = cxl_chase_run(head, pass, &first);
+    cxl_perf_read(&perf, &perf_mid);
+    if (ret == 0) ret = cxl_chase_run(head, num_loads, &steady);
+    cxl_perf_read(&perf, &perf_end);
+    cxl_perf_close(&perf);
+    if (ret < 0) return -1;
+    
+    cxl_perf_diff(&perf_mid, &perf_start, &cell->first_pass_perf);
+    cxl_perf_diff(&perf_end, &perf_mid, &cell->perf);
+    cell->num_loads = steady.num_loads;
+    cell->first_pass_ns = first.ns_per_load;
+    cell->ns_per_load = steady.ns_per_load;
+    cell->cycles_per_load = steady.cycles_per_load;
+    
+    return 0;
+}
+
+/* ====== 扫描 ====== */
+int cxl_sweep_run(const sweep_matrix_t *matrix, const cxl_config_t *config,
+                  sweep_cell_t *cells, int max_cells) {
+    int total = cxl_sweep_num_cells(matrix);
+    
+    if (!matrix || !config || !cells || total <= 0 || total > max_cells || matrix->num_loads == 0) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    cpu_set_t saved;
+    if (sched_getaffinity(0, sizeof(saved), &saved) < 0) {
+        fprintf(stderr, "[ERROR] Failed to get CPU affinity\n");
+        return -1;
+    }
+    
+    uint8_t *pending = calloc((size_t)total, 1);
+    if (!pending) {
+        fprintf(stderr, "[ERROR] Failed to allocate sweep state\n");
+        return -1;
+    }
+    
+    /* 按笛卡尔积顺序展开单元，先解析数据节点与探测 CPU */
+    int unavailable = 0;
+    int idx = 0;
+    for (int t = 0; t < matrix->num_thread_placements; t++) {
+        for (int d = 0; d < matrix->num_data; d++) {
+            for (int c = 0; c < matrix->num_cpus; c++) {
+                for (int w = 0; w < matrix->num_working_sets; w++) {
+                    for (int s = 0; s < matrix->num_strides; s++, idx++) {
+                        sweep_cell_t *cell = &cells[idx];
+                        int cpu = matrix->cpus[c];
+                        
+                        memset(cell, 0, sizeof(sweep_cell_t));
+                        cell->index = (uint32_t)idx;
+                        cell->thread_placement = matrix->thread_placements[t];
+                        cell->data_kind = matrix->data[d].kind;
+                        cell->cpu = cpu;
+                        cell->working_set = matrix->working_sets[w];
+                        cell->stride = matrix->strides[s];
+                        cell->status = -1;
+                        cell->cache_reset = -1;
+                        
+                        if (cpu >= CXL_MAX_CORES || !CPU_ISSET(cpu, &saved)) {
+                            cell->node = -1;
+                            cell->probe_cpu = -1;
+                        } else {
+                            cell->node = sweep_resolve_node(&matrix->data[d], cpu, config);
+                            cell->probe_cpu = sweep_probe_cpu(matrix->thread_placements[t], cpu, &saved);
+                        }
+                        
+                        if (cell->node < 0 || cell->probe_cpu < 0 ||
+                            cell->working_set < 2 * cell->stride) {
+                            unavailable++;
+                        } else {
+                            pending[idx] = 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    /* 按数据节点分组：每个节点分配一次缓冲区，每个（工作集，步长）只构造一次链表 */
+    int measured = 0, too_large = 0, failed = 0;
+    page_mode_t mode = cxl_bench_get_page_mode();
+    
+    for (int i = 0; i < total; i++) {
+        if (!pending[i]) continue;
+        
+        int node = cells[i].node;
+        size_t capacity = SIZE_MAX;
+        long long free_bytes = 0;
+        if (numa_node_size64(node, &free_bytes) > 0 && free_bytes > 0) {
+            capacity = (size_t)(free_bytes / 2);
+        }
+        
+        size_t alloc_size = 0;
+        for (int j = i; j < total; j++) {
+            if (pending[j] && cells[j].node == node && cells[j].working_set <= capacity &&
+                cells[j].working_set > alloc_size) {
+                alloc_size = cells[j].working_set;
+            }
+        }
+        
+        size_t page_size = 0;
+        void *buffer = (alloc_size > 0) ? cxl_malloc_on_node_pages(alloc_size, node, mode, &page_size) : NULL;
+        
+        fprintf(stdout, "[Node %d] Buffer: %zu MiB, page size %zu KiB\n",
+                node, alloc_size >> 20, page_size >> 10);
+        
+        for (int w = 0; w < matrix->num_working_sets; w++) {
+            for (int s = 0; s < matrix->num_strides; s++) {
+                size_t ws = matrix->working_sets[w];
+                size_t stride = matrix->strides[s];
+                void *head = NULL;
+                
+                for (int j = i; j < total; j++) {
+                    sweep_cell_t *cell = &cells[j];
+                    if (!pending[j] || cell->node != node || cell->working_set != ws ||
+                        cell->stride != stride) {
+                        continue;
+                    }
+                    
+                    pending[j] = 0;
+                    
+                    if (ws > alloc_size) {
+                        too_large++;
+                        continue;
+                    }
+                    
+                    if (!buffer) {
+                        failed++;
+                        continue;
+                    }
+                    
+                    if (!head) {
+                        head = cxl_chase_build(buffer, ws, stride, 0x5DEECE66DULL ^ ws ^ ((uint64_t)stride << 32));
+                    }
+                    
+                    /* 清掉上一个单元留在各核缓存中的链表行，每个单元都从内存开始 */
+                    if (head && cxl_flush_bulk(buffer, ws, FLUSH_INSN_AUTO, 0) == 0) {
+                        cell->cache_reset = (int32_t)cxl_flush_insn();
+                    }
+                    
+                    cell->page_size = page_size;
+                    if (head && sweep_measure(cell, head, matrix->num_loads) == 0) {
+                        cell->status = 0;
+                        measured++;
+                    } else {
+                        failed++;
+                    }
+                }
+            }
+        }
+        
+        if (buffer) {
+            cxl_free_pages(buffer, alloc_size, mode);
+        }
+    }
+    
+    sched_setaffinity(0, sizeof(saved), &saved);
+    free(pending);
+    
+    if (unavailable > 0) {
+        fprintf(stdout, "[INFO] %d cells skipped: placement, CPU or node not available, or working set under two strides\n", unavailable);
+    }
+    if (too_large > 0) {
+        fprintf(stdout, "[INFO] %d cells skipped: working set exceeds half of the node's free memory\n", too_large);
+    }
+    if (failed > 0) {
+        fprintf(stderr, "[WARNING] %d cells failed\n", failed);
+    }
+    
+    return measured;
+}
+
+/* ====== 导出 ====== */
+int cxl_sweep_export_csv(const sweep_cell_t *cells, int num_cells, const char *output_file) {
+    if (!cells || num_cells < 0 || !output_file) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    FILE *file = fopen(output_file, "w");
+    if (!file) {
+        fprintf(stderr, "[ERROR] Failed to open file: %s\n", output_file);
+        return -1;
+    }
+    
+    fprintf(file, "index,thread_placement,data,node,cpu,probe_cpu,working_set_bytes,stride_bytes,"
+                  "page_size,num_loads,first_pass_ns,ns_per_load,cycles_per_load,status,cache_reset");
+    cxl_perf_csv_header(file, "first_");
+    cxl_perf_csv_header(file, NULL);
+    fprintf(file, "\n");
+    
+    for (int i = 0; i < num_cells; i++) {
+        const sweep_cell_t *cell = &cells[i];
+        fprintf(file, "%u,%s,%s,%d,%d,%d,%lu,%lu,%lu,%lu,%.3f,%.3f,%.3f,%s,%s",
+                cell->index, cxl_sweep_placement_name((thread_placement_t)cell->thread_placement),
+                cxl_sweep_data_name((sweep_data_kind_t)cell->data_kind), cell->node, cell->cpu,
+                cell->probe_cpu, cell->working_set, cell->stride, cell->page_size, cell->num_loads,
+                cell->first_pass_ns, cell->ns_per_load, cell->cycles_per_load,
+                cell->status == 0 ? "ok" : "skipped",
+                cell->cache_reset >= 0 ? cxl_flush_insn_name((flush_insn_t)cell->cache_reset) : "none");
+        cxl_perf_csv_row(file, &cell->first_pass_perf);
+        cxl_perf_csv_row(file, &cell->perf);
+        fprintf(file, "\n");
+    }
+    
+    fclose(file);
+    
+    fprintf(stdout, "[INFO] Sweep results exported to: %s\n", output_file);
+    
+    return 0;
+}
+
+int cxl_sweep_export_binary(const sweep_cell_t *cells, int num_cells, const char *output_file) {
+    if (!cells || num_cells < 0 || !output_file) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    FILE *file = fopen(output_file, "wb");
+    if (!file) {
+        fprintf(stderr, "[ERROR] Failed to open file: %s\n", output_file);
+        return -1;
+    }
+    
+    sweep_file_header_t header;
+    struct timespec ts;
+    
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CXL_SWEEP_MAGIC, sizeof(header.magic));
+    header.version = CXL_SWEEP_VERSION;
+    header.header_size = sizeof(sweep_file_header_t);
+    header.record_size = sizeof(sweep_cell_t);
+    header.num_cells = (uint32_t)num_cells;
+    header.tsc_hz = cxl_tsc_hz();
+    clock_gettime(CLOCK_REALTIME, &ts);
+    header.created_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    
+    int ret = 0;
+    if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+        fwrite(cells, sizeof(sweep_cell_t), (size_t)num_cells, file) != (size_t)num_cells) {
+        fprintf(stderr, "[ERROR] Failed to write sweep results: %s\n", output_file);
+        ret = -1;
+    }
+    
+    if (fclose(file) != 0) ret = -1;
+    
+    if (ret == 0) {
+        fprintf(stdout, "[INFO] Sweep results exported to: %s\n", output_file);
+    }
+    
+    return ret;
+}
@@ -0,0 +1,481 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <pthread.h>
+#include "cxl_topology.h"
+#include "cxl_common.h"
+
+/* ====== 全局拓扑状态 ====== */
+static struct {
+    cxl_topology_t topo;
+    int status;                 /* cxl_topology_discover 的返回值 */
+} topology_state;
+
+static pthread_once_t topology_once = PTHREAD_ONCE_INIT;
+
+/* ====== sysfs 读取辅助函数 ====== */
+
+/* 拼接路径，超长时返回 -1 而不是读取被截断的路径 */
+__attribute__((format(printf, 3, 4)))
+static int topo_path(char *buf, size_t size, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(buf, size, fmt, args);
+    va_end(args);
+    
+    return (len < 0 || (size_t)len >= size) ? -1 : 0;
+}
+
+static int topo_read_u64(const char *path, uint64_t *value) {
+    char buf[64];
+    if (cxl_read_sysfs_line(path, buf, sizeof(buf)) < 0) {
+        return -1;
+    }
+    
+    char *end = NULL;
+    unsigned long long parsed = strtoull(buf, &end, 10);
+    if (end == buf) {
+        return -1;
+    }
+    
+    *value = parsed;
+    return 0;
+}
+
+/* "nodeN" -> N，其他名称返回 -1 */
+static int topo_parse_node_name(const char *name) {
+    if (strncmp(name, "node", 4) != 0 || !isdigit((unsigned char)name[4])) {
+        return -1;
+    }
+    
+    char *end = NULL;
+    long id = strtol(name + 4, &end, 10);
+    if (*end != '\0' || id < 0 || id >= CXL_TOPO_MAX_NODES) {
+        return -1;
+    }
+    
+    return (int)id;
+}
+
+/* cpulist 格式："0-3,8,10-11"，空字符串表示没有 CPU */
+static void topo_parse_cpulist(const char *list, int *num_cpus, int *first_cpu) {
+    *num_cpus = 0;
+    *first_cpu = -1;
+    
+    const char *p = list;
+    while (*p) {
+        char *end = NULL;
+        long lo = strtol(p, &end, 10);
+        if (end == p) break;
+        
+        long hi = lo;
+        p = end;
+        if (*p == '-') {
+            hi = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        
+        if (hi >= lo) {
+            if (*first_cpu < 0 || lo < *first_cpu) *first_cpu = (int)lo;
+            *num_cpus += (int)(hi - lo + 1);
+        }
+        
+        if (*p == ',') p++;
+    }
+}
+
+/* 节点 meminfo 每行格式："Node 0 MemTotal:       32768 kB" */
+static int topo_parse_meminfo(const char *path, topo_node_t *node) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long long value = 0;
+        char key[64];
+        int id;
+        
+        if (sscanf(line, "Node %d %63[^:]: %llu", &id, key, &value) != 3) continue;
+        
+        if (strcmp(key, "MemTotal") == 0) {
+            node->mem_total_kb = value;
+        } else if (strcmp(key, "MemFree") == 0) {
+            node->mem_free_kb = value;
+        }
+    }
+    
+    fclose(file);
+    return 0;
+}
+
+/* distance 按节点编号升序列出到每个在线节点的距离 */
+static void topo_parse_distance(const char *path, cxl_topology_t *topo, topo_node_t *node) {
+    char buf[1024];
+    if (cxl_read_sysfs_line(path, buf, sizeof(buf)) < 0) {
+        return;
+    }
+    
+    const char *p = buf;
+    for (int target = 0; target <= topo->max_node; target++) {
+        if (!topo->nodes[target].present) continue;
+        
+        char *end = NULL;
+        long distance = strtol(p, &end, 10);
+        if (end == p) break;
+        
+        node->distance[target] = (distance > 0 && distance < 256) ? (uint8_t)distance : 0;
+        p = end;
+    }
+}
+
+/* HMAT 访问类：accessN/initiators/ 下有发起节点的 nodeX 链接与性能属性 */
+static void topo_parse_access(const char *node_dir, int access_class, topo_access_t *access) {
+    char dir[CXL_TOPO_PATH_MAX];
+    char path[CXL_TOPO_PATH_MAX + 32];
+    
+    if (topo_path(dir, sizeof(dir), "%s/access%d/initiators", node_dir, access_class) < 0) {
+        return;
+    }
+    
+    DIR *d = opendir(dir);
+    if (!d) {
+        return;
+    }
+    
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        int id = topo_parse_node_name(entry->d_name);
+        if (id >= 0) access->initiators |= 1ULL << id;
+    }
+    closedir(d);
+    
+    static const char *attrs[] = {"read_latency", "write_latency", "read_bandwidth", "write_bandwidth"};
+    uint32_t *fields[] = {&access->read_latency, &access->write_latency,
+                          &access->read_bandwidth, &access->write_bandwidth};
+    
+    for (int i = 0; i < 4; i++) {
+        uint64_t value = 0;
+        if (topo_path(path, sizeof(path), "%s/%s", dir, attrs[i]) == 0 &&
+            topo_read_u64(path, &value) == 0) {
+            *fields[i] = (value > UINT32_MAX) ? UINT32_MAX : (uint32_t)value;
+        }
+    }
+    
+    access->valid = 1;
+}
+
+/* ====== CXL 总线设备 ====== */
+
+/* region 的内存经 dax 设备上线为 NUMA 节点：regionN/dax_regionN/daxN.M/target_node */
+static void topo_mark_region_targets(const char *dir, int depth, uint64_t *targets) {
+    char path[CXL_TOPO_PATH_MAX];
+    uint64_t node = 0;
+    
+    if (topo_path(path, sizeof(path), "%s/target_node", dir) == 0 &&
+        topo_read_u64(path, &node) == 0 && node < CXL_TOPO_MAX_NODES) {
+        *targets |= 1ULL << node;
+    }
+    
+    if (depth <= 0) return;
+    
+    DIR *d = opendir(dir);
+    if (!d) return;
+    
+    /* 只进入 dax 子设备，避免沿 subsystem/driver 等链接遍历整个 sysfs */
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (strncmp(entry->d_name, "dax", 3) != 0) continue;
+        if (topo_path(path, sizeof(path), "%s/%s", dir, entry->d_name) == 0) {
+            topo_mark_region_targets(path, depth - 1, targets);
+        }
+    }
+    closedir(d);
+}
+
+static uint64_t topo_scan_cxl_bus(cxl_topology_t *topo) {
+    char dir[CXL_TOPO_PATH_MAX];
+    char path[CXL_TOPO_PATH_MAX + 32];
+    uint64_t targets = 0;
+    
+    DIR *d = NULL;
+    if (topo_path(dir, sizeof(dir), "%s/bus/cxl/devices", topo->sysfs_root) == 0) {
+        d = opendir(dir);
+    }
+    if (!d) {
+        return 0;
+    }
+    
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        const char *name = entry->d_name;
+        int is_memdev = (strncmp(name, "mem", 3) == 0 && isdigit((unsigned char)name[3]));
+        int is_region = (strncmp(name, "region", 6) == 0 && isdigit((unsigned char)name[6]));
+        
+        if (!is_memdev && !is_region) continue;
+        
+        topo_device_t device;
+        memset(&device, 0, sizeof(device));
+        memcpy(device.name, name, strnlen(name, sizeof(device.name) - 1));
+        device.numa_node = -1;
+        
+        if (is_memdev) {
+            /* memdev 的 numa_node 是设备所挂的主机桥所在节点，不是其内存所在节点 */
+            uint64_t node = 0;
+            if (topo_path(path, sizeof(path), "%s/%s/numa_node", dir, name) == 0 &&
+                topo_read_u64(path, &node) == 0 && node < CXL_TOPO_MAX_NODES) {
+                device.numa_node = (int)node;
+            }
+        } else {
+            uint64_t region_targets = 0;
+            if (topo_path(path, sizeof(path), "%s/%s", dir, name) == 0) {
+                topo_mark_region_targets(path, 2, &region_targets);
+            }
+            if (region_targets) {
+                device.numa_node = __builtin_ctzll(region_targets);
+            }
+            targets |= region_targets;
+        }
+        
+        if (topo->num_devices < CXL_TOPO_MAX_DEVICES) {
+            topo->devices[topo->num_devices++] = device;
+        }
+    }
+    closedir(d);
+    
+    return targets;
+}
+
+/* ====== 最近发起节点 ====== */
+static int topo_closest_cpu_node(const cxl_topology_t *topo, int node, uint64_t candidates) {
+    const topo_node_t *info = &topo->nodes[node];
+    int best = -1;
+    int best_distance = 256;
+    
+    for (int i = 0; i <= topo->max_node; i++) {
+        if (!(candidates & (1ULL << i))) continue;
+        if (!topo->nodes[i].present || topo->nodes[i].num_cpus == 0) continue;
+        
+        int distance = info->distance[i] ? info->distance[i] : 255;
+        if (best < 0 || distance < best_distance) {
+            best = i;
+            best_distance = distance;
+        }
+    }
+    
+    return best;
+}
+
+static int topo_find_initiator(const cxl_topology_t *topo, int node) {
+    const topo_node_t *info = &topo->nodes[node];
+    
+    if (info->num_cpus > 0) {
+        return node;
+    }
+    
+    /* HMAT 已给出性能最优的发起者：access1 只含 CPU，优先使用 */
+    for (int c = 1; c >= 0; c--) {
+        if (info->access[c].valid && info->access[c].initiators) {
+            int best = topo_closest_cpu_node(topo, node, info->access[c].initiators);
+            if (best >= 0) return best;
+        }
+    }
+    
+    /* 退回到 SLIT 距离，距离未知时取编号最小的 CPU 节点 */
+    return topo_closest_cpu_node(topo, node, ~0ULL);
+}
+
+/* ====== 拓扑探测 ====== */
+int cxl_topology_discover(const char *sysfs_root, cxl_topology_t *topo) {
+    if (!topo) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    memset(topo, 0, sizeof(cxl_topology_t));
+    topo->max_node = -1;
+    
+    if (!sysfs_root) sysfs_root = getenv(CXL_SYSFS_ROOT_ENV);
+    if (!sysfs_root || !sysfs_root[0]) sysfs_root = CXL_SYSFS_ROOT_DEFAULT;
+    snprintf(topo->sysfs_root, sizeof(topo->sysfs_root), "%s", sysfs_root);
+    
+    char node_root[CXL_TOPO_PATH_MAX];
+    /* 先枚举节点：distance 需要知道在线节点列表 */
+    DIR *d = NULL;
+    if (topo_path(node_root, sizeof(node_root), "%s/devices/system/node", topo->sysfs_root) == 0) {
+        d = opendir(node_root);
+    }
+    if (!d) {
+        fprintf(stderr, "[ERROR] Failed to open %s\n", node_root);
+        return -1;
+    }
+    
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        int id = topo_parse_node_name(entry->d_name);
+        if (id < 0) continue;
+        
+        topo->nodes[id].present = 1;
+        topo->num_nodes++;
+        if (id > topo->max_node) topo->max_node = id;
+    }
+    closedir(d);
+    
+    if (topo->num_nodes == 0) {
+        fprintf(stderr, "[ERROR] No NUMA nodes found under %s\n", node_root);
+        return -1;
+    }
+    
+    uint64_t mem_unknown = 0;
+    
+    for (int id = 0; id <= topo->max_node; id++) {
+        topo_node_t *node = &topo->nodes[id];
+        if (!node->present) continue;
+        
+        char node_dir[CXL_TOPO_PATH_MAX];
+        char path[CXL_TOPO_PATH_MAX + 32];
+        char cpulist[1024];
+        
+        node->first_cpu = -1;
+        if (topo_path(node_dir, sizeof(node_dir), "%s/node%d", node_root, id) < 0) continue;
+        
+        if (topo_path(path, sizeof(path), "%s/cpulist", node_dir) == 0 &&
+            cxl_read_sysfs_line(path, cpulist, sizeof(cpulist)) == 0) {
+            topo_parse_cpulist(cpulist, &node->num_cpus, &node->first_cpu);
+        }
+        
+        if (topo_path(path, sizeof(path), "%s/meminfo", node_dir) < 0 ||
+            topo_parse_meminfo(path, node) < 0) {
+            mem_unknown |= 1ULL << id;
+        }
+        
+        if (topo_path(path, sizeof(path), "%s/distance", node_dir) == 0) {
+            topo_parse_distance(path, topo, node);
+        }
+        
+        topo_parse_access(node_dir, 0, &node->access[0]);
+        topo_parse_access(node_dir, 1, &node->access[1]);
+    }
+    
+    uint64_t region_targets = topo_scan_cxl_bus(topo);
+    uint64_t cpuless_with_memory = 0;
+    
+    for (int id = 0; id <= topo->max_node; id++) {
+        topo_node_t *node = &topo->nodes[id];
+        if (!node->present) continue;
+        
+        if (node->num_cpus > 0) {
+            node->kind = TOPO_NODE_CPU;
+        } else if (region_targets & (1ULL << id)) {
+            node->kind = TOPO_NODE_CXL;
+        } else {
+            node->kind = TOPO_NODE_CPULESS;
+        }
+        
+        /* 没有内存（region 尚未上线）的节点无法分配，不作为 CXL 节点 */
+        if (node->kind != TOPO_NODE_CPU &&
+            (node->mem_total_kb > 0 || (mem_unknown & (1ULL << id)))) {
+            cpuless_with_memory |= 1ULL << id;
+        }
+        
+        node->nearest_initiator = topo_find_initiator(topo, id);
+    }
+    
+    /* CXL region 的目标节点排在前面，其余无 CPU 的节点作为候选 */
+    for (int id = 0; id <= topo->max_node; id++) {
+        if ((cpuless_with_memory & (1ULL << id)) && topo->nodes[id].kind == TOPO_NODE_CXL) {
+            topo->cxl_nodes[topo->num_cxl_nodes++] = id;
+        }
+    }
+    for (int id = 0; id <= topo->max_node; id++) {
+        if ((cpuless_with_memory & (1ULL << id)) && topo->nodes[id].kind == TOPO_NODE_CPULESS) {
+            topo->cxl_nodes[topo->num_cxl_nodes++] = id;
+        }
+    }
+    
+    return 0;
+}
+
+/* ====== 缓存的本机拓扑 ====== */
+static void topology_discover_once(void) {
+    topology_state.status = cxl_topology_discover(NULL, &topology_state.topo);
+}
+
+const cxl_topology_t *cxl_topology_get(void) {
+    pthread_once(&topology_once, topology_discover_once);
+    
+    return (topology_state.status == 0) ? &topology_state.topo : NULL;
+}
+
+/* ====== 查询 ====== */
+int cxl_topology_cxl_node(const cxl_topology_t *topo) {
+    if (!topo || topo->num_cxl_nodes == 0) {
+        return -1;
+    }
+    
+    return topo->cxl_nodes[0];
+}
+
+int cxl_topology_nearest_initiator(const cxl_topology_t *topo, int node) {
+    if (!topo || node < 0 || node > topo->max_node || !topo->nodes[node].present) {
+        return -1;
+    }
+    
+    return topo->nodes[node].nearest_initiator;
+}
+
+const char *cxl_topology_kind_name(topo_node_kind_t kind) {
+    switch (kind) {
+        case TOPO_NODE_CPU:     return "cpu";
+        case TOPO_NODE_CXL:     return "cxl";
+        case TOPO_NODE_CPULESS: return "cpuless";
+        default:                return "unknown";
+    }
+}
+
+/* ====== 打印 ====== */
+void cxl_topology_print(const cxl_topology_t *topo) {
+    if (!topo) return;
+    
+    fprintf(stdout, "\n========== NUMA / CXL Topology ==========\n");
+    fprintf(stdout, "sysfs root: %s\n", topo->sysfs_root);
+    fprintf(stdout, "  %-6s %-8s %6s %12s %10s %10s %10s\n",
+           "Node", "Kind", "CPUs", "Memory(MiB)", "Initiator", "Lat(ns)", "BW(MB/s)");
+    
+    for (int id = 0; id <= topo->max_node; id++) {
+        const topo_node_t *node = &topo->nodes[id];
+        if (!node->present) continue;
+        
+        /* 优先显示 CPU 发起者（access1）的 HMAT 数据 */
+        const topo_access_t *access = node->access[1].valid ? &node->access[1] : &node->access[0];
+        
+        fprintf(stdout, "  %-6d %-8s %6d %12lu %10d", id, cxl_topology_kind_name(node->kind),
+               node->num_cpus, node->mem_total_kb >> 10, node->nearest_initiator);
+        
+        if (access->valid && access->read_latency) {
+            fprintf(stdout, " %10u", access->read_latency);
+        } else {
+            fprintf(stdout, " %10s", "-");
+        }
+        if (access->valid && access->read_bandwidth) {
+            fprintf(stdout, " %10u\n", access->read_bandwidth);
+        } else {
+            fprintf(stdout, " %10s\n", "-");
+        }
+    }
+    
+    for (int i = 0; i < topo->num_devices; i++) {
+        fprintf(stdout, "  CXL device %-10s node %d\n", topo->devices[i].name, topo->devices[i].numa_node);
+    }
+    
+    if (topo->num_cxl_nodes == 0) {
+        fprintf(stdout, "  No CXL memory node detected\n");
+    }
+    
+    fprintf(stdout, "=========================================\n");
+}
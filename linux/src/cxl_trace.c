@@ -0,0 +1,542 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cxl_trace.h"
+#include "cxl_topology.h"
+#include "cxl_common.h"
+
+/* 单个 uint64_t 的 LEB128 编码最多 10 字节 */
+#define TRACE_MAX_VARINT_BYTES  10
+
+/* ====== 写入器 ====== */
+struct cxl_trace_writer {
+    FILE *file;
+    uint64_t offset;                /* 已写出的字节数 */
+    uint64_t total_samples;
+    uint64_t *pending;              /* 当前块中尚未编码的样本 */
+    uint32_t num_pending;
+    uint8_t *payload;               /* 编码缓冲区 */
+    cxl_trace_chunk_t *index;
+    size_t num_chunks;
+    size_t index_capacity;
+    int failed;
+};
+
+/* ====== 读取器 ====== */
+struct cxl_trace_reader {
+    int fd;
+    const uint8_t *base;            /* mmap 起始地址 */
+    size_t size;
+    const cxl_trace_header_t *header;
+    const cxl_trace_chunk_t *index; /* 指向映射区域，或指向 owned_index */
+    cxl_trace_chunk_t *owned_index; /* 缺少文件尾时重建的索引 */
+    uint64_t num_chunks;
+    uint64_t total_samples;
+};
+
+/* ====== 变长编码 ====== */
+static inline uint64_t trace_zigzag_encode(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t trace_zigzag_decode(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static size_t trace_encode(const uint64_t *samples, uint32_t num_samples, uint8_t *out) {
+    uint8_t *p = out;
+    uint64_t prev = 0;
+    
+    for (uint32_t i = 0; i < num_samples; i++) {
+        uint64_t v = trace_zigzag_encode((int64_t)(samples[i] - prev));
+        prev = samples[i];
+        
+        while (v >= 0x80) {
+            *p++ = (uint8_t)(v | 0x80);
+            v >>= 7;
+        }
+        *p++ = (uint8_t)v;
+    }
+    
+    return (size_t)(p - out);
+}
+
+static int trace_decode(const uint8_t *in, size_t size, uint32_t num_samples, uint64_t *samples) {
+    const uint8_t *p = in;
+    const uint8_t *end = in + size;
+    uint64_t prev = 0;
+    
+    for (uint32_t i = 0; i < num_samples; i++) {
+        uint64_t v = 0;
+        int shift = 0;
+        
+        /* 单字节（|差值| < 64）是最常见的情况 */
+        while (1) {
+            if (p >= end || shift > 63) {
+                return -1;
+            }
+            uint8_t byte = *p++;
+            v |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+            shift += 7;
+        }
+        
+        prev += (uint64_t)trace_zigzag_decode(v);
+        samples[i] = prev;
+    }
+    
+    return (p == end) ? 0 : -1;
+}
+
+/* ====== 写入 ====== */
+static int trace_write(cxl_trace_writer_t *writer, const void *data, size_t size) {
+    if (writer->failed) return -1;
+    
+    if (fwrite(data, 1, size, writer->file) != size) {
+        fprintf(stderr, "[ERROR] Failed to write trace file\n");
+        writer->failed = 1;
+        return -1;
+    }
+    
+    writer->offset += size;
+    return 0;
+}
+
+static void trace_fill_header(cxl_trace_header_t *header, const char *label,
+                              const cxl_config_t *config, uint64_t tsc_hz) {
+    struct timespec ts;
+    
+    memset(header, 0, sizeof(cxl_trace_header_t));
+    memcpy(header->magic, CXL_TRACE_MAGIC, sizeof(header->magic));
+    header->version = CXL_TRACE_VERSION;
+    header->header_size = sizeof(cxl_trace_header_t);
+    header->tsc_hz = tsc_hz;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    header->created_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    if (label) {
+        strncpy(header->label, label, sizeof(header->label) - 1);
+    }
+    header->chunk_samples = CXL_TRACE_CHUNK_SAMPLES;
+    
+    if (config) {
+        header->has_config = 1;
+        header->numa_node_normal = config->numa_node_normal;
+        header->numa_node_cxl = config->numa_node_cxl;
+        header->thread_placement = config->thread_placement;
+        header->data_placement = config->data_placement;
+        header->attacker_cpu = config->attacker_cpu;
+        header->victim_cpu = config->victim_cpu;
+        header->probe_cpu = config->probe_cpu;
+        header->monitor_cpu = config->monitor_cpu;
+        header->prefetcher_enabled = config->prefetcher_enabled;
+        header->isolcpus_enabled = config->isolcpus_enabled;
+        header->iterations = config->iterations;
+        header->warmup_iterations = config->warmup_iterations;
+        header->sample_size = config->sample_size;
+    }
+    
+    header->cxl_node = -1;
+    const cxl_topology_t *topo = cxl_topology_get();
+    if (topo) {
+        header->cxl_node = cxl_topology_cxl_node(topo);
+        for (int id = 0; id <= topo->max_node && header->num_nodes < CXL_TRACE_MAX_NODES; id++) {
+            const topo_node_t *node = &topo->nodes[id];
+            if (!node->present) continue;
+            
+            const topo_access_t *access = node->access[1].valid ? &node->access[1] : &node->access[0];
+            cxl_trace_node_t *entry = &header->nodes[header->num_nodes++];
+            entry->id = id;
+            entry->kind = node->kind;
+            entry->num_cpus = node->num_cpus;
+            entry->nearest_initiator = node->nearest_initiator;
+            entry->mem_total_kb = node->mem_total_kb;
+            entry->read_latency = access->read_latency;
+            entry->read_bandwidth = access->read_bandwidth;
+        }
+    }
+}
+
+cxl_trace_writer_t *cxl_trace_writer_open(const char *path, const char *label,
+                                          const cxl_config_t *config, uint64_t tsc_hz) {
+    if (!path) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return NULL;
+    }
+    
+    cxl_trace_writer_t *writer = calloc(1, sizeof(cxl_trace_writer_t));
+    if (!writer) {
+        fprintf(stderr, "[ERROR] Failed to allocate trace writer\n");
+        return NULL;
+    }
+    
+    writer->pending = malloc(CXL_TRACE_CHUNK_SAMPLES * sizeof(uint64_t));
+    writer->payload = malloc((size_t)CXL_TRACE_CHUNK_SAMPLES * TRACE_MAX_VARINT_BYTES);
+    writer->file = fopen(path, "wb");
+    
+    if (!writer->pending || !writer->payload || !writer->file) {
+        fprintf(stderr, "[ERROR] Failed to open trace file: %s\n", path);
+        if (writer->file) fclose(writer->file);
+        free(writer->pending);
+        free(writer->payload);
+        free(writer);
+        return NULL;
+    }
+    
+    cxl_trace_header_t header;
+    trace_fill_header(&header, label, config, tsc_hz);
+    trace_write(writer, &header, sizeof(header));
+    
+    return writer;
+}
+
+static int trace_flush_chunk(cxl_trace_writer_t *writer) {
+    if (writer->num_pending == 0) return 0;
+    
+    if (writer->num_chunks == writer->index_capacity) {
+        size_t capacity = writer->index_capacity ? writer->index_capacity * 2 : 64;
+        cxl_trace_chunk_t *index = realloc(writer->index, capacity * sizeof(cxl_trace_chunk_t));
+        if (!index) {
+            fprintf(stderr, "[ERROR] Failed to grow trace index\n");
+            writer->failed = 1;
+            return -1;
+        }
+        writer->index = index;
+        writer->index_capacity = capacity;
+    }
+    
+    cxl_trace_chunk_t chunk;
+    memset(&chunk, 0, sizeof(chunk));
+    chunk.first_sample = writer->total_samples;
+    chunk.num_samples = writer->num_pending;
+    chunk.min = UINT64_MAX;
+    
+    for (uint32_t i = 0; i < writer->num_pending; i++) {
+        uint64_t v = writer->pending[i];
+        if (v < chunk.min) chunk.min = v;
+        if (v > chunk.max) chunk.max = v;
+        chunk.sum += v;
+    }
+    
+    chunk.payload_bytes = (uint32_t)trace_encode(writer->pending, writer->num_pending, writer->payload);
+    chunk.offset = writer->offset + sizeof(cxl_trace_chunk_t);
+    
+    if (trace_write(writer, &chunk, sizeof(chunk)) < 0 ||
+        trace_write(writer, writer->payload, chunk.payload_bytes) < 0) {
+        return -1;
+    }
+    
+    writer->index[writer->num_chunks++] = chunk;
+    writer->total_samples += writer->num_pending;
+    writer->num_pending = 0;
+    
+    return 0;
+}
+
+int cxl_trace_writer_append(cxl_trace_writer_t *writer, const uint64_t *samples, size_t num_samples) {
+    if (!writer || (!samples && num_samples > 0)) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    while (num_samples > 0) {
+        size_t room = CXL_TRACE_CHUNK_SAMPLES - writer->num_pending;
+        size_t n = (num_samples < room) ? num_samples : room;
+        
+        memcpy(writer->pending + writer->num_pending, samples, n * sizeof(uint64_t));
+        writer->num_pending += (uint32_t)n;
+        samples += n;
+        num_samples -= n;
+        
+        if (writer->num_pending == CXL_TRACE_CHUNK_SAMPLES && trace_flush_chunk(writer) < 0) {
+            return -1;
+        }
+    }
+    
+    return writer->failed ? -1 : 0;
+}
+
+int cxl_trace_writer_close(cxl_trace_writer_t *writer) {
+    if (!writer) return -1;
+    
+    trace_flush_chunk(writer);
+    
+    /* payload 长度任意，索引前补零到 8 字节边界，读取端才能直接在映射区域上访问索引 */
+    static const uint8_t padding[sizeof(uint64_t)] = {0};
+    size_t misalign = (size_t)(writer->offset % sizeof(uint64_t));
+    if (misalign != 0) {
+        trace_write(writer, padding, sizeof(uint64_t) - misalign);
+    }
+    
+    cxl_trace_trailer_t trailer;
+    memset(&trailer, 0, sizeof(trailer));
+    trailer.index_offset = writer->offset;
+    trailer.num_chunks = writer->num_chunks;
+    trailer.total_samples = writer->total_samples;
+    memcpy(trailer.magic, CXL_TRACE_END_MAGIC, sizeof(CXL_TRACE_END_MAGIC));
+    
+    if (writer->num_chunks > 0) {
+        trace_write(writer, writer->index, writer->num_chunks * sizeof(cxl_trace_chunk_t));
+    }
+    trace_write(writer, &trailer, sizeof(trailer));
+    
+    int ret = writer->failed ? -1 : 0;
+    if (fclose(writer->file) != 0) ret = -1;
+    
+    free(writer->pending);
+    free(writer->payload);
+    free(writer->index);
+    free(writer);
+    
+    return ret;
+}
+
+/* ====== 读取 ====== */
+static int trace_chunk_valid(const cxl_trace_reader_t *reader, const cxl_trace_chunk_t *chunk) {
+    return chunk->num_samples > 0 && chunk->num_samples <= CXL_TRACE_CHUNK_SAMPLES &&
+           chunk->offset <= reader->size && chunk->payload_bytes <= reader->size - chunk->offset;
+}
+
+/* 文件尾缺失或损坏：从文件头之后沿块头逐块重建索引 */
+static int trace_rebuild_index(cxl_trace_reader_t *reader) {
+    size_t capacity = 64;
+    uint64_t offset = reader->header->header_size;
+    
+    reader->owned_index = malloc(capacity * sizeof(cxl_trace_chunk_t));
+    if (!reader->owned_index) return -1;
+    
+    while (offset + sizeof(cxl_trace_chunk_t) <= reader->size) {
+        cxl_trace_chunk_t chunk;
+        memcpy(&chunk, reader->base + offset, sizeof(chunk));
+        
+        if (chunk.offset != offset + sizeof(cxl_trace_chunk_t) ||
+            chunk.first_sample != reader->total_samples || !trace_chunk_valid(reader, &chunk)) {
+            break;
+        }
+        
+        if (reader->num_chunks == capacity) {
+            capacity *= 2;
+            cxl_trace_chunk_t *index = realloc(reader->owned_index, capacity * sizeof(cxl_trace_chunk_t));
+            if (!index) return -1;
+            reader->owned_index = index;
+        }
+        
+        reader->owned_index[reader->num_chunks++] = chunk;
+        reader->total_samples += chunk.num_samples;
+        offset = chunk.offset + chunk.payload_bytes;
+    }
+    
+    reader->index = reader->owned_index;
+    fprintf(stderr, "[WARNING] Trace trailer missing, recovered %lu chunks (%lu samples)\n",
+            reader->num_chunks, reader->total_samples);
+    
+    return 0;
+}
+
+cxl_trace_reader_t *cxl_trace_open(const char *path) {
+    if (!path) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return NULL;
+    }
+    
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "[ERROR] Failed to open trace file: %s\n", path);
+        return NULL;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(cxl_trace_header_t)) {
+        fprintf(stderr, "[ERROR] Trace file too small: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+    
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "[ERROR] Failed to map trace file: %s\n", path);
+        close(fd);
+        return NULL;
+    }
+    
+    cxl_trace_reader_t *reader = calloc(1, sizeof(cxl_trace_reader_t));
+    if (!reader) {
+        munmap(base, (size_t)st.st_size);
+        close(fd);
+        return NULL;
+    }
+    
+    reader->fd = fd;
+    reader->base = base;
+    reader->size = (size_t)st.st_size;
+    reader->header = (const cxl_trace_header_t *)base;
+    
+    if (memcmp(reader->header->magic, CXL_TRACE_MAGIC, sizeof(reader->header->magic)) != 0 ||
+        reader->header->version != CXL_TRACE_VERSION ||
+        reader->header->header_size != sizeof(cxl_trace_header_t)) {
+        fprintf(stderr, "[ERROR] Not a CXL trace file (or unsupported version): %s\n", path);
+        cxl_trace_close(reader);
+        return NULL;
+    }
+    
+    /* 优先使用文件尾中的块索引（写入时补齐到 8 字节，直接在映射区域内使用）；不对齐视为文件尾无效，重建索引 */
+    int have_index = 0;
+    if (reader->size >= sizeof(cxl_trace_header_t) + sizeof(cxl_trace_trailer_t)) {
+        cxl_trace_trailer_t trailer;
+        memcpy(&trailer, reader->base + reader->size - sizeof(trailer), sizeof(trailer));
+        
+        size_t index_end = reader->size - sizeof(trailer);
+        if (memcmp(trailer.magic, CXL_TRACE_END_MAGIC, sizeof(CXL_TRACE_END_MAGIC)) == 0 &&
+            trailer.index_offset <= index_end &&
+            trailer.num_chunks == (index_end - trailer.index_offset) / sizeof(cxl_trace_chunk_t) &&
+            trailer.index_offset % _Alignof(cxl_trace_chunk_t) == 0) {
+            reader->index = (const cxl_trace_chunk_t *)(reader->base + trailer.index_offset);
+            reader->num_chunks = trailer.num_chunks;
+            reader->total_samples = trailer.total_samples;
+            have_index = 1;
+        }
+    }
+    
+    if (!have_index && trace_rebuild_index(reader) < 0) {
+        fprintf(stderr, "[ERROR] Failed to rebuild trace index: %s\n", path);
+        cxl_trace_close(reader);
+        return NULL;
+    }
+    
+    return reader;
+}
+
+void cxl_trace_close(cxl_trace_reader_t *reader) {
+    if (!reader) return;
+    
+    if (reader->base) munmap((void *)reader->base, reader->size);
+    if (reader->fd >= 0) close(reader->fd);
+    free(reader->owned_index);
+    free(reader);
+}
+
+const cxl_trace_header_t *cxl_trace_get_header(const cxl_trace_reader_t *reader) {
+    return reader ? reader->header : NULL;
+}
+
+uint64_t cxl_trace_num_samples(const cxl_trace_reader_t *reader) {
+    return reader ? reader->total_samples : 0;
+}
+
+uint64_t cxl_trace_num_chunks(const cxl_trace_reader_t *reader) {
+    return reader ? reader->num_chunks : 0;
+}
+
+const cxl_trace_chunk_t *cxl_trace_get_chunk(const cxl_trace_reader_t *reader, uint64_t chunk) {
+    if (!reader || chunk >= reader->num_chunks) {
+        return NULL;
+    }
+    
+    return &reader->index[chunk];
+}
+
+int cxl_trace_decode_chunk(const cxl_trace_reader_t *reader, uint64_t chunk, uint64_t *samples) {
+    const cxl_trace_chunk_t *entry = cxl_trace_get_chunk(reader, chunk);
+    if (!entry || !samples) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    if (!trace_chunk_valid(reader, entry) ||
+        trace_decode(reader->base + entry->offset, entry->payload_bytes,
+                     entry->num_samples, samples) < 0) {
+        fprintf(stderr, "[ERROR] Corrupt trace chunk %lu\n", chunk);
+        return -1;
+    }
+    
+    return (int)entry->num_samples;
+}
+
+int cxl_trace_read(const cxl_trace_reader_t *reader, uint64_t first, uint64_t count, uint64_t *samples) {
+    if (!reader || !samples || first > reader->total_samples ||
+        count > reader->total_samples - first) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    if (count == 0) return 0;
+    
+    /* 二分查找包含 first 的块 */
+    uint64_t lo = 0, hi = reader->num_chunks - 1;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo + 1) / 2;
+        if (reader->index[mid].first_sample <= first) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    
+    uint64_t *chunk_buf = NULL;
+    uint64_t done = 0;
+    
+    for (uint64_t c = lo; c < reader->num_chunks && done < count; c++) {
+        const cxl_trace_chunk_t *entry = &reader->index[c];
+        uint64_t skip = (first + done) - entry->first_sample;
+        uint64_t take = entry->num_samples - skip;
+        if (take > count - done) take = count - done;
+        
+        /* 整块落在输出范围内时直接解码到输出缓冲区 */
+        if (skip == 0 && take == entry->num_samples) {
+            if (cxl_trace_decode_chunk(reader, c, samples + done) < 0) {
+                free(chunk_buf);
+                return -1;
+            }
+        } else {
+            if (!chunk_buf) {
+                chunk_buf = malloc(CXL_TRACE_CHUNK_SAMPLES * sizeof(uint64_t));
+                if (!chunk_buf) {
+                    fprintf(stderr, "[ERROR] Failed to allocate decode buffer\n");
+                    return -1;
+                }
+            }
+            if (cxl_trace_decode_chunk(reader, c, chunk_buf) < 0) {
+                free(chunk_buf);
+                return -1;
+            }
+            memcpy(samples + done, chunk_buf + skip, take * sizeof(uint64_t));
+        }
+        
+        done += take;
+    }
+    
+    free(chunk_buf);
+    
+    return (done == count) ? 0 : -1;
+}
+
+int cxl_trace_to_histogram(const cxl_trace_reader_t *reader, cxl_histogram_t *hist) {
+    if (!reader || !hist) {
+        fprintf(stderr, "[ERROR] Invalid parameters\n");
+        return -1;
+    }
+    
+    uint64_t *chunk_buf = malloc(CXL_TRACE_CHUNK_SAMPLES * sizeof(uint64_t));
+    if (!chunk_buf) {
+        fprintf(stderr, "[ERROR] Failed to allocate decode buffer\n");
+        return -1;
+    }
+    
+    for (uint64_t c = 0; c < reader->num_chunks; c++) {
+        int n = cxl_trace_decode_chunk(reader, c, chunk_buf);
+        if (n < 0) {
+            free(chunk_buf);
+            return -1;
+        }
+        cxl_histogram_record_array(hist, chunk_buf, (size_t)n);
+    }
+    
+    free(chunk_buf);
+    
+    return 0;
+}
@@ -0,0 +1,169 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "cxl_tsc.h"
+#include "cxl_common.h"
+
+/* ====== TSC 模块状态 ====== */
+static struct {
+    pthread_once_t once;
+    cxl_tsc_info_t info;
+} tsc_state = {
+    .once = PTHREAD_ONCE_INIT,
+};
+
+static int tsc_check_invariant(void) {
+    uint32_t eax, ebx, ecx, edx;
+    
+    cxl_cpuid(0x80000000, 0, &eax, &ebx, &ecx, &edx);
+    if (eax < 0x80000007) {
+        return 0;
+    }
+    
+    cxl_cpuid(0x80000007, 0, &eax, &ebx, &ecx, &edx);
+    return (edx >> 8) & 1;
+}
+
+static uint64_t tsc_cpuid_hz(tsc_source_t *source) {
+    uint32_t max_leaf, eax, ebx, ecx, edx;
+    
+    cxl_cpuid(0, 0, &max_leaf, &ebx, &ecx, &edx);
+    
+    /* 0x15：TSC = 晶振频率(ECX) × EBX / EAX */
+    if (max_leaf >= 0x15) {
+        cxl_cpuid(0x15, 0, &eax, &ebx, &ecx, &edx);
+        if (eax != 0 && ebx != 0 && ecx != 0) {
+            *source = TSC_SOURCE_CPUID_15H;
+            return (uint64_t)ecx * ebx / eax;
+        }
+    }
+    
+    /* 0x16：EAX 为基准频率（MHz），大多数处理器上 TSC 以基准频率运行 */
+    if (max_leaf >= 0x16) {
+        cxl_cpuid(0x16, 0, &eax, &ebx, &ecx, &edx);
+        if ((eax & 0xFFFF) != 0) {
+            *source = TSC_SOURCE_CPUID_16H;
+            return (uint64_t)(eax & 0xFFFF) * 1000000ULL;
+        }
+    }
+    
+    return 0;
+}
+
+/* ====== 对照 CLOCK_MONOTONIC_RAW 测量 ====== */
+static uint64_t tsc_timespec_ns(const struct timespec *ts) {
+    return (uint64_t)ts->tv_sec * 1000000000ULL + (uint64_t)ts->tv_nsec;
+}
+
+static int tsc_compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t tsc_calibrate(void) {
+    uint64_t rounds[CXL_TSC_CALIBRATE_ROUNDS];
+    
+    for (int r = 0; r < CXL_TSC_CALIBRATE_ROUNDS; r++) {
+        struct timespec ts;
+        
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        uint64_t start_tsc = cxl_rdtscp(NULL);
+        uint64_t start_ns = tsc_timespec_ns(&ts);
+        uint64_t end_ns, end_tsc;
+        
+        /* 忙等而非休眠，避免唤醒延迟落在两次读数之间 */
+        do {
+            clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+            end_tsc = cxl_rdtscp(NULL);
+            end_ns = tsc_timespec_ns(&ts);
+        } while (end_ns - start_ns < CXL_TSC_CALIBRATE_NS);
+        
+        rounds[r] = (uint64_t)((double)(end_tsc - start_tsc) * 1e9 / (double)(end_ns - start_ns));
+    }
+    
+    qsort(rounds, CXL_TSC_CALIBRATE_ROUNDS, sizeof(uint64_t), tsc_compare_u64);
+    
+    return rounds[CXL_TSC_CALIBRATE_ROUNDS / 2];
+}
+
+static void tsc_init_once(void) {
+    cxl_tsc_info_t *info = &tsc_state.info;
+    tsc_source_t cpuid_source = TSC_SOURCE_CALIBRATED;
+    
+    info->invariant = tsc_check_invariant();
+    info->cpuid_hz = tsc_cpuid_hz(&cpuid_source);
+    info->calibrated_hz = tsc_calibrate();
+    info->source = TSC_SOURCE_CALIBRATED;
+    info->tsc_hz = info->calibrated_hz;
+    
+    if (info->cpuid_hz != 0) {
+        double deviation = fabs((double)info->cpuid_hz - (double)info->calibrated_hz) /
+                           (double)info->calibrated_hz;
+        if (deviation <= CXL_TSC_MAX_DEVIATION) {
+            info->source = cpuid_source;
+            info->tsc_hz = info->cpuid_hz;
+        } else {
+            fprintf(stderr, "[WARNING] CPUID TSC frequency %lu Hz differs from measured %lu Hz by %.1f%%, using measured\n",
+                    info->cpuid_hz, info->calibrated_hz, deviation * 100.0);
+        }
+    }
+    
+    if (!info->invariant) {
+        fprintf(stderr, "[WARNING] TSC is not invariant, cycle/ns conversion may drift with frequency changes\n");
+    }
+    
+    if (info->tsc_hz == 0) {
+        info->tsc_hz = 1000000000ULL;  /* 不会发生，防止除零 */
+    }
+    
+    info->ns_mult = (uint64_t)(((unsigned __int128)1000000000ULL << CXL_TSC_SHIFT) / info->tsc_hz);
+    info->cycles_mult = (uint64_t)(((unsigned __int128)info->tsc_hz << CXL_TSC_SHIFT) / 1000000000ULL);
+}
+
+/* ====== 接口 ====== */
+const cxl_tsc_info_t *cxl_tsc_get(void) {
+    pthread_once(&tsc_state.once, tsc_init_once);
+    return &tsc_state.info;
+}
+
+uint64_t cxl_tsc_hz(void) {
+    return cxl_tsc_get()->tsc_hz;
+}
+
+uint64_t cxl_cycles_to_ns(uint64_t cycles) {
+    return cxl_tsc_to_ns(cxl_tsc_get(), cycles);
+}
+
+double cxl_cycles_to_ns_f(double cycles) {
+    return cycles * 1e9 / (double)cxl_tsc_get()->tsc_hz;
+}
+
+uint64_t cxl_ns_to_cycles(uint64_t ns) {
+    return cxl_tsc_from_ns(cxl_tsc_get(), ns);
+}
+
+const char *cxl_tsc_source_name(tsc_source_t source) {
+    switch (source) {
+        case TSC_SOURCE_CPUID_15H:  return "cpuid-0x15";
+        case TSC_SOURCE_CPUID_16H:  return "cpuid-0x16";
+        case TSC_SOURCE_CALIBRATED: return "calibrated";
+        default:                    return "unknown";
+    }
+}
+
+void cxl_tsc_print(void) {
+    const cxl_tsc_info_t *info = cxl_tsc_get();
+    
+    fprintf(stdout, "TSC:\n");
+    fprintf(stdout, "  Frequency:  %.3f MHz (%s)\n", info->tsc_hz / 1e6, cxl_tsc_source_name(info->source));
+    fprintf(stdout, "  Invariant:  %s\n", info->invariant ? "yes" : "no");
+    if (info->cpuid_hz != 0) {
+        fprintf(stdout, "  CPUID:      %.3f MHz\n", info->cpuid_hz / 1e6);
+    }
+    fprintf(stdout, "  Measured:   %.3f MHz\n", info->calibrated_hz / 1e6);
+}
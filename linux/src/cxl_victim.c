@@ -7,6 +7,7 @@
 #include <time.h>
 #include <stdint.h>
 #include "cxl_victim.h"
+#include "cxl_tsc.h"
 #include "cxl_attack_primitives.h"
 #include "cxl_attacker.h"
 #include "cxl_common.h"
@@ -114,21 +115,23 @@ int cxl_victim_workload(uint64_t duration_us, const char *workload_type) {
         return -1;
     }
     
-    uint64_t cycles_per_us = 2400;  /* 假设 2.4 GHz CPU */
     uint64_t start_cycles = cxl_rdtscp(NULL);
+    uint64_t end_cycles = start_cycles + cxl_ns_to_cycles(duration_us * 1000);
     
     if (strcmp(workload_type, "cpu-intensive") == 0) {
-        /* CPU 密集型工作负载 */
+        /* CPU 密集型工作负载，每 1024 次迭代检查一次截止时间 */
         volatile uint64_t result = 0;
-        for (uint64_t i = 0; i < duration_us * cycles_per_us; i++) {
-            result = (result * 1664525 + 1013904223) ^ i;
-        }
+        uint64_t i = 0;
+        do {
+            for (uint64_t j = 0; j < 1024; j++, i++) {
+                result = (result * 1664525 + 1013904223) ^ i;
+            }
+        } while (cxl_rdtscp(NULL) < end_cycles);
     } else if (strcmp(workload_type, "memory-intensive") == 0) {
         /* 内存密集型工作负载 */
         size_t buffer_size = 1024 * 1024;  /* 1 MB */
         volatile uint8_t *buffer = malloc(buffer_size);
         
-        uint64_t end_cycles = start_cycles + duration_us * cycles_per_us;
         while (cxl_rdtscp(NULL) < end_cycles) {
             for (size_t i = 0; i < buffer_size; i += 64) {
                 (void)(buffer[i]);